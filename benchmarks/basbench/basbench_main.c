@@ -0,0 +1,450 @@
+/****************************************************************************
+ * apps/benchmarks/basbench/basbench_main.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/boardctl.h>
+#include <sys/mount.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bas.h"
+#include "basbench_romfs.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BASBENCH_SECTORSIZE  512
+#define BASBENCH_NSECTORS(b) (((b) + BASBENCH_SECTORSIZE - 1) / \
+                              BASBENCH_SECTORSIZE)
+#define BASBENCH_PATHSIZE    64
+#define BASBENCH_MAXFILES    64
+
+#define BASBENCH_BENCH       CONFIG_BENCHMARK_BASBENCH_MOUNTPT "/bench"
+#define BASBENCH_TESTS       CONFIG_BENCHMARK_BASBENCH_MOUNTPT "/tests"
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct basbench_stat_s
+{
+  uint64_t min;
+  uint64_t sum;
+  int count;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* bastest programs that read the console, stop into direct mode or do
+ * file I/O.  They would block or fail on the read-only image.
+ */
+
+static FAR const char *g_skip[] =
+{
+  "test11.bas",
+  "test15.bas",
+  "test20.bas",
+  "test33.bas",
+  "test36.bas",
+  "test37.bas",
+  "test52.bas"
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: basbench_now
+ ****************************************************************************/
+
+static uint64_t basbench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/****************************************************************************
+ * Name: basbench_add
+ ****************************************************************************/
+
+static void basbench_add(FAR struct basbench_stat_s *st, uint64_t us)
+{
+  if (st->count == 0 || us < st->min)
+    {
+      st->min = us;
+    }
+
+  st->sum += us;
+  st->count++;
+}
+
+/****************************************************************************
+ * Name: basbench_avg
+ ****************************************************************************/
+
+static uint64_t basbench_avg(FAR const struct basbench_stat_s *st)
+{
+  return st->count ? st->sum / st->count : 0;
+}
+
+/****************************************************************************
+ * Name: basbench_mount
+ *
+ * Description:
+ *   Register the ROM disk and mount the program image, unless a previous
+ *   run already did.
+ *
+ ****************************************************************************/
+
+static int basbench_mount(void)
+{
+  struct boardioc_romdisk_s desc;
+  char devpath[16];
+  struct stat st;
+  int ret;
+
+  if (stat(BASBENCH_BENCH, &st) == 0)
+    {
+      return 0;
+    }
+
+  desc.minor    = CONFIG_BENCHMARK_BASBENCH_DEVMINOR;
+  desc.nsectors = BASBENCH_NSECTORS(basbench_romfs_img_len);
+  desc.sectsize = BASBENCH_SECTORSIZE;
+  desc.image    = (FAR uint8_t *)basbench_romfs_img;
+
+  ret = boardctl(BOARDIOC_ROMDISK, (uintptr_t)&desc);
+  if (ret < 0 && errno != EEXIST)
+    {
+      printf("ERROR: romdisk registration failed: %d\n", errno);
+      return -errno;
+    }
+
+  snprintf(devpath, sizeof(devpath), "/dev/ram%d",
+           CONFIG_BENCHMARK_BASBENCH_DEVMINOR);
+  ret = mount(devpath, CONFIG_BENCHMARK_BASBENCH_MOUNTPT, "romfs",
+              MS_RDONLY, NULL);
+  if (ret < 0)
+    {
+      printf("ERROR: mount %s at %s failed: %d\n", devpath,
+             CONFIG_BENCHMARK_BASBENCH_MOUNTPT, errno);
+      return -errno;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: basbench_skip
+ ****************************************************************************/
+
+static bool basbench_skip(FAR const char *name)
+{
+  int i;
+
+  for (i = 0; i < nitems(g_skip); i++)
+    {
+      if (strcmp(g_skip[i], name) == 0)
+        {
+          return true;
+        }
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: basbench_cmp
+ ****************************************************************************/
+
+static int basbench_cmp(FAR const void *a, FAR const void *b)
+{
+  return strcmp(*(FAR char * const *)a, *(FAR char * const *)b);
+}
+
+/****************************************************************************
+ * Name: basbench_list
+ *
+ * Description:
+ *   Collect the .bas files of a directory in name order.
+ *
+ ****************************************************************************/
+
+static int basbench_list(FAR const char *dir, FAR char **names)
+{
+  FAR struct dirent *de;
+  FAR DIR *dirp;
+  size_t len;
+  int n = 0;
+
+  dirp = opendir(dir);
+  if (dirp == NULL)
+    {
+      printf("ERROR: opendir %s failed: %d\n", dir, errno);
+      return -errno;
+    }
+
+  while ((de = readdir(dirp)) != NULL && n < BASBENCH_MAXFILES)
+    {
+      len = strlen(de->d_name);
+      if (len > 4 && strcmp(de->d_name + len - 4, ".bas") == 0 &&
+          !basbench_skip(de->d_name))
+        {
+          names[n] = strdup(de->d_name);
+          if (names[n] != NULL)
+            {
+              n++;
+            }
+        }
+    }
+
+  closedir(dirp);
+  qsort(names, n, sizeof(*names), basbench_cmp);
+  return n;
+}
+
+/****************************************************************************
+ * Name: basbench_run
+ *
+ * Description:
+ *   Run one program the way the bas command does, from initialization to
+ *   bas_exit().  Unless show is set, the program output goes to /dev/null.
+ *
+ ****************************************************************************/
+
+static uint64_t basbench_run(FAR char *path, bool show)
+{
+  uint64_t start;
+  int savedin;
+  int saved;
+  int lpfd;
+  int fd;
+
+  /* bas_exit() closes the console input and output channels, keep copies
+   * of them to put back afterwards.
+   */
+
+  fflush(stdout);
+  savedin = dup(STDIN_FILENO);
+  saved = dup(STDOUT_FILENO);
+  if (!show && saved >= 0)
+    {
+      fd = open("/dev/null", O_WRONLY);
+      if (fd >= 0)
+        {
+          dup2(fd, STDOUT_FILENO);
+          close(fd);
+        }
+    }
+
+  lpfd = open("/dev/null", O_WRONLY);
+
+  start = basbench_now();
+
+  g_bas_argc  = 0;
+  g_bas_argv  = &path;
+  g_bas_argv0 = path;
+  g_bas_end   = false;
+
+  bas_init(0, 0, 0, lpfd);
+  bas_runFile(path);
+  bas_exit();
+
+  start = basbench_now() - start;
+
+  if (savedin >= 0)
+    {
+      dup2(savedin, STDIN_FILENO);
+      close(savedin);
+    }
+
+  if (saved >= 0)
+    {
+      dup2(saved, STDOUT_FILENO);
+      close(saved);
+    }
+
+  return start;
+}
+
+/****************************************************************************
+ * Name: basbench_dir
+ *
+ * Description:
+ *   Time every program of a directory.  Returns the sum of the average
+ *   run times.
+ *
+ ****************************************************************************/
+
+static int basbench_dir(FAR const char *dir, int rounds, bool each,
+                        bool verbose, FAR uint64_t *total)
+{
+  FAR char *names[BASBENCH_MAXFILES];
+  char path[BASBENCH_PATHSIZE];
+  struct basbench_stat_s st;
+  int n;
+  int i;
+  int r;
+
+  n = basbench_list(dir, names);
+  if (n < 0)
+    {
+      return n;
+    }
+
+  *total = 0;
+  for (i = 0; i < n; i++)
+    {
+      snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+      memset(&st, 0, sizeof(st));
+
+      if (verbose)
+        {
+          printf("%s: ", names[i]);
+          basbench_run(path, true);
+        }
+
+      for (r = 0; r < rounds; r++)
+        {
+          basbench_add(&st, basbench_run(path, false));
+        }
+
+      if (each)
+        {
+          printf("%-14s min %8" PRIu64 " us  avg %8" PRIu64 " us\n",
+                 names[i], st.min, basbench_avg(&st));
+        }
+
+      *total += basbench_avg(&st);
+      free(names[i]);
+    }
+
+  return n;
+}
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname, int exitcode)
+{
+  printf("Usage: %s [-n rounds] [-v]\n", progname);
+  printf("  -n  Rounds per program (default %d)\n",
+         CONFIG_BENCHMARK_BASBENCH_ROUNDS);
+  printf("  -v  Show program output and per test times\n");
+  exit(exitcode);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  int rounds = CONFIG_BENCHMARK_BASBENCH_ROUNDS;
+  bool verbose = false;
+  uint64_t total;
+  int ret;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:vh")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'n':
+            rounds = atoi(optarg);
+            break;
+
+          case 'v':
+            verbose = true;
+            break;
+
+          case 'h':
+            show_usage(argv[0], EXIT_SUCCESS);
+            break;
+
+          default:
+            show_usage(argv[0], EXIT_FAILURE);
+            break;
+        }
+    }
+
+  if (rounds <= 0)
+    {
+      show_usage(argv[0], EXIT_FAILURE);
+    }
+
+  ret = basbench_mount();
+  if (ret < 0)
+    {
+      return EXIT_FAILURE;
+    }
+
+  printf("bas %s, %d rounds, scratch chunk %d bytes\n",
+         CONFIG_INTERPRETER_BAS_VERSION, rounds,
+         CONFIG_INTERPRETER_BAS_SCRATCHSIZE);
+
+  ret = basbench_dir(BASBENCH_BENCH, rounds, true, verbose, &total);
+  if (ret < 0)
+    {
+      return EXIT_FAILURE;
+    }
+
+  printf("%-14s %24" PRIu64 " us\n", "workloads", total);
+
+  ret = basbench_dir(BASBENCH_TESTS, rounds, verbose, verbose, &total);
+  if (ret < 0)
+    {
+      return EXIT_FAILURE;
+    }
+
+  printf("%-14s %24" PRIu64 " us  (%d programs)\n", "bastest", total,
+         ret);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,10 @@
+10 rem Array indexing and arithmetic in a counted loop
+20 dim a(100), b(10,10)
+30 s = 0
+40 for i = 1 to 20000
+50   j = i mod 100
+60   a(j) = a(j) + i
+70   b(j mod 10, j \ 10) = a(j) - j
+80   s = s + b(j mod 10, j \ 10) mod 1000
+90 next i
+100 print s
@@ -0,0 +1,17 @@
+rem User functions with locals and recursion
+def fnsq(x) = x * x
+def fnfib(n)
+  local a, b, t, k
+  a = 0 : b = 1
+  for k = 1 to n
+    t = a + b : a = b : b = t
+  next k
+fnend a
+def fnfact(n)
+  if n <= 1 then fnreturn 1
+fnend n * fnfact(n - 1)
+s = 0
+for i = 1 to 2000
+  s = s + fnsq(i mod 37) + fnfib(i mod 20) + fnfact(i mod 8)
+next i
+print s
@@ -0,0 +1,12 @@
+10 rem Sieve of Eratosthenes
+20 n = 8190
+30 dim f%(n)
+40 c = 0
+50 for i = 2 to n
+60   if f%(i) then goto 110
+70   c = c + 1
+80   for k = i + i to n step i
+90     f%(k) = 1
+100   next k
+110 next i
+120 print c
@@ -0,0 +1,10 @@
+10 rem String building, slicing and conversion
+20 b$ = ""
+30 n = 0
+40 for i = 1 to 5000
+50   b$ = b$ + chr$(65 + i mod 26)
+60   if len(b$) > 64 then b$ = mid$(b$, 9)
+70   c$ = left$(b$, 8) + str$(i)
+80   n = n + len(c$) + asc(right$(b$, 1))
+90 next i
+100 print n
@@ -0,0 +1,425 @@
+/****************************************************************************
+ * apps/benchmarks/elbench/elbench_main.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <logging/embedlog.h>
+#include <logging/el_async.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define ELBENCH_MAXTHREADS  8
+#define ELBENCH_SLOW_NS     1000000
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+enum elbench_mode_e
+{
+  ELBENCH_SYNC = 0,         /* embedlog file output, one file per thread */
+  ELBENCH_ASYNC,            /* asynchronous sink, one file */
+  ELBENCH_LZF,              /* asynchronous sink, compressed */
+  ELBENCH_NMODES
+};
+
+struct elbench_thread_s
+{
+  pthread_t tid;
+  struct el el;
+  int id;
+  int count;
+  int period;               /* Pause between messages (us) */
+  uint64_t min;
+  uint64_t max;
+  uint64_t sum;
+  uint32_t slow;            /* Calls slower than ELBENCH_SLOW_NS */
+  uint32_t failed;          /* Calls that returned an error */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static FAR const char *g_modename[ELBENCH_NMODES] =
+{
+  "sync",
+  "async",
+  "async+lzf"
+};
+
+static struct elbench_thread_s g_threads[ELBENCH_MAXTHREADS];
+static struct el_async_s g_sink;
+static volatile bool g_stop;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint64_t elbench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: elbench_producer
+ *
+ * Description:
+ *   Log a CSV style sample record count times, timing every call.  Stops
+ *   early when g_stop is set.
+ *
+ ****************************************************************************/
+
+static FAR void *elbench_producer(FAR void *arg)
+{
+  FAR struct elbench_thread_s *th = arg;
+  uint64_t start;
+  uint64_t ns;
+  int i;
+
+  for (i = 0; i < th->count && !g_stop; i++)
+    {
+      start = elbench_now();
+      if (el_oprint(ELI, &th->el, "%d,%d,%" PRIu32 ",%d", th->id, i,
+                    (uint32_t)start, i * 7 % 1000) != 0)
+        {
+          th->failed++;
+        }
+
+      ns = elbench_now() - start;
+      if (i == 0 || ns < th->min)
+        {
+          th->min = ns;
+        }
+
+      if (ns > th->max)
+        {
+          th->max = ns;
+        }
+
+      if (ns > ELBENCH_SLOW_NS)
+        {
+          th->slow++;
+        }
+
+      th->sum += ns;
+
+      if (th->period > 0)
+        {
+          usleep(th->period);
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: elbench_run
+ ****************************************************************************/
+
+static int elbench_run(enum elbench_mode_e mode, FAR const char *dir,
+                       int nthreads, int count, int period,
+                       size_t ringsize)
+{
+  FAR struct elbench_thread_s *th;
+  struct el_async_stats_s stats;
+  struct el_async_config_s cfg;
+  char path[PATH_MAX];
+  uint64_t produced;
+  uint64_t stored;
+  uint64_t start;
+  uint64_t total;
+  uint64_t min = UINT64_MAX;
+  uint64_t max = 0;
+  uint64_t sum = 0;
+  uint32_t slow = 0;
+  uint32_t failed = 0;
+  int created;
+  int ret = 0;
+  int i;
+
+  memset(&stats, 0, sizeof(stats));
+
+  if (mode != ELBENCH_SYNC)
+    {
+      snprintf(path, sizeof(path), "%s/elbench-%s.log", dir,
+               mode == ELBENCH_LZF ? "lzf" : "async");
+      unlink(path);
+
+      el_async_config_default(&cfg);
+      cfg.path     = path;
+      cfg.compress = mode == ELBENCH_LZF;
+      if (ringsize > 0)
+        {
+          cfg.ringsize = ringsize;
+        }
+
+      ret = el_async_init(&g_sink, &cfg);
+      if (ret < 0)
+        {
+          printf("%-10s not available: %d\n", g_modename[mode], ret);
+          return 0;
+        }
+    }
+
+  for (i = 0; i < nthreads; i++)
+    {
+      th = &g_threads[i];
+      memset(th, 0, sizeof(*th));
+      th->id    = i;
+      th->count  = count;
+      th->period = period;
+
+      el_oinit(&th->el);
+      if (mode == ELBENCH_SYNC)
+        {
+          snprintf(path, sizeof(path), "%s/elbench-sync-%d.log", dir, i);
+          unlink(path);
+          el_oenable_file_log(&th->el, path, 0, 0);
+          el_ooption(&th->el, EL_OUT, EL_OUT_FILE);
+        }
+      else
+        {
+          el_async_attach(&g_sink, &th->el);
+        }
+    }
+
+  g_stop = false;
+  start  = elbench_now();
+
+  for (created = 0; created < nthreads; created++)
+    {
+      ret = pthread_create(&g_threads[created].tid, NULL, elbench_producer,
+                           &g_threads[created]);
+      if (ret != 0)
+        {
+          printf("%-10s pthread_create failed: %d\n", g_modename[mode],
+                 ret);
+          ret    = -ret;
+          g_stop = true;
+          break;
+        }
+    }
+
+  for (i = 0; i < created; i++)
+    {
+      pthread_join(g_threads[i].tid, NULL);
+    }
+
+  if (ret < 0)
+    {
+      goto out;
+    }
+
+  produced = elbench_now() - start;
+
+  /* Count the time until everything logged is on storage */
+
+  if (mode == ELBENCH_SYNC)
+    {
+      for (i = 0; i < nthreads; i++)
+        {
+          el_oflush(&g_threads[i].el);
+        }
+    }
+  else
+    {
+      el_async_flush(&g_sink);
+      el_async_stats(&g_sink, &stats);
+    }
+
+  stored = elbench_now() - start;
+
+  for (i = 0; i < nthreads; i++)
+    {
+      th = &g_threads[i];
+      min     = th->min < min ? th->min : min;
+      max     = th->max > max ? th->max : max;
+      sum    += th->sum;
+      slow   += th->slow;
+      failed += th->failed;
+    }
+
+  total = (uint64_t)nthreads * count;
+  printf("%-10s %7" PRIu64 " %7" PRIu64 " %8" PRIu64 " %6" PRIu32
+         " %6" PRIu32 " %9" PRIu64 " %9" PRIu64 "\n",
+         g_modename[mode], min / 1000, sum / total / 1000, max / 1000,
+         slow, failed,
+         produced ? total * 1000000000 / produced : 0,
+         stored ? total * 1000000000 / stored : 0);
+
+  if (mode != ELBENCH_SYNC)
+    {
+      printf("%-10s %" PRIu32 " records, %" PRIu64 " -> %" PRIu64
+             " bytes in %" PRIu32 " writes, %" PRIu32 " dropped\n", "",
+             stats.records, stats.bytes, stats.written, stats.writes,
+             stats.dropped);
+    }
+
+out:
+  for (i = 0; i < nthreads; i++)
+    {
+      el_ocleanup(&g_threads[i].el);
+    }
+
+  if (mode != ELBENCH_SYNC)
+    {
+      el_async_deinit(&g_sink);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname, int exitcode)
+{
+  printf("Usage: %s [-d dir] [-n count] [-t threads] [-p period] "
+         "[-r ringsize] [-m mode]\n", progname);
+  printf("  -d  Directory for the log files (default %s)\n",
+         CONFIG_BENCHMARK_ELBENCH_DIR);
+  printf("  -n  Messages per thread (default 10000)\n");
+  printf("  -t  Logging threads, 1..%d (default 1)\n", ELBENCH_MAXTHREADS);
+  printf("  -p  Pause between messages in us (default 0: flood)\n");
+  printf("  -r  Ring size of the asynchronous sink (default %d)\n",
+         CONFIG_EMBEDLOG_ASYNC_RINGSIZE);
+  printf("  -m  sync, async or lzf (default: all)\n");
+  exit(exitcode);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  FAR const char *dir = CONFIG_BENCHMARK_ELBENCH_DIR;
+  int first = 0;
+  int last = ELBENCH_NMODES - 1;
+  int nthreads = 1;
+  int count = 10000;
+  int period = 0;
+  int ringsize = 0;
+  int mode;
+  int opt;
+  int ret;
+
+  while ((opt = getopt(argc, argv, "d:n:t:p:r:m:h")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'd':
+            dir = optarg;
+            break;
+
+          case 'n':
+            count = atoi(optarg);
+            break;
+
+          case 't':
+            nthreads = atoi(optarg);
+            break;
+
+          case 'p':
+            period = atoi(optarg);
+            break;
+
+          case 'r':
+            ringsize = atoi(optarg);
+            break;
+
+          case 'm':
+            if (strcmp(optarg, "sync") == 0)
+              {
+                first = last = ELBENCH_SYNC;
+              }
+            else if (strcmp(optarg, "async") == 0)
+              {
+                first = last = ELBENCH_ASYNC;
+              }
+            else if (strcmp(optarg, "lzf") == 0)
+              {
+                first = last = ELBENCH_LZF;
+              }
+            else
+              {
+                show_usage(argv[0], EXIT_FAILURE);
+              }
+            break;
+
+          case 'h':
+            show_usage(argv[0], EXIT_SUCCESS);
+            break;
+
+          default:
+            show_usage(argv[0], EXIT_FAILURE);
+            break;
+        }
+    }
+
+  if (count <= 0 || nthreads <= 0 || nthreads > ELBENCH_MAXTHREADS)
+    {
+      show_usage(argv[0], EXIT_FAILURE);
+    }
+
+  printf("%d thread(s) x %d messages, logs in %s\n", nthreads, count, dir);
+  printf("%-10s %7s %7s %8s %6s %6s %9s %9s\n", "mode", "min us",
+         "avg us", "max us", ">1ms", "failed", "logged/s", "stored/s");
+
+  for (mode = first; mode <= last; mode++)
+    {
+      ret = elbench_run(mode, dir, nthreads, count, period, ringsize);
+      if (ret < 0)
+        {
+          return EXIT_FAILURE;
+        }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,302 @@
+/****************************************************************************
+ * apps/benchmarks/fftbench/fftbench_main.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "math/spectrum.h"
+#include "kiss_fftr.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define FFTBENCH_NFFT_MIN    64
+#define FFTBENCH_NFFT_MAX    8192
+#define FFTBENCH_TIME_DEF    1     /* Seconds per measurement */
+
+#ifdef CONFIG_MATH_KISSFFT_FIXED16
+#  define FFTBENCH_TYPE      "fixed16"
+#else
+#  define FFTBENCH_TYPE      "float"
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: fftbench_now
+ ****************************************************************************/
+
+static uint64_t fftbench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: fftbench_fill
+ *
+ * Description:
+ *   Fill 'buf' with two tones and a little deterministic noise, so the
+ *   transform does not see an all-zero or trivially sparse input.
+ *
+ ****************************************************************************/
+
+static void fftbench_fill(FAR spectrum_sample_t *buf, size_t n)
+{
+  uint32_t seed = 1;
+  size_t   i;
+
+  for (i = 0; i < n; i++)
+    {
+      float v = 0.5f * sinf(2.0f * (float)M_PI * 0.05f * i) +
+                0.25f * sinf(2.0f * (float)M_PI * 0.21f * i);
+
+      seed = seed * 1664525u + 1013904223u;
+      v   += ((int32_t)(seed >> 16) - 32768) / 32768.0f * 0.05f;
+
+#ifdef CONFIG_MATH_KISSFFT_FIXED16
+      buf[i] = (spectrum_sample_t)(v * 32767.0f);
+#else
+      buf[i] = v;
+#endif
+    }
+}
+
+/****************************************************************************
+ * Name: fftbench_fft
+ *
+ * Description:
+ *   Run the bare real FFT for about 'ns' nanoseconds and return the rate
+ *   in transforms per second, or a negative value on allocation failure.
+ *
+ ****************************************************************************/
+
+static float fftbench_fft(FAR const spectrum_sample_t *in, size_t nfft,
+                          uint64_t ns)
+{
+  FAR kiss_fft_cpx *out;
+  kiss_fftr_cfg     cfg;
+  FAR void         *mem;
+  size_t            lenmem = 0;
+  uint64_t          start;
+  uint64_t          elapsed;
+  uint32_t          count = 0;
+
+  kiss_fftr_alloc(nfft, 0, NULL, &lenmem);
+
+  mem = malloc(lenmem);
+  out = malloc((nfft / 2 + 1) * sizeof(kiss_fft_cpx));
+  cfg = mem != NULL ? kiss_fftr_alloc(nfft, 0, mem, &lenmem) : NULL;
+  if (cfg == NULL || out == NULL)
+    {
+      free(out);
+      free(mem);
+      return -1.0f;
+    }
+
+  start = fftbench_now();
+  do
+    {
+      kiss_fftr(cfg, in, out);
+      count++;
+      elapsed = fftbench_now() - start;
+    }
+  while (elapsed < ns);
+
+  free(out);
+  free(mem);
+  return count * 1e9f / elapsed;
+}
+
+/****************************************************************************
+ * Name: fftbench_null_cb
+ ****************************************************************************/
+
+static void fftbench_null_cb(FAR void *priv,
+                             FAR const spectrum_power_t *power,
+                             size_t nbins)
+{
+  FAR uint32_t *published = priv;
+
+  (*published)++;
+}
+
+/****************************************************************************
+ * Name: fftbench_stage
+ *
+ * Description:
+ *   Run the full spectrum stage (window, FFT, power, averaging) on one
+ *   frame at a time and return the rate in frames per second.
+ *
+ ****************************************************************************/
+
+static float fftbench_stage(FAR const spectrum_sample_t *in, size_t nfft,
+                            int window, uint64_t ns)
+{
+  struct spectrum_cfg_s  cfg;
+  FAR struct spectrum_s *s;
+  uint32_t               published = 0;
+  uint64_t               start;
+  uint64_t               elapsed;
+  uint32_t               count = 0;
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.nfft   = nfft;
+  cfg.hop    = nfft;
+  cfg.window = window;
+  cfg.navg   = 4;
+  cfg.cb     = fftbench_null_cb;
+  cfg.priv   = &published;
+
+  s = spectrum_create(&cfg);
+  if (s == NULL)
+    {
+      return -1.0f;
+    }
+
+  start = fftbench_now();
+  do
+    {
+      spectrum_frame(s, in);
+      count++;
+      elapsed = fftbench_now() - start;
+    }
+  while (elapsed < ns);
+
+  spectrum_destroy(s);
+  return count * 1e9f / elapsed;
+}
+
+/****************************************************************************
+ * Name: fftbench_usage
+ ****************************************************************************/
+
+static void fftbench_usage(FAR const char *progname)
+{
+  printf("Usage: %s [-n nfft] [-t seconds] [-w rect|hann|hamming]\n",
+         progname);
+  printf("  -n nfft  run a single power-of-two size (default: %d..%d)\n",
+         FFTBENCH_NFFT_MIN, FFTBENCH_NFFT_MAX);
+  printf("  -t sec   time per measurement (default: %d)\n",
+         FFTBENCH_TIME_DEF);
+  printf("  -w win   window used by the stage (default: hann)\n");
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  FAR spectrum_sample_t *in;
+  uint64_t               ns;
+  size_t                 nmin   = FFTBENCH_NFFT_MIN;
+  size_t                 nmax   = FFTBENCH_NFFT_MAX;
+  size_t                 nfft;
+  int                    window = SPECTRUM_WINDOW_HANN;
+  int                    secs   = FFTBENCH_TIME_DEF;
+  int                    opt;
+
+  while ((opt = getopt(argc, argv, "n:t:w:h")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'n':
+            nmin = nmax = strtoul(optarg, NULL, 0);
+            break;
+
+          case 't':
+            secs = atoi(optarg);
+            break;
+
+          case 'w':
+            window = strcmp(optarg, "rect") == 0 ?
+                     SPECTRUM_WINDOW_RECT :
+                     strcmp(optarg, "hamming") == 0 ?
+                     SPECTRUM_WINDOW_HAMMING : SPECTRUM_WINDOW_HANN;
+            break;
+
+          case 'h':
+          default:
+            fftbench_usage(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+  if (secs <= 0 || nmin == 0 || (nmin & (nmin - 1)) != 0)
+    {
+      fftbench_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  in = malloc(nmax * sizeof(spectrum_sample_t));
+  if (in == NULL)
+    {
+      printf("ERROR: failed to allocate %zu samples\n", nmax);
+      return EXIT_FAILURE;
+    }
+
+  fftbench_fill(in, nmax);
+  ns = (uint64_t)secs * 1000000000ull;
+
+  printf("fftbench: kissfft %s, %d s per size\n", FFTBENCH_TYPE, secs);
+  printf("%6s %12s %10s %12s %10s\n",
+         "nfft", "fft/s", "us/fft", "frames/s", "us/frame");
+
+  for (nfft = nmin; nfft <= nmax; nfft <<= 1)
+    {
+      float fft   = fftbench_fft(in, nfft, ns);
+      float stage = fftbench_stage(in, nfft, window, ns);
+
+      if (fft < 0.0f || stage < 0.0f)
+        {
+          printf("%6zu out of memory\n", nfft);
+          break;
+        }
+
+      printf("%6zu %12.1f %10.2f %12.1f %10.2f\n", nfft,
+             fft, 1e6f / fft, stage, 1e6f / stage);
+    }
+
+  free(in);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,649 @@
+/****************************************************************************
+ * apps/benchmarks/focbatch/focbatch_main.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "industry/foc/foc_common.h"
+#include "industry/foc/float/foc_handler.h"
+#include "industry/foc/float/foc_batch.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define FOCBATCH_NMOTORS_DEF  4
+#define FOCBATCH_ITER_DEF     100000
+#define FOCBATCH_SAMPLES      256
+#define FOCBATCH_VBUS         (12.0f)
+#define FOCBATCH_IQ           (1.0f)
+#define FOCBATCH_KP           (0.2f)
+#define FOCBATCH_KI           (0.005f)
+#define FOCBATCH_DUTY_MAX     (0.95f)
+#define NSEC_PER_SEC          1000000000ll
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Pre-computed input sample */
+
+struct focbatch_sample_s
+{
+  float angle;
+  float curr[CONFIG_MOTOR_FOC_PHASES];
+};
+
+/* Per-motor handler data */
+
+struct focbatch_motor_s
+{
+  foc_handler_f32_t               handler;
+  struct foc_handler_input_f32_s  in;
+  struct foc_handler_output_f32_s out;
+  float                           curr[CONFIG_MOTOR_FOC_PHASES];
+  dq_frame_f32_t                  dq_ref;
+  dq_frame_f32_t                  vdq_comp;
+  int                             phase;   /* Sample table offset */
+};
+
+/* Thread-per-motor mode */
+
+struct focbatch_thr_s
+{
+  pthread_t                    thread;
+  FAR struct focbatch_motor_s *motor;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct focbatch_sample_s g_samples[FOCBATCH_SAMPLES];
+static struct focbatch_motor_s  g_motor[FOC_BATCH_MAX];
+static struct focbatch_thr_s    g_thr[FOC_BATCH_MAX];
+static foc_batch_f32_t          g_batch;
+
+static pthread_barrier_t        g_barrier;
+static sem_t                    g_start;
+static volatile uint32_t        g_tick;
+static volatile bool            g_stop;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: focbatch_samples_init
+ *
+ * Description:
+ *   Phase currents of a rotating q-axis current vector, so that the
+ *   current controllers stay close to equilibrium during the run.
+ *
+ ****************************************************************************/
+
+static void focbatch_samples_init(void)
+{
+  float angle;
+  int   i;
+
+  for (i = 0; i < FOCBATCH_SAMPLES; i++)
+    {
+      angle = 2.0f * M_PI * i / FOCBATCH_SAMPLES;
+
+      g_samples[i].angle   = angle;
+      g_samples[i].curr[0] = -FOCBATCH_IQ * sinf(angle);
+      g_samples[i].curr[1] = -FOCBATCH_IQ * sinf(angle - 2.0f * M_PI / 3);
+      g_samples[i].curr[2] = -FOCBATCH_IQ * sinf(angle + 2.0f * M_PI / 3);
+    }
+}
+
+/****************************************************************************
+ * Name: focbatch_sample
+ ****************************************************************************/
+
+static FAR const struct focbatch_sample_s *focbatch_sample(int motor,
+                                                           uint32_t tick)
+{
+  return &g_samples[(tick + g_motor[motor].phase) % FOCBATCH_SAMPLES];
+}
+
+/****************************************************************************
+ * Name: focbatch_handlers_deinit
+ ****************************************************************************/
+
+static void focbatch_handlers_deinit(int n)
+{
+  int i;
+
+  for (i = 0; i < n; i++)
+    {
+      foc_handler_deinit_f32(&g_motor[i].handler);
+    }
+}
+
+/****************************************************************************
+ * Name: focbatch_handlers_init
+ *
+ * Description:
+ *   Initialize the first n handlers.  On failure the ones already
+ *   initialized are released again.
+ *
+ ****************************************************************************/
+
+static int focbatch_handlers_init(int n)
+{
+  struct foc_initdata_f32_s ctrl_cfg;
+  struct foc_mod_cfg_f32_s  mod_cfg;
+  int                       ret;
+  int                       i;
+
+  ctrl_cfg.id_kp       = FOCBATCH_KP;
+  ctrl_cfg.id_ki       = FOCBATCH_KI;
+  ctrl_cfg.iq_kp       = FOCBATCH_KP;
+  ctrl_cfg.iq_ki       = FOCBATCH_KI;
+  mod_cfg.pwm_duty_max = FOCBATCH_DUTY_MAX;
+
+  for (i = 0; i < n; i++)
+    {
+      FAR struct focbatch_motor_s *m = &g_motor[i];
+
+      ret = foc_handler_init_f32(&m->handler,
+                                 &g_foc_control_pi_f32,
+                                 &g_foc_mod_svm3_f32);
+      if (ret < 0)
+        {
+          printf("ERROR: foc_handler_init_f32 failed %d\n", ret);
+          focbatch_handlers_deinit(i);
+          return ret;
+        }
+
+      foc_handler_cfg_f32(&m->handler, &ctrl_cfg, &mod_cfg);
+
+      m->dq_ref.d    = 0.0f;
+      m->dq_ref.q    = FOCBATCH_IQ;
+      m->vdq_comp.d  = 0.0f;
+      m->vdq_comp.q  = 0.0f;
+      m->in.current  = m->curr;
+      m->in.dq_ref   = &m->dq_ref;
+      m->in.vdq_comp = &m->vdq_comp;
+      m->in.vbus     = FOCBATCH_VBUS;
+      m->in.mode     = FOC_HANDLER_MODE_CURRENT;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: focbatch_motor_run
+ ****************************************************************************/
+
+static void focbatch_motor_run(int motor, uint32_t tick)
+{
+  FAR struct focbatch_motor_s        *m = &g_motor[motor];
+  FAR const struct focbatch_sample_s *s = focbatch_sample(motor, tick);
+
+  m->curr[0]  = s->curr[0];
+  m->curr[1]  = s->curr[1];
+  m->curr[2]  = s->curr[2];
+  m->in.angle = s->angle;
+
+  foc_handler_run_f32(&m->handler, &m->in, &m->out);
+}
+
+/****************************************************************************
+ * Name: focbatch_thread
+ ****************************************************************************/
+
+static FAR void *focbatch_thread(FAR void *arg)
+{
+  int motor = (int)(intptr_t)arg;
+  int ret;
+
+  /* Wait until every thread exists, or the run is abandoned */
+
+  while ((ret = sem_wait(&g_start)) < 0 && errno == EINTR);
+  if (ret < 0)
+    {
+      printf("ERROR: sem_wait failed %d\n", errno);
+    }
+
+  if (g_stop)
+    {
+      return NULL;
+    }
+
+  for (; ; )
+    {
+      pthread_barrier_wait(&g_barrier);
+      if (g_stop)
+        {
+          break;
+        }
+
+      focbatch_motor_run(motor, g_tick);
+      pthread_barrier_wait(&g_barrier);
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: focbatch_now
+ ****************************************************************************/
+
+static uint64_t focbatch_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: focbatch_report
+ ****************************************************************************/
+
+static void focbatch_report(FAR const char *name, int n, uint32_t iter,
+                            uint64_t nsec)
+{
+  printf("%-8s %10.1f ns/period %10.1f ns/motor\n", name,
+         (double)nsec / iter, (double)nsec / iter / n);
+}
+
+/****************************************************************************
+ * Name: focbatch_run_handler
+ *
+ * Description:
+ *   One FOC handler per motor, all run from this thread
+ *
+ ****************************************************************************/
+
+static uint64_t focbatch_run_handler(int n, uint32_t iter)
+{
+  uint64_t start;
+  uint32_t t;
+  int      i;
+
+  start = focbatch_now();
+
+  for (t = 0; t < iter; t++)
+    {
+      for (i = 0; i < n; i++)
+        {
+          focbatch_motor_run(i, t);
+        }
+    }
+
+  return focbatch_now() - start;
+}
+
+/****************************************************************************
+ * Name: focbatch_run_threads
+ *
+ * Description:
+ *   One thread per motor, released once per control period.  Returns
+ *   the elapsed time or a negated errno.
+ *
+ ****************************************************************************/
+
+static int64_t focbatch_run_threads(int n, uint32_t iter)
+{
+  uint64_t start;
+  uint32_t t;
+  int      ret;
+  int      i;
+
+  ret = pthread_barrier_init(&g_barrier, NULL, n + 1);
+  if (ret != 0)
+    {
+      printf("ERROR: pthread_barrier_init failed %d\n", ret);
+      ret = -ret;
+      return ret;
+    }
+
+  if (sem_init(&g_start, 0, 0) < 0)
+    {
+      ret = -errno;
+      pthread_barrier_destroy(&g_barrier);
+      return ret;
+    }
+
+  g_stop = false;
+
+  for (i = 0; i < n; i++)
+    {
+      ret = pthread_create(&g_thr[i].thread, NULL, focbatch_thread,
+                           (FAR void *)(intptr_t)i);
+      if (ret != 0)
+        {
+          printf("ERROR: pthread_create failed %d\n", ret);
+          ret = -ret;
+          break;
+        }
+    }
+
+  if (ret < 0)
+    {
+      /* The threads already started have not reached the barrier yet, let
+       * them see the stop flag instead.
+       */
+
+      g_stop = true;
+      n      = i;
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      sem_post(&g_start);
+    }
+
+  if (ret < 0)
+    {
+      goto out;
+    }
+
+  start = focbatch_now();
+
+  for (t = 0; t < iter; t++)
+    {
+      g_tick = t;
+      pthread_barrier_wait(&g_barrier);
+      pthread_barrier_wait(&g_barrier);
+    }
+
+  start = focbatch_now() - start;
+
+  g_stop = true;
+  pthread_barrier_wait(&g_barrier);
+  ret = OK;
+
+out:
+  for (i = 0; i < n; i++)
+    {
+      pthread_join(g_thr[i].thread, NULL);
+    }
+
+  sem_destroy(&g_start);
+  pthread_barrier_destroy(&g_barrier);
+  return ret < 0 ? ret : (int64_t)start;
+}
+
+/****************************************************************************
+ * Name: focbatch_batch_init
+ ****************************************************************************/
+
+static int focbatch_batch_init(int n)
+{
+  struct foc_initdata_f32_s ctrl_cfg;
+  struct foc_mod_cfg_f32_s  mod_cfg;
+  int                       ret;
+  int                       i;
+
+  ret = foc_batch_init_f32(&g_batch, n);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ctrl_cfg.id_kp       = FOCBATCH_KP;
+  ctrl_cfg.id_ki       = FOCBATCH_KI;
+  ctrl_cfg.iq_kp       = FOCBATCH_KP;
+  ctrl_cfg.iq_ki       = FOCBATCH_KI;
+  mod_cfg.pwm_duty_max = FOCBATCH_DUTY_MAX;
+
+  for (i = 0; i < n; i++)
+    {
+      foc_batch_cfg_f32(&g_batch, i, &ctrl_cfg, &mod_cfg);
+
+      g_batch.vbus[i]   = FOCBATCH_VBUS;
+      g_batch.id_ref[i] = 0.0f;
+      g_batch.iq_ref[i] = FOCBATCH_IQ;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: focbatch_run_batch
+ *
+ * Description:
+ *   All motors in one batched controller call.  Gathering the samples
+ *   into the batch is part of the measured time.
+ *
+ ****************************************************************************/
+
+static uint64_t focbatch_run_batch(int n, uint32_t iter)
+{
+  FAR const struct focbatch_sample_s *s;
+  uint64_t                            start;
+  uint32_t                            t;
+  int                                 i;
+
+  start = focbatch_now();
+
+  for (t = 0; t < iter; t++)
+    {
+      for (i = 0; i < n; i++)
+        {
+          s = focbatch_sample(i, t);
+
+          g_batch.curr[0][i] = s->curr[0];
+          g_batch.curr[1][i] = s->curr[1];
+          g_batch.curr[2][i] = s->curr[2];
+          g_batch.angle[i]   = s->angle;
+        }
+
+      foc_batch_run_f32(&g_batch);
+    }
+
+  return focbatch_now() - start;
+}
+
+/****************************************************************************
+ * Name: focbatch_compare
+ *
+ * Description:
+ *   Compare the last duty cycles of the handler and batch runs
+ *
+ ****************************************************************************/
+
+static void focbatch_compare(int n)
+{
+  float diff;
+  float max = 0.0f;
+  int   i;
+  int   j;
+
+  for (i = 0; i < n; i++)
+    {
+      for (j = 0; j < CONFIG_MOTOR_FOC_PHASES; j++)
+        {
+          diff = fabsf(g_motor[i].out.duty[j] - g_batch.duty[j][i]);
+          if (diff > max)
+            {
+              max = diff;
+            }
+        }
+    }
+
+  printf("max duty difference handler/batch: %.5f\n", max);
+}
+
+/****************************************************************************
+ * Name: focbatch_help
+ ****************************************************************************/
+
+static void focbatch_help(FAR const char *progname)
+{
+  printf("Usage: %s [options]\n", progname);
+  printf("  [-n motors] number of motors, 1-%d (default: %d)\n",
+         FOC_BATCH_MAX, FOCBATCH_NMOTORS_DEF);
+  printf("  [-i iter] control periods to run (default: %d)\n",
+         FOCBATCH_ITER_DEF);
+  printf("  [-m mode] h=handlers, t=threads, b=batch, a=all "
+         "(default: a)\n");
+  printf("  [-h] show this help\n");
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  uint32_t iter = FOCBATCH_ITER_DEF;
+  int64_t  nsec;
+  char     mode = 'a';
+  int      n    = FOCBATCH_NMOTORS_DEF;
+  int      ret;
+  int      opt;
+  int      i;
+
+  while ((opt = getopt(argc, argv, "n:i:m:h")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'n':
+            n = atoi(optarg);
+            break;
+
+          case 'i':
+            iter = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'm':
+            mode = optarg[0];
+            break;
+
+          case 'h':
+          default:
+            focbatch_help(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+  if (n <= 0 || n > FOC_BATCH_MAX || iter == 0)
+    {
+      focbatch_help(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  focbatch_samples_init();
+
+  /* Spread the motors over the electrical period */
+
+  for (i = 0; i < n; i++)
+    {
+      g_motor[i].phase = i * FOCBATCH_SAMPLES / n;
+    }
+
+  printf("focbatch: %d motors, %" PRIu32 " periods\n", n, iter);
+
+  if (mode == 'h' || mode == 'a')
+    {
+      ret = focbatch_handlers_init(n);
+      if (ret < 0)
+        {
+          goto errout;
+        }
+
+      focbatch_report("handler", n, iter, focbatch_run_handler(n, iter));
+      focbatch_handlers_deinit(n);
+    }
+
+  if (mode == 't' || mode == 'a')
+    {
+      ret = focbatch_handlers_init(n);
+      if (ret < 0)
+        {
+          goto errout;
+        }
+
+      nsec = focbatch_run_threads(n, iter);
+      if (nsec < 0)
+        {
+          goto errout_with_handlers;
+        }
+
+      focbatch_report("threads", n, iter, nsec);
+
+      /* Keep the handlers so the thread run can be compared with the
+       * batch run below.
+       */
+
+      if (mode == 't')
+        {
+          focbatch_handlers_deinit(n);
+        }
+    }
+
+  if (mode == 'b' || mode == 'a')
+    {
+      ret = focbatch_batch_init(n);
+      if (ret < 0)
+        {
+          if (mode == 'a')
+            {
+              goto errout_with_handlers;
+            }
+
+          goto errout;
+        }
+
+      focbatch_report("batch", n, iter, focbatch_run_batch(n, iter));
+
+      if (mode == 'a')
+        {
+          focbatch_compare(n);
+          focbatch_handlers_deinit(n);
+        }
+    }
+
+  return EXIT_SUCCESS;
+
+errout_with_handlers:
+  focbatch_handlers_deinit(n);
+
+errout:
+  return EXIT_FAILURE;
+}
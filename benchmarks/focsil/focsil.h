@@ -0,0 +1,124 @@
+/****************************************************************************
+ * apps/benchmarks/focsil/focsil.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_BENCHMARKS_FOCSIL_FOCSIL_H
+#define __APPS_BENCHMARKS_FOCSIL_FOCSIL_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Simulated motor and supply */
+
+#define FOCSIL_POLES      7
+#define FOCSIL_RES        (0.11f)       /* Phase resistance [Ohm] */
+#define FOCSIL_IND        (0.0002f)     /* Phase inductance [H] */
+#define FOCSIL_INER       (0.001f)      /* Rotor inertia [kg*m^2] */
+#define FOCSIL_FLUX       (0.005f)      /* Flux linkage [Wb] */
+#define FOCSIL_VBUS       (12.0f)       /* Bus voltage [V] */
+#define FOCSIL_IPHASE_ADC (0.001f)      /* Raw current scale [A/LSB] */
+#define FOCSIL_DUTY_MAX   (0.95f)
+
+/* Controller tuning: current loop bandwidth and velocity PI */
+
+#define FOCSIL_CURR_BW    (1000.0f)     /* Current loop bandwidth [rad/s] */
+#define FOCSIL_VEL_BW     (100.0f)      /* Velocity loop bandwidth [rad/s] */
+#define FOCSIL_IQ_MAX     (10.0f)       /* Velocity PI output limit [A] */
+
+/* Torque constant [Nm/A] */
+
+#define FOCSIL_KT         (1.5f * FOCSIL_POLES * FOCSIL_FLUX)
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* One profile segment: hold a velocity set-point and load torque */
+
+struct focsil_seg_s
+{
+  float time;                   /* Segment duration [s] */
+  float vel;                    /* Mechanical velocity set-point [rad/s] */
+  float load;                   /* Load torque [Nm] */
+};
+
+struct focsil_cfg_s
+{
+  FAR const struct focsil_seg_s *prof;
+  int                            nseg;
+  uint32_t                       freq;     /* Control loop frequency */
+  int                            velpre;   /* Velocity loop prescaler */
+  float                          settle;   /* Ignored time per segment */
+  bool                           realtime; /* Pace loop at 'freq' */
+};
+
+/* Control loop pacing for real-time mode */
+
+struct focsil_pace_s
+{
+  struct timespec next;
+  long            per_ns;
+};
+
+struct focsil_result_s
+{
+  uint32_t iter;                /* Control loop iterations */
+  uint32_t missed;              /* Missed deadlines in real-time mode */
+  uint32_t err_cnt;             /* All error samples */
+  uint32_t ss_cnt;              /* Steady-state error samples */
+  double   err_sq;              /* Sum of squared velocity errors */
+  double   ss_sq;               /* Sum of squared steady-state errors */
+  float    ss_max;              /* Max abs steady-state error [rad/s] */
+  float    vel_end;             /* Final mechanical velocity [rad/s] */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+void focsil_pace_init(FAR struct focsil_pace_s *pace, uint32_t freq);
+void focsil_pace_wait(FAR struct focsil_pace_s *pace,
+                      FAR struct focsil_result_s *res);
+void focsil_err_put(FAR struct focsil_result_s *res, float err,
+                    bool settled);
+
+#ifdef CONFIG_INDUSTRY_FOC_FLOAT
+int focsil_run_f32(FAR const struct focsil_cfg_s *cfg,
+                   FAR struct focsil_result_s *res);
+#endif
+
+#ifdef CONFIG_INDUSTRY_FOC_FIXED16
+int focsil_run_b16(FAR const struct focsil_cfg_s *cfg,
+                   FAR struct focsil_result_s *res);
+#endif
+
+#endif /* __APPS_BENCHMARKS_FOCSIL_FOCSIL_H */
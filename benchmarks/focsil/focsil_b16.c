@@ -0,0 +1,250 @@
+/****************************************************************************
+ * apps/benchmarks/focsil/focsil_b16.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <dspb16.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "industry/foc/fixed16/foc_handler.h"
+#include "industry/foc/fixed16/foc_model.h"
+
+#include "focsil.h"
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct focsil_b16_s
+{
+  foc_handler_b16_t            handler;
+  foc_model_b16_t              model;
+  pid_controller_b16_t         vel_pi;
+  struct foc_model_state_b16_s model_state;
+  struct foc_state_b16_s       foc_state;
+  b16_t                        per;
+  b16_t                        angle;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: focsil_b16_init
+ ****************************************************************************/
+
+static int focsil_b16_init(FAR struct focsil_b16_s *sil,
+                           FAR const struct focsil_cfg_s *cfg)
+{
+  struct foc_initdata_b16_s       ctrl_cfg;
+  struct foc_mod_cfg_b16_s        mod_cfg;
+  struct foc_model_pmsm_cfg_b16_s pmsm_cfg;
+  float                           per;
+  float                           vel_kp;
+  int                             ret;
+
+  memset(sil, 0, sizeof(*sil));
+  per      = 1.0f / cfg->freq;
+  sil->per = ftob16(per);
+
+  ret = foc_handler_init_b16(&sil->handler,
+                             &g_foc_control_pi_b16,
+                             &g_foc_mod_svm3_b16);
+  if (ret < 0)
+    {
+      printf("ERROR: foc_handler_init_b16 failed %d\n", ret);
+      return ret;
+    }
+
+  /* Same tuning as the float controller */
+
+  ctrl_cfg.id_kp = ftob16(FOCSIL_IND * FOCSIL_CURR_BW);
+  ctrl_cfg.id_ki = ftob16(FOCSIL_RES * FOCSIL_CURR_BW * per);
+  ctrl_cfg.iq_kp = ctrl_cfg.id_kp;
+  ctrl_cfg.iq_ki = ctrl_cfg.id_ki;
+
+  mod_cfg.pwm_duty_max = ftob16(FOCSIL_DUTY_MAX);
+
+  foc_handler_cfg_b16(&sil->handler, &ctrl_cfg, &mod_cfg);
+
+  ret = foc_model_init_b16(&sil->model, &g_foc_model_pmsm_ops_b16);
+  if (ret < 0)
+    {
+      printf("ERROR: foc_model_init_b16 failed %d\n", ret);
+      foc_handler_deinit_b16(&sil->handler);
+      return ret;
+    }
+
+  pmsm_cfg.poles      = FOCSIL_POLES;
+  pmsm_cfg.res        = ftob16(FOCSIL_RES);
+  pmsm_cfg.ind        = ftob16(FOCSIL_IND);
+  pmsm_cfg.iner       = ftob16(FOCSIL_INER);
+  pmsm_cfg.flux_link  = ftob16(FOCSIL_FLUX);
+  pmsm_cfg.ind_d      = ftob16(FOCSIL_IND);
+  pmsm_cfg.ind_q      = ftob16(FOCSIL_IND);
+  pmsm_cfg.per        = sil->per;
+  pmsm_cfg.iphase_adc = ftob16(FOCSIL_IPHASE_ADC);
+
+  foc_model_cfg_b16(&sil->model, &pmsm_cfg);
+
+  vel_kp = FOCSIL_INER * FOCSIL_VEL_BW / FOCSIL_KT;
+  pi_controller_init_b16(&sil->vel_pi, ftob16(vel_kp),
+                         ftob16(vel_kp * FOCSIL_VEL_BW / 5.0f * per *
+                                cfg->velpre));
+  pi_saturation_set_b16(&sil->vel_pi, ftob16(-FOCSIL_IQ_MAX),
+                        ftob16(FOCSIL_IQ_MAX));
+  pi_antiwindup_enable_b16(&sil->vel_pi, ftob16(0.99f), true);
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: focsil_b16_deinit
+ ****************************************************************************/
+
+static void focsil_b16_deinit(FAR struct focsil_b16_s *sil)
+{
+  foc_model_deinit_b16(&sil->model);
+  foc_handler_deinit_b16(&sil->handler);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: focsil_run_b16
+ *
+ * Description:
+ *   Run the closed-loop profile with the fixed16 controller
+ *
+ ****************************************************************************/
+
+int focsil_run_b16(FAR const struct focsil_cfg_s *cfg,
+                   FAR struct focsil_result_s *res)
+{
+  struct focsil_b16_s             sil;
+  struct foc_handler_input_b16_s  input;
+  struct foc_handler_output_b16_s output;
+  struct focsil_pace_s            pace;
+  dq_frame_b16_t                  dq_ref;
+  dq_frame_b16_t                  vdq_comp;
+  uint32_t                        nsteps;
+  uint32_t                        settle;
+  uint32_t                        step;
+  b16_t                           vel;
+  b16_t                           load;
+  b16_t                           err;
+  int                             seg;
+  int                             ret;
+
+  ret = focsil_b16_init(&sil, cfg);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  dq_ref.d   = 0;
+  dq_ref.q   = 0;
+  vdq_comp.d = 0;
+  vdq_comp.q = 0;
+
+  input.current  = sil.model_state.curr;
+  input.dq_ref   = &dq_ref;
+  input.vdq_comp = &vdq_comp;
+  input.vbus     = ftob16(FOCSIL_VBUS);
+  input.mode     = FOC_HANDLER_MODE_CURRENT;
+
+  settle = (uint32_t)(cfg->settle * cfg->freq);
+
+  if (cfg->realtime)
+    {
+      focsil_pace_init(&pace, cfg->freq);
+    }
+
+  for (seg = 0; seg < cfg->nseg; seg++)
+    {
+      nsteps = (uint32_t)(cfg->prof[seg].time * cfg->freq);
+      vel    = ftob16(cfg->prof[seg].vel);
+      load   = ftob16(cfg->prof[seg].load);
+
+      for (step = 0; step < nsteps; step++)
+        {
+          /* Sample the plant */
+
+          foc_model_state_b16(&sil.model, &sil.model_state);
+
+          /* Integrate the angle with the model period so that it stays
+           * aligned with the model rotor.
+           */
+
+          sil.angle += b16mulb16(sil.model_state.omega_e, sil.per);
+          angle_norm_2pi_b16(&sil.angle, 0, MOTOR_ANGLE_E_MAX_B16);
+
+          /* Velocity controller */
+
+          if (res->iter % cfg->velpre == 0)
+            {
+              err      = vel - sil.model_state.omega_m;
+              dq_ref.q = pi_controller_b16(&sil.vel_pi, err);
+
+              focsil_err_put(res, b16tof(err), step >= settle);
+            }
+
+          /* Current controller and modulation */
+
+          input.angle = sil.angle;
+
+          ret = foc_handler_run_b16(&sil.handler, &input, &output);
+          if (ret < 0)
+            {
+              goto errout;
+            }
+
+          foc_handler_state_b16(&sil.handler, &sil.foc_state, NULL);
+
+          /* Apply the modulated voltage to the plant */
+
+          foc_model_run_b16(&sil.model, load, &sil.foc_state.vab);
+
+          res->iter += 1;
+
+          if (cfg->realtime)
+            {
+              focsil_pace_wait(&pace, res);
+            }
+        }
+    }
+
+  res->vel_end = b16tof(sil.model_state.omega_m);
+
+errout:
+  focsil_b16_deinit(&sil);
+  return ret;
+}
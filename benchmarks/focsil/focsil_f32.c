@@ -0,0 +1,245 @@
+/****************************************************************************
+ * apps/benchmarks/focsil/focsil_f32.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <dsp.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "industry/foc/float/foc_handler.h"
+#include "industry/foc/float/foc_model.h"
+
+#include "focsil.h"
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct focsil_f32_s
+{
+  foc_handler_f32_t            handler;
+  foc_model_f32_t              model;
+  pid_controller_f32_t         vel_pi;
+  struct foc_model_state_f32_s model_state;
+  struct foc_state_f32_s       foc_state;
+  float                        per;
+  float                        angle;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: focsil_f32_init
+ ****************************************************************************/
+
+static int focsil_f32_init(FAR struct focsil_f32_s *sil,
+                           FAR const struct focsil_cfg_s *cfg)
+{
+  struct foc_initdata_f32_s       ctrl_cfg;
+  struct foc_mod_cfg_f32_s        mod_cfg;
+  struct foc_model_pmsm_cfg_f32_s pmsm_cfg;
+  float                           vel_kp;
+  int                             ret;
+
+  memset(sil, 0, sizeof(*sil));
+  sil->per = 1.0f / cfg->freq;
+
+  ret = foc_handler_init_f32(&sil->handler,
+                             &g_foc_control_pi_f32,
+                             &g_foc_mod_svm3_f32);
+  if (ret < 0)
+    {
+      printf("ERROR: foc_handler_init_f32 failed %d\n", ret);
+      return ret;
+    }
+
+  /* Current loop tuned by pole-zero cancellation of the R-L plant */
+
+  ctrl_cfg.id_kp = FOCSIL_IND * FOCSIL_CURR_BW;
+  ctrl_cfg.id_ki = FOCSIL_RES * FOCSIL_CURR_BW * sil->per;
+  ctrl_cfg.iq_kp = ctrl_cfg.id_kp;
+  ctrl_cfg.iq_ki = ctrl_cfg.id_ki;
+
+  mod_cfg.pwm_duty_max = FOCSIL_DUTY_MAX;
+
+  foc_handler_cfg_f32(&sil->handler, &ctrl_cfg, &mod_cfg);
+
+  ret = foc_model_init_f32(&sil->model, &g_foc_model_pmsm_ops_f32);
+  if (ret < 0)
+    {
+      printf("ERROR: foc_model_init_f32 failed %d\n", ret);
+      foc_handler_deinit_f32(&sil->handler);
+      return ret;
+    }
+
+  pmsm_cfg.poles      = FOCSIL_POLES;
+  pmsm_cfg.res        = FOCSIL_RES;
+  pmsm_cfg.ind        = FOCSIL_IND;
+  pmsm_cfg.iner       = FOCSIL_INER;
+  pmsm_cfg.flux_link  = FOCSIL_FLUX;
+  pmsm_cfg.ind_d      = FOCSIL_IND;
+  pmsm_cfg.ind_q      = FOCSIL_IND;
+  pmsm_cfg.per        = sil->per;
+  pmsm_cfg.iphase_adc = FOCSIL_IPHASE_ADC;
+
+  foc_model_cfg_f32(&sil->model, &pmsm_cfg);
+
+  /* Velocity loop runs every 'velpre' control periods */
+
+  vel_kp = FOCSIL_INER * FOCSIL_VEL_BW / FOCSIL_KT;
+  pi_controller_init(&sil->vel_pi, vel_kp,
+                     vel_kp * FOCSIL_VEL_BW / 5.0f * sil->per * cfg->velpre);
+  pi_saturation_set(&sil->vel_pi, -FOCSIL_IQ_MAX, FOCSIL_IQ_MAX);
+  pi_antiwindup_enable(&sil->vel_pi, 0.99f, true);
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: focsil_f32_deinit
+ ****************************************************************************/
+
+static void focsil_f32_deinit(FAR struct focsil_f32_s *sil)
+{
+  foc_model_deinit_f32(&sil->model);
+  foc_handler_deinit_f32(&sil->handler);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: focsil_run_f32
+ *
+ * Description:
+ *   Run the closed-loop profile with the float32 controller
+ *
+ ****************************************************************************/
+
+int focsil_run_f32(FAR const struct focsil_cfg_s *cfg,
+                   FAR struct focsil_result_s *res)
+{
+  struct focsil_f32_s             sil;
+  struct foc_handler_input_f32_s  input;
+  struct foc_handler_output_f32_s output;
+  struct focsil_pace_s            pace;
+  dq_frame_f32_t                  dq_ref;
+  dq_frame_f32_t                  vdq_comp;
+  uint32_t                        nsteps;
+  uint32_t                        settle;
+  uint32_t                        step;
+  float                           err;
+  int                             seg;
+  int                             ret;
+
+  ret = focsil_f32_init(&sil, cfg);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  dq_ref.d   = 0.0f;
+  dq_ref.q   = 0.0f;
+  vdq_comp.d = 0.0f;
+  vdq_comp.q = 0.0f;
+
+  input.current  = sil.model_state.curr;
+  input.dq_ref   = &dq_ref;
+  input.vdq_comp = &vdq_comp;
+  input.vbus     = FOCSIL_VBUS;
+  input.mode     = FOC_HANDLER_MODE_CURRENT;
+
+  settle = (uint32_t)(cfg->settle * cfg->freq);
+
+  if (cfg->realtime)
+    {
+      focsil_pace_init(&pace, cfg->freq);
+    }
+
+  for (seg = 0; seg < cfg->nseg; seg++)
+    {
+      nsteps = (uint32_t)(cfg->prof[seg].time * cfg->freq);
+
+      for (step = 0; step < nsteps; step++)
+        {
+          /* Sample the plant */
+
+          foc_model_state_f32(&sil.model, &sil.model_state);
+
+          /* The model does not export its rotor angle, so track it the
+           * same way a perfect encoder would.
+           */
+
+          sil.angle += sil.model_state.omega_e * sil.per;
+          angle_norm_2pi(&sil.angle, 0.0f, MOTOR_ANGLE_E_MAX);
+
+          /* Velocity controller */
+
+          if (res->iter % cfg->velpre == 0)
+            {
+              err      = cfg->prof[seg].vel - sil.model_state.omega_m;
+              dq_ref.q = pi_controller(&sil.vel_pi, err);
+
+              focsil_err_put(res, err, step >= settle);
+            }
+
+          /* Current controller and modulation */
+
+          input.angle = sil.angle;
+
+          ret = foc_handler_run_f32(&sil.handler, &input, &output);
+          if (ret < 0)
+            {
+              goto errout;
+            }
+
+          foc_handler_state_f32(&sil.handler, &sil.foc_state, NULL);
+
+          /* Apply the modulated voltage to the plant */
+
+          foc_model_run_f32(&sil.model, cfg->prof[seg].load,
+                            &sil.foc_state.vab);
+
+          res->iter += 1;
+
+          if (cfg->realtime)
+            {
+              focsil_pace_wait(&pace, res);
+            }
+        }
+    }
+
+  res->vel_end = sil.model_state.omega_m;
+
+errout:
+  focsil_f32_deinit(&sil);
+  return ret;
+}
@@ -0,0 +1,465 @@
+/****************************************************************************
+ * apps/benchmarks/focsil/focsil_main.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "focsil.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define FOCSIL_SEG_MAX       32
+#define FOCSIL_SETTLE_DEF    (0.1f)
+#define NSEC_PER_SEC         1000000000ll
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct focsil_prof_s
+{
+  FAR const char                *name;
+  FAR const struct focsil_seg_s *seg;
+  int                            nseg;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Velocity steps with reversal at no load */
+
+static const struct focsil_seg_s g_prof_vel[] =
+{
+  {0.5f,  50.0f, 0.0f},
+  {0.5f, 120.0f, 0.0f},
+  {0.5f,  80.0f, 0.0f},
+  {0.5f, -80.0f, 0.0f},
+  {0.5f,   0.0f, 0.0f},
+};
+
+/* Load torque steps at constant velocity */
+
+static const struct focsil_seg_s g_prof_load[] =
+{
+  {0.5f, 80.0f, 0.0f},
+  {0.5f, 80.0f, 0.1f},
+  {0.5f, 80.0f, 0.05f},
+  {0.5f, 80.0f, 0.2f},
+  {0.5f, 80.0f, 0.0f},
+};
+
+static const struct focsil_prof_s g_prof[] =
+{
+  {"vel",  g_prof_vel,  sizeof(g_prof_vel) / sizeof(g_prof_vel[0])},
+  {"load", g_prof_load, sizeof(g_prof_load) / sizeof(g_prof_load[0])},
+};
+
+#define FOCSIL_PROF_NUM (sizeof(g_prof) / sizeof(g_prof[0]))
+
+/* Segments loaded from file */
+
+static struct focsil_seg_s g_prof_file[FOCSIL_SEG_MAX];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: focsil_help
+ ****************************************************************************/
+
+static void focsil_help(FAR const char *progname)
+{
+  int i;
+
+  printf("Usage: %s [options]\n", progname);
+  printf("  [-t type] controller type: f=float, b=fixed16, a=all "
+         "(default: a)\n");
+  printf("  [-f freq] control loop frequency [Hz] (default: %d)\n",
+         CONFIG_BENCHMARK_FOCSIL_FREQ);
+  printf("  [-v pre] velocity loop prescaler (default: %d)\n",
+         CONFIG_BENCHMARK_FOCSIL_VEL_PRESCALER);
+  printf("  [-p name] built-in profile:");
+  for (i = 0; i < FOCSIL_PROF_NUM; i++)
+    {
+      printf(" %s", g_prof[i].name);
+    }
+
+  printf(" (default: %s)\n", g_prof[0].name);
+  printf("  [-P file] profile file, one \"time vel load\" "
+         "segment per line\n");
+  printf("  [-s sec] settle time excluded from steady-state error "
+         "(default: %.2f)\n", FOCSIL_SETTLE_DEF);
+  printf("  [-r] pace the loop in real time and count missed "
+         "deadlines\n");
+  printf("  [-h] show this help\n");
+}
+
+/****************************************************************************
+ * Name: focsil_prof_load
+ ****************************************************************************/
+
+static int focsil_prof_load(FAR const char *path)
+{
+  FAR FILE *fp;
+  char      line[80];
+  int       nseg = 0;
+
+  fp = fopen(path, "r");
+  if (fp == NULL)
+    {
+      printf("ERROR: failed to open %s: %d\n", path, errno);
+      return -errno;
+    }
+
+  while (fgets(line, sizeof(line), fp) != NULL)
+    {
+      FAR struct focsil_seg_s *seg = &g_prof_file[nseg];
+
+      if (line[0] == '#' || line[0] == '\n')
+        {
+          continue;
+        }
+
+      if (nseg >= FOCSIL_SEG_MAX)
+        {
+          printf("WARNING: only %d segments used\n", FOCSIL_SEG_MAX);
+          break;
+        }
+
+      if (sscanf(line, "%f %f %f", &seg->time, &seg->vel, &seg->load) != 3
+          || seg->time <= 0.0f)
+        {
+          printf("ERROR: bad segment: %s", line);
+          fclose(fp);
+          return -EINVAL;
+        }
+
+      nseg++;
+    }
+
+  fclose(fp);
+  return nseg;
+}
+
+/****************************************************************************
+ * Name: focsil_report
+ ****************************************************************************/
+
+static void focsil_report(FAR const char *name,
+                          FAR const struct focsil_cfg_s *cfg,
+                          FAR const struct focsil_result_s *res,
+                          uint64_t nsec)
+{
+  double sec = (double)nsec / NSEC_PER_SEC;
+
+  printf("%s:\n", name);
+  printf("  iterations:     %" PRIu32 "\n", res->iter);
+  printf("  wall time:      %.3f s\n", sec);
+
+  if (res->iter > 0 && nsec > 0)
+    {
+      printf("  iter/sec:       %.0f\n", res->iter / sec);
+      printf("  ns/iter:        %.1f\n", (double)nsec / res->iter);
+    }
+
+  if (cfg->realtime)
+    {
+      printf("  missed:         %" PRIu32 "\n", res->missed);
+    }
+
+  if (res->err_cnt > 0)
+    {
+      printf("  vel err rms:    %.4f rad/s\n",
+             sqrt(res->err_sq / res->err_cnt));
+    }
+
+  if (res->ss_cnt > 0)
+    {
+      printf("  ss err rms:     %.4f rad/s\n",
+             sqrt(res->ss_sq / res->ss_cnt));
+      printf("  ss err max:     %.4f rad/s\n", res->ss_max);
+    }
+
+  printf("  final vel:      %.3f rad/s\n", res->vel_end);
+}
+
+/****************************************************************************
+ * Name: focsil_exec
+ ****************************************************************************/
+
+static int focsil_exec(FAR const char *name,
+                       CODE int (*run)(FAR const struct focsil_cfg_s *,
+                                       FAR struct focsil_result_s *),
+                       FAR const struct focsil_cfg_s *cfg)
+{
+  struct focsil_result_s res;
+  struct timespec        start;
+  struct timespec        end;
+  uint64_t               nsec;
+  int                    ret;
+
+  memset(&res, 0, sizeof(res));
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  ret = run(cfg, &res);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  if (ret < 0)
+    {
+      printf("ERROR: %s run failed %d\n", name, ret);
+      return ret;
+    }
+
+  nsec = (uint64_t)(end.tv_sec - start.tv_sec) * NSEC_PER_SEC +
+         end.tv_nsec - start.tv_nsec;
+
+  focsil_report(name, cfg, &res, nsec);
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: focsil_pace_init
+ ****************************************************************************/
+
+void focsil_pace_init(FAR struct focsil_pace_s *pace, uint32_t freq)
+{
+  pace->per_ns = NSEC_PER_SEC / freq;
+  clock_gettime(CLOCK_MONOTONIC, &pace->next);
+}
+
+/****************************************************************************
+ * Name: focsil_pace_wait
+ *
+ * Description:
+ *   Sleep until the next control period.  If the deadline has already
+ *   passed, count it as missed and restart the schedule from now so one
+ *   long iteration is not reported as a burst of misses.
+ *
+ ****************************************************************************/
+
+void focsil_pace_wait(FAR struct focsil_pace_s *pace,
+                      FAR struct focsil_result_s *res)
+{
+  struct timespec now;
+
+  pace->next.tv_nsec += pace->per_ns;
+  if (pace->next.tv_nsec >= NSEC_PER_SEC)
+    {
+      pace->next.tv_nsec -= NSEC_PER_SEC;
+      pace->next.tv_sec  += 1;
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  if (now.tv_sec > pace->next.tv_sec ||
+      (now.tv_sec == pace->next.tv_sec &&
+       now.tv_nsec > pace->next.tv_nsec))
+    {
+      res->missed += 1;
+      pace->next   = now;
+      return;
+    }
+
+  clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &pace->next, NULL);
+}
+
+/****************************************************************************
+ * Name: focsil_err_put
+ ****************************************************************************/
+
+void focsil_err_put(FAR struct focsil_result_s *res, float err,
+                    bool settled)
+{
+  res->err_sq  += (double)err * err;
+  res->err_cnt += 1;
+
+  if (settled)
+    {
+      res->ss_sq  += (double)err * err;
+      res->ss_cnt += 1;
+
+      err = fabsf(err);
+      if (err > res->ss_max)
+        {
+          res->ss_max = err;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct focsil_cfg_s cfg;
+  FAR const char     *file = NULL;
+  char                type = 'a';
+  int                 prof = 0;
+  int                 ret  = OK;
+  int                 opt;
+  int                 i;
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.freq   = CONFIG_BENCHMARK_FOCSIL_FREQ;
+  cfg.velpre = CONFIG_BENCHMARK_FOCSIL_VEL_PRESCALER;
+  cfg.settle = FOCSIL_SETTLE_DEF;
+
+  while ((opt = getopt(argc, argv, "t:f:v:p:P:s:rh")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 't':
+            type = optarg[0];
+            break;
+
+          case 'f':
+            cfg.freq = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'v':
+            cfg.velpre = atoi(optarg);
+            break;
+
+          case 'p':
+            for (prof = 0; prof < FOCSIL_PROF_NUM; prof++)
+              {
+                if (strcmp(optarg, g_prof[prof].name) == 0)
+                  {
+                    break;
+                  }
+              }
+
+            if (prof == FOCSIL_PROF_NUM)
+              {
+                printf("ERROR: unknown profile %s\n", optarg);
+                return EXIT_FAILURE;
+              }
+            break;
+
+          case 'P':
+            file = optarg;
+            break;
+
+          case 's':
+            cfg.settle = strtof(optarg, NULL);
+            break;
+
+          case 'r':
+            cfg.realtime = true;
+            break;
+
+          case 'h':
+          default:
+            focsil_help(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+  if (cfg.freq == 0 || cfg.velpre <= 0)
+    {
+      printf("ERROR: invalid frequency or prescaler\n");
+      return EXIT_FAILURE;
+    }
+
+  if (file != NULL)
+    {
+      ret = focsil_prof_load(file);
+      if (ret <= 0)
+        {
+          printf("ERROR: no segments in %s\n", file);
+          return EXIT_FAILURE;
+        }
+
+      cfg.prof = g_prof_file;
+      cfg.nseg = ret;
+    }
+  else
+    {
+      cfg.prof = g_prof[prof].seg;
+      cfg.nseg = g_prof[prof].nseg;
+    }
+
+  printf("focsil: freq=%" PRIu32 " Hz velpre=%d profile=%s%s\n",
+         cfg.freq, cfg.velpre, file ? file : g_prof[prof].name,
+         cfg.realtime ? " realtime" : "");
+
+  for (i = 0; i < cfg.nseg; i++)
+    {
+      printf("  seg %d: %.3f s vel=%.1f rad/s load=%.3f Nm\n", i,
+             cfg.prof[i].time, cfg.prof[i].vel, cfg.prof[i].load);
+    }
+
+  ret = -ENOSYS;
+
+#ifdef CONFIG_INDUSTRY_FOC_FLOAT
+  if (type == 'f' || type == 'a')
+    {
+      ret = focsil_exec("float", focsil_run_f32, &cfg);
+      if (ret < 0)
+        {
+          return EXIT_FAILURE;
+        }
+    }
+#endif
+
+#ifdef CONFIG_INDUSTRY_FOC_FIXED16
+  if (type == 'b' || type == 'a')
+    {
+      ret = focsil_exec("fixed16", focsil_run_b16, &cfg);
+      if (ret < 0)
+        {
+          return EXIT_FAILURE;
+        }
+    }
+#endif
+
+  if (ret == -ENOSYS)
+    {
+      printf("ERROR: controller type '%c' not available\n", type);
+      return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,486 @@
+/****************************************************************************
+ * apps/benchmarks/luabench/luabench_main.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/boardctl.h>
+#include <sys/mount.h>
+#include <sys/param.h>
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <lua.h>
+#include <lualib.h>
+#include <lauxlib.h>
+
+#include "luabench_romfs.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define LUABENCH_SECTORSIZE  512
+#define LUABENCH_NSECTORS(b) (((b) + LUABENCH_SECTORSIZE - 1) / \
+                              LUABENCH_SECTORSIZE)
+#define LUABENCH_PATHSIZE    64
+#define LUABENCH_BOOT        "boot.lua"
+
+#define LUABENCH_SRC         CONFIG_BENCHMARK_LUABENCH_MOUNTPT "/src"
+#define LUABENCH_BIN         CONFIG_BENCHMARK_LUABENCH_MOUNTPT "/bin"
+
+#ifdef CONFIG_INTERPRETER_LUA_LAZYLOAD
+#  define LUABENCH_LIBMODE   "lazy"
+#else
+#  define LUABENCH_LIBMODE   "eager"
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct luabench_stat_s
+{
+  uint64_t min;
+  uint64_t sum;
+  int count;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static FAR const char *g_scripts[] =
+{
+  "util.lua",
+  "config.lua",
+  "boot.lua"
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: luabench_now
+ ****************************************************************************/
+
+static uint64_t luabench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/****************************************************************************
+ * Name: luabench_add
+ ****************************************************************************/
+
+static void luabench_add(FAR struct luabench_stat_s *st, uint64_t us)
+{
+  if (st->count == 0 || us < st->min)
+    {
+      st->min = us;
+    }
+
+  st->sum += us;
+  st->count++;
+}
+
+/****************************************************************************
+ * Name: luabench_avg
+ ****************************************************************************/
+
+static uint64_t luabench_avg(FAR const struct luabench_stat_s *st)
+{
+  return st->count ? st->sum / st->count : 0;
+}
+
+/****************************************************************************
+ * Name: luabench_mount
+ *
+ * Description:
+ *   Register the ROM disk and mount the script image, unless a previous
+ *   run already did.
+ *
+ ****************************************************************************/
+
+static int luabench_mount(void)
+{
+  struct boardioc_romdisk_s desc;
+  char devpath[16];
+  struct stat st;
+  int ret;
+
+  if (stat(LUABENCH_SRC, &st) == 0)
+    {
+      return 0;
+    }
+
+  desc.minor    = CONFIG_BENCHMARK_LUABENCH_DEVMINOR;
+  desc.nsectors = LUABENCH_NSECTORS(luabench_romfs_img_len);
+  desc.sectsize = LUABENCH_SECTORSIZE;
+  desc.image    = (FAR uint8_t *)luabench_romfs_img;
+
+  ret = boardctl(BOARDIOC_ROMDISK, (uintptr_t)&desc);
+  if (ret < 0 && errno != EEXIST)
+    {
+      printf("ERROR: romdisk registration failed: %d\n", errno);
+      return -errno;
+    }
+
+  snprintf(devpath, sizeof(devpath), "/dev/ram%d",
+           CONFIG_BENCHMARK_LUABENCH_DEVMINOR);
+  ret = mount(devpath, CONFIG_BENCHMARK_LUABENCH_MOUNTPT, "romfs",
+              MS_RDONLY, NULL);
+  if (ret < 0)
+    {
+      printf("ERROR: mount %s at %s failed: %d\n", devpath,
+             CONFIG_BENCHMARK_LUABENCH_MOUNTPT, errno);
+      return -errno;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: luabench_newstate
+ *
+ * Description:
+ *   Create a state the way the lua program does and point require() at
+ *   the given script directory.
+ *
+ ****************************************************************************/
+
+static FAR lua_State *luabench_newstate(FAR const char *dir)
+{
+  FAR lua_State *L;
+
+  L = luaL_newstate();
+  if (L == NULL)
+    {
+      return NULL;
+    }
+
+  luaL_openlibs(L);
+
+  if (dir != NULL)
+    {
+      lua_getglobal(L, LUA_LOADLIBNAME);
+      lua_pushfstring(L, "%s/?.lua", dir);
+      lua_setfield(L, -2, "path");
+      lua_pop(L, 1);
+    }
+
+  return L;
+}
+
+/****************************************************************************
+ * Name: luabench_state
+ *
+ * Description:
+ *   Cost of creating and closing a bare state with all libraries
+ *   registered, and the memory it holds.
+ *
+ ****************************************************************************/
+
+static int luabench_state(int rounds)
+{
+  struct luabench_stat_s st;
+  FAR lua_State *L;
+  uint64_t start;
+  int kbytes = 0;
+  int i;
+
+  memset(&st, 0, sizeof(st));
+
+  for (i = 0; i < rounds; i++)
+    {
+      start = luabench_now();
+      L = luabench_newstate(NULL);
+      if (L == NULL)
+        {
+          printf("ERROR: luaL_newstate failed\n");
+          return -ENOMEM;
+        }
+
+      luabench_add(&st, luabench_now() - start);
+      kbytes = lua_gc(L, LUA_GCCOUNT, 0);
+      lua_close(L);
+    }
+
+  printf("state (%s libs)   min %6" PRIu64 " us  avg %6" PRIu64
+         " us  heap %d KiB\n", LUABENCH_LIBMODE, st.min,
+         luabench_avg(&st), kbytes);
+  return 0;
+}
+
+/****************************************************************************
+ * Name: luabench_loadone
+ *
+ * Description:
+ *   Time luaL_loadfile() of one script, i.e. reading plus either parsing
+ *   and code generation or undumping.
+ *
+ ****************************************************************************/
+
+static int luabench_loadone(FAR lua_State *L, FAR const char *path,
+                            int rounds, FAR struct luabench_stat_s *st)
+{
+  uint64_t start;
+  int ret;
+  int i;
+
+  memset(st, 0, sizeof(*st));
+
+  for (i = 0; i < rounds; i++)
+    {
+      start = luabench_now();
+      ret = luaL_loadfile(L, path);
+      luabench_add(st, luabench_now() - start);
+      if (ret != LUA_OK)
+        {
+          printf("ERROR: %s\n", lua_tostring(L, -1));
+          lua_pop(L, 1);
+          return -EINVAL;
+        }
+
+      lua_pop(L, 1);
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: luabench_load
+ ****************************************************************************/
+
+static int luabench_load(int rounds)
+{
+  struct luabench_stat_s src;
+  struct luabench_stat_s bin;
+  char path[LUABENCH_PATHSIZE];
+  struct stat srcst;
+  struct stat binst;
+  FAR lua_State *L;
+  int ret = 0;
+  int i;
+
+  L = luabench_newstate(NULL);
+  if (L == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  printf("%-12s %14s %14s %12s\n", "load", "source", "luac", "size");
+
+  for (i = 0; i < nitems(g_scripts); i++)
+    {
+      snprintf(path, sizeof(path), "%s/%s", LUABENCH_SRC, g_scripts[i]);
+      stat(path, &srcst);
+      ret = luabench_loadone(L, path, rounds, &src);
+      if (ret < 0)
+        {
+          break;
+        }
+
+      snprintf(path, sizeof(path), "%s/%s", LUABENCH_BIN, g_scripts[i]);
+      stat(path, &binst);
+      ret = luabench_loadone(L, path, rounds, &bin);
+      if (ret < 0)
+        {
+          break;
+        }
+
+      printf("%-12s %11" PRIu64 " us %11" PRIu64 " us %5ld/%-6ld\n",
+             g_scripts[i], luabench_avg(&src), luabench_avg(&bin),
+             (long)srcst.st_size, (long)binst.st_size);
+    }
+
+  lua_close(L);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: luabench_boot
+ *
+ * Description:
+ *   Complete boot: new state, run boot.lua which require()s the other
+ *   scripts, close.  Returns the checksum computed by the script.
+ *
+ ****************************************************************************/
+
+static int luabench_boot(FAR const char *dir, int rounds,
+                         FAR struct luabench_stat_s *st,
+                         FAR uint32_t *check)
+{
+  char path[LUABENCH_PATHSIZE];
+  FAR lua_State *L;
+  uint64_t start;
+  int ret;
+  int i;
+
+  memset(st, 0, sizeof(*st));
+  snprintf(path, sizeof(path), "%s/%s", dir, LUABENCH_BOOT);
+
+  for (i = 0; i < rounds; i++)
+    {
+      start = luabench_now();
+      L = luabench_newstate(dir);
+      if (L == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      ret = luaL_loadfile(L, path);
+      if (ret == LUA_OK)
+        {
+          ret = lua_pcall(L, 0, 1, 0);
+        }
+
+      if (ret != LUA_OK)
+        {
+          printf("ERROR: %s\n", lua_tostring(L, -1));
+          lua_close(L);
+          return -EINVAL;
+        }
+
+      *check = (uint32_t)lua_tointeger(L, -1);
+      lua_close(L);
+      luabench_add(st, luabench_now() - start);
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname, int exitcode)
+{
+  printf("Usage: %s [-n rounds]\n", progname);
+  printf("  -n  Rounds per measurement (default %d)\n",
+         CONFIG_BENCHMARK_LUABENCH_ROUNDS);
+  exit(exitcode);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct luabench_stat_s src;
+  struct luabench_stat_s bin;
+  uint32_t srccheck = 0;
+  uint32_t bincheck = 0;
+  int rounds = CONFIG_BENCHMARK_LUABENCH_ROUNDS;
+  int ret;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:h")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'n':
+            rounds = atoi(optarg);
+            break;
+
+          case 'h':
+            show_usage(argv[0], EXIT_SUCCESS);
+            break;
+
+          default:
+            show_usage(argv[0], EXIT_FAILURE);
+            break;
+        }
+    }
+
+  if (rounds <= 0)
+    {
+      show_usage(argv[0], EXIT_FAILURE);
+    }
+
+  ret = luabench_mount();
+  if (ret < 0)
+    {
+      return EXIT_FAILURE;
+    }
+
+  printf("%s, %d rounds, scripts in %s\n", LUA_RELEASE, rounds,
+         CONFIG_BENCHMARK_LUABENCH_MOUNTPT);
+
+  ret = luabench_state(rounds);
+  if (ret < 0)
+    {
+      return EXIT_FAILURE;
+    }
+
+  ret = luabench_load(rounds);
+  if (ret < 0)
+    {
+      return EXIT_FAILURE;
+    }
+
+  ret = luabench_boot(LUABENCH_SRC, rounds, &src, &srccheck);
+  if (ret >= 0)
+    {
+      ret = luabench_boot(LUABENCH_BIN, rounds, &bin, &bincheck);
+    }
+
+  if (ret < 0)
+    {
+      return EXIT_FAILURE;
+    }
+
+  printf("boot source  min %6" PRIu64 " us  avg %6" PRIu64
+         " us  check %08" PRIx32 "\n", src.min, luabench_avg(&src),
+         srccheck);
+  printf("boot luac    min %6" PRIu64 " us  avg %6" PRIu64
+         " us  check %08" PRIx32 "\n", bin.min, luabench_avg(&bin),
+         bincheck);
+
+  if (srccheck != bincheck)
+    {
+      printf("ERROR: source and precompiled boot differ\n");
+      return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+-- Simulated boot script: load the configuration, set up a service table
+-- and a small state machine, and return a checksum of what was built so
+-- that the benchmark can check that every variant did the same work.
+
+local util = require("util")
+local config = require("config")
+
+-- Method syntax on strings goes through the string metatable.  Use it
+-- before anything names the string global, so that a state that opens
+-- libraries lazily is caught if it forgets that metatable.
+
+local banner = ("boot"):upper() .. ("-"):rep(3) .. ("%03d"):format(7)
+
+local cfg = config.load()
+
+local services = {}
+local order = {}
+
+local function service(name, deps, rate)
+  services[name] = {
+    name = name,
+    deps = deps or {},
+    rate = tonumber(rate) or 0,
+    state = "stopped",
+  }
+end
+
+service("syslog")
+service("net", { "syslog" })
+service("shell", { "syslog" })
+service("sensors", { "syslog" }, cfg.app["sensors.rate"])
+service("telemetry", { "net", "sensors" })
+
+-- Start the services in dependency order
+
+local function start(name, depth)
+  local s = services[name]
+  if not s or s.state == "running" then
+    return
+  end
+  assert(depth < 8, "dependency loop at " .. name)
+  for _, dep in ipairs(s.deps) do
+    start(dep, depth + 1)
+  end
+  s.state = "running"
+  order[#order + 1] = name
+end
+
+for _, name in ipairs(cfg.app.autostart) do
+  start(name, 0)
+end
+
+-- Log level state machine
+
+local levels = { "error", "warn", "info", "debug" }
+local levelnum = {}
+for i, l in ipairs(levels) do
+  levelnum[l] = i
+end
+
+local transitions = 0
+local level = levelnum[cfg.log.level] or 3
+for i = 1, 64 do
+  local nxt = (level + i) % #levels + 1
+  if nxt ~= level then
+    transitions = transitions + 1
+    level = nxt
+  end
+end
+
+-- Summary and checksum
+
+local summary = string.format("%s %s %d services (%s) mtu=%s",
+                              cfg.net.hostname, cfg.net.ipaddr, #order,
+                              table.concat(order, ","), cfg.net.mtu)
+
+local h = util.hash(summary)
+h = util.hash(banner, h)
+h = util.hash(util.serialize(cfg), h)
+h = (h + transitions) % 4294967296
+
+return h
@@ -0,0 +1,70 @@
+-- Parse an ini style configuration, as a boot script would do with the
+-- files found in /etc
+
+local util = require("util")
+
+local config = {}
+
+local defaults = {
+  net = { hostname = "nuttx", dhcp = "yes", mtu = "1500" },
+  log = { level = "info", target = "syslog" },
+  app = { autostart = "shell", watchdog = "30" },
+}
+
+local text = [[
+# system configuration
+[net]
+hostname = sim-board
+ipaddr   = 10.0.0.2
+netmask  = 255.255.255.0
+gateway  = 10.0.0.1
+dns      = 10.0.0.1, 8.8.8.8
+
+[log]
+level  = debug
+target = syslog, file
+file   = /tmp/boot.log
+
+[app]
+autostart = sensors, telemetry, shell
+watchdog  = 10
+sensors.rate     = 50
+sensors.channels = accel, gyro, mag, baro
+telemetry.link   = udp://10.0.0.1:14550
+]]
+
+function config.parse(s)
+  local out = {}
+  local section = out
+  for raw in string.gmatch(s, "[^\n]+") do
+    local line = util.trim(raw)
+    if line ~= "" and string.sub(line, 1, 1) ~= "#" then
+      local name = string.match(line, "^%[(.+)%]$")
+      if name then
+        out[name] = out[name] or {}
+        section = out[name]
+      else
+        local key, value = string.match(line, "^([%w%._]+)%s*=%s*(.*)$")
+        if key then
+          if string.find(value, ",", 1, true) then
+            local list = {}
+            for _, item in ipairs(util.split(value, ",")) do
+              list[#list + 1] = util.trim(item)
+            end
+            value = list
+          end
+          section[key] = value
+        end
+      end
+    end
+  end
+  return out
+end
+
+function config.load()
+  local parsed = config.parse(text)
+  local result = util.merge({}, defaults)
+  return util.merge(result, parsed)
+end
+
+return config
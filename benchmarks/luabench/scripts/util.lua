@@ -0,0 +1,66 @@
+-- Helpers shared by the luabench boot scripts
+
+local util = {}
+
+function util.split(s, sep)
+  local out = {}
+  local pattern = "([^" .. sep .. "]*)"
+  for item in string.gmatch(s, pattern) do
+    if item ~= "" then
+      out[#out + 1] = item
+    end
+  end
+  return out
+end
+
+function util.trim(s)
+  return (string.gsub(s, "^%s*(.-)%s*$", "%1"))
+end
+
+function util.keys(t)
+  local out = {}
+  for k in pairs(t) do
+    out[#out + 1] = k
+  end
+  table.sort(out)
+  return out
+end
+
+function util.merge(dst, src)
+  for k, v in pairs(src) do
+    if type(v) == "table" and type(dst[k]) == "table" then
+      util.merge(dst[k], v)
+    else
+      dst[k] = v
+    end
+  end
+  return dst
+end
+
+function util.hash(s, h)
+  h = h or 5381
+  for i = 1, #s do
+    h = (h * 33 + string.byte(s, i)) % 4294967296
+  end
+  return h
+end
+
+function util.serialize(v, indent)
+  indent = indent or ""
+  if type(v) ~= "table" then
+    if type(v) == "string" then
+      return string.format("%q", v)
+    end
+    return tostring(v)
+  end
+
+  local lines = { "{" }
+  for _, k in ipairs(util.keys(v)) do
+    lines[#lines + 1] = string.format("%s  %s = %s,", indent, tostring(k),
+                                      util.serialize(v[k], indent .. "  "))
+  end
+  lines[#lines + 1] = indent .. "}"
+  return table.concat(lines, "\n")
+end
+
+return util
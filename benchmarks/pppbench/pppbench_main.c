@@ -0,0 +1,335 @@
+/****************************************************************************
+ * apps/benchmarks/pppbench/pppbench_main.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ppp.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Largest payload: the receive buffer also holds protocol and FCS */
+
+#define PPPBENCH_MAXSIZE    (PPP_RX_BUFFER_SIZE - 4)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct ppp_context_s g_tx;
+static struct ppp_context_s g_rx;
+static uint8_t g_packet[PPPBENCH_MAXSIZE];
+static int g_count = 10000;
+static int g_size  = 1000;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: pppbench_now
+ ****************************************************************************/
+
+static uint64_t pppbench_now(clockid_t clockid)
+{
+  struct timespec ts;
+
+  if (clock_gettime(clockid, &ts) < 0)
+    {
+      return 0;
+    }
+
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: pppbench_writer
+ *
+ * Description:
+ *   Frame g_count copies of the test packet into the master side.
+ *
+ ****************************************************************************/
+
+static FAR void *pppbench_writer(FAR void *arg)
+{
+  int i;
+
+  for (i = 0; i < g_count; i++)
+    {
+      /* Nobody answers on this link: keep ahdlc_tx() from deciding that
+       * the peer is gone and reconnecting.
+       */
+
+      g_tx.ahdlc_tx_offline = 0;
+      g_packet[0] = (uint8_t)i;
+      ahdlc_tx(&g_tx, IPV4, NULL, g_packet, 0, g_size);
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: pppbench_open
+ *
+ * Description:
+ *   Open a pseudo-terminal pair in raw mode.
+ *
+ ****************************************************************************/
+
+static int pppbench_open(FAR int *master, FAR int *slave)
+{
+#ifdef CONFIG_SERIAL_TERMIOS
+  struct termios tio;
+#endif
+
+  *master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (*master < 0)
+    {
+      return -errno;
+    }
+
+  if (grantpt(*master) < 0 || unlockpt(*master) < 0 ||
+      (*slave = open(ptsname(*master), O_RDWR | O_NOCTTY)) < 0)
+    {
+      int errcode = errno;
+      close(*master);
+      return -errcode;
+    }
+
+#ifdef CONFIG_SERIAL_TERMIOS
+  if (tcgetattr(*slave, &tio) == 0)
+    {
+      cfmakeraw(&tio);
+      tcsetattr(*slave, TCSANOW, &tio);
+    }
+#endif
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname, int exitcode)
+{
+  printf("Usage: %s [-n count] [-s size] [-b readsize] [-a]\n", progname);
+  printf("  -n  Frames to send (default 10000)\n");
+  printf("  -s  IPv4 payload bytes per frame, 1..%d (default 1000)\n",
+         PPPBENCH_MAXSIZE);
+  printf("  -b  Bytes per read() on the receive side, 1..%d (default %d)\n",
+         PPP_TTY_BUFFER_SIZE, PPP_TTY_BUFFER_SIZE);
+  printf("  -a  Payload without bytes needing escapes "
+         "(default: random data)\n");
+  exit(exitcode);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  pthread_t writer;
+  uint64_t wall;
+  uint64_t cpu;
+  uint64_t bytes;
+  uint32_t seed = 0x12345678;
+  bool ascii = false;
+  int readsize = PPP_TTY_BUFFER_SIZE;
+  int received = 0;
+  int badsize = 0;
+  int master;
+  int slave;
+  int opt;
+  int ret;
+  int i;
+
+  while ((opt = getopt(argc, argv, "n:s:b:ah")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'n':
+            g_count = atoi(optarg);
+            break;
+
+          case 's':
+            g_size = atoi(optarg);
+            break;
+
+          case 'b':
+            readsize = atoi(optarg);
+            break;
+
+          case 'a':
+            ascii = true;
+            break;
+
+          case 'h':
+            show_usage(argv[0], EXIT_SUCCESS);
+            break;
+
+          default:
+            show_usage(argv[0], EXIT_FAILURE);
+        }
+    }
+
+  if (g_count <= 0 || g_size <= 0 || g_size > PPPBENCH_MAXSIZE ||
+      readsize <= 0 || readsize > PPP_TTY_BUFFER_SIZE)
+    {
+      show_usage(argv[0], EXIT_FAILURE);
+    }
+
+  for (i = 0; i < g_size; i++)
+    {
+      seed ^= seed << 13;
+      seed ^= seed >> 17;
+      seed ^= seed << 5;
+      g_packet[i] = ascii ? 'A' + seed % 26 : (uint8_t)seed;
+    }
+
+  ret = pppbench_open(&master, &slave);
+  if (ret < 0)
+    {
+      fprintf(stderr, "ERROR: pseudo-terminal: %d\n", ret);
+      return EXIT_FAILURE;
+    }
+
+  ahdlc_init(&g_tx);
+  g_tx.ctl.fd = master;
+
+  ahdlc_init(&g_rx);
+  ahdlc_rx_ready(&g_rx);
+  g_rx.ppp_flags |= PPP_RX_READY;
+  g_rx.ctl.fd = slave;
+
+  printf("pppbench: %d frames of %d bytes, %d byte reads\n",
+         g_count, g_size, readsize);
+
+  wall = pppbench_now(CLOCK_MONOTONIC);
+  cpu  = pppbench_now(CLOCK_PROCESS_CPUTIME_ID);
+
+  ret = pthread_create(&writer, NULL, pppbench_writer, NULL);
+  if (ret != 0)
+    {
+      fprintf(stderr, "ERROR: pthread_create: %d\n", ret);
+      close(slave);
+      close(master);
+      return EXIT_FAILURE;
+    }
+
+  /* Receive the same way ppp_poll() does, one IP packet at a time.  The
+   * last frames may be lost to errors, so stop when the writer is done
+   * and nothing arrives for a second.
+   */
+
+  while (received + badsize < g_count)
+    {
+      g_rx.ip_len = 0;
+      if (g_rx.tty_rxpos >= g_rx.tty_rxlen)
+        {
+          struct pollfd pfd;
+
+          pfd.fd     = slave;
+          pfd.events = POLLIN;
+          if (poll(&pfd, 1, 1000) <= 0)
+            {
+              break;
+            }
+
+          ret = read(slave, g_rx.tty_rxbuf, readsize);
+          if (ret <= 0)
+            {
+              break;
+            }
+
+          g_rx.tty_rxpos = 0;
+          g_rx.tty_rxlen = ret;
+        }
+
+      g_rx.tty_rxpos += ahdlc_rx_block(&g_rx,
+                                       &g_rx.tty_rxbuf[g_rx.tty_rxpos],
+                                       g_rx.tty_rxlen - g_rx.tty_rxpos);
+
+      if (g_rx.ip_len > 0)
+        {
+          if (g_rx.ip_len == g_size &&
+              memcmp(&g_rx.ip_buf[1], &g_packet[1], g_size - 1) == 0)
+            {
+              received++;
+            }
+          else
+            {
+              badsize++;
+            }
+        }
+    }
+
+  pthread_join(writer, NULL);
+
+  cpu  = pppbench_now(CLOCK_PROCESS_CPUTIME_ID) - cpu;
+  wall = pppbench_now(CLOCK_MONOTONIC) - wall;
+  bytes = (uint64_t)received * g_size;
+
+  printf("  received  %d frames, %d bad, %u FCS errors\n",
+         received, badsize, g_rx.ahdlc_crc_error);
+  printf("  time      %" PRIu64 " us, %" PRIu64 " KB/s payload\n",
+         wall / 1000, wall > 0 ? bytes * 1000000000 / 1024 / wall : 0);
+
+  if (cpu > 0 && bytes > 0)
+    {
+      printf("  cpu       %" PRIu64 " us (%" PRIu64 "%% of wall), "
+             "%" PRIu64 " ns/byte\n", cpu / 1000,
+             cpu * 100 / wall, cpu / bytes);
+    }
+  else
+    {
+      printf("  cpu       not available\n");
+    }
+
+  close(slave);
+  close(master);
+  return received == g_count ? EXIT_SUCCESS : EXIT_FAILURE;
+}
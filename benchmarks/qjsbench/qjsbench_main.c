@@ -0,0 +1,506 @@
+/****************************************************************************
+ * apps/benchmarks/qjsbench/qjsbench_main.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <quickjs/quickjs.h>
+
+#include "qjsbench_script.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define QJSBENCH_FILENAME "ui.js"
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct qjsbench_stat_s
+{
+  uint64_t min;
+  uint64_t sum;
+  int count;
+};
+
+/* The script in both forms, as the interpreter would get it from a file
+ * or from a qjsc generated array.
+ */
+
+struct qjsbench_code_s
+{
+  FAR char *src;
+  size_t src_len;
+  FAR uint8_t *bc;
+  size_t bc_len;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: qjsbench_now
+ ****************************************************************************/
+
+static uint64_t qjsbench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/****************************************************************************
+ * Name: qjsbench_add
+ ****************************************************************************/
+
+static void qjsbench_add(FAR struct qjsbench_stat_s *st, uint64_t us)
+{
+  if (st->count == 0 || us < st->min)
+    {
+      st->min = us;
+    }
+
+  st->sum += us;
+  st->count++;
+}
+
+/****************************************************************************
+ * Name: qjsbench_avg
+ ****************************************************************************/
+
+static uint64_t qjsbench_avg(FAR const struct qjsbench_stat_s *st)
+{
+  return st->count ? st->sum / st->count : 0;
+}
+
+/****************************************************************************
+ * Name: qjsbench_error
+ ****************************************************************************/
+
+static void qjsbench_error(FAR JSContext *ctx)
+{
+  JSValue exc = JS_GetException(ctx);
+  FAR const char *str = JS_ToCString(ctx, exc);
+
+  printf("ERROR: %s\n", str ? str : "[exception]");
+  JS_FreeCString(ctx, str);
+  JS_FreeValue(ctx, exc);
+}
+
+/****************************************************************************
+ * Name: qjsbench_new
+ ****************************************************************************/
+
+static FAR JSContext *qjsbench_new(void)
+{
+  FAR JSRuntime *rt;
+  FAR JSContext *ctx;
+
+  rt = JS_NewRuntime();
+  if (rt == NULL)
+    {
+      return NULL;
+    }
+
+  ctx = JS_NewContext(rt);
+  if (ctx == NULL)
+    {
+      JS_FreeRuntime(rt);
+    }
+
+  return ctx;
+}
+
+/****************************************************************************
+ * Name: qjsbench_free
+ ****************************************************************************/
+
+static void qjsbench_free(FAR JSContext *ctx)
+{
+  FAR JSRuntime *rt = JS_GetRuntime(ctx);
+
+  JS_FreeContext(ctx);
+  JS_FreeRuntime(rt);
+}
+
+/****************************************************************************
+ * Name: qjsbench_compile
+ *
+ * Description:
+ *   Produce the bytecode once, in the format qjsc emits at build time.
+ *
+ ****************************************************************************/
+
+static int qjsbench_compile(FAR struct qjsbench_code_s *code)
+{
+  FAR JSContext *ctx;
+  FAR uint8_t *bc;
+  JSValue obj;
+  int ret = -ENOMEM;
+
+  code->src_len = ui_js_len;
+  code->src = malloc(ui_js_len + 1);
+  if (code->src == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  /* JS_Eval() wants a NUL terminated buffer */
+
+  memcpy(code->src, ui_js, ui_js_len);
+  code->src[ui_js_len] = '\0';
+
+  ctx = qjsbench_new();
+  if (ctx == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  obj = JS_Eval(ctx, code->src, code->src_len, QJSBENCH_FILENAME,
+                JS_EVAL_TYPE_GLOBAL | JS_EVAL_FLAG_COMPILE_ONLY);
+  if (JS_IsException(obj))
+    {
+      qjsbench_error(ctx);
+      ret = -EINVAL;
+      goto out;
+    }
+
+  bc = JS_WriteObject(ctx, &code->bc_len, obj, JS_WRITE_OBJ_BYTECODE);
+  JS_FreeValue(ctx, obj);
+  if (bc != NULL)
+    {
+      code->bc = malloc(code->bc_len);
+      if (code->bc != NULL)
+        {
+          memcpy(code->bc, bc, code->bc_len);
+          ret = 0;
+        }
+
+      js_free(ctx, bc);
+    }
+
+out:
+  qjsbench_free(ctx);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: qjsbench_run
+ *
+ * Description:
+ *   Evaluate the script in the context, from source or bytecode, and
+ *   return its checksum.
+ *
+ ****************************************************************************/
+
+static int qjsbench_run(FAR JSContext *ctx,
+                        FAR const struct qjsbench_code_s *code,
+                        bool bytecode, FAR uint32_t *check)
+{
+  JSValue val;
+  int64_t v;
+
+  if (bytecode)
+    {
+      val = JS_ReadObject(ctx, code->bc, code->bc_len,
+                          JS_READ_OBJ_BYTECODE);
+      if (!JS_IsException(val))
+        {
+          val = JS_EvalFunction(ctx, val);
+        }
+    }
+  else
+    {
+      val = JS_Eval(ctx, code->src, code->src_len, QJSBENCH_FILENAME,
+                    JS_EVAL_TYPE_GLOBAL);
+    }
+
+  if (JS_IsException(val) || JS_ToInt64(ctx, &v, val) < 0)
+    {
+      qjsbench_error(ctx);
+      JS_FreeValue(ctx, val);
+      return -EINVAL;
+    }
+
+  JS_FreeValue(ctx, val);
+  *check = (uint32_t)v;
+  return 0;
+}
+
+/****************************************************************************
+ * Name: qjsbench_setup
+ *
+ * Description:
+ *   Cost of creating and freeing an empty runtime and context, and the
+ *   heap they hold.
+ *
+ ****************************************************************************/
+
+static int qjsbench_setup(int rounds)
+{
+  struct qjsbench_stat_s st;
+  JSMemoryUsage mu;
+  FAR JSContext *ctx;
+  uint64_t start;
+  int i;
+
+  memset(&st, 0, sizeof(st));
+
+  for (i = 0; i < rounds; i++)
+    {
+      start = qjsbench_now();
+      ctx = qjsbench_new();
+      if (ctx == NULL)
+        {
+          printf("ERROR: cannot create runtime\n");
+          return -ENOMEM;
+        }
+
+      qjsbench_add(&st, qjsbench_now() - start);
+      JS_ComputeMemoryUsage(JS_GetRuntime(ctx), &mu);
+      qjsbench_free(ctx);
+    }
+
+  printf("runtime+context   min %6" PRIu64 " us  avg %6" PRIu64
+         " us  heap %" PRId64 " KiB\n", st.min, qjsbench_avg(&st),
+         mu.malloc_size / 1024);
+  return 0;
+}
+
+/****************************************************************************
+ * Name: qjsbench_cold
+ *
+ * Description:
+ *   One fresh runtime and context per run, as a plain qjs launch does.
+ *
+ ****************************************************************************/
+
+static int qjsbench_cold(FAR const struct qjsbench_code_s *code,
+                         bool bytecode, int rounds,
+                         FAR struct qjsbench_stat_s *st,
+                         FAR uint32_t *check)
+{
+  FAR JSContext *ctx;
+  uint64_t start;
+  int ret;
+  int i;
+
+  memset(st, 0, sizeof(*st));
+
+  for (i = 0; i < rounds; i++)
+    {
+      start = qjsbench_now();
+      ctx = qjsbench_new();
+      if (ctx == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      ret = qjsbench_run(ctx, code, bytecode, check);
+      qjsbench_free(ctx);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      qjsbench_add(st, qjsbench_now() - start);
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: qjsbench_warm
+ *
+ * Description:
+ *   One context reused for every run, as qjs --serve does.  The first run
+ *   is not counted.
+ *
+ ****************************************************************************/
+
+static int qjsbench_warm(FAR const struct qjsbench_code_s *code,
+                         bool bytecode, int rounds,
+                         FAR struct qjsbench_stat_s *st,
+                         FAR uint32_t *check, FAR int64_t *heap)
+{
+  JSMemoryUsage mu;
+  FAR JSContext *ctx;
+  uint64_t start;
+  int ret;
+  int i;
+
+  memset(st, 0, sizeof(*st));
+
+  ctx = qjsbench_new();
+  if (ctx == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  ret = qjsbench_run(ctx, code, bytecode, check);
+  for (i = 0; ret >= 0 && i < rounds; i++)
+    {
+      start = qjsbench_now();
+      ret = qjsbench_run(ctx, code, bytecode, check);
+      qjsbench_add(st, qjsbench_now() - start);
+    }
+
+  JS_RunGC(JS_GetRuntime(ctx));
+  JS_ComputeMemoryUsage(JS_GetRuntime(ctx), &mu);
+  *heap = mu.malloc_size;
+
+  qjsbench_free(ctx);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname, int exitcode)
+{
+  printf("Usage: %s [-n rounds]\n", progname);
+  printf("  -n  Rounds per measurement (default %d)\n",
+         CONFIG_BENCHMARK_QJSBENCH_ROUNDS);
+  exit(exitcode);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  static const FAR char *names[4] =
+  {
+    "cold source", "cold bytecode", "warm source", "warm bytecode"
+  };
+
+  struct qjsbench_code_s code;
+  struct qjsbench_stat_s st[4];
+  uint32_t check[4];
+  int64_t heap[4];
+  int rounds = CONFIG_BENCHMARK_QJSBENCH_ROUNDS;
+  int ret = 0;
+  int opt;
+  int i;
+
+  while ((opt = getopt(argc, argv, "n:h")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'n':
+            rounds = atoi(optarg);
+            break;
+
+          case 'h':
+            show_usage(argv[0], EXIT_SUCCESS);
+            break;
+
+          default:
+            show_usage(argv[0], EXIT_FAILURE);
+            break;
+        }
+    }
+
+  if (rounds <= 0)
+    {
+      show_usage(argv[0], EXIT_FAILURE);
+    }
+
+  memset(&code, 0, sizeof(code));
+  memset(heap, 0, sizeof(heap));
+
+  ret = qjsbench_compile(&code);
+  if (ret < 0)
+    {
+      printf("ERROR: cannot compile %s: %d\n", QJSBENCH_FILENAME, ret);
+      goto out;
+    }
+
+  printf("QuickJS, %d rounds, %s %zu bytes source, %zu bytes bytecode\n",
+         rounds, QJSBENCH_FILENAME, code.src_len, code.bc_len);
+
+  ret = qjsbench_setup(rounds);
+  for (i = 0; ret >= 0 && i < 4; i++)
+    {
+      if (i < 2)
+        {
+          ret = qjsbench_cold(&code, i & 1, rounds, &st[i], &check[i]);
+        }
+      else
+        {
+          ret = qjsbench_warm(&code, i & 1, rounds, &st[i], &check[i],
+                              &heap[i]);
+        }
+    }
+
+  if (ret < 0)
+    {
+      goto out;
+    }
+
+  for (i = 0; i < 4; i++)
+    {
+      printf("%-16s  min %6" PRIu64 " us  avg %6" PRIu64
+             " us  check %08" PRIx32, names[i], st[i].min,
+             qjsbench_avg(&st[i]), check[i]);
+      if (heap[i] != 0)
+        {
+          printf("  heap %" PRId64 " KiB", heap[i] / 1024);
+        }
+
+      printf("\n");
+
+      if (check[i] != check[0])
+        {
+          printf("ERROR: %s result differs\n", names[i]);
+          ret = -EINVAL;
+        }
+    }
+
+out:
+  free(code.src);
+  free(code.bc);
+  return ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+/* Typical small UI script: build a widget tree from a description,
+ * apply a theme, lay it out and hash the result.  The value of the last
+ * expression is the checksum reported by qjsbench.
+ */
+
+(function () {
+  "use strict";
+
+  var theme = {
+    padding: 4,
+    spacing: 2,
+    font: { size: 12, width: 7 },
+    colors: { fg: 0xffffff, bg: 0x202020, accent: 0x3080ff }
+  };
+
+  var screen = {
+    type: "column", children: [
+      { type: "label", text: "Settings" },
+      { type: "row", children: [
+        { type: "label", text: "Volume" },
+        { type: "slider", min: 0, max: 100, value: 42 }
+      ] },
+      { type: "row", children: [
+        { type: "label", text: "Brightness" },
+        { type: "slider", min: 0, max: 255, value: 200 }
+      ] },
+      { type: "list", items: ["Wi-Fi", "Bluetooth", "Display", "Sound",
+                              "Storage", "Battery", "About"] },
+      { type: "row", children: [
+        { type: "button", text: "Cancel" },
+        { type: "button", text: "OK", accent: true }
+      ] }
+    ]
+  };
+
+  function Widget(desc, parent) {
+    this.type = desc.type;
+    this.parent = parent;
+    this.x = 0;
+    this.y = 0;
+    this.w = 0;
+    this.h = 0;
+    this.text = desc.text || "";
+    this.children = [];
+    this.color = desc.accent ? theme.colors.accent : theme.colors.fg;
+    this.value = desc.value || 0;
+    this.range = desc.max ? desc.max - desc.min : 0;
+
+    var kids = desc.children || [];
+    if (desc.items) {
+      kids = desc.items.map(function (s) {
+        return { type: "label", text: s };
+      });
+    }
+
+    for (var i = 0; i < kids.length; i++) {
+      this.children.push(new Widget(kids[i], this));
+    }
+  }
+
+  Widget.prototype.measure = function () {
+    var p = theme.padding;
+    var s = theme.spacing;
+    var horiz = this.type === "row";
+    var w = 0;
+    var h = 0;
+
+    this.children.forEach(function (c) {
+      c.measure();
+      if (horiz) {
+        w += c.w + s;
+        h = Math.max(h, c.h);
+      } else {
+        w = Math.max(w, c.w);
+        h += c.h + s;
+      }
+    });
+
+    if (this.type === "slider") {
+      w = this.range + 2;
+      h = theme.font.size;
+    } else if (this.text) {
+      w = this.text.length * theme.font.width;
+      h = theme.font.size;
+    }
+
+    this.w = w + 2 * p;
+    this.h = h + 2 * p;
+  };
+
+  Widget.prototype.place = function (x, y) {
+    var horiz = this.type === "row";
+    var cx = x + theme.padding;
+    var cy = y + theme.padding;
+
+    this.x = x;
+    this.y = y;
+    for (var i = 0; i < this.children.length; i++) {
+      var c = this.children[i];
+      c.place(cx, cy);
+      if (horiz) {
+        cx += c.w + theme.spacing;
+      } else {
+        cy += c.h + theme.spacing;
+      }
+    }
+  };
+
+  Widget.prototype.hash = function (h) {
+    var fields = [this.x, this.y, this.w, this.h, this.color, this.value];
+
+    for (var i = 0; i < fields.length; i++) {
+      h = Math.imul(h ^ fields[i], 16777619) >>> 0;
+    }
+
+    for (i = 0; i < this.text.length; i++) {
+      h = Math.imul(h ^ this.text.charCodeAt(i), 16777619) >>> 0;
+    }
+
+    return this.children.reduce(function (acc, c) {
+      return c.hash(acc);
+    }, h);
+  };
+
+  var root = new Widget(screen, null);
+  root.measure();
+  root.place(0, 0);
+  return root.hash(2166136261);
+})();
@@ -0,0 +1,71 @@
+/****************************************************************************
+ * apps/benchmarks/wamrbench/wamrbench_kernel.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/* This file is only meant to be built as a Wasm module (see kernel/),
+ * wamrbench looks up and calls the exported wamrbench_run().
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "wamrbench_kernel.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wamrbench_run
+ ****************************************************************************/
+
+uint32_t wamrbench_run(uint32_t iterations)
+{
+  return wamrbench_workload(iterations);
+}
+
+/****************************************************************************
+ * Name: main
+ *
+ * Description:
+ *   Allow the module to be run stand-alone by iwasm as well.
+ *
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  uint32_t iterations = 1000;
+
+  if (argc > 1)
+    {
+      iterations = strtoul(argv[1], NULL, 0);
+    }
+
+  printf("wamrbench_kernel: %lu iterations, checksum 0x%08lx\n",
+         (unsigned long)iterations,
+         (unsigned long)wamrbench_run(iterations));
+  return 0;
+}
@@ -0,0 +1,195 @@
+/****************************************************************************
+ * apps/benchmarks/wamrbench/wamrbench_kernel.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_BENCHMARKS_WAMRBENCH_WAMRBENCH_KERNEL_H
+#define __APPS_BENCHMARKS_WAMRBENCH_WAMRBENCH_KERNEL_H
+
+/* The workload is shared by the Wasm module and the native reference run
+ * of wamrbench, so it only uses integer arithmetic and local storage and
+ * does not depend on any library function.
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdint.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define WAMRBENCH_BUFSIZE    256
+#define WAMRBENCH_MATSIZE    8
+#define WAMRBENCH_SORTSIZE   32
+
+/****************************************************************************
+ * Inline Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wamrbench_crc32
+ *
+ * Description:
+ *   Bitwise CRC-32, branchy byte loop.
+ *
+ ****************************************************************************/
+
+static inline uint32_t wamrbench_crc32(uint32_t crc, const uint8_t *buf,
+                                       int len)
+{
+  int i;
+  int j;
+
+  crc = ~crc;
+  for (i = 0; i < len; i++)
+    {
+      crc ^= buf[i];
+      for (j = 0; j < 8; j++)
+        {
+          crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+        }
+    }
+
+  return ~crc;
+}
+
+/****************************************************************************
+ * Name: wamrbench_matmul
+ *
+ * Description:
+ *   Integer matrix multiply, returns the sum of the product.
+ *
+ ****************************************************************************/
+
+static inline uint32_t
+wamrbench_matmul(const int32_t a[WAMRBENCH_MATSIZE][WAMRBENCH_MATSIZE],
+                 const int32_t b[WAMRBENCH_MATSIZE][WAMRBENCH_MATSIZE])
+{
+  uint32_t sum = 0;
+  int32_t acc;
+  int i;
+  int j;
+  int k;
+
+  for (i = 0; i < WAMRBENCH_MATSIZE; i++)
+    {
+      for (j = 0; j < WAMRBENCH_MATSIZE; j++)
+        {
+          acc = 0;
+          for (k = 0; k < WAMRBENCH_MATSIZE; k++)
+            {
+              acc += a[i][k] * b[k][j];
+            }
+
+          sum += (uint32_t)acc;
+        }
+    }
+
+  return sum;
+}
+
+/****************************************************************************
+ * Name: wamrbench_sort
+ *
+ * Description:
+ *   Insertion sort, returns a position weighted sum of the result.
+ *
+ ****************************************************************************/
+
+static inline uint32_t wamrbench_sort(uint32_t *v, int n)
+{
+  uint32_t sum = 0;
+  uint32_t tmp;
+  int i;
+  int j;
+
+  for (i = 1; i < n; i++)
+    {
+      tmp = v[i];
+      for (j = i; j > 0 && v[j - 1] > tmp; j--)
+        {
+          v[j] = v[j - 1];
+        }
+
+      v[j] = tmp;
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      sum += v[i] * (uint32_t)(i + 1);
+    }
+
+  return sum;
+}
+
+/****************************************************************************
+ * Name: wamrbench_workload
+ *
+ * Description:
+ *   Run the benchmark kernel 'iterations' times and return a checksum
+ *   that must be identical for every execution mode.
+ *
+ ****************************************************************************/
+
+static inline uint32_t wamrbench_workload(uint32_t iterations)
+{
+  int32_t a[WAMRBENCH_MATSIZE][WAMRBENCH_MATSIZE];
+  int32_t b[WAMRBENCH_MATSIZE][WAMRBENCH_MATSIZE];
+  uint32_t v[WAMRBENCH_SORTSIZE];
+  uint8_t buf[WAMRBENCH_BUFSIZE];
+  uint32_t seed = 0x12345678;
+  uint32_t check = 0;
+  uint32_t n;
+  int i;
+
+  for (n = 0; n < iterations; n++)
+    {
+      /* Refill the inputs from a LCG so that every iteration differs */
+
+      for (i = 0; i < WAMRBENCH_BUFSIZE; i++)
+        {
+          seed = seed * 1103515245 + 12345;
+          buf[i] = (uint8_t)(seed >> 16);
+        }
+
+      for (i = 0; i < WAMRBENCH_MATSIZE * WAMRBENCH_MATSIZE; i++)
+        {
+          a[i / WAMRBENCH_MATSIZE][i % WAMRBENCH_MATSIZE] = buf[i] - 128;
+          b[i / WAMRBENCH_MATSIZE][i % WAMRBENCH_MATSIZE] =
+            buf[i + 64] - 128;
+        }
+
+      for (i = 0; i < WAMRBENCH_SORTSIZE; i++)
+        {
+          v[i] = ((uint32_t)buf[128 + 4 * i] << 8) | buf[129 + 4 * i];
+        }
+
+      check = wamrbench_crc32(check, buf, WAMRBENCH_BUFSIZE);
+      check += wamrbench_matmul(a, b);
+      check ^= wamrbench_sort(v, WAMRBENCH_SORTSIZE);
+    }
+
+  return check;
+}
+
+#endif /* __APPS_BENCHMARKS_WAMRBENCH_WAMRBENCH_KERNEL_H */
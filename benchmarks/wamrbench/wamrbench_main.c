@@ -0,0 +1,653 @@
+/****************************************************************************
+ * apps/benchmarks/wamrbench/wamrbench_main.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "wasm_export.h"
+
+#include "wamrbench_kernel.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define WAMRBENCH_ENTRY     "wamrbench_run"
+#define WAMRBENCH_ERRSIZE   128
+#define WAMRBENCH_PATHSIZE  128
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+enum wamrbench_mode_e
+{
+  WAMRBENCH_MODE_AUTO = 0,    /* Prefer .aot, fall back to .wasm */
+  WAMRBENCH_MODE_INT,         /* .wasm only */
+  WAMRBENCH_MODE_AOT,         /* .aot only */
+  WAMRBENCH_MODE_BOTH         /* Both, plus a comparison */
+};
+
+struct wamrbench_inst_s
+{
+  FAR uint8_t *buf;
+  uint32_t size;
+  wasm_module_t module;
+  wasm_module_inst_t inst;
+  wasm_exec_env_t env;
+  wasm_function_inst_t func;
+};
+
+struct wamrbench_result_s
+{
+  bool valid;
+  uint32_t check;
+  uint64_t startup_min;       /* us, read + load + instantiate + 1st call */
+  uint64_t startup_avg;
+  uint64_t load_avg;          /* us, load + instantiate only */
+  uint64_t run;               /* us, steady state call */
+};
+
+struct wamrbench_s
+{
+  FAR const char *base;
+  enum wamrbench_mode_e mode;
+  uint32_t iterations;
+  int rounds;
+  uint32_t stacksize;
+  uint32_t heapsize;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: wamrbench_now
+ ****************************************************************************/
+
+static uint64_t wamrbench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/****************************************************************************
+ * Name: wamrbench_exists
+ ****************************************************************************/
+
+static bool wamrbench_exists(FAR const char *path)
+{
+  struct stat st;
+
+  return stat(path, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+/****************************************************************************
+ * Name: wamrbench_readfile
+ ****************************************************************************/
+
+static FAR uint8_t *wamrbench_readfile(FAR const char *path,
+                                       FAR uint32_t *size)
+{
+  FAR uint8_t *buf;
+  struct stat st;
+  ssize_t nread;
+  size_t total = 0;
+  int fd;
+
+  fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    {
+      return NULL;
+    }
+
+  if (fstat(fd, &st) < 0 || st.st_size <= 0)
+    {
+      errno = st.st_size <= 0 ? EINVAL : errno;
+      close(fd);
+      return NULL;
+    }
+
+  buf = malloc(st.st_size);
+  if (buf == NULL)
+    {
+      close(fd);
+      return NULL;
+    }
+
+  while ((off_t)total < st.st_size)
+    {
+      nread = read(fd, buf + total, st.st_size - total);
+      if (nread <= 0)
+        {
+          if (nread < 0 && errno == EINTR)
+            {
+              continue;
+            }
+
+          free(buf);
+          close(fd);
+          return NULL;
+        }
+
+      total += nread;
+    }
+
+  close(fd);
+  *size = total;
+  return buf;
+}
+
+/****************************************************************************
+ * Name: wamrbench_unload
+ ****************************************************************************/
+
+static void wamrbench_unload(FAR struct wamrbench_inst_s *wi)
+{
+  if (wi->env != NULL)
+    {
+      wasm_runtime_destroy_exec_env(wi->env);
+    }
+
+  if (wi->inst != NULL)
+    {
+      wasm_runtime_deinstantiate(wi->inst);
+    }
+
+  if (wi->module != NULL)
+    {
+      wasm_runtime_unload(wi->module);
+    }
+
+  free(wi->buf);
+  memset(wi, 0, sizeof(*wi));
+}
+
+/****************************************************************************
+ * Name: wamrbench_load
+ *
+ * Description:
+ *   Read, load and instantiate a module and look up the kernel entry.
+ *   The runtime keeps references into the file buffer, so it is only
+ *   released by wamrbench_unload().
+ *
+ ****************************************************************************/
+
+static int wamrbench_load(FAR struct wamrbench_s *wb,
+                          FAR struct wamrbench_inst_s *wi,
+                          FAR const char *path, bool verbose)
+{
+  char error[WAMRBENCH_ERRSIZE];
+
+  memset(wi, 0, sizeof(*wi));
+
+  wi->buf = wamrbench_readfile(path, &wi->size);
+  if (wi->buf == NULL)
+    {
+      if (verbose)
+        {
+          printf("%s: read failed: %d\n", path, errno);
+        }
+
+      return -EIO;
+    }
+
+  wi->module = wasm_runtime_load(wi->buf, wi->size, error, sizeof(error));
+  if (wi->module == NULL)
+    {
+      if (verbose)
+        {
+          printf("%s: load failed: %s\n", path, error);
+        }
+
+      goto errout;
+    }
+
+  wi->inst = wasm_runtime_instantiate(wi->module, wb->stacksize,
+                                      wb->heapsize, error, sizeof(error));
+  if (wi->inst == NULL)
+    {
+      if (verbose)
+        {
+          printf("%s: instantiate failed: %s\n", path, error);
+        }
+
+      goto errout;
+    }
+
+  wi->func = wasm_runtime_lookup_function(wi->inst, WAMRBENCH_ENTRY);
+  if (wi->func == NULL)
+    {
+      if (verbose)
+        {
+          printf("%s: %s not exported\n", path, WAMRBENCH_ENTRY);
+        }
+
+      goto errout;
+    }
+
+  wi->env = wasm_runtime_create_exec_env(wi->inst, wb->stacksize);
+  if (wi->env == NULL)
+    {
+      if (verbose)
+        {
+          printf("%s: exec env creation failed\n", path);
+        }
+
+      goto errout;
+    }
+
+  return 0;
+
+errout:
+  wamrbench_unload(wi);
+  return -EINVAL;
+}
+
+/****************************************************************************
+ * Name: wamrbench_call
+ ****************************************************************************/
+
+static int wamrbench_call(FAR struct wamrbench_inst_s *wi,
+                          uint32_t iterations, FAR uint32_t *check)
+{
+  uint32_t argv[1];
+
+  argv[0] = iterations;
+  if (!wasm_runtime_call_wasm(wi->env, wi->func, 1, argv))
+    {
+      printf("call failed: %s\n", wasm_runtime_get_exception(wi->inst));
+      return -EINVAL;
+    }
+
+  *check = argv[0];
+  return 0;
+}
+
+/****************************************************************************
+ * Name: wamrbench_measure
+ *
+ * Description:
+ *   Measure the cold start 'rounds' times, then keep one instance and time
+ *   a warm call of the full iteration count.
+ *
+ ****************************************************************************/
+
+static int wamrbench_measure(FAR struct wamrbench_s *wb,
+                             FAR const char *path,
+                             FAR struct wamrbench_result_s *res)
+{
+  struct wamrbench_inst_s wi;
+  uint64_t startup_sum = 0;
+  uint64_t load_sum = 0;
+  uint64_t start;
+  uint64_t loaded;
+  uint64_t elapsed;
+  uint32_t check;
+  int ret;
+  int i;
+
+  memset(res, 0, sizeof(*res));
+  res->startup_min = UINT64_MAX;
+
+  for (i = 0; i < wb->rounds; i++)
+    {
+      start = wamrbench_now();
+      ret = wamrbench_load(wb, &wi, path, i == 0);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      loaded = wamrbench_now();
+      ret = wamrbench_call(&wi, 1, &check);
+      elapsed = wamrbench_now() - start;
+      wamrbench_unload(&wi);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      startup_sum += elapsed;
+      load_sum += loaded - start;
+      if (elapsed < res->startup_min)
+        {
+          res->startup_min = elapsed;
+        }
+    }
+
+  res->startup_avg = startup_sum / wb->rounds;
+  res->load_avg = load_sum / wb->rounds;
+
+  ret = wamrbench_load(wb, &wi, path, true);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  /* Warm up the caches (and the fast interpreter's pre-compiled code) */
+
+  ret = wamrbench_call(&wi, 1, &check);
+  if (ret >= 0)
+    {
+      start = wamrbench_now();
+      ret = wamrbench_call(&wi, wb->iterations, &res->check);
+      res->run = wamrbench_now() - start;
+    }
+
+  wamrbench_unload(&wi);
+  res->valid = ret >= 0;
+  return ret;
+}
+
+/****************************************************************************
+ * Name: wamrbench_report
+ ****************************************************************************/
+
+static void wamrbench_report(FAR struct wamrbench_s *wb,
+                             FAR const char *name,
+                             FAR const struct wamrbench_result_s *res)
+{
+  uint64_t rate = res->run ? (uint64_t)wb->iterations * 1000000 / res->run
+                           : 0;
+
+  printf("%-6s run %10" PRIu64 " us %8" PRIu64 " it/s  check %08" PRIx32
+         "\n", name, res->run, rate, res->check);
+
+  /* The native reference has no startup phase */
+
+  if (res->startup_avg != 0)
+    {
+      printf("%-6s startup min %" PRIu64 " us avg %" PRIu64 " us "
+             "(load+instantiate %" PRIu64 " us)\n", "",
+             res->startup_min, res->startup_avg, res->load_avg);
+    }
+}
+
+/****************************************************************************
+ * Name: wamrbench_ratio
+ *
+ * Description:
+ *   Print a / b with one decimal, without floating point.
+ *
+ ****************************************************************************/
+
+static void wamrbench_ratio(FAR const char *what, uint64_t a, uint64_t b)
+{
+  uint64_t r;
+
+  if (b == 0)
+    {
+      return;
+    }
+
+  r = (a * 10 + b / 2) / b;
+  printf("  %-32s %" PRIu64 ".%" PRIu64 "x\n", what, r / 10, r % 10);
+}
+
+/****************************************************************************
+ * Name: wamrbench_native
+ ****************************************************************************/
+
+static void wamrbench_native(FAR struct wamrbench_s *wb,
+                             FAR struct wamrbench_result_s *res)
+{
+  uint64_t start;
+
+  memset(res, 0, sizeof(*res));
+
+  start = wamrbench_now();
+  res->check = wamrbench_workload(wb->iterations);
+  res->run = wamrbench_now() - start;
+  res->valid = true;
+}
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname, int exitcode)
+{
+  printf("Usage: %s [-m auto|int|aot|both] [-n iterations] [-r rounds]\n"
+         "          [-s stack] [-H heap] [module]\n", progname);
+  printf("  module  Path without extension (default %s), <module>.aot\n"
+         "          and <module>.wasm are used\n",
+         CONFIG_BENCHMARK_WAMRBENCH_MODULE);
+  printf("  -m      auto: load the AOT image if present, else bytecode\n"
+         "          int/aot: force one form, both: compare (default)\n");
+  printf("  -n      Kernel iterations per timed call (default %d)\n",
+         CONFIG_BENCHMARK_WAMRBENCH_ITERATIONS);
+  printf("  -r      Cold start rounds (default %d)\n",
+         CONFIG_BENCHMARK_WAMRBENCH_ROUNDS);
+  printf("  -s/-H   Wasm stack/heap size (default %d/%d)\n",
+         CONFIG_BENCHMARK_WAMRBENCH_WASM_STACKSIZE,
+         CONFIG_BENCHMARK_WAMRBENCH_WASM_HEAPSIZE);
+  exit(exitcode);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct wamrbench_result_s native;
+  struct wamrbench_result_s interp;
+  struct wamrbench_result_s aot;
+  struct wamrbench_s wb;
+  char wasmpath[WAMRBENCH_PATHSIZE];
+  char aotpath[WAMRBENCH_PATHSIZE];
+  FAR char *ext;
+  bool haveaot;
+  bool havewasm;
+  int ret = EXIT_SUCCESS;
+  int opt;
+
+  memset(&wb, 0, sizeof(wb));
+  wb.base       = CONFIG_BENCHMARK_WAMRBENCH_MODULE;
+  wb.mode       = WAMRBENCH_MODE_BOTH;
+  wb.iterations = CONFIG_BENCHMARK_WAMRBENCH_ITERATIONS;
+  wb.rounds     = CONFIG_BENCHMARK_WAMRBENCH_ROUNDS;
+  wb.stacksize  = CONFIG_BENCHMARK_WAMRBENCH_WASM_STACKSIZE;
+  wb.heapsize   = CONFIG_BENCHMARK_WAMRBENCH_WASM_HEAPSIZE;
+
+  while ((opt = getopt(argc, argv, "m:n:r:s:H:h")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'm':
+            if (strcmp(optarg, "auto") == 0)
+              {
+                wb.mode = WAMRBENCH_MODE_AUTO;
+              }
+            else if (strcmp(optarg, "int") == 0)
+              {
+                wb.mode = WAMRBENCH_MODE_INT;
+              }
+            else if (strcmp(optarg, "aot") == 0)
+              {
+                wb.mode = WAMRBENCH_MODE_AOT;
+              }
+            else if (strcmp(optarg, "both") == 0)
+              {
+                wb.mode = WAMRBENCH_MODE_BOTH;
+              }
+            else
+              {
+                show_usage(argv[0], EXIT_FAILURE);
+              }
+            break;
+
+          case 'n':
+            wb.iterations = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'r':
+            wb.rounds = atoi(optarg);
+            break;
+
+          case 's':
+            wb.stacksize = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'H':
+            wb.heapsize = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'h':
+            show_usage(argv[0], EXIT_SUCCESS);
+            break;
+
+          default:
+            show_usage(argv[0], EXIT_FAILURE);
+        }
+    }
+
+  if (optind < argc)
+    {
+      wb.base = argv[optind];
+    }
+
+  if (wb.iterations == 0 || wb.rounds <= 0)
+    {
+      show_usage(argv[0], EXIT_FAILURE);
+    }
+
+  /* Accept the module given with either extension */
+
+  snprintf(wasmpath, sizeof(wasmpath), "%s", wb.base);
+  ext = strrchr(wasmpath, '.');
+  if (ext != NULL && (strcmp(ext, ".wasm") == 0 || strcmp(ext, ".aot") == 0))
+    {
+      *ext = '\0';
+    }
+
+  strlcpy(aotpath, wasmpath, sizeof(aotpath));
+  strlcat(aotpath, ".aot", sizeof(aotpath));
+  strlcat(wasmpath, ".wasm", sizeof(wasmpath));
+
+  haveaot  = wamrbench_exists(aotpath);
+  havewasm = wamrbench_exists(wasmpath);
+
+  if (wb.mode == WAMRBENCH_MODE_AUTO)
+    {
+      wb.mode = haveaot ? WAMRBENCH_MODE_AOT : WAMRBENCH_MODE_INT;
+      printf("Using %s\n", haveaot ? aotpath : wasmpath);
+    }
+
+  if (!wasm_runtime_init())
+    {
+      printf("wasm_runtime_init failed\n");
+      return EXIT_FAILURE;
+    }
+
+  memset(&interp, 0, sizeof(interp));
+  memset(&aot, 0, sizeof(aot));
+
+  printf("wamrbench: %" PRIu32 " iterations, %d cold start rounds\n",
+         wb.iterations, wb.rounds);
+
+  wamrbench_native(&wb, &native);
+  wamrbench_report(&wb, "native", &native);
+
+  if (wb.mode == WAMRBENCH_MODE_INT || wb.mode == WAMRBENCH_MODE_BOTH)
+    {
+      if (!havewasm)
+        {
+          printf("%s: not found\n", wasmpath);
+        }
+      else if (wamrbench_measure(&wb, wasmpath, &interp) >= 0)
+        {
+          wamrbench_report(&wb, "interp", &interp);
+        }
+    }
+
+  if (wb.mode == WAMRBENCH_MODE_AOT || wb.mode == WAMRBENCH_MODE_BOTH)
+    {
+      if (!haveaot)
+        {
+          printf("%s: not found, enable INTERPRETERS_WAMR_AOT to "
+                 "generate it\n", aotpath);
+        }
+      else if (wamrbench_measure(&wb, aotpath, &aot) >= 0)
+        {
+          wamrbench_report(&wb, "aot", &aot);
+        }
+    }
+
+  if ((interp.valid && interp.check != native.check) ||
+      (aot.valid && aot.check != native.check))
+    {
+      printf("ERROR: checksum mismatch\n");
+      ret = EXIT_FAILURE;
+    }
+
+  if (!interp.valid && !aot.valid)
+    {
+      ret = EXIT_FAILURE;
+    }
+
+  if (interp.valid && aot.valid)
+    {
+      printf("AOT vs. interpreter:\n");
+      wamrbench_ratio("startup speedup (avg)", interp.startup_avg,
+                      aot.startup_avg);
+      wamrbench_ratio("throughput speedup", interp.run, aot.run);
+    }
+
+  if (interp.valid)
+    {
+      wamrbench_ratio("interpreter slowdown vs. native", interp.run,
+                      native.run);
+    }
+
+  if (aot.valid)
+    {
+      wamrbench_ratio("aot slowdown vs. native", aot.run, native.run);
+    }
+
+  wasm_runtime_destroy();
+  return ret;
+}
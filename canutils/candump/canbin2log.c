@@ -0,0 +1,333 @@
+/****************************************************************************
+ * apps/canutils/candump/canbin2log.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <net/if.h>
+#include <nuttx/can.h>
+
+#include "lib.h"
+#include "candump_binlog.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MAXDEV 32
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static char g_devname[MAXDEV][IFNAMSIZ + 1];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname)
+{
+  fprintf(stderr, "Usage: %s [-a] <binary capture> [<output file>]\n",
+          progname);
+  fprintf(stderr, "Convert a 'candump -b' capture to the candump log "
+          "file format.\n");
+  fprintf(stderr, "  -a  write Vector ASC format instead\n");
+}
+
+static FAR const char *devname_get(int dev)
+{
+  if (dev < MAXDEV && g_devname[dev][0] != '\0')
+    {
+      return g_devname[dev];
+    }
+
+  return "can?";
+}
+
+static void print_log(FAR FILE *out,
+                      FAR const struct candump_bin_rec_s *rec,
+                      FAR struct canfd_frame *frame)
+{
+  char buf[CL_CFSZ];
+
+  sprint_canframe(buf, frame, 0,
+                  rec->type == CANDUMP_BIN_FDFRAME ?
+                  CANFD_MAX_DLEN : CAN_MAX_DLEN);
+  fprintf(out, "(%010" PRIu32 ".%06" PRIu32 ") %s %s\n",
+          rec->tv_sec, rec->tv_usec, devname_get(rec->dev), buf);
+}
+
+/* ASC "absolute" timestamps count from the start of the measurement, which
+ * is the time on the date line.  Both are taken from the first record of
+ * the capture.
+ */
+
+static void print_asc_header(FAR FILE *out, time_t start)
+{
+  fprintf(out, "date %s", ctime(&start));
+  fprintf(out, "base hex  timestamps absolute\n");
+  fprintf(out, "no internal events logged\n");
+}
+
+static void print_asc(FAR FILE *out,
+                      FAR const struct candump_bin_rec_s *rec,
+                      FAR const struct canfd_frame *frame,
+                      FAR const struct timeval *start)
+{
+  struct timeval tv;
+  canid_t id;
+  int i;
+
+  tv.tv_sec  = rec->tv_sec - start->tv_sec;
+  tv.tv_usec = (long)rec->tv_usec - start->tv_usec;
+  if (tv.tv_usec < 0)
+    {
+      tv.tv_sec--;
+      tv.tv_usec += 1000000;
+    }
+
+  fprintf(out, "%4ld.%06ld ", (long)tv.tv_sec, (long)tv.tv_usec);
+
+  if (frame->can_id & CAN_ERR_FLAG)
+    {
+      fprintf(out, "%-2d ErrorFrame\n", rec->dev + 1);
+      return;
+    }
+
+  id = frame->can_id & ((frame->can_id & CAN_EFF_FLAG) ?
+                        CAN_EFF_MASK : CAN_SFF_MASK);
+
+  if (rec->type == CANDUMP_BIN_FDFRAME)
+    {
+      fprintf(out, "CANFD %3d Rx %8" PRIX32 "%c %d %d %X %2d",
+              rec->dev + 1, (uint32_t)id,
+              (frame->can_id & CAN_EFF_FLAG) ? 'x' : ' ',
+              (frame->flags & CANFD_BRS) ? 1 : 0,
+              (frame->flags & CANFD_ESI) ? 1 : 0,
+              can_len2dlc(frame->len), frame->len);
+    }
+  else
+    {
+      char idbuf[16];
+
+      snprintf(idbuf, sizeof(idbuf), "%" PRIX32 "%s", (uint32_t)id,
+               (frame->can_id & CAN_EFF_FLAG) ? "x" : "");
+      fprintf(out, "%-2d %-15s Rx   %c %d", rec->dev + 1, idbuf,
+              (frame->can_id & CAN_RTR_FLAG) ? 'r' : 'd', frame->len);
+
+      if (frame->can_id & CAN_RTR_FLAG)
+        {
+          fprintf(out, "\n");
+          return;
+        }
+    }
+
+  for (i = 0; i < frame->len; i++)
+    {
+      fprintf(out, " %02X", frame->data[i]);
+    }
+
+  fprintf(out, "\n");
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct candump_bin_hdr_s hdr;
+  struct candump_bin_rec_s rec;
+  struct canfd_frame frame;
+  struct timeval start;
+  uint8_t payload[UINT8_MAX];
+  FAR FILE *out = stdout;
+  FAR FILE *in;
+  uint32_t frames = 0;
+  uint32_t sockdrops = 0;
+  uint32_t ringdrops = 0;
+  bool asc = false;
+  bool first = true;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "ah")) != -1)
+    {
+      switch (opt)
+        {
+          case 'a':
+            asc = true;
+            break;
+
+          default:
+            show_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+  if (optind >= argc)
+    {
+      show_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  in = fopen(argv[optind], "rb");
+  if (in == NULL)
+    {
+      perror("open capture");
+      return EXIT_FAILURE;
+    }
+
+  if (fread(&hdr, sizeof(hdr), 1, in) != 1 ||
+      memcmp(hdr.magic, CANDUMP_BIN_MAGIC, sizeof(hdr.magic)) != 0 ||
+      hdr.version != CANDUMP_BIN_VERSION)
+    {
+      fprintf(stderr, "%s: not a candump binary capture\n", argv[optind]);
+      fclose(in);
+      return EXIT_FAILURE;
+    }
+
+  if (optind + 1 < argc)
+    {
+      out = fopen(argv[optind + 1], "w");
+      if (out == NULL)
+        {
+          perror("open output");
+          fclose(in);
+          return EXIT_FAILURE;
+        }
+    }
+
+  while (fread(&rec, sizeof(rec), 1, in) == 1)
+    {
+      if (rec.len > 0 && fread(payload, rec.len, 1, in) != 1)
+        {
+          fprintf(stderr, "truncated record after %" PRIu32 " frames\n",
+                  frames);
+          break;
+        }
+
+      if (first)
+        {
+          start.tv_sec  = rec.tv_sec;
+          start.tv_usec = rec.tv_usec;
+          first = false;
+
+          if (asc)
+            {
+              print_asc_header(out, start.tv_sec);
+            }
+        }
+
+      switch (rec.type)
+        {
+          case CANDUMP_BIN_DEVICE:
+            if (rec.dev < MAXDEV && rec.len <= IFNAMSIZ)
+              {
+                memcpy(g_devname[rec.dev], payload, rec.len);
+                g_devname[rec.dev][rec.len] = '\0';
+              }
+            break;
+
+          case CANDUMP_BIN_DROP:
+            if (rec.flags == CANDUMP_BIN_DROP_RING)
+              {
+                ringdrops += rec.can_id;
+              }
+            else
+              {
+                sockdrops += rec.can_id;
+              }
+
+            if (!asc)
+              {
+                fprintf(out, "DROPCOUNT: dropped %" PRIu32 " CAN frame%s "
+                        "on '%s' %s\n", rec.can_id,
+                        rec.can_id > 1 ? "s" : "", devname_get(rec.dev),
+                        rec.flags == CANDUMP_BIN_DROP_RING ?
+                        "capture buffer" : "socket");
+              }
+            break;
+
+          case CANDUMP_BIN_FRAME:
+          case CANDUMP_BIN_FDFRAME:
+            if (rec.len > CANFD_MAX_DLEN)
+              {
+                fprintf(stderr, "bad frame length %d\n", rec.len);
+                break;
+              }
+
+            memset(&frame, 0, sizeof(frame));
+            frame.can_id = rec.can_id;
+            frame.flags  = rec.flags;
+            frame.len    = rec.len;
+            memcpy(frame.data, payload, rec.len);
+
+            if (asc)
+              {
+                print_asc(out, &rec, &frame, &start);
+              }
+            else
+              {
+                print_log(out, &rec, &frame);
+              }
+
+            frames++;
+            break;
+
+          default:
+            fprintf(stderr, "unknown record type %d\n", rec.type);
+            break;
+        }
+    }
+
+  if (asc && first)
+    {
+      /* An empty capture has no start time, use that of the file */
+
+      struct stat st;
+
+      print_asc_header(out, fstat(fileno(in), &st) == 0 ? st.st_mtime : 0);
+    }
+
+  fprintf(stderr, "%" PRIu32 " frames, dropped %" PRIu32 " (socket) %"
+          PRIu32 " (capture buffer)\n", frames, sockdrops, ringdrops);
+
+  if (out != stdout)
+    {
+      fclose(out);
+    }
+
+  fclose(in);
+  return EXIT_SUCCESS;
+}
@@ -69,6 +69,10 @@
 #include "terminal.h"
 #include "lib.h"
 
+#ifdef CONFIG_CANUTILS_CANDUMP_BINARY
+#include "candump_binlog.h"
+#endif
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -137,6 +141,9 @@ static void print_usage(char *prg)
 	fprintf(stderr, "         -s <level>  (silent mode - %d: off (default) %d: animation %d: silent)\n", SILENT_OFF, SILENT_ANI, SILENT_ON);
 	fprintf(stderr, "         -l          (log CAN-frames into file. Sets '-s %d' by default)\n", SILENT_ON);
 	fprintf(stderr, "         -L          (use log file format on stdout)\n");
+#ifdef CONFIG_CANUTILS_CANDUMP_BINARY
+	fprintf(stderr, "         -b <file>   (binary capture into <file>, convert with canbin2log. Sets '-s %d' by default)\n", SILENT_ON);
+#endif
 	fprintf(stderr, "         -n <count>  (terminate after reception of <count> CAN frames)\n");
 	fprintf(stderr, "         -r <size>   (set socket receive buffer to <size>)\n");
 	fprintf(stderr, "         -D          (Don't exit if a \"detected\" can device goes down.\n");
@@ -172,6 +179,33 @@ void sigterm(int signo)
 	running = 0;
 }
 
+static void get_cmsg_info(struct msghdr *msg, struct timeval *tv, __u32 *drops)
+{
+	struct cmsghdr *cmsg;
+
+	for (cmsg = CMSG_FIRSTHDR(msg);
+	     cmsg && (cmsg->cmsg_level == SOL_SOCKET);
+	     cmsg = CMSG_NXTHDR(msg,cmsg)) {
+		if (cmsg->cmsg_type == SO_TIMESTAMP) {
+			memcpy(tv, CMSG_DATA(cmsg), sizeof(*tv));
+		} else if (cmsg->cmsg_type == SO_TIMESTAMPING) {
+
+			struct timespec *stamp = (struct timespec *)CMSG_DATA(cmsg);
+
+			/*
+			 * stamp[0] is the software timestamp
+			 * stamp[1] is deprecated
+			 * stamp[2] is the raw hardware timestamp
+			 * See chapter 2.1.2 Receive timestamps in
+			 * linux/Documentation/networking/timestamping.txt
+			 */
+			tv->tv_sec = stamp[2].tv_sec;
+			tv->tv_usec = stamp[2].tv_nsec/1000;
+		} else if (cmsg->cmsg_type == SO_RXQ_OVFL)
+			memcpy(drops, CMSG_DATA(cmsg), sizeof(__u32));
+	}
+}
+
 int idx2dindex(int ifidx, int socket) {
 
 	int i;
@@ -221,6 +255,66 @@ int idx2dindex(int ifidx, int socket) {
 	return i;
 }
 
+#ifdef CONFIG_CANUTILS_CANDUMP_BINARY
+/*
+ * Drain up to CONFIG_CANUTILS_CANDUMP_RXBATCH frames from one readable
+ * socket straight into the binary capture ring buffer. Only the first
+ * recvmsg() may block, the others stop as soon as the queue is empty.
+ */
+static int binlog_drain(struct candump_binlog_s *binlog, int sock, int i,
+			struct msghdr *msg, struct canfd_frame *frame,
+			size_t ctrllen, int *count, int down_causes_exit)
+{
+	struct sockaddr_can *addr = msg->msg_name;
+	struct timeval tv = { 0, 0 };
+	int nbytes, idx, n;
+
+	for (n = 0; n < CONFIG_CANUTILS_CANDUMP_RXBATCH && running; n++) {
+
+		/* these settings may be modified by recvmsg() */
+		msg->msg_iov->iov_len = sizeof(*frame);
+		msg->msg_namelen = sizeof(*addr);
+		msg->msg_controllen = ctrllen;
+		msg->msg_flags = 0;
+
+		nbytes = recvmsg(sock, msg, n ? MSG_DONTWAIT : 0);
+		if (nbytes < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				break;
+			if ((errno == ENETDOWN) && !down_causes_exit) {
+				fprintf(stderr, "interface down\n");
+				break;
+			}
+			perror("read");
+			return -1;
+		}
+
+		if ((size_t)nbytes != CAN_MTU && (size_t)nbytes != CANFD_MTU) {
+			fprintf(stderr, "read: incomplete CAN frame\n");
+			return -1;
+		}
+
+		idx = idx2dindex(addr->can_ifindex, sock);
+		get_cmsg_info(msg, &tv, &dropcnt[i]);
+
+		if (dropcnt[i] != last_dropcnt[i]) {
+			candump_binlog_drop(binlog, idx, &tv,
+					    dropcnt[i] - last_dropcnt[i]);
+			last_dropcnt[i] = dropcnt[i];
+		}
+
+		candump_binlog_frame(binlog, idx, devname[idx], &tv, frame,
+				     (size_t)nbytes == CANFD_MTU);
+
+		if (*count && (--(*count) == 0))
+			running = 0;
+	}
+
+	candump_binlog_commit(binlog);
+	return 0;
+}
+#endif
+
 int main(int argc, char **argv)
 {
 	fd_set rdfs;
@@ -246,7 +340,6 @@ int main(int argc, char **argv)
 	char ctrlmsg[CMSG_SPACE(sizeof(struct timeval) + 3*sizeof(struct timespec) + sizeof(__u32))];
 	struct iovec iov;
 	struct msghdr msg;
-	struct cmsghdr *cmsg;
 	struct can_filter *rfilter;
 	can_err_mask_t err_mask;
 	struct canfd_frame frame;
@@ -255,6 +348,10 @@ int main(int argc, char **argv)
 	struct timeval tv, last_tv;
 	struct timeval timeout, timeout_config = { 0, 0 }, *timeout_current = NULL;
 	FILE *logfile = NULL;
+	char *binfile = NULL;
+#ifdef CONFIG_CANUTILS_CANDUMP_BINARY
+	struct candump_binlog_s *binlog = NULL;
+#endif
 
 #if 0 /* NuttX doesn't support these signals */
 	signal(SIGTERM, sigterm);
@@ -265,7 +362,7 @@ int main(int argc, char **argv)
 	last_tv.tv_sec  = 0;
 	last_tv.tv_usec = 0;
 
-	while ((opt = getopt(argc, argv, "t:HciaSs:lDdxLn:r:heT:?")) != -1) {
+	while ((opt = getopt(argc, argv, "t:HciaSs:lDdxLb:n:r:heT:?")) != -1) {
 		switch (opt) {
 		case 't':
 			timestamp = optarg[0];
@@ -329,6 +426,12 @@ int main(int argc, char **argv)
 			logfrmt = 1;
 			break;
 
+#ifdef CONFIG_CANUTILS_CANDUMP_BINARY
+		case 'b':
+			binfile = optarg;
+			break;
+#endif
+
 		case 'n':
 			count = atoi(optarg);
 			if (count < 1) {
@@ -373,8 +476,13 @@ int main(int argc, char **argv)
 		exit(0);
 	}
 
+	if (binfile && (log || logfrmt)) {
+		fprintf(stderr, "Binary capture can not be combined with log file formats!\n");
+		exit(0);
+	}
+
 	if (silent == SILENT_INI) {
-		if (log) {
+		if (log || binfile) {
 			fprintf(stderr, "Disabled standard output while logging.\n");
 			silent = SILENT_ON; /* disable output on stdout */
 		} else
@@ -537,7 +645,7 @@ int main(int argc, char **argv)
 			}
 		}
 
-		if (timestamp || log || logfrmt) {
+		if (timestamp || log || logfrmt || binfile) {
 
 			if (hwtimestamp) {
 				const int timestamping_flags = (SOF_TIMESTAMPING_SOFTWARE | \
@@ -609,6 +717,21 @@ int main(int argc, char **argv)
 		}
 	}
 
+#ifdef CONFIG_CANUTILS_CANDUMP_BINARY
+	if (binfile) {
+		if (silent != SILENT_ON)
+			fprintf(stderr, "Warning: Console output active while logging!\n");
+
+		fprintf(stderr, "Enabling binary capture '%s'\n", binfile);
+
+		binlog = candump_binlog_open(binfile, CONFIG_CANUTILS_CANDUMP_BINBUFSIZE);
+		if (!binlog) {
+			perror("binary capture");
+			return 1;
+		}
+	}
+#endif
+
 	/* these settings are static and can be held out of the hot path */
 	iov.iov_base = &frame;
 	msg.msg_name = &addr;
@@ -637,6 +760,24 @@ int main(int argc, char **argv)
 
 				int idx;
 
+#ifdef CONFIG_CANUTILS_CANDUMP_BINARY
+				if (binlog) {
+					if (binlog_drain(binlog, s[i], i, &msg, &frame,
+							 sizeof(ctrlmsg), &count,
+							 down_causes_exit) < 0) {
+						candump_binlog_close(binlog, stderr);
+						return 1;
+					}
+
+					if (silent == SILENT_ANI) {
+						printf("%c\b", anichar[silentani%=MAXANI]);
+						silentani++;
+						fflush(stdout);
+					}
+					continue;
+				}
+#endif
+
 				/* these settings may be modified by recvmsg() */
 				iov.iov_len = sizeof(frame);
 				msg.msg_namelen = sizeof(addr);
@@ -667,27 +808,7 @@ int main(int argc, char **argv)
 				if (count && (--count == 0))
 					running = 0;
 
-				for (cmsg = CMSG_FIRSTHDR(&msg);
-				     cmsg && (cmsg->cmsg_level == SOL_SOCKET);
-				     cmsg = CMSG_NXTHDR(&msg,cmsg)) {
-					if (cmsg->cmsg_type == SO_TIMESTAMP) {
-						memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
-					} else if (cmsg->cmsg_type == SO_TIMESTAMPING) {
-
-						struct timespec *stamp = (struct timespec *)CMSG_DATA(cmsg);
-
-						/*
-						 * stamp[0] is the software timestamp
-						 * stamp[1] is deprecated
-						 * stamp[2] is the raw hardware timestamp
-						 * See chapter 2.1.2 Receive timestamps in
-						 * linux/Documentation/networking/timestamping.txt
-						 */
-						tv.tv_sec = stamp[2].tv_sec;
-						tv.tv_usec = stamp[2].tv_nsec/1000;
-					} else if (cmsg->cmsg_type == SO_RXQ_OVFL)
-						memcpy(&dropcnt[i], CMSG_DATA(cmsg), sizeof(__u32));
-				}
+				get_cmsg_info(&msg, &tv, &dropcnt[i]);
 
 				/* check for (unlikely) dropped frames on this specific socket */
 				if (dropcnt[i] != last_dropcnt[i]) {
@@ -813,5 +934,10 @@ int main(int argc, char **argv)
 	if (log)
 		fclose(logfile);
 
+#ifdef CONFIG_CANUTILS_CANDUMP_BINARY
+	if (binlog)
+		candump_binlog_close(binlog, stderr);
+#endif
+
 	return 0;
 }
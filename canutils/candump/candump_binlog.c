@@ -0,0 +1,562 @@
+/****************************************************************************
+ * apps/canutils/candump/candump_binlog.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <net/if.h>
+
+#include "candump_binlog.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The writer waits until this many bytes are pending (or the flush
+ * interval expires) so that the file sees few, large writes.
+ */
+
+#define BINLOG_WRITE_CHUNK    4096
+#define BINLOG_FLUSH_MSEC     200
+
+#define BINLOG_MAXDEV         32
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct candump_binlog_s
+{
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  int fd;
+  bool stop;
+
+  /* Ring buffer.  head/tail are free running byte counters, the producer
+   * owns wpos (uncommitted head) and the writer owns tail.
+   */
+
+  FAR uint8_t *buf;
+  size_t size;
+  size_t head;
+  size_t tail;
+  size_t wpos;
+  size_t ctail;                 /* Producer's cached copy of tail */
+  size_t chunk;                 /* Pending bytes that wake the writer */
+
+  /* Statistics */
+
+  uint32_t frames;
+  uint32_t sockdrops;
+  uint32_t ringdrops;
+  uint32_t pendingdrops;        /* Ring drops not yet recorded in the file */
+  bool sockpending;             /* Any pendingsock[] entry is set */
+  uint64_t written;
+  int error;
+
+  /* Socket drops not yet recorded in the file, per device index */
+
+  uint32_t pendingsock[BINLOG_MAXDEV];
+
+  /* Device names already recorded per index */
+
+  char devname[BINLOG_MAXDEV][IFNAMSIZ + 1];
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/* Write all of 'data'.  A write that stores nothing (a full device) is
+ * an error too, or the loop would never end.
+ */
+
+static int binlog_write(int fd, FAR const uint8_t *data, size_t len)
+{
+  ssize_t n;
+
+  while (len > 0)
+    {
+      n = write(fd, data, len);
+      if (n <= 0)
+        {
+          if (n < 0 && errno == EINTR)
+            {
+              continue;
+            }
+
+          if (n == 0)
+            {
+              errno = EIO;
+            }
+
+          return -errno;
+        }
+
+      data += n;
+      len  -= n;
+    }
+
+  return 0;
+}
+
+static FAR void *binlog_thread(FAR void *arg)
+{
+  FAR struct candump_binlog_s *log = arg;
+  struct timespec abstime;
+  size_t head;
+  size_t tail;
+  size_t off;
+  size_t len;
+  bool stop;
+  int ret;
+
+  pthread_mutex_lock(&log->lock);
+
+  for (; ; )
+    {
+      while (!log->stop && log->head - log->tail < log->chunk)
+        {
+          clock_gettime(CLOCK_REALTIME, &abstime);
+          abstime.tv_nsec += BINLOG_FLUSH_MSEC * 1000000;
+          if (abstime.tv_nsec >= 1000000000)
+            {
+              abstime.tv_sec++;
+              abstime.tv_nsec -= 1000000000;
+            }
+
+          if (pthread_cond_timedwait(&log->cond, &log->lock,
+                                     &abstime) == ETIMEDOUT)
+            {
+              break;
+            }
+        }
+
+      head = log->head;
+      tail = log->tail;
+      stop = log->stop;
+      pthread_mutex_unlock(&log->lock);
+
+      /* Write the pending span, at most two pieces if it wraps */
+
+      while (tail != head)
+        {
+          off = tail % log->size;
+          len = head - tail;
+          if (off + len > log->size)
+            {
+              len = log->size - off;
+            }
+
+          /* After the first error the rest is discarded */
+
+          if (log->error == 0)
+            {
+              ret = binlog_write(log->fd, &log->buf[off], len);
+              if (ret < 0)
+                {
+                  log->error = ret;
+                }
+              else
+                {
+                  log->written += len;
+                }
+            }
+
+          tail += len;
+        }
+
+      pthread_mutex_lock(&log->lock);
+      log->tail = tail;
+
+      if (stop && log->head == log->tail)
+        {
+          break;
+        }
+    }
+
+  pthread_mutex_unlock(&log->lock);
+  return NULL;
+}
+
+/* Copy a record into the ring at the producer position.  Returns false if
+ * there is no room; the caller accounts for the drop.
+ */
+
+static bool binlog_put(FAR struct candump_binlog_s *log,
+                       FAR const struct candump_bin_rec_s *rec,
+                       FAR const void *payload)
+{
+  FAR const uint8_t *src[2];
+  size_t need = sizeof(*rec) + rec->len;
+  size_t len[2];
+  size_t off;
+  size_t n;
+  int i;
+
+  /* tail only ever grows, so the cached value underestimates free space
+   * and the lock is only taken when the ring looks full.
+   */
+
+  if (log->wpos - log->ctail + need > log->size)
+    {
+      pthread_mutex_lock(&log->lock);
+      log->ctail = log->tail;
+      pthread_mutex_unlock(&log->lock);
+
+      if (log->wpos - log->ctail + need > log->size)
+        {
+          return false;
+        }
+    }
+
+  src[0] = (FAR const uint8_t *)rec;
+  len[0] = sizeof(*rec);
+  src[1] = payload;
+  len[1] = rec->len;
+
+  for (i = 0; i < 2; i++)
+    {
+      while (len[i] > 0)
+        {
+          off = log->wpos % log->size;
+          n   = len[i];
+          if (off + n > log->size)
+            {
+              n = log->size - off;
+            }
+
+          memcpy(&log->buf[off], src[i], n);
+          log->wpos += n;
+          src[i]    += n;
+          len[i]    -= n;
+        }
+    }
+
+  return true;
+}
+
+static void binlog_droprec(FAR struct candump_binlog_s *log,
+                           FAR struct candump_bin_rec_s *rec,
+                           FAR const struct timeval *tv)
+{
+  memset(rec, 0, sizeof(*rec));
+  rec->type    = CANDUMP_BIN_DROP;
+  rec->flags   = CANDUMP_BIN_DROP_RING;
+  rec->tv_sec  = tv->tv_sec;
+  rec->tv_usec = tv->tv_usec;
+  rec->can_id  = log->pendingdrops;
+}
+
+static void binlog_sockrec(FAR struct candump_bin_rec_s *rec, int dev,
+                           FAR const struct timeval *tv, uint32_t count)
+{
+  memset(rec, 0, sizeof(*rec));
+  rec->type    = CANDUMP_BIN_DROP;
+  rec->dev     = dev;
+  rec->flags   = CANDUMP_BIN_DROP_SOCKET;
+  rec->tv_sec  = tv->tv_sec;
+  rec->tv_usec = tv->tv_usec;
+  rec->can_id  = count;
+}
+
+static void binlog_flushdrops(FAR struct candump_binlog_s *log,
+                              FAR const struct timeval *tv)
+{
+  struct candump_bin_rec_s rec;
+
+  binlog_droprec(log, &rec, tv);
+  if (binlog_put(log, &rec, NULL))
+    {
+      log->pendingdrops = 0;
+    }
+}
+
+/* Write a record straight to the file, once the writer has stopped */
+
+static void binlog_putfile(FAR struct candump_binlog_s *log,
+                           FAR const struct candump_bin_rec_s *rec)
+{
+  int ret;
+
+  if (log->error == 0)
+    {
+      ret = binlog_write(log->fd, (FAR const uint8_t *)rec, sizeof(*rec));
+      if (ret < 0)
+        {
+          log->error = ret;
+        }
+      else
+        {
+          log->written += sizeof(*rec);
+        }
+    }
+}
+
+/* Retry the socket drop records that found no room in the ring */
+
+static void binlog_flushsock(FAR struct candump_binlog_s *log,
+                             FAR const struct timeval *tv)
+{
+  struct candump_bin_rec_s rec;
+  int dev;
+
+  log->sockpending = false;
+  for (dev = 0; dev < BINLOG_MAXDEV; dev++)
+    {
+      if (log->pendingsock[dev] > 0)
+        {
+          binlog_sockrec(&rec, dev, tv, log->pendingsock[dev]);
+          if (binlog_put(log, &rec, NULL))
+            {
+              log->pendingsock[dev] = 0;
+            }
+          else
+            {
+              log->sockpending = true;
+            }
+        }
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+FAR struct candump_binlog_s *candump_binlog_open(FAR const char *path,
+                                                 size_t bufsize)
+{
+  FAR struct candump_binlog_s *log;
+  struct candump_bin_hdr_s hdr;
+  int ret;
+
+  log = calloc(1, sizeof(*log));
+  if (log == NULL)
+    {
+      return NULL;
+    }
+
+  log->buf = malloc(bufsize);
+  if (log->buf == NULL)
+    {
+      goto errout_with_log;
+    }
+
+  log->size  = bufsize;
+  log->chunk = bufsize / 4 < BINLOG_WRITE_CHUNK ?
+               bufsize / 4 : BINLOG_WRITE_CHUNK;
+
+  log->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (log->fd < 0)
+    {
+      goto errout_with_buf;
+    }
+
+  memcpy(hdr.magic, CANDUMP_BIN_MAGIC, sizeof(hdr.magic));
+  hdr.version  = CANDUMP_BIN_VERSION;
+  hdr.reserved = 0;
+
+  if (binlog_write(log->fd, (FAR const uint8_t *)&hdr, sizeof(hdr)) < 0)
+    {
+      goto errout_with_fd;
+    }
+
+  log->written = sizeof(hdr);
+
+  pthread_mutex_init(&log->lock, NULL);
+  pthread_cond_init(&log->cond, NULL);
+
+  ret = pthread_create(&log->thread, NULL, binlog_thread, log);
+  if (ret != 0)
+    {
+      pthread_cond_destroy(&log->cond);
+      pthread_mutex_destroy(&log->lock);
+      goto errout_with_fd;
+    }
+
+  pthread_setname_np(log->thread, "candump_wr");
+  return log;
+
+errout_with_fd:
+  close(log->fd);
+errout_with_buf:
+  free(log->buf);
+errout_with_log:
+  free(log);
+  return NULL;
+}
+
+void candump_binlog_frame(FAR struct candump_binlog_s *log, int dev,
+                          FAR const char *devname,
+                          FAR const struct timeval *tv,
+                          FAR const struct canfd_frame *frame, bool fd)
+{
+  struct candump_bin_rec_s rec;
+
+  if (log->sockpending)
+    {
+      binlog_flushsock(log, tv);
+    }
+
+  if (log->pendingdrops > 0)
+    {
+      binlog_flushdrops(log, tv);
+    }
+
+  rec.dev     = dev;
+  rec.tv_sec  = tv->tv_sec;
+  rec.tv_usec = tv->tv_usec;
+
+  if (dev < BINLOG_MAXDEV && strcmp(log->devname[dev], devname) != 0)
+    {
+      rec.type   = CANDUMP_BIN_DEVICE;
+      rec.flags  = 0;
+      rec.len    = strnlen(devname, IFNAMSIZ);
+      rec.can_id = 0;
+
+      if (!binlog_put(log, &rec, devname))
+        {
+          log->ringdrops++;
+          log->pendingdrops++;
+          return;
+        }
+
+      strlcpy(log->devname[dev], devname, sizeof(log->devname[dev]));
+    }
+
+  rec.type   = fd ? CANDUMP_BIN_FDFRAME : CANDUMP_BIN_FRAME;
+  rec.flags  = frame->flags;
+  rec.len    = frame->len;
+  rec.can_id = frame->can_id;
+
+  if (binlog_put(log, &rec, frame->data))
+    {
+      log->frames++;
+    }
+  else
+    {
+      log->ringdrops++;
+      log->pendingdrops++;
+    }
+}
+
+void candump_binlog_drop(FAR struct candump_binlog_s *log, int dev,
+                         FAR const struct timeval *tv, uint32_t count)
+{
+  struct candump_bin_rec_s rec;
+
+  log->sockdrops += count;
+
+  if (dev < BINLOG_MAXDEV)
+    {
+      /* Merge with what is still waiting, so the count stays in order */
+
+      log->pendingsock[dev] += count;
+      binlog_flushsock(log, tv);
+      return;
+    }
+
+  binlog_sockrec(&rec, dev, tv, count);
+  binlog_put(log, &rec, NULL);
+}
+
+void candump_binlog_commit(FAR struct candump_binlog_s *log)
+{
+  pthread_mutex_lock(&log->lock);
+  if (log->head != log->wpos)
+    {
+      log->head = log->wpos;
+      if (log->head - log->tail >= log->chunk)
+        {
+          pthread_cond_signal(&log->cond);
+        }
+    }
+
+  pthread_mutex_unlock(&log->lock);
+}
+
+void candump_binlog_close(FAR struct candump_binlog_s *log,
+                          FAR FILE *stream)
+{
+  struct candump_bin_rec_s rec;
+  struct timeval tv;
+  int dev;
+
+  candump_binlog_commit(log);
+
+  pthread_mutex_lock(&log->lock);
+  log->stop = true;
+  pthread_cond_signal(&log->cond);
+  pthread_mutex_unlock(&log->lock);
+
+  pthread_join(log->thread, NULL);
+
+  /* Drops that never found room in the buffer go directly to the file,
+   * stamped with the time of closing.
+   */
+
+  gettimeofday(&tv, NULL);
+
+  for (dev = 0; log->sockpending && dev < BINLOG_MAXDEV; dev++)
+    {
+      if (log->pendingsock[dev] > 0)
+        {
+          binlog_sockrec(&rec, dev, &tv, log->pendingsock[dev]);
+          binlog_putfile(log, &rec);
+        }
+    }
+
+  if (log->pendingdrops > 0)
+    {
+      binlog_droprec(log, &rec, &tv);
+      binlog_putfile(log, &rec);
+    }
+
+  if (log->error < 0)
+    {
+      fprintf(stream, "binary log write error: %d\n", log->error);
+    }
+
+  fprintf(stream, "binary log: %" PRIu32 " frames, %" PRIu64 " bytes, "
+          "dropped %" PRIu32 " (socket) %" PRIu32 " (ring buffer)\n",
+          log->frames, log->written, log->sockdrops, log->ringdrops);
+
+  close(log->fd);
+  pthread_cond_destroy(&log->cond);
+  pthread_mutex_destroy(&log->lock);
+  free(log->buf);
+  free(log);
+}
@@ -0,0 +1,155 @@
+/****************************************************************************
+ * apps/canutils/candump/candump_binlog.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_CANUTILS_CANDUMP_CANDUMP_BINLOG_H
+#define __APPS_CANUTILS_CANDUMP_CANDUMP_BINLOG_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/time.h>
+
+#include <nuttx/can.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* A binary capture file starts with a struct candump_bin_hdr_s followed by
+ * a sequence of records.  Every record is a struct candump_bin_rec_s
+ * immediately followed by 'len' payload bytes (frame data or device name).
+ * All fields are stored in the byte order of the capturing target.
+ */
+
+#define CANDUMP_BIN_MAGIC       "CANDBIN1"
+#define CANDUMP_BIN_VERSION     1
+
+/* Record types */
+
+#define CANDUMP_BIN_FRAME       0  /* Classic CAN frame */
+#define CANDUMP_BIN_FDFRAME     1  /* CAN FD frame */
+#define CANDUMP_BIN_DEVICE      2  /* Interface name for a device index */
+#define CANDUMP_BIN_DROP        3  /* Dropped frames, count in can_id */
+
+/* Sources of dropped frames (flags field of CANDUMP_BIN_DROP) */
+
+#define CANDUMP_BIN_DROP_SOCKET 0  /* Socket receive queue overflow */
+#define CANDUMP_BIN_DROP_RING   1  /* Capture ring buffer overflow */
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+struct candump_bin_hdr_s
+{
+  char     magic[8];               /* CANDUMP_BIN_MAGIC, not terminated */
+  uint32_t version;                /* CANDUMP_BIN_VERSION */
+  uint32_t reserved;
+};
+
+struct candump_bin_rec_s
+{
+  uint8_t  type;                   /* CANDUMP_BIN_* record type */
+  uint8_t  dev;                    /* Device index */
+  uint8_t  flags;                  /* canfd_frame flags or drop source */
+  uint8_t  len;                    /* Number of payload bytes that follow */
+  uint32_t tv_sec;                 /* Receive timestamp */
+  uint32_t tv_usec;
+  uint32_t can_id;                 /* CAN ID incl. flags, or drop count */
+};
+
+struct candump_binlog_s;
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: candump_binlog_open
+ *
+ * Description:
+ *   Create the capture file, allocate a ring buffer of 'bufsize' bytes and
+ *   start the writer thread that drains it to the file.
+ *
+ ****************************************************************************/
+
+FAR struct candump_binlog_s *candump_binlog_open(FAR const char *path,
+                                                 size_t bufsize);
+
+/****************************************************************************
+ * Name: candump_binlog_frame
+ *
+ * Description:
+ *   Queue one received frame.  'devname' is recorded once per device
+ *   index.  If the ring buffer is full the frame is counted as dropped.
+ *   The record becomes visible to the writer on the next
+ *   candump_binlog_commit().
+ *
+ ****************************************************************************/
+
+void candump_binlog_frame(FAR struct candump_binlog_s *log, int dev,
+                          FAR const char *devname,
+                          FAR const struct timeval *tv,
+                          FAR const struct canfd_frame *frame, bool fd);
+
+/****************************************************************************
+ * Name: candump_binlog_drop
+ *
+ * Description:
+ *   Record 'count' frames dropped by the socket layer on device 'dev'.
+ *   If the ring buffer is full the count is kept and recorded with the
+ *   next frame, or when the log is closed.
+ *
+ ****************************************************************************/
+
+void candump_binlog_drop(FAR struct candump_binlog_s *log, int dev,
+                         FAR const struct timeval *tv, uint32_t count);
+
+/****************************************************************************
+ * Name: candump_binlog_commit
+ *
+ * Description:
+ *   Publish all records queued since the last commit to the writer thread.
+ *
+ ****************************************************************************/
+
+void candump_binlog_commit(FAR struct candump_binlog_s *log);
+
+/****************************************************************************
+ * Name: candump_binlog_close
+ *
+ * Description:
+ *   Flush the ring buffer, stop the writer thread, close the file and
+ *   print the capture and drop statistics to 'stream'.
+ *
+ ****************************************************************************/
+
+void candump_binlog_close(FAR struct candump_binlog_s *log,
+                          FAR FILE *stream);
+
+#endif /* __APPS_CANUTILS_CANDUMP_CANDUMP_BINLOG_H */
@@ -26,7 +26,9 @@
 
 #include <nuttx/config.h>
 
+#include <stdbool.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <nuttx/clock.h>
@@ -73,6 +75,48 @@
     } \
   while (0)
 
+/* Longest accepted serial command, e.g. "T1FFFFFFF81122334455667788" */
+
+#define SLCAN_MAXLINE     30
+
+/* Longest outbound frame record: 'T' + 8 id + 1 len + 16 data + '\r' */
+
+#define SLCAN_MAXFRAME    27
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct slcan_s
+{
+  int fd;                  /* UART slcan channel */
+  int s;                   /* CAN socket */
+  int mode;                /* 0: CAN channel closed, 1: open */
+  int canspeed;            /* Bit rate set by the last 'S' command */
+  FAR const char *candev;  /* CAN interface name */
+
+  /* Serial receive: raw input chunk and the command being assembled */
+
+  char rxbuf[CONFIG_CANUTILS_SLCAN_RXBUFSIZE];
+  char line[SLCAN_MAXLINE + 1];
+  size_t linelen;
+  bool overflow;           /* Current command exceeded SLCAN_MAXLINE */
+
+  /* Serial transmit: responses and received frames pending for the tty */
+
+  char txbuf[CONFIG_CANUTILS_SLCAN_TXBUFSIZE];
+  size_t txlen;
+  int txerror;             /* First failed write, the link is unusable */
+
+  /* Frame statistics for the trace output */
+
+  uint32_t rxframes;
+  uint32_t txframes;
+  uint32_t lastrx;
+  uint32_t lasttx;
+  clock_t lastreport;
+};
+
 /****************************************************************************
  * private data
  ****************************************************************************/
@@ -83,52 +127,453 @@ static char opening[] = "starting slcan\n";
 static char opening[] = "";
 #endif
 
-static void ok_return(int fd)
+static const char g_hexdigits[] = "0123456789ABCDEF";
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int tx_flush(FAR struct slcan_s *priv)
+{
+  FAR const char *ptr = priv->txbuf;
+  ssize_t n;
+  int ret = OK;
+
+  while (priv->txlen > 0)
+    {
+      n = write(priv->fd, ptr, priv->txlen);
+      if (n <= 0)
+        {
+          if (n < 0 && errno == EINTR)
+            {
+              continue;
+            }
+
+          /* The buffered records can not be delivered any more */
+
+          ret = n < 0 ? -errno : -EIO;
+          syslog(LOG_ERR, "serial write error %d, %zu bytes lost\n",
+                 ret, priv->txlen);
+          if (priv->txerror == OK)
+            {
+              priv->txerror = ret;
+            }
+
+          break;
+        }
+
+      ptr        += n;
+      priv->txlen -= n;
+    }
+
+  priv->txlen = 0;
+  return ret;
+}
+
+static void tx_append(FAR struct slcan_s *priv, FAR const char *data,
+                      size_t len)
+{
+  if (priv->txlen + len > sizeof(priv->txbuf))
+    {
+      tx_flush(priv);
+    }
+
+  memcpy(&priv->txbuf[priv->txlen], data, len);
+  priv->txlen += len;
+}
+
+static void ok_return(FAR struct slcan_s *priv)
+{
+  tx_append(priv, "\r", 1);
+}
+
+static void fail_return(FAR struct slcan_s *priv)
 {
-  write(fd, "\r", 1);
+  tx_append(priv, "\a", 1); /* BELL return for error */
 }
 
-static void fail_return(int fd)
+static int hexval(char ch)
 {
-  write(fd, "\a", 1); /* BELL return for error */
+  if (ch >= '0' && ch <= '9')
+    {
+      return ch - '0';
+    }
+
+  ch = tolower(ch);
+  if (ch >= 'a' && ch <= 'f')
+    {
+      return ch - 'a' + 10;
+    }
+
+  return -1;
 }
 
-static int readlinebuffer(int fd, char *buf, int maxlen)
+/* Parse 'len' hex digits from 'str', returns -1 on a malformed digit */
+
+static int32_t hexparse(FAR const char *str, int len)
 {
-  size_t n;
-  int meslen = 0;
-  int noeol  = 1;
-  uint8_t ch;
+  int32_t val = 0;
+  int digit;
 
-  while ((meslen < maxlen) && noeol)
+  while (len-- > 0)
     {
-      n = read(fd, &ch, 1);
-      if (n > 0)
+      digit = hexval(*str++);
+      if (digit < 0)
         {
-          /* valid input */
+          return -1;
+        }
 
-          if (ch == '\r')
+      val = (val << 4) | digit;
+    }
+
+  return val;
+}
+
+/* Format one received CAN frame as an slcan record into the transmit
+ * buffer, without going through the stdio formatter.
+ */
+
+static void frame_format(FAR struct slcan_s *priv,
+                         FAR const struct canfd_frame *frame)
+{
+  FAR char *sbp;
+  canid_t id;
+  int digits;
+  int i;
+
+  if (priv->txlen + SLCAN_MAXFRAME > sizeof(priv->txbuf))
+    {
+      tx_flush(priv);
+    }
+
+  sbp = &priv->txbuf[priv->txlen];
+
+  if (frame->can_id & CAN_EFF_FLAG)
+    {
+      /* 29 bit address */
+
+      id     = frame->can_id & CAN_EFF_MASK;
+      digits = 8;
+      *sbp++ = 'T';
+    }
+  else
+    {
+      /* 11 bit address */
+
+      id     = frame->can_id & CAN_SFF_MASK;
+      digits = 3;
+      *sbp++ = 't';
+    }
+
+  for (i = digits - 1; i >= 0; i--)
+    {
+      *sbp++ = g_hexdigits[(id >> (4 * i)) & 0xf];
+    }
+
+  *sbp++ = '0' + frame->len;
+
+  for (i = 0; i < frame->len; i++)
+    {
+      *sbp++ = g_hexdigits[frame->data[i] >> 4];
+      *sbp++ = g_hexdigits[frame->data[i] & 0xf];
+    }
+
+  *sbp++ = '\r';
+  priv->txlen = sbp - priv->txbuf;
+}
+
+/* Transmit a 't' (11 bit) or 'T' (29 bit) command on the CAN bus */
+
+static void frame_transmit(FAR struct slcan_s *priv, FAR const char *buf,
+                           size_t n)
+{
+  struct canfd_frame frame;
+  int digits = buf[0] == 'T' ? 8 : 3;
+  int32_t idval;
+  int32_t val;
+  int i;
+
+  memset(&frame, 0, sizeof(frame));
+
+  if (n < digits + 2 || (idval = hexparse(&buf[1], digits)) < 0)
+    {
+      fail_return(priv);
+      return;
+    }
+
+  frame.len = buf[digits + 1] - '0'; /* get byte count */
+  if (frame.len > CAN_MAX_DLEN || n < digits + 2 + 2 * frame.len)
+    {
+      fail_return(priv);
+      return;
+    }
+
+  /* get canmessage */
+
+  for (i = 0; i < frame.len; i++)
+    {
+      val = hexparse(&buf[digits + 2 + 2 * i], 2);
+      if (val < 0)
+        {
+          fail_return(priv);
+          return;
+        }
+
+      frame.data[i] = val;
+    }
+
+  debug_print("Transmitt: 0x%" PRIX32 " len %d\n", idval, frame.len);
+
+  if (digits == 8)
+    {
+      frame.can_id = idval | CAN_EFF_FLAG; /* 29 bit */
+    }
+  else
+    {
+      frame.can_id = idval; /* 11 bit address command */
+    }
+
+  if (write(priv->s, &frame, CAN_MTU) != CAN_MTU)
+    {
+      syslog(LOG_ERR, "transmitt error\n");
+
+      /* TODO update error flags */
+    }
+  else
+    {
+      priv->txframes++;
+    }
+
+  ok_return(priv);
+}
+
+static void set_speed(FAR struct slcan_s *priv, char code)
+{
+  struct ifreq ifr;
+
+  switch (code)
+    {
+    case '0':
+      priv->canspeed = 10000;
+      break;
+    case '1':
+      priv->canspeed = 20000;
+      break;
+    case '2':
+      priv->canspeed = 50000;
+      break;
+    case '3':
+      priv->canspeed = 100000;
+      break;
+    case '4':
+      priv->canspeed = 125000;
+      break;
+    case '5':
+      priv->canspeed = 250000;
+      break;
+    case '6':
+      priv->canspeed = 500000;
+      break;
+    case '7':
+      priv->canspeed = 800000;
+      break;
+    case '8': /* set speed to 1Mbps */
+      priv->canspeed = 1000000;
+      break;
+    default:
+      break;
+    }
+
+  /* set the device name */
+
+  strlcpy(ifr.ifr_name, priv->candev, IFNAMSIZ);
+
+  ifr.ifr_ifru.ifru_can_data.arbi_bitrate =
+    priv->canspeed / 1000; /* Convert bit/s to kbit/s */
+  ifr.ifr_ifru.ifru_can_data.arbi_samplep = 80;
+
+  if (ioctl(priv->s, SIOCSCANBITRATE, &ifr) < 0)
+    {
+      syslog(LOG_ERR, "set speed %d failed\n", priv->canspeed);
+      fail_return(priv);
+    }
+  else
+    {
+      debug_print("set speed %d\n", priv->canspeed);
+      ok_return(priv);
+    }
+}
+
+/* Handle one complete serial command (without the terminating '\r') */
+
+static void command_process(FAR struct slcan_s *priv, FAR const char *buf,
+                            size_t n)
+{
+  switch (priv->mode)
+    {
+    case 0: /* CAN channel not open */
+      if (buf[0] == 'F')
+        {
+          /* return clear flags */
+
+          tx_append(priv, "F00\r", 4);
+        }
+      else if (buf[0] == 'O')
+        {
+          /* open CAN interface */
+
+          priv->mode = 1;
+          debug_print("Open interface\n");
+          ok_return(priv);
+        }
+      else if (buf[0] == 'S')
+        {
+          /* set CAN interface speed */
+
+          set_speed(priv, n > 1 ? buf[1] : '\0');
+        }
+      else
+        {
+          /* whatever */
+
+          ok_return(priv);
+        }
+      break;
+
+    case 1: /* CAN task running open interface */
+      if (buf[0] == 'C')
+        {
+          /* close interface */
+
+          priv->mode = 0;
+          debug_print("Close interface\n");
+          ok_return(priv);
+        }
+      else if (buf[0] == 'T' || buf[0] == 't')
+        {
+          /* Transmit an extended 29 bit or an 11 bit CAN frame */
+
+          frame_transmit(priv, buf, n);
+        }
+      else
+        {
+          /* whatever */
+
+          ok_return(priv);
+        }
+      break;
+
+    default: /* should not happen */
+      priv->mode = 100;
+      break;
+    }
+}
+
+/* Read everything the UART has available in one call and process every
+ * complete command contained in it.  Partial commands are kept in
+ * priv->line until the terminating '\r' arrives.
+ */
+
+static void serial_receive(FAR struct slcan_s *priv)
+{
+  ssize_t nread;
+  ssize_t i;
+  char ch;
+
+  nread = read(priv->fd, priv->rxbuf, sizeof(priv->rxbuf));
+  if (nread <= 0)
+    {
+      return;
+    }
+
+  for (i = 0; i < nread; i++)
+    {
+      ch = priv->rxbuf[i];
+      if (ch == '\r')
+        {
+          if (priv->overflow)
             {
-              noeol = 0;
-              *buf  = '\0';
+              fail_return(priv);
             }
-          else
+          else if (priv->linelen > 0)
             {
-              *buf++ = ch;
-              meslen++;
+              priv->line[priv->linelen] = '\0';
+              command_process(priv, priv->line, priv->linelen);
             }
+
+          priv->linelen  = 0;
+          priv->overflow = false;
+        }
+      else if (priv->linelen < SLCAN_MAXLINE)
+        {
+          priv->line[priv->linelen++] = ch;
         }
       else
         {
-          return (meslen);
+          priv->overflow = true;
+        }
+    }
+}
+
+/* Drain up to CONFIG_CANUTILS_SLCAN_RXBATCH frames from the CAN socket
+ * per wakeup and queue their records for a single write to the tty.
+ */
+
+static void can_receive(FAR struct slcan_s *priv, FAR struct msghdr *msg,
+                        FAR struct canfd_frame *frame, size_t ctrllen)
+{
+  int nbytes;
+  int count;
+
+  for (count = 0; count < CONFIG_CANUTILS_SLCAN_RXBATCH; count++)
+    {
+      msg->msg_iov->iov_len = sizeof(*frame);
+      msg->msg_namelen      = sizeof(struct sockaddr_can);
+      msg->msg_controllen   = ctrllen;
+      msg->msg_flags        = 0;
+
+      nbytes = recvmsg(priv->s, msg, MSG_DONTWAIT);
+      if (nbytes < 0)
+        {
+          break;
+        }
+
+      if (nbytes == CAN_MTU)
+        {
+          priv->rxframes++;
+          frame_format(priv, frame);
         }
     }
-  return (meslen);
 }
 
-static int caninit(char *candev, int *s, struct sockaddr_can *addr,
-                   char *ctrlmsg, struct canfd_frame *frame,
-                   struct msghdr *msg, struct iovec *iov)
+static void stats_report(FAR struct slcan_s *priv)
+{
+  clock_t now = clock();
+  clock_t elapsed = now - priv->lastreport;
+
+  if (elapsed < CLOCKS_PER_SEC)
+    {
+      return;
+    }
+
+  if (priv->rxframes != priv->lastrx || priv->txframes != priv->lasttx)
+    {
+      debug_print("rx %" PRIu32 " frames/s, tx %" PRIu32 " frames/s\n",
+                  (uint32_t)((uint64_t)(priv->rxframes - priv->lastrx) *
+                             CLOCKS_PER_SEC / elapsed),
+                  (uint32_t)((uint64_t)(priv->txframes - priv->lasttx) *
+                             CLOCKS_PER_SEC / elapsed));
+    }
+
+  priv->lastrx     = priv->rxframes;
+  priv->lasttx     = priv->txframes;
+  priv->lastreport = now;
+}
+
+static int caninit(FAR const char *candev, int *s,
+                   struct sockaddr_can *addr, char *ctrlmsg,
+                   struct canfd_frame *frame, struct msghdr *msg,
+                   struct iovec *iov)
 {
   struct ifreq ifr;
 
@@ -180,21 +625,8 @@ static int caninit(char *candev, int *s, struct sockaddr_can *addr,
 
 int main(int argc, char *argv[])
 {
-  /* UART */
-
-  char buf[31];
-  int mode = 0;
-  size_t n;
-  int canspeed = 1000000; /* default to 1MBps */
-  int fd;                 /* UART slcan channel */
-
-  /* CAN */
-
-  int s;
-  int nbytes;
-  int i;
+  FAR struct slcan_s *priv;
   int ret;
-  int reccount = 0;
   struct sockaddr_can addr;
   struct canfd_frame frame;
   struct msghdr msg;
@@ -202,8 +634,6 @@ int main(int argc, char *argv[])
   fd_set rdfs;
   char ctrlmsg[CMSG_SPACE(sizeof(struct timeval) +
                           3 * sizeof(struct timespec) + sizeof(int))];
-  char sbuf[40];
-  char *sbp;
 
   if (argc != 3)
     {
@@ -215,301 +645,97 @@ int main(int argc, char *argv[])
   char *chrdev = argv[2];
   char *candev = argv[1];
 
+  /* The receive and transmit buffers are too large for the stack */
+
+  priv = zalloc(sizeof(struct slcan_s));
+  if (priv == NULL)
+    {
+      syslog(LOG_ERR, "Failed to allocate slcan state\n");
+      return -1;
+    }
+
+  priv->canspeed   = 1000000; /* default to 1MBps */
+  priv->candev     = candev;
+  priv->lastreport = clock();
+
   debug_print("Starting slcan on NuttX\n");
-  fd = open(chrdev, O_RDWR);
-  if (fd < 0)
+  priv->fd = open(chrdev, O_RDWR);
+  if (priv->fd < 0)
     {
       syslog(LOG_ERR, "Failed to open serial channel %s\n", chrdev);
+      free(priv);
       return -1;
     }
   else
     {
       /* Create CAN socket */
 
-      if (caninit(candev, &s, &addr, &ctrlmsg[0], &frame, &msg, &iov) < 0)
+      memset(&msg, 0, sizeof(msg));
+      if (caninit(candev, &priv->s, &addr, &ctrlmsg[0], &frame, &msg,
+                  &iov) < 0)
         {
           syslog(LOG_ERR, "Failed to open CAN socket %s\n", candev);
-          close(fd);
+          close(priv->fd);
+          free(priv);
           return -1;
         }
 
       /* serial interface active */
 
       debug_print("Serial interface open %s\n", chrdev);
-      write(fd, opening, (sizeof(opening) - 1));
+      write(priv->fd, opening, (sizeof(opening) - 1));
 
-      while (mode < 100)
+      while (priv->mode < 100)
         {
-          /* Setup ooll */
+          /* Setup poll */
 
           FD_ZERO(&rdfs);
-          FD_SET(s, &rdfs);  /* CAN Socket */
-          FD_SET(fd, &rdfs); /* UART */
+          FD_SET(priv->s, &rdfs);  /* CAN Socket */
+          FD_SET(priv->fd, &rdfs); /* UART */
 
-          if ((ret = select(s + 1, &rdfs, NULL, NULL, NULL)) <= 0)
+          ret = select((priv->s > priv->fd ? priv->s : priv->fd) + 1,
+                       &rdfs, NULL, NULL, NULL);
+          if (ret <= 0)
             {
               continue;
             }
 
-          if (FD_ISSET(s, &rdfs))
+          if (FD_ISSET(priv->s, &rdfs))
             {
-              /* CAN received new message in socketCAN input */
-
-              iov.iov_len        = sizeof(frame);
-              msg.msg_namelen    = sizeof(addr);
-              msg.msg_controllen = sizeof(ctrlmsg);
-              msg.msg_flags      = 0;
-              nbytes             = recvmsg(s, &msg, 0);
-
-              if (nbytes == CAN_MTU)
-                {
-                  reccount++;
-                  debug_print("R%d, Id:0x%" PRIx32 "\n",
-                              reccount, frame.can_id);
-                  if (frame.can_id & CAN_EFF_FLAG)
-                    {
-                      /* 29 bit address */
-
-                      frame.can_id = frame.can_id & ~CAN_EFF_FLAG;
-                      snprintf(sbuf, sizeof(sbuf), "T%08" PRIx32 "%d",
-                               frame.can_id, frame.len);
-                      sbp = &sbuf[10];
-                    }
-                  else
-                    {
-                      /* 11 bit address */
-
-                      snprintf(sbuf, sizeof(sbuf), "t%03" PRIx32 "%d",
-                               frame.can_id, frame.len);
-                      sbp = &sbuf[5];
-                    }
-
-                  for (i = 0; i < frame.len; i++)
-                    {
-                      snprintf(sbp, sizeof(sbuf) - (sbp - sbuf),
-                               "%02X", frame.data[i]);
-                      sbp += 2;
-                    }
-
-                  *sbp++ = '\r';
-                  *sbp   = '\0';
-                  write(fd, sbuf, strlen(sbuf));
-                }
+              /* CAN received new messages in socketCAN input */
+
+              can_receive(priv, &msg, &frame, sizeof(ctrlmsg));
             }
 
-          if (FD_ISSET(fd, &rdfs))
+          if (FD_ISSET(priv->fd, &rdfs))
             {
               /* UART receive */
 
-              n = readlinebuffer(fd, buf, 30);
-
-              switch (mode)
-                {
-                case 0: /* CAN channel not open */
-                  if (n > 0)
-                    {
-                      if (buf[0] == 'F')
-                        {
-                          /* return clear flags */
-
-                          write(fd, "F00\r", 4);
-                        }
-                      else if (buf[0] == 'O')
-                        {
-                          /* open CAN interface */
-
-                          mode = 1;
-                          debug_print("Open interface\n");
-                          ok_return(fd);
-                        }
-                      else if (buf[0] == 'S')
-                        {
-                          /* set CAN interface speed */
-
-                          switch (buf[1])
-                            {
-                            case '0':
-                              canspeed = 10000;
-                              break;
-                            case '1':
-                              canspeed = 20000;
-                              break;
-                            case '2':
-                              canspeed = 50000;
-                              break;
-                            case '3':
-                              canspeed = 100000;
-                              break;
-                            case '4':
-                              canspeed = 125000;
-                              break;
-                            case '5':
-                              canspeed = 250000;
-                              break;
-                            case '6':
-                              canspeed = 500000;
-                              break;
-                            case '7':
-                              canspeed = 800000;
-                              break;
-                            case '8': /* set speed to 1Mbps */
-                              canspeed = 1000000;
-                              break;
-                            default:
-                              break;
-                            }
-
-                          struct ifreq ifr;
-
-                          /* set the device name */
-
-                          strlcpy(ifr.ifr_name, argv[1], IFNAMSIZ);
-
-                          ifr.ifr_ifru.ifru_can_data.arbi_bitrate =
-                            canspeed / 1000; /* Convert bit/s to kbit/s */
-                          ifr.ifr_ifru.ifru_can_data.arbi_samplep = 80;
-
-                          if (ioctl(s, SIOCSCANBITRATE, &ifr) < 0)
-                            {
-                              syslog(LOG_ERR, "set speed %d failed\n",
-                                     canspeed);
-                              fail_return(fd);
-                            }
-                          else
-                            {
-                              debug_print("set speed %d\n", canspeed);
-                              ok_return(fd);
-                            }
-                        }
-                      else
-                        {
-                          /* whatever */
-
-                          ok_return(fd);
-                        }
-                    }
-                  break;
-                case 1: /* CAN task running open interface */
-                  if (n > 0)
-                    {
-                      if (buf[0] == 'C')
-                        {
-                          /* close interface */
-
-                          mode = 0;
-                          debug_print("Close interface\n");
-                          ok_return(fd);
-                        }
-                      else if (buf[0] == 'T')
-                        {
-                          /* Transmit an extended 29 bit CAN frame */
-
-                          char tbuf[9];
-                          int idval;
-                          int val;
-
-                          /* get 29bit CAN ID */
-
-                          strncpy(tbuf, &buf[1], 8);
-                          tbuf[8] = '\0';
-                          sscanf(tbuf, "%x", &idval);
-
-                          frame.len = buf[9] - '0'; /* get byte count */
-
-                          /* get canmessage */
-
-                          for (i = 0; i < frame.len; i++)
-                            {
-                              tbuf[0] = buf[10 + (2 * i)];
-                              tbuf[1] = buf[11 + (2 * i)];
-                              tbuf[2] = '\0';
-                              sscanf(tbuf, "%x", &val);
-                              frame.data[i] = val & 0xff;
-                            }
-
-                          debug_print("Transmitt: 0x%X ", idval);
-                          for (i = 0; i < frame.len; i++)
-                            {
-                              debug_print("0x%02X ", frame.data[i]);
-                            }
-
-                          debug_print("\n");
-
-                          frame.can_id = idval | CAN_EFF_FLAG; /* 29 bit */
-
-                          if (write(s, &frame, CAN_MTU) != CAN_MTU)
-                            {
-                              syslog(LOG_ERR, "transmitt error\n");
-
-                              /* TODO update error flags */
-                            }
-
-                          ok_return(fd);
-                        }
-                      else if (buf[0] == 't')
-                        {
-                          /* Transmit an 11 bit CAN frame */
-
-                          char tbuf[9];
-                          int idval;
-                          int val;
-
-                          /* get 11bit CAN ID */
-
-                          strncpy(tbuf, &buf[1], 3);
-                          tbuf[3] = '\0';
-                          sscanf(tbuf, "%x", &idval);
-
-                          frame.len = buf[4] - '0'; /* get byte count */
-
-                          /* get canmessage */
-
-                          for (i = 0; i < frame.len; i++)
-                            {
-                              tbuf[0] = buf[5 + (2 * i)];
-                              tbuf[1] = buf[6 + (2 * i)];
-                              tbuf[2] = '\0';
-                              sscanf(tbuf, "%x", &val);
-                              frame.data[i] = val & 0xff;
-                            }
-
-                          debug_print("Transmitt: 0x%X ", idval);
-                          for (i = 0; i < frame.len; i++)
-                            {
-                              debug_print("0x%02X ", frame.data[i]);
-                            }
-
-                          debug_print("\n");
-
-                          frame.can_id = idval; /* 11 bit address command */
-
-                          if (write(s, &frame, CAN_MTU) != CAN_MTU)
-                            {
-                              syslog(LOG_ERR, "transmitt error\n");
-
-                              /* TODO update error flags */
-                            }
-
-                          ok_return(fd);
-                        }
-                      else
-                        {
-                          /* whatever */
-
-                          ok_return(fd);
-                        }
-                    }
-                  break;
-                default: /* should not happen */
-                  mode = 100;
-                  break;
-                }
+              serial_receive(priv);
+            }
+
+          /* Push all responses and frame records out in one write.  Stop
+           * once a write has failed, the host no longer sees the bus.
+           */
+
+          tx_flush(priv);
+          if (priv->txerror < 0)
+            {
+              syslog(LOG_ERR, "serial link lost, stopping\n");
+              break;
+            }
+
+          if (DEBUG)
+            {
+              stats_report(priv);
             }
         }
 
-      close(fd);
-      close(s);
+      close(priv->fd);
+      close(priv->s);
     }
 
-  return 0;
+  ret = priv->txerror < 0 ? -1 : 0;
+  free(priv);
+  return ret;
 }
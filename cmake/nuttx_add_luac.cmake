@@ -0,0 +1,91 @@
+# ##############################################################################
+# apps/cmake/nuttx_add_luac.cmake
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed to the Apache Software Foundation (ASF) under one or more contributor
+# license agreements.  See the NOTICE file distributed with this work for
+# additional information regarding copyright ownership.  The ASF licenses this
+# file to you under the Apache License, Version 2.0 (the "License"); you may not
+# use this file except in compliance with the License.  You may obtain a copy of
+# the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+# License for the specific language governing permissions and limitations under
+# the License.
+#
+# ##############################################################################
+
+# Host luac built by interpreters/lua when CONFIG_INTERPRETER_LUA_LUAC is set.
+# The path is fixed here so that applications configured before
+# interpreters/lua can already refer to it.
+
+set(LUAC_HOST_DIR ${CMAKE_BINARY_DIR}/apps/interpreters/lua/luac_host)
+set(LUAC_EXECUTABLE ${LUAC_HOST_DIR}/luac)
+
+include(nuttx_parse_function_args)
+
+# ~~~
+# nuttx_add_luac
+#
+# Description:
+#    Precompile Lua scripts with the host luac. Each script is written to
+#    OUTPUT_DIR under its original name, so that loadfile() and require()
+#    find the binary chunk without any change to the scripts.
+#
+# Example:
+#  nuttx_add_luac(
+#    TARGET
+#    myapp_luac
+#    OUTPUT_DIR
+#    ${CMAKE_CURRENT_BINARY_DIR}/romfs
+#    SRCS
+#    ${scripts})
+#
+# ~~~
+
+function(nuttx_add_luac)
+
+  # parse arguments into variables
+
+  nuttx_parse_function_args(
+    FUNC
+    nuttx_add_luac
+    ONE_VALUE
+    TARGET
+    OUTPUT_DIR
+    MULTI_VALUE
+    SRCS
+    REQUIRED
+    TARGET
+    OUTPUT_DIR
+    SRCS
+    ARGN
+    ${ARGN})
+
+  set(LUAC_FLAGS)
+  if(CONFIG_INTERPRETER_LUA_LUAC_STRIP)
+    list(APPEND LUAC_FLAGS -s)
+  endif()
+
+  set(LUAC_OUTPUTS)
+  foreach(src ${SRCS})
+    get_filename_component(name ${src} NAME)
+    set(out ${OUTPUT_DIR}/${name})
+    add_custom_command(
+      OUTPUT ${out}
+      COMMAND ${CMAKE_COMMAND} -E make_directory ${OUTPUT_DIR}
+      COMMAND ${LUAC_EXECUTABLE} ${LUAC_FLAGS} -o ${out} ${src}
+      DEPENDS ${src} luac_host
+      VERBATIM
+      COMMENT "LUAC: ${name}")
+    list(APPEND LUAC_OUTPUTS ${out})
+  endforeach()
+
+  add_custom_target(${TARGET} DEPENDS ${LUAC_OUTPUTS})
+
+endfunction()
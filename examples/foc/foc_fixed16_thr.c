@@ -130,6 +130,15 @@ static int foc_handler_run(FAR struct foc_motor_b16_s *motor,
 
   ret = foc_handler_run_b16(&motor->handler, &input, &output);
 
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+  /* Collect handler stage times */
+
+  foc_perf_stage_put(&dev->perf, FOC_PERF_STAGE_CTRL,
+                     motor->handler.perf.ctrl);
+  foc_perf_stage_put(&dev->perf, FOC_PERF_STAGE_MOD,
+                     motor->handler.perf.mod);
+#endif
+
   /* Get duty from controller */
 
   for (i = 0; i < CONFIG_MOTOR_FOC_PHASES; i += 1)
@@ -289,6 +298,21 @@ static void foc_fixed16_nxscope(FAR struct foc_nxscope_s *nxs,
   ptr = svm3_tmp;
   nxscope_put_vb16(&nxs->nxs, i++, ptr, 4);
 #endif
+#if (CONFIG_EXAMPLES_FOC_NXSCOPE_CFG & FOC_NXSCOPE_PERF)
+  uint32_t perf_tmp[FOC_PERF_STAGE_NUM];
+
+  /* Skip observer channels which are not captured for fixed16 */
+
+#  if (CONFIG_EXAMPLES_FOC_NXSCOPE_CFG & FOC_NXSCOPE_VOBS)
+  i++;
+#  endif
+#  if (CONFIG_EXAMPLES_FOC_NXSCOPE_CFG & FOC_NXSCOPE_AOBS)
+  i++;
+#  endif
+
+  foc_perf_stage_last(&dev->perf, perf_tmp);
+  nxscope_put_vuint32(&nxs->nxs, i++, perf_tmp, FOC_PERF_STAGE_NUM);
+#endif
 
   nxscope_unlock(&nxs->nxs);
 }
@@ -340,6 +364,12 @@ int foc_fixed16_thr(FAR struct foc_ctrl_env_s *envp)
   motor.pwm_duty_max = FOCDUTY_TO_FIXED16(dev.info.hw_cfg.pwm_max);
   motor.iphase_adc = b16idiv(dev.info.hw_cfg.iphase_scale, 100000);
 
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+  /* Stage times are collected in the device perf data */
+
+  motor.perf = &dev.perf;
+#endif
+
   /* Start with motor free */
 
   handle.app_state = FOC_EXAMPLE_STATE_FREE;
@@ -30,6 +30,10 @@
 #include <string.h>
 #include <dspb16.h>
 
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+#  include <nuttx/clock.h>
+#endif
+
 #include "foc_cfg.h"
 #include "foc_debug.h"
 #include "foc_motor_b16.h"
@@ -1850,7 +1854,10 @@ errout:
 
 int foc_motor_get(FAR struct foc_motor_b16_s *motor)
 {
-  int ret = OK;
+  int      ret = OK;
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+  uint32_t ts  = perf_gettime();
+#endif
 
   DEBUGASSERT(motor);
 
@@ -1862,6 +1869,10 @@ int foc_motor_get(FAR struct foc_motor_b16_s *motor)
       goto errout;
     }
 
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+  ts = foc_perf_stage(motor->perf, FOC_PERF_STAGE_ANGLE, ts);
+#endif
+
 #ifdef CONFIG_EXAMPLES_FOC_HAVE_VEL
   /* Get motor velocity */
 
@@ -1870,6 +1881,10 @@ int foc_motor_get(FAR struct foc_motor_b16_s *motor)
     {
       goto errout;
     }
+
+#  ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+  foc_perf_stage(motor->perf, FOC_PERF_STAGE_VEL, ts);
+#  endif
 #endif
 
 errout:
@@ -30,6 +30,10 @@
 #include <string.h>
 #include <dsp.h>
 
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+#  include <nuttx/clock.h>
+#endif
+
 #include "foc_cfg.h"
 #include "foc_debug.h"
 #include "foc_motor_f32.h"
@@ -1839,7 +1843,10 @@ errout:
 
 int foc_motor_get(FAR struct foc_motor_f32_s *motor)
 {
-  int ret = OK;
+  int      ret = OK;
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+  uint32_t ts  = perf_gettime();
+#endif
 
   DEBUGASSERT(motor);
 
@@ -1851,6 +1858,10 @@ int foc_motor_get(FAR struct foc_motor_f32_s *motor)
       goto errout;
     }
 
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+  ts = foc_perf_stage(motor->perf, FOC_PERF_STAGE_ANGLE, ts);
+#endif
+
 #ifdef CONFIG_EXAMPLES_FOC_HAVE_VEL
   /* Get motor velocity */
 
@@ -1859,6 +1870,10 @@ int foc_motor_get(FAR struct foc_motor_f32_s *motor)
     {
       goto errout;
     }
+
+#  ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+  foc_perf_stage(motor->perf, FOC_PERF_STAGE_VEL, ts);
+#  endif
 #endif
 
 errout:
@@ -32,6 +32,10 @@
 #include "foc_mq.h"
 #include "foc_thr.h"
 
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+#  include "foc_perf.h"
+#endif
+
 #include "industry/foc/float/foc_handler.h"
 #include "industry/foc/float/foc_ramp.h"
 #include "industry/foc/float/foc_angle.h"
@@ -71,6 +75,9 @@ struct foc_motor_f32_s
   /* App data ***************************************************************/
 
   FAR struct foc_ctrl_env_s    *envp;         /* Thread env */
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+  FAR struct foc_perf_s        *perf;         /* Stage perf (device) */
+#endif
   struct foc_mq_s               mq;           /* MQ data */
   bool                          fault;        /* Fault flag */
   bool                          startstop;    /* Start/stop request */
@@ -34,6 +34,10 @@
 #include "foc_nxscope.h"
 #include "foc_thr.h"
 
+#if (CONFIG_EXAMPLES_FOC_NXSCOPE_CFG & FOC_NXSCOPE_PERF)
+#  include "foc_perf.h"
+#endif
+
 #include "industry/foc/foc_common.h"
 
 /****************************************************************************
@@ -44,6 +48,11 @@
 #  error CONFIG_LOGGING_NXSCOPE_DISABLE_PUTLOCK must be set to proper operation.
 #endif
 
+#if (CONFIG_EXAMPLES_FOC_NXSCOPE_CFG & FOC_NXSCOPE_PERF) && \
+    !defined(CONFIG_EXAMPLES_FOC_PERF_STAGES)
+#  error FOC_NXSCOPE_PERF requires CONFIG_EXAMPLES_FOC_PERF_STAGES
+#endif
+
 #if defined(CONFIG_LOGGING_NXSCOPE_INTF_SERIAL) && !defined(CONFIG_SERIAL_RTT)
 #  ifndef CONFIG_SERIAL_TERMIOS
 #    error CONFIG_SERIAL_TERMIOS must be set to proper operation.
@@ -247,6 +256,13 @@ int foc_nxscope_init(FAR struct foc_nxscope_s *nxs)
 #if (CONFIG_EXAMPLES_FOC_NXSCOPE_CFG & FOC_NXSCOPE_AOBS)
       nxscope_chan_init(&nxs->nxs, i++, "aobs", u.u8, 1, 0);
 #endif
+#if (CONFIG_EXAMPLES_FOC_NXSCOPE_CFG & FOC_NXSCOPE_PERF)
+      /* Stage times are raw perf ticks regardless of the controller type */
+
+      u.s.dtype = NXSCOPE_TYPE_UINT32;
+      nxscope_chan_init(&nxs->nxs, i++, "perf", u.u8, FOC_PERF_STAGE_NUM,
+                        0);
+#endif
 
       if (i > CONFIG_EXAMPLES_FOC_NXSCOPE_CHANNELS)
         {
@@ -27,6 +27,7 @@
 #include <nuttx/config.h>
 
 #include <assert.h>
+#include <inttypes.h>
 #include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
@@ -41,6 +42,21 @@
 
 #define PRINTF_PERF(format, ...) printf(format, ##__VA_ARGS__)
 
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+static const char *g_foc_perf_stage_name[FOC_PERF_STAGE_NUM] =
+{
+  "angle",
+  "vel",
+  "ctrl",
+  "mod",
+  "exec"
+};
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -83,8 +99,19 @@ static bool foc_perf_per(struct foc_perf_s *p, FAR uint32_t *per)
 
 int foc_perf_init(struct foc_perf_s *p)
 {
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+  int i = 0;
+#endif
+
   memset(p, 0, sizeof(struct foc_perf_s));
 
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+  for (i = 0; i < FOC_PERF_STAGE_NUM; i += 1)
+    {
+      p->stage[i].min = UINT32_MAX;
+    }
+#endif
+
   return OK;
 }
 
@@ -128,6 +155,10 @@ void foc_perf_end(struct foc_perf_s *p)
       p->per_max = tmp;
       p->per_max_changed = true;
     }
+
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+  foc_perf_stage_put(p, FOC_PERF_STAGE_EXEC, p->exec);
+#endif
 }
 
 /****************************************************************************
@@ -170,5 +201,142 @@ void foc_perf_exit(struct foc_perf_s *p)
   PRINTF_PERF("per ticks=%" PRId32 "\n", max);
   PRINTF_PERF("  nsec=%" PRId32 "\n", ts.tv_nsec);
 
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+  foc_perf_stage_dump(p);
+#endif
+
   PRINTF_PERF("===============================\n");
 }
+
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+/****************************************************************************
+ * Name: foc_perf_stage_put
+ *
+ * Description:
+ *   Add one execution time sample for a given control loop stage
+ *
+ ****************************************************************************/
+
+void foc_perf_stage_put(struct foc_perf_s *p, int stage, uint32_t ticks)
+{
+  FAR struct foc_perf_stage_s *s = &p->stage[stage];
+  uint32_t                     bin;
+
+  DEBUGASSERT(stage < FOC_PERF_STAGE_NUM);
+
+  s->last = ticks;
+  s->cnt += 1;
+  s->sum += ticks;
+
+  if (ticks < s->min)
+    {
+      s->min = ticks;
+    }
+
+  if (ticks > s->max)
+    {
+      s->max = ticks;
+    }
+
+  bin = ticks >> CONFIG_EXAMPLES_FOC_PERF_HIST_SHIFT;
+  if (bin >= CONFIG_EXAMPLES_FOC_PERF_HIST_BINS)
+    {
+      bin = CONFIG_EXAMPLES_FOC_PERF_HIST_BINS - 1;
+    }
+
+  s->hist[bin] += 1;
+}
+
+/****************************************************************************
+ * Name: foc_perf_stage
+ *
+ * Description:
+ *   Close a control loop stage that began at 'start' and return the
+ *   current time, so consecutive stages can be chained.
+ *
+ ****************************************************************************/
+
+uint32_t foc_perf_stage(struct foc_perf_s *p, int stage, uint32_t start)
+{
+  uint32_t now = perf_gettime();
+
+  foc_perf_stage_put(p, stage, now - start);
+
+  return now;
+}
+
+/****************************************************************************
+ * Name: foc_perf_stage_last
+ *
+ * Description:
+ *   Get the last sample of all stages (FOC_PERF_STAGE_NUM values)
+ *
+ ****************************************************************************/
+
+void foc_perf_stage_last(struct foc_perf_s *p, FAR uint32_t *ticks)
+{
+  int i = 0;
+
+  for (i = 0; i < FOC_PERF_STAGE_NUM; i += 1)
+    {
+      ticks[i] = p->stage[i].last;
+    }
+}
+
+/****************************************************************************
+ * Name: foc_perf_stage_dump
+ ****************************************************************************/
+
+void foc_perf_stage_dump(struct foc_perf_s *p)
+{
+  FAR struct foc_perf_stage_s *s = NULL;
+  struct timespec              ts;
+  uint32_t                     avg;
+  int                          i;
+  int                          j;
+
+  PRINTF_PERF("stage    min      avg      max   [ticks]\n");
+
+  for (i = 0; i < FOC_PERF_STAGE_NUM; i += 1)
+    {
+      s = &p->stage[i];
+      if (s->cnt == 0)
+        {
+          continue;
+        }
+
+      avg = (uint32_t)(s->sum / s->cnt);
+      perf_convert(avg, &ts);
+
+      PRINTF_PERF("%-6s %7" PRIu32 " %8" PRIu32 " %8" PRIu32
+                  "   (avg %ld nsec)\n",
+                  g_foc_perf_stage_name[i], s->min, avg, s->max,
+                  ts.tv_nsec);
+    }
+
+  PRINTF_PERF("histogram, bin width %d ticks:\n",
+              1 << CONFIG_EXAMPLES_FOC_PERF_HIST_SHIFT);
+
+  for (i = 0; i < FOC_PERF_STAGE_NUM; i += 1)
+    {
+      s = &p->stage[i];
+      if (s->cnt == 0)
+        {
+          continue;
+        }
+
+      PRINTF_PERF("%s:\n", g_foc_perf_stage_name[i]);
+
+      for (j = 0; j < CONFIG_EXAMPLES_FOC_PERF_HIST_BINS; j += 1)
+        {
+          if (s->hist[j] > 0)
+            {
+              PRINTF_PERF("  %6d%s %" PRIu32 "\n",
+                          j << CONFIG_EXAMPLES_FOC_PERF_HIST_SHIFT,
+                          (j == CONFIG_EXAMPLES_FOC_PERF_HIST_BINS - 1) ?
+                          "+" : " ", s->hist[j]);
+            }
+        }
+    }
+}
+#endif
@@ -29,10 +29,45 @@
 
 #include <nuttx/config.h>
 
+#include <stdbool.h>
+#include <stdint.h>
+
 /****************************************************************************
  * Public Type Definition
  ****************************************************************************/
 
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+/* Control loop stages measured separately */
+
+enum foc_perf_stage_e
+{
+  FOC_PERF_STAGE_ANGLE = 0,     /* Angle observer/sensor (foc_angle) */
+  FOC_PERF_STAGE_VEL,           /* Velocity observer (foc_velocity) */
+  FOC_PERF_STAGE_CTRL,          /* Current/voltage controller */
+  FOC_PERF_STAGE_MOD,           /* Modulation (SVM3) */
+  FOC_PERF_STAGE_EXEC,          /* Whole control loop execution */
+  FOC_PERF_STAGE_NUM
+};
+
+/* Per-stage statistics and latency histogram.
+ *
+ * All fields are written only from the control thread, so updating them
+ * needs no locking. Bin i counts samples in
+ * [i << CONFIG_EXAMPLES_FOC_PERF_HIST_SHIFT, (i + 1) << ...) ticks,
+ * the last bin also collects everything above its lower bound.
+ */
+
+struct foc_perf_stage_s
+{
+  uint32_t last;                /* Last sample */
+  uint32_t min;                 /* Min sample */
+  uint32_t max;                 /* Max sample */
+  uint32_t cnt;                 /* Number of samples */
+  uint64_t sum;                 /* Sum of samples */
+  uint32_t hist[CONFIG_EXAMPLES_FOC_PERF_HIST_BINS];
+};
+#endif
+
 /* The diagram below illustrates the operation of a simple FOC ocntroller
  * performance measurement tool:
  *
@@ -65,6 +100,9 @@ struct foc_perf_s
   uint32_t per_max;             /* Control loop period max */
   uint32_t exec;                /* Temporary storage */
   uint32_t per;                 /* Temporary storage */
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+  struct foc_perf_stage_s stage[FOC_PERF_STAGE_NUM];
+#endif
 };
 
 /****************************************************************************
@@ -76,5 +114,11 @@ void foc_perf_start(struct foc_perf_s *p);
 void foc_perf_end(struct foc_perf_s *p);
 void foc_perf_live(struct foc_perf_s *p);
 void foc_perf_exit(struct foc_perf_s *p);
+#ifdef CONFIG_EXAMPLES_FOC_PERF_STAGES
+uint32_t foc_perf_stage(struct foc_perf_s *p, int stage, uint32_t start);
+void foc_perf_stage_put(struct foc_perf_s *p, int stage, uint32_t ticks);
+void foc_perf_stage_last(struct foc_perf_s *p, FAR uint32_t *ticks);
+void foc_perf_stage_dump(struct foc_perf_s *p);
+#endif
 
 #endif /* __APPS_EXAMPLES_FOC_FOC_PERF_H */
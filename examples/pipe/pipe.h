@@ -54,5 +54,8 @@ extern int transfer_test(int fdin, int fdout,
                          int boost_reader, int boost_writer);
 extern int interlock_test(void);
 extern int redirection_test(void);
+#ifdef CONFIG_EXAMPLES_PIPE_BENCH
+extern int pipe_bench(int argc, FAR char *argv[]);
+#endif
 
 #endif /* __APPS_EXAMPLES_PIPE_PIPE_H */
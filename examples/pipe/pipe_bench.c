@@ -0,0 +1,1201 @@
+/****************************************************************************
+ * apps/examples/pipe/pipe_bench.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <mqueue.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "pipe.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_MAXSIZES    8
+#define BENCH_MAXPAIRS    8
+#define BENCH_MAXTHREADS  8     /* Per side */
+#define BENCH_MQ_MAXMSG   8
+#define BENCH_MQ_NAME     "/pipebench%d"
+
+#define NSEC_PER_SEC      1000000000ull
+
+#if CONFIG_DEV_PIPE_SIZE > 0
+#  define BENCH_HAVE_PIPE 1
+#endif
+
+#if CONFIG_DEV_FIFO_SIZE > 0
+#  define BENCH_HAVE_FIFO 1
+#endif
+
+#ifndef CONFIG_DISABLE_MQUEUE
+#  define BENCH_HAVE_MQ 1
+#endif
+
+#ifdef CONFIG_NET_LOCAL_STREAM
+#  define BENCH_HAVE_LOCAL 1
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+enum bench_type_e
+{
+  BENCH_PIPE = 0,
+  BENCH_FIFO,
+  BENCH_MQ,
+  BENCH_LOCAL,
+  BENCH_NTYPES
+};
+
+enum bench_affinity_e
+{
+  BENCH_AFFINITY_NONE = 0,     /* Let the scheduler place threads */
+  BENCH_AFFINITY_SAME,         /* Everything on CPU 0 */
+  BENCH_AFFINITY_SPLIT         /* Writers on CPU 0, readers on CPU 1 */
+};
+
+/* One unidirectional channel of any of the transports */
+
+struct bench_chan_s
+{
+  int type;
+  int index;                   /* Selects the FIFO path or mqueue name */
+  int rfd;
+  int wfd;
+#ifdef BENCH_HAVE_MQ
+  mqd_t mq;
+#endif
+};
+
+struct bench_opts_s
+{
+  unsigned int types;          /* Bit set of enum bench_type_e */
+  int nsizes;
+  size_t sizes[BENCH_MAXSIZES];
+  int npairs;
+  int writers[BENCH_MAXPAIRS];
+  int readers[BENCH_MAXPAIRS];
+  size_t bytes;                /* Bytes moved per throughput run */
+  int samples;                 /* Latency samples per size */
+  int affinity;
+};
+
+struct bench_thread_s
+{
+  FAR struct bench_run_s *run;
+  pthread_t tid;
+  size_t msgs;                 /* Messages to write, writers only */
+  uint64_t bytes;
+  unsigned long waits;         /* Operations that had to block */
+  int error;
+};
+
+struct bench_run_s
+{
+  struct bench_chan_s chan;
+  size_t size;
+  bool counting;               /* Blocking waits can be counted */
+  volatile bool abort;         /* Not all threads started, do nothing */
+  sem_t start;                 /* Posted once per thread to start it */
+  struct bench_thread_s writers[BENCH_MAXTHREADS];
+  struct bench_thread_s readers[BENCH_MAXTHREADS];
+};
+
+/* Ping-pong latency state.  The stamp is written by the ping side before
+ * each message and read by the pong side after it wakes up; the reply
+ * orders the two, so no locking is needed.
+ */
+
+struct bench_lat_s
+{
+  struct bench_chan_s ping;
+  struct bench_chan_s pong;
+  size_t size;
+  int samples;
+  volatile uint64_t stamp;
+  FAR uint32_t *lat;
+  int error;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const char * const g_bench_names[BENCH_NTYPES] =
+{
+  "pipe", "fifo", "mqueue", "local"
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bench_now
+ ****************************************************************************/
+
+static uint64_t bench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: bench_chan_open
+ ****************************************************************************/
+
+static int bench_chan_open(FAR struct bench_chan_s *chan, int type,
+                           int index, size_t size)
+{
+  memset(chan, 0, sizeof(*chan));
+  chan->type  = type;
+  chan->index = index;
+  chan->rfd   = -1;
+  chan->wfd   = -1;
+
+  switch (type)
+    {
+#ifdef BENCH_HAVE_PIPE
+      case BENCH_PIPE:
+        {
+          int fd[2];
+
+          if (pipe(fd) < 0)
+            {
+              return -errno;
+            }
+
+          chan->rfd = fd[0];
+          chan->wfd = fd[1];
+        }
+        return OK;
+#endif
+
+#ifdef BENCH_HAVE_FIFO
+      case BENCH_FIFO:
+        {
+          FAR const char *path = index ? FIFO_PATH2 : FIFO_PATH1;
+
+          if (mkfifo(path, 0666) < 0 && errno != EEXIST)
+            {
+              return -errno;
+            }
+
+          /* Open the read side without blocking for a writer, then make
+           * it blocking again for the benchmark.
+           */
+
+          chan->rfd = open(path, O_RDONLY | O_NONBLOCK);
+          chan->wfd = open(path, O_WRONLY);
+          if (chan->rfd < 0 || chan->wfd < 0)
+            {
+              int errcode = errno;
+
+              close(chan->rfd);
+              close(chan->wfd);
+              remove(path);
+              return -errcode;
+            }
+
+          fcntl(chan->rfd, F_SETFL, fcntl(chan->rfd, F_GETFL) & ~O_NONBLOCK);
+        }
+        return OK;
+#endif
+
+#ifdef BENCH_HAVE_MQ
+      case BENCH_MQ:
+        {
+          struct mq_attr attr;
+          char name[16];
+
+          memset(&attr, 0, sizeof(attr));
+          attr.mq_maxmsg  = BENCH_MQ_MAXMSG;
+          attr.mq_msgsize = size;
+
+          snprintf(name, sizeof(name), BENCH_MQ_NAME, index);
+          chan->mq = mq_open(name, O_RDWR | O_CREAT, 0666, &attr);
+          if (chan->mq == (mqd_t)-1)
+            {
+              return -errno;
+            }
+        }
+        return OK;
+#endif
+
+#ifdef BENCH_HAVE_LOCAL
+      case BENCH_LOCAL:
+        {
+          int sv[2];
+
+          if (socketpair(AF_LOCAL, SOCK_STREAM, 0, sv) < 0)
+            {
+              return -errno;
+            }
+
+          chan->rfd = sv[0];
+          chan->wfd = sv[1];
+        }
+        return OK;
+#endif
+
+      default:
+        return -ENOSYS;
+    }
+}
+
+/****************************************************************************
+ * Name: bench_chan_close
+ ****************************************************************************/
+
+static void bench_chan_close(FAR struct bench_chan_s *chan)
+{
+#ifdef BENCH_HAVE_MQ
+  if (chan->type == BENCH_MQ)
+    {
+      char name[16];
+
+      snprintf(name, sizeof(name), BENCH_MQ_NAME, chan->index);
+      mq_close(chan->mq);
+      mq_unlink(name);
+      return;
+    }
+#endif
+
+  if (chan->rfd >= 0)
+    {
+      close(chan->rfd);
+    }
+
+  if (chan->wfd >= 0)
+    {
+      close(chan->wfd);
+    }
+
+#ifdef BENCH_HAVE_FIFO
+  if (chan->type == BENCH_FIFO)
+    {
+      remove(chan->index ? FIFO_PATH2 : FIFO_PATH1);
+    }
+#endif
+}
+
+/****************************************************************************
+ * Name: bench_chan_eof
+ *
+ * Description:
+ *   Make every one of 'nreaders' blocked readers return end of stream.
+ *
+ ****************************************************************************/
+
+static void bench_chan_eof(FAR struct bench_chan_s *chan, int nreaders)
+{
+#ifdef BENCH_HAVE_MQ
+  if (chan->type == BENCH_MQ)
+    {
+      char dummy = 0;
+
+      /* An empty message is the end marker, one per reader */
+
+      while (nreaders-- > 0)
+        {
+          mq_send(chan->mq, &dummy, 0, 0);
+        }
+
+      return;
+    }
+#endif
+
+#ifdef BENCH_HAVE_LOCAL
+  if (chan->type == BENCH_LOCAL)
+    {
+      shutdown(chan->wfd, SHUT_WR);
+      return;
+    }
+#endif
+
+  close(chan->wfd);
+  chan->wfd = -1;
+}
+
+/****************************************************************************
+ * Name: bench_chan_write
+ *
+ * Description:
+ *   Write a whole message.  Returns the number of bytes written or a
+ *   negated errno.
+ *
+ ****************************************************************************/
+
+static ssize_t bench_chan_write(FAR struct bench_chan_s *chan,
+                                FAR const char *buf, size_t len)
+{
+  size_t done = 0;
+  ssize_t ret;
+
+#ifdef BENCH_HAVE_MQ
+  if (chan->type == BENCH_MQ)
+    {
+      return mq_send(chan->mq, buf, len, 0) < 0 ? -errno : (ssize_t)len;
+    }
+#endif
+
+  while (done < len)
+    {
+      ret = write(chan->wfd, buf + done, len - done);
+      if (ret <= 0)
+        {
+          return ret < 0 ? -errno : -EPIPE;
+        }
+
+      done += ret;
+    }
+
+  return done;
+}
+
+/****************************************************************************
+ * Name: bench_chan_read
+ *
+ * Description:
+ *   Read up to 'len' bytes, or exactly one message for a message queue.
+ *   Returns zero at end of stream.
+ *
+ ****************************************************************************/
+
+static ssize_t bench_chan_read(FAR struct bench_chan_s *chan,
+                               FAR char *buf, size_t len)
+{
+  ssize_t ret;
+
+#ifdef BENCH_HAVE_MQ
+  if (chan->type == BENCH_MQ)
+    {
+      ret = mq_receive(chan->mq, buf, len, NULL);
+      return ret < 0 ? -errno : ret;
+    }
+#endif
+
+  ret = read(chan->rfd, buf, len);
+  return ret < 0 ? -errno : ret;
+}
+
+/****************************************************************************
+ * Name: bench_chan_readall
+ ****************************************************************************/
+
+static int bench_chan_readall(FAR struct bench_chan_s *chan, FAR char *buf,
+                              size_t len)
+{
+  size_t done = 0;
+  ssize_t ret;
+
+  while (done < len)
+    {
+      ret = bench_chan_read(chan, buf + done, len - done);
+      if (ret <= 0)
+        {
+          return ret < 0 ? ret : -EPIPE;
+        }
+
+      done += ret;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bench_chan_blocks
+ *
+ * Description:
+ *   Return 1 if reading (or writing 'len' bytes) would block right now,
+ *   0 if not and a negated errno if the transport cannot tell.  Every
+ *   blocking operation costs the caller one switch out and one back in,
+ *   so this is how context switches are counted without kernel support.
+ *
+ ****************************************************************************/
+
+static int bench_chan_blocks(FAR struct bench_chan_s *chan, bool write,
+                             size_t len)
+{
+  int avail;
+
+#ifdef BENCH_HAVE_MQ
+  if (chan->type == BENCH_MQ)
+    {
+      struct mq_attr attr;
+
+      if (mq_getattr(chan->mq, &attr) < 0)
+        {
+          return -errno;
+        }
+
+      return write ? attr.mq_curmsgs >= attr.mq_maxmsg :
+                     attr.mq_curmsgs == 0;
+    }
+#endif
+
+  if (write)
+    {
+#ifdef FIONSPACE
+      if (chan->type != BENCH_LOCAL &&
+          ioctl(chan->wfd, FIONSPACE, (unsigned long)&avail) >= 0)
+        {
+          return (size_t)avail < len;
+        }
+#endif
+
+      return -ENOTTY;
+    }
+
+  if (ioctl(chan->rfd, FIONREAD, (unsigned long)&avail) < 0)
+    {
+      return -errno;
+    }
+
+  return avail == 0;
+}
+
+/****************************************************************************
+ * Name: bench_setaffinity
+ ****************************************************************************/
+
+static void bench_setaffinity(FAR pthread_attr_t *attr, int affinity,
+                              bool reader)
+{
+#ifdef CONFIG_SMP
+  cpu_set_t cpuset;
+
+  if (affinity == BENCH_AFFINITY_NONE)
+    {
+      return;
+    }
+
+  CPU_ZERO(&cpuset);
+  CPU_SET(affinity == BENCH_AFFINITY_SPLIT && reader ?
+          1 % CONFIG_SMP_NCPUS : 0, &cpuset);
+  pthread_attr_setaffinity_np(attr, sizeof(cpu_set_t), &cpuset);
+#endif
+}
+
+/****************************************************************************
+ * Name: bench_start
+ *
+ * Description:
+ *   Wait for the start of the run.  Only an interrupted wait is retried.
+ *
+ ****************************************************************************/
+
+static int bench_start(FAR struct bench_run_s *run)
+{
+  int ret;
+
+  while ((ret = sem_wait(&run->start)) < 0 && errno == EINTR);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: bench_writer
+ ****************************************************************************/
+
+static FAR void *bench_writer(FAR void *arg)
+{
+  FAR struct bench_thread_s *self = arg;
+  FAR struct bench_run_s *run = self->run;
+  FAR char *buf;
+  ssize_t ret;
+  size_t i;
+
+  buf = malloc(run->size);
+  if (buf == NULL)
+    {
+      self->error = ENOMEM;
+    }
+  else
+    {
+      memset(buf, 0x5a, run->size);
+    }
+
+  if (bench_start(run) < 0)
+    {
+      self->error = errno;
+    }
+
+  for (i = 0; buf != NULL && !run->abort && i < self->msgs; i++)
+    {
+      if (run->counting &&
+          bench_chan_blocks(&run->chan, true, run->size) == 1)
+        {
+          self->waits++;
+        }
+
+      ret = bench_chan_write(&run->chan, buf, run->size);
+      if (ret < 0)
+        {
+          self->error = -ret;
+          break;
+        }
+
+      self->bytes += ret;
+    }
+
+  free(buf);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: bench_reader
+ ****************************************************************************/
+
+static FAR void *bench_reader(FAR void *arg)
+{
+  FAR struct bench_thread_s *self = arg;
+  FAR struct bench_run_s *run = self->run;
+  FAR char *buf;
+  ssize_t ret;
+
+  buf = malloc(run->size);
+  if (buf == NULL)
+    {
+      self->error = ENOMEM;
+    }
+
+  if (bench_start(run) < 0)
+    {
+      self->error = errno;
+    }
+
+  while (buf != NULL && !run->abort)
+    {
+      if (run->counting && bench_chan_blocks(&run->chan, false, 0) == 1)
+        {
+          self->waits++;
+        }
+
+      ret = bench_chan_read(&run->chan, buf, run->size);
+      if (ret <= 0)
+        {
+          if (ret < 0)
+            {
+              self->error = -ret;
+            }
+
+          break;
+        }
+
+      self->bytes += ret;
+    }
+
+  free(buf);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: bench_throughput
+ *
+ * Description:
+ *   Move opts->bytes through one channel with 'nwriters' writers and
+ *   'nreaders' readers sharing it, and print one result row.
+ *
+ ****************************************************************************/
+
+static int bench_throughput(FAR const struct bench_opts_s *opts, int type,
+                            size_t size, int nwriters, int nreaders)
+{
+  FAR struct bench_run_s *run;
+  pthread_attr_t attr;
+  unsigned long waits = 0;
+  uint64_t bytes = 0;
+  uint64_t start;
+  uint64_t elapsed;
+  size_t msgs;
+  float mbytes;
+  int error = 0;
+  int ret;
+  int i;
+  int n;
+
+  run = zalloc(sizeof(*run));
+  if (run == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  ret = bench_chan_open(&run->chan, type, 0, size);
+  if (ret < 0)
+    {
+      printf("%-7s %6zu %2d %2d  unsupported (%d)\n",
+             g_bench_names[type], size, nwriters, nreaders, -ret);
+      free(run);
+      return OK;
+    }
+
+  run->size     = size;
+  run->counting = bench_chan_blocks(&run->chan, false, 0) >= 0;
+  if (sem_init(&run->start, 0, 0) < 0)
+    {
+      ret = -errno;
+      bench_chan_close(&run->chan);
+      free(run);
+      return ret;
+    }
+
+  /* Split the messages between the writers */
+
+  msgs = opts->bytes / size / nwriters;
+  if (msgs == 0)
+    {
+      msgs = 1;
+    }
+
+  for (n = 0; n < nreaders + nwriters; n++)
+    {
+      bool reader = n < nreaders;
+      FAR struct bench_thread_s *thr = reader ? &run->readers[n] :
+                                       &run->writers[n - nreaders];
+
+      thr->run  = run;
+      thr->msgs = msgs;
+
+      pthread_attr_init(&attr);
+      bench_setaffinity(&attr, opts->affinity, reader);
+      ret = pthread_create(&thr->tid, &attr,
+                           reader ? bench_reader : bench_writer, thr);
+      pthread_attr_destroy(&attr);
+      if (ret != 0)
+        {
+          printf("ERROR: pthread_create failed: %d\n", ret);
+          break;
+        }
+    }
+
+  if (n < nreaders + nwriters)
+    {
+      /* Release the threads already started with nothing to do and wait
+       * for them.
+       */
+
+      run->abort = true;
+      for (i = 0; i < n; i++)
+        {
+          sem_post(&run->start);
+        }
+
+      for (i = 0; i < n; i++)
+        {
+          pthread_join(i < nreaders ? run->readers[i].tid :
+                       run->writers[i - nreaders].tid, NULL);
+        }
+
+      sem_destroy(&run->start);
+      bench_chan_close(&run->chan);
+      free(run);
+      return -ret;
+    }
+
+  start = bench_now();
+  for (i = 0; i < n; i++)
+    {
+      sem_post(&run->start);
+    }
+
+  for (i = 0; i < nwriters; i++)
+    {
+      pthread_join(run->writers[i].tid, NULL);
+    }
+
+  /* All data is written; the readers see end of stream once it has been
+   * consumed.
+   */
+
+  bench_chan_eof(&run->chan, nreaders);
+
+  for (i = 0; i < nreaders; i++)
+    {
+      pthread_join(run->readers[i].tid, NULL);
+    }
+
+  elapsed = bench_now() - start;
+
+  for (i = 0; i < nreaders; i++)
+    {
+      bytes += run->readers[i].bytes;
+      waits += run->readers[i].waits;
+      error  = error ? error : run->readers[i].error;
+    }
+
+  for (i = 0; i < nwriters; i++)
+    {
+      waits += run->writers[i].waits;
+      error  = error ? error : run->writers[i].error;
+    }
+
+  sem_destroy(&run->start);
+  bench_chan_close(&run->chan);
+
+  mbytes = bytes / 1048576.0f;
+  printf("%-7s %6zu %2d %2d %9.2f %10.0f",
+         g_bench_names[type], size, nwriters, nreaders,
+         mbytes * NSEC_PER_SEC / elapsed,
+         (float)bytes / size * NSEC_PER_SEC / elapsed);
+
+  if (run->counting && mbytes > 0.0f)
+    {
+      printf(" %10.1f", 2 * waits / mbytes);
+    }
+  else
+    {
+      printf(" %10s", "-");
+    }
+
+  if (error != 0)
+    {
+      printf("  error %d", error);
+    }
+
+  printf("\n");
+
+  free(run);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bench_pong
+ *
+ * Description:
+ *   Acknowledge every message.  On an error the acknowledge channel is
+ *   ended, so the ping side wakes up instead of waiting forever.
+ *
+ ****************************************************************************/
+
+static FAR void *bench_pong(FAR void *arg)
+{
+  FAR struct bench_lat_s *lat = arg;
+  FAR char *buf;
+  char ack = 0;
+  int ret;
+  int i;
+
+  buf = malloc(lat->size);
+  if (buf == NULL)
+    {
+      lat->error = ENOMEM;
+      bench_chan_eof(&lat->pong, 1);
+      return NULL;
+    }
+
+  for (i = 0; i < lat->samples; i++)
+    {
+      ret = bench_chan_readall(&lat->ping, buf, lat->size);
+      if (ret < 0)
+        {
+          lat->error = -ret;
+          break;
+        }
+
+      lat->lat[i] = bench_now() - lat->stamp;
+
+      ret = bench_chan_write(&lat->pong, &ack, 1);
+      if (ret < 0)
+        {
+          lat->error = -ret;
+          break;
+        }
+    }
+
+  if (lat->error != 0)
+    {
+      bench_chan_eof(&lat->pong, 1);
+    }
+
+  free(buf);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: bench_cmp
+ ****************************************************************************/
+
+static int bench_cmp(FAR const void *a, FAR const void *b)
+{
+  uint32_t x = *(FAR const uint32_t *)a;
+  uint32_t y = *(FAR const uint32_t *)b;
+
+  return x < y ? -1 : x > y;
+}
+
+/****************************************************************************
+ * Name: bench_latency
+ *
+ * Description:
+ *   Measure the time from a write until the blocked reader runs.  The
+ *   reader acknowledges each message on a second channel before the next
+ *   one is sent, so it is always asleep when a message is written.
+ *
+ ****************************************************************************/
+
+static int bench_latency(FAR const struct bench_opts_s *opts, int type,
+                         size_t size)
+{
+  struct bench_lat_s lat;
+  pthread_attr_t attr;
+  pthread_t tid;
+  FAR char *buf;
+  char ack;
+  int ret;
+  int n;
+
+  memset(&lat, 0, sizeof(lat));
+  lat.size    = size;
+  lat.samples = opts->samples;
+  lat.lat     = malloc(opts->samples * sizeof(uint32_t));
+  buf         = zalloc(size);
+  if (lat.lat == NULL || buf == NULL)
+    {
+      free(lat.lat);
+      free(buf);
+      return -ENOMEM;
+    }
+
+  ret = bench_chan_open(&lat.ping, type, 0, size);
+  if (ret >= 0)
+    {
+      ret = bench_chan_open(&lat.pong, type, 1, 1);
+      if (ret < 0)
+        {
+          bench_chan_close(&lat.ping);
+        }
+    }
+
+  if (ret < 0)
+    {
+      printf("%-7s %6zu  unsupported (%d)\n", g_bench_names[type], size,
+             -ret);
+      free(lat.lat);
+      free(buf);
+      return OK;
+    }
+
+  pthread_attr_init(&attr);
+  bench_setaffinity(&attr, opts->affinity, true);
+  ret = pthread_create(&tid, &attr, bench_pong, &lat);
+  pthread_attr_destroy(&attr);
+  if (ret != 0)
+    {
+      printf("ERROR: pthread_create failed: %d\n", ret);
+      ret = -ret;
+      goto out;
+    }
+
+  /* Give the reader time to block on its first read */
+
+  usleep(10000);
+
+  for (n = 0; n < opts->samples && lat.error == 0; n++)
+    {
+      lat.stamp = bench_now();
+      if (bench_chan_write(&lat.ping, buf, size) < 0 ||
+          bench_chan_readall(&lat.pong, &ack, 1) < 0)
+        {
+          break;
+        }
+    }
+
+  if (n < opts->samples)
+    {
+      /* Unblock the reader if the loop ended early */
+
+      bench_chan_eof(&lat.ping, 1);
+    }
+
+  pthread_join(tid, NULL);
+
+  if (n > 0)
+    {
+      qsort(lat.lat, n, sizeof(uint32_t), bench_cmp);
+      printf("%-7s %6zu %8.1f %8.1f %8.1f %8.1f %8.1f",
+             g_bench_names[type], size,
+             lat.lat[0] / 1000.0f,
+             lat.lat[n / 2] / 1000.0f,
+             lat.lat[n * 9 / 10] / 1000.0f,
+             lat.lat[n * 99 / 100] / 1000.0f,
+             lat.lat[n - 1] / 1000.0f);
+    }
+  else
+    {
+      printf("%-7s %6zu  no samples", g_bench_names[type], size);
+    }
+
+  if (lat.error != 0)
+    {
+      printf("  error %d", lat.error);
+    }
+
+  printf("\n");
+  ret = OK;
+
+out:
+  bench_chan_close(&lat.ping);
+  bench_chan_close(&lat.pong);
+  free(lat.lat);
+  free(buf);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: bench_usage
+ ****************************************************************************/
+
+static void bench_usage(FAR const char *progname)
+{
+  fprintf(stderr,
+          "Usage: %s bench [-t types] [-s sizes] [-p WxR,...] "
+          "[-n bytes] [-l samples] [-a none|same|split]\n", progname);
+  fprintf(stderr,
+          "  -t types    comma list of pipe,fifo,mqueue,local "
+          "(default: all built in)\n"
+          "  -s sizes    comma list of message sizes "
+          "(default: 1,64,512,4096)\n"
+          "  -p pairs    comma list of writers x readers "
+          "(default: 1x1,2x2)\n"
+          "  -n bytes    bytes per throughput run (default: %d)\n"
+          "  -l samples  latency samples per size (default: %d)\n"
+          "  -a mode     SMP affinity: none, same CPU, or writers and "
+          "readers split\n",
+          CONFIG_EXAMPLES_PIPE_BENCH_BYTES,
+          CONFIG_EXAMPLES_PIPE_BENCH_SAMPLES);
+}
+
+/****************************************************************************
+ * Name: bench_parse
+ ****************************************************************************/
+
+static int bench_parse(FAR struct bench_opts_s *opts, int argc,
+                       FAR char *argv[])
+{
+  FAR char *tok;
+  FAR char *save;
+  int opt;
+  int i;
+
+  memset(opts, 0, sizeof(*opts));
+  opts->bytes   = CONFIG_EXAMPLES_PIPE_BENCH_BYTES;
+  opts->samples = CONFIG_EXAMPLES_PIPE_BENCH_SAMPLES;
+
+  while ((opt = getopt(argc, argv, "t:s:p:n:l:a:h")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 't':
+            for (tok = strtok_r(optarg, ",", &save); tok != NULL;
+                 tok = strtok_r(NULL, ",", &save))
+              {
+                for (i = 0; i < BENCH_NTYPES; i++)
+                  {
+                    if (strcmp(tok, g_bench_names[i]) == 0)
+                      {
+                        opts->types |= 1 << i;
+                        break;
+                      }
+                  }
+
+                if (i == BENCH_NTYPES)
+                  {
+                    return -EINVAL;
+                  }
+              }
+            break;
+
+          case 's':
+            for (tok = strtok_r(optarg, ",", &save);
+                 tok != NULL && opts->nsizes < BENCH_MAXSIZES;
+                 tok = strtok_r(NULL, ",", &save))
+              {
+                opts->sizes[opts->nsizes] = strtoul(tok, NULL, 0);
+                if (opts->sizes[opts->nsizes++] == 0)
+                  {
+                    return -EINVAL;
+                  }
+              }
+            break;
+
+          case 'p':
+            for (tok = strtok_r(optarg, ",", &save);
+                 tok != NULL && opts->npairs < BENCH_MAXPAIRS;
+                 tok = strtok_r(NULL, ",", &save))
+              {
+                int w;
+                int r;
+
+                if (sscanf(tok, "%dx%d", &w, &r) != 2 ||
+                    w < 1 || w > BENCH_MAXTHREADS ||
+                    r < 1 || r > BENCH_MAXTHREADS)
+                  {
+                    return -EINVAL;
+                  }
+
+                opts->writers[opts->npairs]   = w;
+                opts->readers[opts->npairs++] = r;
+              }
+            break;
+
+          case 'n':
+            opts->bytes = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'l':
+            opts->samples = atoi(optarg);
+            break;
+
+          case 'a':
+            opts->affinity = strcmp(optarg, "same") == 0 ?
+                             BENCH_AFFINITY_SAME :
+                             strcmp(optarg, "split") == 0 ?
+                             BENCH_AFFINITY_SPLIT : BENCH_AFFINITY_NONE;
+            break;
+
+          default:
+            return -EINVAL;
+        }
+    }
+
+  if (opts->types == 0)
+    {
+      opts->types = (1 << BENCH_NTYPES) - 1;
+    }
+
+  if (opts->nsizes == 0)
+    {
+      opts->sizes[0] = 1;
+      opts->sizes[1] = 64;
+      opts->sizes[2] = 512;
+      opts->sizes[3] = 4096;
+      opts->nsizes   = 4;
+    }
+
+  if (opts->npairs == 0)
+    {
+      opts->writers[0] = 1;
+      opts->readers[0] = 1;
+      opts->writers[1] = 2;
+      opts->readers[1] = 2;
+      opts->npairs     = 2;
+    }
+
+  return opts->bytes > 0 && opts->samples > 0 ? OK : -EINVAL;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: pipe_bench
+ *
+ * Description:
+ *   Throughput and wakeup latency of pipes, FIFOs, message queues and
+ *   local sockets.  Started as "pipe bench [options]".
+ *
+ ****************************************************************************/
+
+int pipe_bench(int argc, FAR char *argv[])
+{
+  struct bench_opts_s opts;
+  int type;
+  int s;
+  int p;
+
+  if (bench_parse(&opts, argc, argv) < 0)
+    {
+      bench_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  printf("Throughput (%zu bytes per run, ctxsw counted as 2 per "
+         "blocking wait)\n", opts.bytes);
+  printf("%-7s %6s %2s %2s %9s %10s %10s\n",
+         "type", "size", "W", "R", "MB/s", "msgs/s", "ctxsw/MB");
+
+  for (type = 0; type < BENCH_NTYPES; type++)
+    {
+      if ((opts.types & (1 << type)) == 0)
+        {
+          continue;
+        }
+
+      for (s = 0; s < opts.nsizes; s++)
+        {
+          for (p = 0; p < opts.npairs; p++)
+            {
+              if (bench_throughput(&opts, type, opts.sizes[s],
+                                   opts.writers[p], opts.readers[p]) < 0)
+                {
+                  return EXIT_FAILURE;
+                }
+            }
+        }
+    }
+
+  printf("\nWakeup latency (%d samples, us)\n", opts.samples);
+  printf("%-7s %6s %8s %8s %8s %8s %8s\n",
+         "type", "size", "min", "p50", "p90", "p99", "max");
+
+  for (type = 0; type < BENCH_NTYPES; type++)
+    {
+      if ((opts.types & (1 << type)) == 0)
+        {
+          continue;
+        }
+
+      for (s = 0; s < opts.nsizes; s++)
+        {
+          if (bench_latency(&opts, type, opts.sizes[s]) < 0)
+            {
+              return EXIT_FAILURE;
+            }
+        }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -28,6 +28,7 @@
 
 #include <sys/stat.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <sched.h>
 #include <fcntl.h>
@@ -76,6 +77,15 @@ int main(int argc, FAR char *argv[])
   int ret;
 #endif
 
+#ifdef CONFIG_EXAMPLES_PIPE_BENCH
+  /* "pipe bench ..." runs the benchmarks instead of the tests */
+
+  if (argc > 1 && strcmp(argv[1], "bench") == 0)
+    {
+      return pipe_bench(argc - 1, argv + 1);
+    }
+#endif
+
 #if CONFIG_DEV_FIFO_SIZE > 0
   /* Test FIFO logic */
 
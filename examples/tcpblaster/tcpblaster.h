@@ -27,8 +27,14 @@
  * Included Files
  ****************************************************************************/
 
+#include <sys/types.h>
+#include <sys/socket.h>
 #include <arpa/inet.h>
 
+#include <pthread.h>
+#include <stdbool.h>
+#include <time.h>
+
 #ifdef TCPBLASTER_HOST
 #else
 #  include <debug.h>
@@ -56,14 +62,30 @@
 #  define FAR
 #  define TCPBLASTER_HAVE_SOLINGER 1
 
+#  ifdef __linux__
+#    define TCPBLASTER_HAVE_SENDFILE 1
+#  endif
+
 #else
 #  ifdef CONFIG_NET_SOLINGER
 #    define TCPBLASTER_HAVE_SOLINGER 1
 #  else
 #    undef TCPBLASTER_HAVE_SOLINGER
 #  endif
+
+#  define TCPBLASTER_HAVE_SENDFILE 1
 #endif /* TCPBLASTER_HOST */
 
+/* MSG_ZEROCOPY is only provided by Linux hosts */
+
+#if defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+#  define TCPBLASTER_HAVE_ZEROCOPY 1
+#endif
+
+#ifdef TCPBLASTER_HAVE_SENDFILE
+#  include <sys/sendfile.h>
+#endif
+
 #ifdef CONFIG_EXAMPLES_TCPBLASTER_IPv6
 #  define AF_INETX AF_INET6
 #  define PF_INETX PF_INET6
@@ -82,12 +104,97 @@
 #  define SENDSIZE 4096
 #endif
 
-#ifdef CONFIG_EXAMPLES_TCPBLASTER_GROUPSIZE
-#  define GROUPSIZE CONFIG_EXAMPLES_TCPBLASTER_GROUPSIZE
+#ifdef CONFIG_EXAMPLES_TCPBLASTER_INTERVAL
+#  define INTERVAL CONFIG_EXAMPLES_TCPBLASTER_INTERVAL
 #else
-#  define GROUPSIZE 50
+#  define INTERVAL 1
 #endif
 
+#ifdef CONFIG_EXAMPLES_TCPBLASTER_NSTREAMS
+#  define NSTREAMS CONFIG_EXAMPLES_TCPBLASTER_NSTREAMS
+#else
+#  define NSTREAMS 1
+#endif
+
+#ifdef CONFIG_EXAMPLES_TCPBLASTER_MAXSTREAMS
+#  define MAXSTREAMS CONFIG_EXAMPLES_TCPBLASTER_MAXSTREAMS
+#else
+#  define MAXSTREAMS 8
+#endif
+
+/* Maximum number of message sizes in one sweep */
+
+#define MAXSIZES 12
+
+/* Seconds spent on each message size when sweeping and no -t is given */
+
+#define SWEEP_DURATION 10
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+enum tcpblaster_mode_e
+{
+  TCPBLASTER_MODE_SEND = 0,      /* send() from a user buffer */
+  TCPBLASTER_MODE_SENDFILE,      /* sendfile() from a file */
+  TCPBLASTER_MODE_ZEROCOPY       /* send() with MSG_ZEROCOPY */
+};
+
+/* Options shared by the client and the server, so that both ends of a test
+ * can be started with the same command line.
+ */
+
+struct tcpblaster_opts_s
+{
+  int nstreams;                  /* Number of parallel connections */
+  int nsizes;                    /* Number of entries in sizes[] */
+  int sizes[MAXSIZES];           /* Message sizes to sweep */
+  int maxsize;                   /* Largest entry in sizes[] */
+  int mode;                      /* See enum tcpblaster_mode_e */
+  int interval;                  /* Report interval in seconds */
+  int duration;                  /* Seconds per message size, 0 = forever */
+  FAR const char *file;          /* Source file for sendfile mode */
+};
+
+/* Per-connection state.  The counters are only written by the thread that
+ * owns the connection and are sampled without locking by the reporter.
+ */
+
+struct tcpblaster_stream_s
+{
+  pthread_t thread;
+  int sockfd;
+  int index;
+  int error;                     /* errno of a failed stream, else 0 */
+  volatile bool done;
+  volatile unsigned long bytes;
+  volatile unsigned long count;
+  volatile unsigned long partials;
+};
+
+/* Interval and summary reporting over a set of streams */
+
+struct tcpblaster_report_s
+{
+  FAR struct tcpblaster_stream_s *streams;
+  int nstreams;
+  struct timespec first;         /* Start of the current summary period */
+  struct timespec last;          /* Start of the current interval */
+  unsigned long lastbytes[MAXSTREAMS];
+  unsigned long lastcount[MAXSTREAMS];
+  unsigned long lastpartials[MAXSTREAMS];
+  unsigned long long totalbytes;
+  unsigned long long totalcount;
+  unsigned long long totalpartials;
+  float cpusum;
+  int cpusamples;
+#ifdef TCPBLASTER_HOST
+  struct timespec cpuwall;
+  double cpuused;
+#endif
+};
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -98,6 +205,8 @@ extern uint16_t g_tcpblasterserver_ipv6[8];
 extern uint32_t g_tcpblasterserver_ipv4;
 #endif
 
+extern struct tcpblaster_opts_s g_tcpblaster_opts;
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -110,4 +219,10 @@ void tcpblaster_cmdline(int argc, char **argv);
 extern void tcpblaster_client(void);
 extern void tcpblaster_server(void);
 
+void tcpblaster_report_reset(FAR struct tcpblaster_report_s *rpt);
+void tcpblaster_report_interval(FAR struct tcpblaster_report_s *rpt,
+                                FAR const char *tag);
+void tcpblaster_report_summary(FAR struct tcpblaster_report_s *rpt,
+                               FAR const char *tag, int size);
+
 #endif /* __APPS_EXAMPLES_TCPBLASTER_TCPBLASTER_H */
@@ -34,6 +34,8 @@
 #include <unistd.h>
 #include <time.h>
 #include <poll.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <string.h>
 #include <errno.h>
 
@@ -42,40 +44,30 @@
 #include "tcpblaster.h"
 
 /****************************************************************************
- * Public Functions
+ * Private Data
  ****************************************************************************/
 
-void tcpblaster_client(void)
+static FAR char *g_outbuf;
+static volatile int g_sendsize;
+static volatile bool g_stop;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * tcpblaster_connect
+ ****************************************************************************/
+
+static int tcpblaster_connect(void)
 {
 #ifdef CONFIG_EXAMPLES_TCPBLASTER_IPv6
   struct sockaddr_in6 server;
 #else
   struct sockaddr_in server;
 #endif
-  struct timespec start;
   socklen_t addrlen;
-  FAR char *outbuf;
-  unsigned long sendtotal;
-  unsigned long totallost;
-  int groupcount;
-  int sendcount;
-  int partials;
   int sockfd;
-  int nbytessent;
-  int ch;
-  int i;
-  char timebuff[100];
-
-  setbuf(stdout, NULL);
-
-  /* Allocate buffers */
-
-  outbuf = (FAR char *)malloc(SENDSIZE);
-  if (!outbuf)
-    {
-      printf("client: failed to allocate buffers\n");
-      exit(1);
-    }
 
   /* Create a new TCP socket */
 
@@ -83,7 +75,7 @@ void tcpblaster_client(void)
   if (sockfd < 0)
     {
       printf("client socket failure %d\n", errno);
-      goto errout_with_buffers;
+      return -1;
     }
 
   /* Set up the server address */
@@ -93,21 +85,11 @@ void tcpblaster_client(void)
   server.sin6_port       = HTONS(CONFIG_EXAMPLES_TCPBLASTER_SERVER_PORTNO);
   memcpy(server.sin6_addr.s6_addr, g_tcpblasterserver_ipv6, 16);
   addrlen                = sizeof(struct sockaddr_in6);
-
-  printf("Connecting to IPv6 Address: "
-         "%04x:%04x:%04x:%04x:%04x:%04x:%04x:%04x\n",
-         g_tcpblasterserver_ipv6[0], g_tcpblasterserver_ipv6[1],
-         g_tcpblasterserver_ipv6[2], g_tcpblasterserver_ipv6[3],
-         g_tcpblasterserver_ipv6[4], g_tcpblasterserver_ipv6[5],
-         g_tcpblasterserver_ipv6[6], g_tcpblasterserver_ipv6[7]);
 #else
   server.sin_family      = AF_INET;
   server.sin_port        = HTONS(CONFIG_EXAMPLES_TCPBLASTER_SERVER_PORTNO);
   server.sin_addr.s_addr = (in_addr_t)g_tcpblasterserver_ipv4;
   addrlen                = sizeof(struct sockaddr_in);
-
-  printf("Connecting to IPv4 Address: %08lx\n",
-         (unsigned long)g_tcpblasterserver_ipv4);
 #endif
 
   /* Connect the socket to the server */
@@ -115,41 +97,103 @@ void tcpblaster_client(void)
   if (connect(sockfd, (FAR struct sockaddr *)&server, addrlen) < 0)
     {
       printf("client: connect failure: %d\n", errno);
-      goto errout_with_socket;
+      close(sockfd);
+      return -1;
     }
 
-  printf("client: Connected\n");
+#ifdef TCPBLASTER_HAVE_ZEROCOPY
+  if (g_tcpblaster_opts.mode == TCPBLASTER_MODE_ZEROCOPY)
+    {
+      int optval = 1;
 
-  /* Initialize the buffer */
+      if (setsockopt(sockfd, SOL_SOCKET, SO_ZEROCOPY, &optval,
+                     sizeof(optval)) < 0)
+        {
+          printf("client: setsockopt SO_ZEROCOPY failure: %d\n", errno);
+          close(sockfd);
+          return -1;
+        }
+    }
+#endif
 
-  ch = 0x20;
-  for (i = 0; i < SENDSIZE; i++ )
+  return sockfd;
+}
+
+#ifdef TCPBLASTER_HAVE_ZEROCOPY
+/****************************************************************************
+ * tcpblaster_reap
+ *
+ * Description:
+ *   Drain MSG_ZEROCOPY completion notifications from the error queue.  The
+ *   payload never changes, so there is no need to wait for them before the
+ *   buffer is reused; they only have to be consumed so the socket does not
+ *   run out of option memory.
+ *
+ ****************************************************************************/
+
+static void tcpblaster_reap(int sockfd)
+{
+  char control[64];
+  struct msghdr msg;
+
+  for (; ; )
     {
-      outbuf[i] = ch;
-      if (++ch > 0x7e)
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_control    = control;
+      msg.msg_controllen = sizeof(control);
+
+      if (recvmsg(sockfd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
         {
-          ch = 0x20;
+          break;
         }
     }
+}
+#endif
+
+/****************************************************************************
+ * tcpblaster_sender
+ *
+ * Description:
+ *   Send on one connection until g_stop is set, using the message size
+ *   currently selected by the sweep.
+ *
+ ****************************************************************************/
 
-  /* Then send messages forever */
+static FAR void *tcpblaster_sender(FAR void *arg)
+{
+  FAR struct tcpblaster_stream_s *stream = arg;
+  int mode = g_tcpblaster_opts.mode;
+  int filefd = -1;
+#ifdef TCPBLASTER_HAVE_SENDFILE
+  off_t offset = 0;
+#endif
+  int nbytessent;
+  int size;
 
-  groupcount = 0;
-  sendcount = 0;
-  sendtotal = 0;
-  partials  = 0;
-  totallost = 0;
+#ifdef TCPBLASTER_HAVE_SENDFILE
+  if (mode == TCPBLASTER_MODE_SENDFILE)
+    {
+      /* Each stream reads the file through its own descriptor */
 
-  clock_gettime(CLOCK_REALTIME, &start);
+      filefd = open(g_tcpblaster_opts.file, O_RDONLY);
+      if (filefd < 0)
+        {
+          printf("client: failed to open %s: %d\n",
+                 g_tcpblaster_opts.file, errno);
+          stream->error = errno;
+          goto out;
+        }
+    }
+#endif
 
-  for (; ; )
+  while (!g_stop)
     {
 #ifdef CONFIG_EXAMPLES_TCPBLASTER_POLLOUT
       struct pollfd fds[1];
       int ret;
 
       memset(fds, 0, 1 * sizeof(struct pollfd));
-      fds[0].fd     = sockfd;
+      fds[0].fd     = stream->sockfd;
       fds[0].events = POLLOUT;
 
       /* Wait until we can send data or until the connection is lost */
@@ -158,98 +202,265 @@ void tcpblaster_client(void)
       if (ret < 0)
         {
           printf("client: ERROR poll failed: %d\n", errno);
-          goto errout_with_socket;
+          stream->error = errno;
+          break;
         }
 
       if ((fds[0].revents & POLLHUP) != 0)
         {
           printf("client: WARNING poll returned POLLHUP\n");
-          goto errout_with_socket;
+          stream->error = ECONNRESET;
+          break;
         }
 #endif
 
-      nbytessent = send(sockfd, outbuf, SENDSIZE, 0);
+      size = g_sendsize;
+
+      switch (mode)
+        {
+#ifdef TCPBLASTER_HAVE_SENDFILE
+          case TCPBLASTER_MODE_SENDFILE:
+            nbytessent = sendfile(stream->sockfd, filefd, &offset, size);
+            if (nbytessent == 0)
+              {
+                /* End of file, start over */
+
+                offset = 0;
+                continue;
+              }
+            break;
+#endif
+
+#ifdef TCPBLASTER_HAVE_ZEROCOPY
+          case TCPBLASTER_MODE_ZEROCOPY:
+            nbytessent = send(stream->sockfd, g_outbuf, size, MSG_ZEROCOPY);
+            tcpblaster_reap(stream->sockfd);
+            if (nbytessent < 0 && errno == ENOBUFS)
+              {
+                /* Too many completions outstanding */
+
+                continue;
+              }
+            break;
+#endif
+
+          default:
+            nbytessent = send(stream->sockfd, g_outbuf, size, 0);
+            break;
+        }
+
       if (nbytessent < 0)
         {
-          printf("client: send failed: %d\n", errno);
-          goto errout_with_socket;
+          printf("client: stream %d send failed: %d\n", stream->index,
+                 errno);
+          stream->error = errno;
+          break;
         }
-      else if (nbytessent > 0 && nbytessent < SENDSIZE)
+      else if (nbytessent < size && mode != TCPBLASTER_MODE_SENDFILE)
         {
           /* Partial buffers can be sent if there is insufficient buffering
-           * space to buffer the whole SENDSIZE request.  This is not an
-           * error, but is an interesting thing to keep track of.
+           * space to buffer the whole request.  This is not an error, but
+           * is an interesting thing to keep track of.  In sendfile mode
+           * short sends at the end of the file are expected.
            */
 
-          partials++;
-          totallost += (SENDSIZE - nbytessent);
+          stream->partials++;
+        }
+
+      stream->bytes += nbytessent;
+      stream->count++;
+    }
+
+#ifdef TCPBLASTER_HAVE_SENDFILE
+out:
+#endif
+  if (filefd >= 0)
+    {
+      close(filefd);
+    }
+
+  stream->done = true;
+  return NULL;
+}
+
+/****************************************************************************
+ * tcpblaster_run
+ *
+ * Description:
+ *   Report every interval until 'duration' seconds have passed (forever if
+ *   zero) or every stream has failed.  Returns the number of streams still
+ *   running.
+ *
+ ****************************************************************************/
+
+static int tcpblaster_run(FAR struct tcpblaster_report_s *rpt,
+                           FAR const char *tag, int duration)
+{
+  int elapsed = 0;
+  int active;
+  int i;
+
+  do
+    {
+      sleep(g_tcpblaster_opts.interval);
+      elapsed += g_tcpblaster_opts.interval;
+
+      tcpblaster_report_interval(rpt, tag);
+
+      for (active = 0, i = 0; i < rpt->nstreams; i++)
+        {
+          active += !rpt->streams[i].done;
         }
-      else if (nbytessent != SENDSIZE)
+    }
+  while (active > 0 && (duration == 0 || elapsed < duration));
+
+  return active;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+void tcpblaster_client(void)
+{
+  FAR struct tcpblaster_opts_s *opts = &g_tcpblaster_opts;
+  struct tcpblaster_stream_s streams[MAXSTREAMS];
+  struct tcpblaster_report_s rpt;
+  char tag[32];
+  int nstarted = 0;
+  int ch;
+  int i;
+
+  setbuf(stdout, NULL);
+
+  /* Allocate the send buffer, shared read-only by all streams */
+
+  g_outbuf = (FAR char *)malloc(opts->maxsize);
+  if (!g_outbuf)
+    {
+      printf("client: failed to allocate buffers\n");
+      exit(1);
+    }
+
+  /* Initialize the buffer */
+
+  ch = 0x20;
+  for (i = 0; i < opts->maxsize; i++ )
+    {
+      g_outbuf[i] = ch;
+      if (++ch > 0x7e)
         {
-          printf("client: Bad send length=%d: of %d\n",
-                  nbytessent, SENDSIZE);
-          goto errout_with_socket;
+          ch = 0x20;
         }
+    }
 
-      sendtotal += nbytessent;
+#ifdef CONFIG_EXAMPLES_TCPBLASTER_IPv6
+  printf("Connecting to IPv6 Address: "
+         "%04x:%04x:%04x:%04x:%04x:%04x:%04x:%04x\n",
+         g_tcpblasterserver_ipv6[0], g_tcpblasterserver_ipv6[1],
+         g_tcpblasterserver_ipv6[2], g_tcpblasterserver_ipv6[3],
+         g_tcpblasterserver_ipv6[4], g_tcpblasterserver_ipv6[5],
+         g_tcpblasterserver_ipv6[6], g_tcpblasterserver_ipv6[7]);
+#else
+  printf("Connecting to IPv4 Address: %08lx\n",
+         (unsigned long)g_tcpblasterserver_ipv4);
+#endif
+
+  /* Connect all streams before any of them starts sending */
+
+  memset(streams, 0, sizeof(streams));
+  for (i = 0; i < opts->nstreams; i++)
+    {
+      streams[i].sockfd = -1;
+    }
+
+  for (i = 0; i < opts->nstreams; i++)
+    {
+      streams[i].index  = i;
+      streams[i].sockfd = tcpblaster_connect();
+      if (streams[i].sockfd < 0)
+        {
+          goto errout_with_sockets;
+        }
+    }
+
+  printf("client: Connected %d stream(s)\n", opts->nstreams);
 
-      if (++sendcount >= GROUPSIZE)
+  /* Then send messages on every stream */
+
+  g_stop     = false;
+  g_sendsize = opts->sizes[0];
+
+  for (; nstarted < opts->nstreams; nstarted++)
+    {
+      if (pthread_create(&streams[nstarted].thread, NULL,
+                         tcpblaster_sender, &streams[nstarted]) != 0)
         {
-          struct timespec elapsed;
-          struct timespec curr;
-          float fkbrecvd;
-          float felapsed;
-
-          clock_gettime(CLOCK_REALTIME, &curr);
-
-          elapsed.tv_sec  = curr.tv_sec - start.tv_sec;
-          if (curr.tv_nsec >= start.tv_nsec)
-            {
-              elapsed.tv_nsec = curr.tv_nsec - start.tv_nsec;
-            }
-          else
-            {
-              unsigned long borrow = 1000000000 - start.tv_nsec;
-              elapsed.tv_sec--;
-              elapsed.tv_nsec = curr.tv_nsec + borrow;
-            }
-
-          strftime(timebuff, 100,
-                   "%Y-%m-%d %H:%M:%S.000", localtime(&curr.tv_sec));
-
-          fkbrecvd = sendtotal / 1024.0f;
-          felapsed = elapsed.tv_sec + elapsed.tv_nsec / 1000000000.0f;
-          printf("[%s] %d: Sent %d %d-byte buffers: %7.1fKB "
-                 "(avg %5.1f KB) in %6.2f seconds (%7.1f KB/second)\n",
-                 timebuff, groupcount, sendcount, SENDSIZE, fkbrecvd,
-                 fkbrecvd / sendcount, felapsed, fkbrecvd / felapsed);
-
-          if (partials > 0)
-            {
-              float fkblost;
-
-              fkblost = (float)totallost / 1024.0;
-              printf("Partial buffers sent: %d Data not sent: %7.1f Kb\n",
-                     partials, fkblost);
-            }
-
-          sendcount  = 0;
-          sendtotal  = 0;
-          partials   = 0;
-          totallost  = 0;
-          groupcount++;
-
-          clock_gettime(CLOCK_REALTIME, &start);
+          printf("client: failed to start stream %d\n", nstarted);
+          goto errout_with_threads;
+        }
+    }
+
+  memset(&rpt, 0, sizeof(rpt));
+  rpt.streams  = streams;
+  rpt.nstreams = opts->nstreams;
+
+  /* Step through the message sizes.  The senders pick up the new size on
+   * their next send.
+   */
+
+  for (i = 0; i < opts->nsizes; i++)
+    {
+      int active;
+
+      g_sendsize = opts->sizes[i];
+      snprintf(tag, sizeof(tag), "client %d B", opts->sizes[i]);
+
+      tcpblaster_report_reset(&rpt);
+      active = tcpblaster_run(&rpt, tag, opts->duration);
+      tcpblaster_report_summary(&rpt, "client", opts->sizes[i]);
+
+      if (active == 0)
+        {
+          break;
+        }
+    }
+
+  g_stop = true;
+  for (i = 0; i < nstarted; i++)
+    {
+      pthread_join(streams[i].thread, NULL);
+      close(streams[i].sockfd);
+    }
+
+  free(g_outbuf);
+
+  for (i = 0; i < opts->nstreams; i++)
+    {
+      if (streams[i].error != 0)
+        {
+          exit(1);
         }
     }
 
-  free(outbuf);
   return;
 
-errout_with_socket:
-  close(sockfd);
+errout_with_threads:
+  g_stop = true;
+  for (i = 0; i < nstarted; i++)
+    {
+      pthread_join(streams[i].thread, NULL);
+    }
+
+errout_with_sockets:
+  for (i = 0; i < opts->nstreams; i++)
+    {
+      if (streams[i].sockfd >= 0)
+        {
+          close(streams[i].sockfd);
+        }
+    }
 
-errout_with_buffers:
-  free(outbuf);
+  free(g_outbuf);
   exit(1);
 }
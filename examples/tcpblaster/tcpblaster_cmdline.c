@@ -28,6 +28,8 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 #include <arpa/inet.h>
 
 #include "tcpblaster.h"
@@ -44,6 +46,8 @@ uint16_t g_tcpblasterserver_ipv6[8];
 uint32_t g_tcpblasterserver_ipv4;
 #endif
 
+struct tcpblaster_opts_s g_tcpblaster_opts;
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -54,10 +58,60 @@ uint32_t g_tcpblasterserver_ipv4;
 
 static void show_usage(FAR const char *progname)
 {
-  fprintf(stderr, "USAGE: %s [<server-addr>]\n", progname);
+  fprintf(stderr, "USAGE: %s [-n streams] [-s size[,size...]] "
+          "[-m send|sendfile|zerocopy] [-f file] [-i interval] "
+          "[-t seconds] [<server-addr>]\n", progname);
+  fprintf(stderr, "  -n streams  parallel connections, 1..%d (default %d)\n",
+          MAXSTREAMS, NSTREAMS);
+  fprintf(stderr, "  -s sizes    message sizes to sweep, comma separated "
+          "(default %d)\n", SENDSIZE);
+  fprintf(stderr, "  -m mode     client transmit mode (default send)\n");
+  fprintf(stderr, "  -f file     source file for sendfile mode\n");
+  fprintf(stderr, "  -i seconds  report interval (default %d)\n", INTERVAL);
+  fprintf(stderr, "  -t seconds  time per message size, 0 runs forever "
+          "(default 0, or %d when sweeping)\n", SWEEP_DURATION);
+  fprintf(stderr, "Both ends must be started with the same -n\n");
   exit(1);
 }
 
+/****************************************************************************
+ * parse_sizes
+ ****************************************************************************/
+
+static void parse_sizes(FAR const char *progname, FAR char *arg)
+{
+  FAR struct tcpblaster_opts_s *opts = &g_tcpblaster_opts;
+  FAR char *endptr;
+  long size;
+
+  opts->nsizes  = 0;
+  opts->maxsize = 0;
+
+  for (; ; )
+    {
+      size = strtol(arg, &endptr, 0);
+      if (endptr == arg || size <= 0 || opts->nsizes >= MAXSIZES)
+        {
+          fprintf(stderr, "ERROR: bad size list, at most %d sizes\n",
+                  MAXSIZES);
+          show_usage(progname);
+        }
+
+      opts->sizes[opts->nsizes++] = size;
+      if (size > opts->maxsize)
+        {
+          opts->maxsize = size;
+        }
+
+      if (*endptr != ',')
+        {
+          break;
+        }
+
+      arg = endptr + 1;
+    }
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -68,6 +122,8 @@ static void show_usage(FAR const char *progname)
 
 void tcpblaster_cmdline(int argc, char **argv)
 {
+  int opt;
+
   /* Init the default IP address. */
 
 #ifdef CONFIG_EXAMPLES_TCPBLASTER_IPv6
@@ -107,28 +163,117 @@ void tcpblaster_cmdline(int argc, char **argv)
 #  endif
 #endif
 
-  /* Currently only a single command line option is supported:  The server
-   * IP address. Used to override default.
+  /* Default options */
+
+  memset(&g_tcpblaster_opts, 0, sizeof(g_tcpblaster_opts));
+  g_tcpblaster_opts.nstreams = NSTREAMS;
+  g_tcpblaster_opts.nsizes   = 1;
+  g_tcpblaster_opts.sizes[0] = SENDSIZE;
+  g_tcpblaster_opts.maxsize  = SENDSIZE;
+  g_tcpblaster_opts.mode     = TCPBLASTER_MODE_SEND;
+  g_tcpblaster_opts.interval = INTERVAL;
+  g_tcpblaster_opts.duration = -1;
+
+  while ((opt = getopt(argc, argv, "n:s:m:f:i:t:h")) != -1)
+    {
+      switch (opt)
+        {
+          case 'n':
+            g_tcpblaster_opts.nstreams = atoi(optarg);
+            break;
+
+          case 's':
+            parse_sizes(argv[0], optarg);
+            break;
+
+          case 'm':
+            if (strcmp(optarg, "send") == 0)
+              {
+                g_tcpblaster_opts.mode = TCPBLASTER_MODE_SEND;
+              }
+#ifdef TCPBLASTER_HAVE_SENDFILE
+            else if (strcmp(optarg, "sendfile") == 0)
+              {
+                g_tcpblaster_opts.mode = TCPBLASTER_MODE_SENDFILE;
+              }
+#endif
+#ifdef TCPBLASTER_HAVE_ZEROCOPY
+            else if (strcmp(optarg, "zerocopy") == 0)
+              {
+                g_tcpblaster_opts.mode = TCPBLASTER_MODE_ZEROCOPY;
+              }
+#endif
+            else
+              {
+                fprintf(stderr, "ERROR: mode %s not supported\n", optarg);
+                show_usage(argv[0]);
+              }
+            break;
+
+          case 'f':
+            g_tcpblaster_opts.file = optarg;
+            break;
+
+          case 'i':
+            g_tcpblaster_opts.interval = atoi(optarg);
+            break;
+
+          case 't':
+            g_tcpblaster_opts.duration = atoi(optarg);
+            break;
+
+          default:
+            show_usage(argv[0]);
+        }
+    }
+
+  if (g_tcpblaster_opts.nstreams < 1 ||
+      g_tcpblaster_opts.nstreams > MAXSTREAMS ||
+      g_tcpblaster_opts.interval < 1)
+    {
+      fprintf(stderr, "ERROR: bad stream count or interval\n");
+      show_usage(argv[0]);
+    }
+
+  if (g_tcpblaster_opts.mode == TCPBLASTER_MODE_SENDFILE &&
+      g_tcpblaster_opts.file == NULL)
+    {
+      fprintf(stderr, "ERROR: sendfile mode needs -f <file>\n");
+      show_usage(argv[0]);
+    }
+
+  /* A single size runs forever unless told otherwise, a sweep needs a
+   * time limit per size to move on.
+   */
+
+  if (g_tcpblaster_opts.duration < 0)
+    {
+      g_tcpblaster_opts.duration = g_tcpblaster_opts.nsizes > 1 ?
+                                   SWEEP_DURATION : 0;
+    }
+
+  /* The only positional argument is the server IP address.  Used to
+   * override the default.
    */
 
-  if (argc == 2)
+  if (argc - optind == 1)
     {
       int ret;
 
       /* Convert the <server-addr> argument into a binary address */
 
 #ifdef CONFIG_EXAMPLES_TCPBLASTER_IPv6
-      ret = inet_pton(AF_INET6, argv[1], g_tcpblasterserver_ipv6);
+      ret = inet_pton(AF_INET6, argv[optind], g_tcpblasterserver_ipv6);
 #else
-      ret = inet_pton(AF_INET, argv[1], &g_tcpblasterserver_ipv4);
+      ret = inet_pton(AF_INET, argv[optind], &g_tcpblasterserver_ipv4);
 #endif
-      if (ret < 0)
+      if (ret <= 0)
         {
           fprintf(stderr, "ERROR: <server-addr> is invalid\n");
           show_usage(argv[0]);
         }
     }
-  else if (argc != 1)
+  else if (argc - optind > 1)
     {
       fprintf(stderr, "ERROR: Too many arguments\n");
       show_usage(argv[0]);
@@ -42,8 +42,11 @@ if(CONFIG_EXAMPLES_TCPBLASTER_SERVER)
 
 endif()
 
+find_package(Threads REQUIRED)
+
 add_library(tcpblaster)
-target_sources(tcpblaster PRIVATE tcpblaster_cmdline.c)
+target_sources(tcpblaster PRIVATE tcpblaster_cmdline.c tcpblaster_report.c)
+target_link_libraries(tcpblaster PUBLIC Threads::Threads)
 if(CONFIG_EXAMPLES_TCPBLASTER_SERVER)
   target_sources(tcpblaster PRIVATE tcpblaster_client.c)
   add_executable(tcpclient tcpblaster_host.c)
@@ -0,0 +1,302 @@
+/****************************************************************************
+ * apps/examples/tcpblaster/tcpblaster_report.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include "config.h"
+
+#include <sys/types.h>
+#ifdef TCPBLASTER_HOST
+#  include <sys/resource.h>
+#endif
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tcpblaster.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#if !defined(TCPBLASTER_HOST) && defined(CONFIG_FS_PROCFS) && \
+    !defined(CONFIG_FS_PROCFS_EXCLUDE_CPULOAD)
+#  define TCPBLASTER_HAVE_CPULOAD 1
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * tcpblaster_elapsed
+ ****************************************************************************/
+
+static float tcpblaster_elapsed(FAR const struct timespec *start,
+                                FAR const struct timespec *end)
+{
+  return (end->tv_sec - start->tv_sec) +
+         (end->tv_nsec - start->tv_nsec) / 1000000000.0f;
+}
+
+/****************************************************************************
+ * tcpblaster_cpuload
+ *
+ * Description:
+ *   Return the CPU load in percent since the previous call, or a negative
+ *   value if it cannot be measured.  On the target this is the system wide
+ *   load from procfs; on the host it is the CPU time used by this process,
+ *   which may exceed 100% with several streams.
+ *
+ ****************************************************************************/
+
+static float tcpblaster_cpuload(FAR struct tcpblaster_report_s *rpt)
+{
+#if defined(TCPBLASTER_HOST)
+  struct rusage usage;
+  struct timespec now;
+  double used;
+  float load = -1.0f;
+  float wall;
+
+  getrusage(RUSAGE_SELF, &usage);
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  used = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1000000.0 +
+         usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1000000.0;
+  wall = tcpblaster_elapsed(&rpt->cpuwall, &now);
+  if (wall > 0.0f && rpt->cpuwall.tv_sec != 0)
+    {
+      load = (used - rpt->cpuused) * 100.0f / wall;
+    }
+
+  rpt->cpuwall = now;
+  rpt->cpuused = used;
+  return load;
+
+#elif defined(TCPBLASTER_HAVE_CPULOAD)
+  char buf[16];
+  ssize_t nread;
+  int fd;
+
+  fd = open("/proc/cpuload", O_RDONLY);
+  if (fd < 0)
+    {
+      return -1.0f;
+    }
+
+  nread = read(fd, buf, sizeof(buf) - 1);
+  close(fd);
+
+  if (nread <= 0)
+    {
+      return -1.0f;
+    }
+
+  buf[nread] = '\0';
+  return strtof(buf, NULL);
+
+#else
+  return -1.0f;
+#endif
+}
+
+/****************************************************************************
+ * tcpblaster_timestamp
+ ****************************************************************************/
+
+static void tcpblaster_timestamp(FAR char *buf, size_t len)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_REALTIME, &now);
+  strftime(buf, len, "%Y-%m-%d %H:%M:%S", localtime(&now.tv_sec));
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * tcpblaster_report_reset
+ *
+ * Description:
+ *   Start a new summary period and a new interval from the current stream
+ *   counters.
+ *
+ ****************************************************************************/
+
+void tcpblaster_report_reset(FAR struct tcpblaster_report_s *rpt)
+{
+  int i;
+
+  for (i = 0; i < rpt->nstreams; i++)
+    {
+      rpt->lastbytes[i]    = rpt->streams[i].bytes;
+      rpt->lastcount[i]    = rpt->streams[i].count;
+      rpt->lastpartials[i] = rpt->streams[i].partials;
+    }
+
+  rpt->totalbytes    = 0;
+  rpt->totalcount    = 0;
+  rpt->totalpartials = 0;
+  rpt->cpusum        = 0.0f;
+  rpt->cpusamples    = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &rpt->first);
+  rpt->last = rpt->first;
+
+  /* Prime the CPU load measurement */
+
+  tcpblaster_cpuload(rpt);
+}
+
+/****************************************************************************
+ * tcpblaster_report_interval
+ *
+ * Description:
+ *   Print the aggregate and per-stream throughput since the last interval
+ *   and accumulate it into the summary period.  The stream counters are
+ *   unsigned long, so the differences stay correct across wrap-around.
+ *
+ ****************************************************************************/
+
+void tcpblaster_report_interval(FAR struct tcpblaster_report_s *rpt,
+                                FAR const char *tag)
+{
+  struct timespec now;
+  unsigned long bytes = 0;
+  unsigned long count = 0;
+  unsigned long partials = 0;
+  char timebuff[32];
+  float felapsed;
+  float load;
+  int i;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  felapsed = tcpblaster_elapsed(&rpt->last, &now);
+  if (felapsed <= 0.0f)
+    {
+      return;
+    }
+
+  load = tcpblaster_cpuload(rpt);
+  tcpblaster_timestamp(timebuff, sizeof(timebuff));
+
+  printf("[%s] %s:", timebuff, tag);
+
+  for (i = 0; i < rpt->nstreams; i++)
+    {
+      FAR struct tcpblaster_stream_s *stream = &rpt->streams[i];
+      unsigned long sbytes = stream->bytes;
+      unsigned long scount = stream->count;
+      unsigned long spartials = stream->partials;
+      unsigned long delta = sbytes - rpt->lastbytes[i];
+
+      bytes    += delta;
+      count    += scount - rpt->lastcount[i];
+      partials += spartials - rpt->lastpartials[i];
+
+      rpt->lastbytes[i]    = sbytes;
+      rpt->lastcount[i]    = scount;
+      rpt->lastpartials[i] = spartials;
+
+      if (rpt->nstreams > 1)
+        {
+          printf(" %7.1f", delta / 1024.0f / felapsed);
+        }
+    }
+
+  printf("%s %8.1f KB/s, %lu msgs (avg %lu B)",
+         rpt->nstreams > 1 ? " total" : "",
+         bytes / 1024.0f / felapsed, count, count ? bytes / count : 0);
+
+  if (partials > 0)
+    {
+      printf(", %lu partial", partials);
+    }
+
+  if (load >= 0.0f)
+    {
+      printf(", cpu %5.1f%%", load);
+      rpt->cpusum += load;
+      rpt->cpusamples++;
+    }
+
+  printf("\n");
+
+  rpt->totalbytes    += bytes;
+  rpt->totalcount    += count;
+  rpt->totalpartials += partials;
+  rpt->last           = now;
+}
+
+/****************************************************************************
+ * tcpblaster_report_summary
+ *
+ * Description:
+ *   Print one line for the whole summary period.  'size' is the message
+ *   size used during the period, or 0 if it is not known (server side).
+ *
+ ****************************************************************************/
+
+void tcpblaster_report_summary(FAR struct tcpblaster_report_s *rpt,
+                               FAR const char *tag, int size)
+{
+  struct timespec now;
+  float felapsed;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  felapsed = tcpblaster_elapsed(&rpt->first, &now);
+  if (felapsed <= 0.0f)
+    {
+      return;
+    }
+
+  printf("%s summary: ", tag);
+  if (size > 0)
+    {
+      printf("size %d, ", size);
+    }
+
+  printf("%d stream(s), %llu msgs, %.1f KB in %.2f s: %.1f KB/s",
+         rpt->nstreams, rpt->totalcount, rpt->totalbytes / 1024.0f,
+         felapsed, rpt->totalbytes / 1024.0f / felapsed);
+
+  if (rpt->totalpartials > 0)
+    {
+      printf(", %llu partial", rpt->totalpartials);
+    }
+
+  if (rpt->cpusamples > 0)
+    {
+      printf(", cpu avg %.1f%%", rpt->cpusum / rpt->cpusamples);
+    }
+
+  printf("\n");
+}
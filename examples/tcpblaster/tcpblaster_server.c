@@ -36,18 +36,99 @@
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <errno.h>
 
 #include <arpa/inet.h>
 
 #include "tcpblaster.h"
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * tcpblaster_receiver
+ ****************************************************************************/
+
+static FAR void *tcpblaster_receiver(FAR void *arg)
+{
+  FAR struct tcpblaster_stream_s *stream = arg;
+  FAR char *buffer;
+  int bufsize = g_tcpblaster_opts.maxsize;
+  int nbytesread;
+
+  /* Receive into a buffer as large as the largest message size, so each
+   * recv() can return a whole message.
+   */
+
+  buffer = (FAR char *)malloc(bufsize);
+  if (!buffer)
+    {
+      printf("server: failed to allocate buffer\n");
+      stream->error = ENOMEM;
+      stream->done  = true;
+      return NULL;
+    }
+
+  for (; ; )
+    {
+#ifdef CONFIG_EXAMPLES_TCPBLASTER_POLLIN
+      struct pollfd fds[1];
+      int ret;
+
+      memset(fds, 0, 1 * sizeof(struct pollfd));
+      fds[0].fd     = stream->sockfd;
+      fds[0].events = POLLIN;
+
+      /* Wait until we can receive data or until the connection is lost */
+
+      ret = poll(fds, 1, -1);
+      if (ret < 0)
+        {
+          printf("server: ERROR poll failed: %d\n", errno);
+          stream->error = errno;
+          break;
+        }
+
+      if ((fds[0].revents & POLLHUP) != 0)
+        {
+          printf("server: WARNING poll returned POLLHUP\n");
+          break;
+        }
+#endif
+
+      nbytesread = recv(stream->sockfd, buffer, bufsize, 0);
+      if (nbytesread < 0)
+        {
+          printf("server: stream %d recv failed: %d\n", stream->index,
+                 errno);
+          stream->error = errno;
+          break;
+        }
+      else if (nbytesread == 0)
+        {
+          printf("server: stream %d: The client broke the connection\n",
+                 stream->index);
+          break;
+        }
+
+      stream->bytes += nbytesread;
+      stream->count++;
+    }
+
+  free(buffer);
+  stream->done = true;
+  return NULL;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
 void tcpblaster_server(void)
 {
+  FAR struct tcpblaster_opts_s *opts = &g_tcpblaster_opts;
 #ifdef CONFIG_EXAMPLES_TCPBLASTER_IPv6
   struct sockaddr_in6 myaddr;
 #else
@@ -56,36 +137,25 @@ void tcpblaster_server(void)
 #ifdef TCPBLASTER_HAVE_SOLINGER
   struct linger ling;
 #endif
-  struct timespec start;
-  unsigned long recvtotal;
+  struct tcpblaster_stream_s streams[MAXSTREAMS];
+  struct tcpblaster_report_s rpt;
   socklen_t addrlen;
-  char *buffer;
-  int groupcount;
-  int recvcount;
+  int nstarted = 0;
   int listensd;
   int acceptsd;
-  int nbytesread;
   int optval;
-  char timebuff[100];
+  int active;
+  int i;
 
   setbuf(stdout, NULL);
 
-  /* Allocate a BIG buffer */
-
-  buffer = (FAR char *)malloc(SENDSIZE);
-  if (!buffer)
-    {
-      printf("server: failed to allocate buffer\n");
-      exit(1);
-    }
-
   /* Create a new TCP socket */
 
   listensd = socket(PF_INETX, SOCK_STREAM, 0);
   if (listensd < 0)
     {
       printf("server: socket failure: %d\n", errno);
-      goto errout_with_buffer;
+      goto errout;
     }
 
   /* Set socket to reuse address */
@@ -151,131 +221,103 @@ void tcpblaster_server(void)
       goto errout_with_listensd;
     }
 
-  /* Accept only one connection */
+  /* Accept one connection per stream */
+
+  printf("server: Accepting %d connection(s) on port %d\n",
+         opts->nstreams, CONFIG_EXAMPLES_TCPBLASTER_SERVER_PORTNO);
+
+  memset(streams, 0, sizeof(streams));
+  for (; nstarted < opts->nstreams; nstarted++)
+    {
+      FAR struct tcpblaster_stream_s *stream = &streams[nstarted];
 
-  printf("server: Accepting connections on port %d\n",
-         CONFIG_EXAMPLES_TCPBLASTER_SERVER_PORTNO);
 #ifdef __NuttX__
-  acceptsd = accept4(listensd, (FAR struct sockaddr *)&myaddr, &addrlen,
-                     SOCK_CLOEXEC);
+      acceptsd = accept4(listensd, (FAR struct sockaddr *)&myaddr, &addrlen,
+                         SOCK_CLOEXEC);
 #else
-  acceptsd = accept(listensd, (FAR struct sockaddr *)&myaddr, &addrlen);
+      acceptsd = accept(listensd, (FAR struct sockaddr *)&myaddr, &addrlen);
 #endif
-  if (acceptsd < 0)
-    {
-      printf("server: accept failure: %d\n", errno);
-      goto errout_with_listensd;
-    }
-
-  printf("server: Connection accepted -- receiving\n");
+      if (acceptsd < 0)
+        {
+          printf("server: accept failure: %d\n", errno);
+          goto errout_with_threads;
+        }
 
-  /* Configure to "linger" until all data is sent when the socket is closed */
+      /* Configure to "linger" until all data is sent when the socket is
+       * closed
+       */
 
 #ifdef TCPBLASTER_HAVE_SOLINGER
-  ling.l_onoff  = 1;
-  ling.l_linger = 30;     /* timeout is seconds */
+      ling.l_onoff  = 1;
+      ling.l_linger = 30;     /* timeout is seconds */
 
-  if (setsockopt(acceptsd, SOL_SOCKET, SO_LINGER, &ling, sizeof(ling)) < 0)
-    {
-      printf("server: setsockopt SO_LINGER failure: %d\n", errno);
-      goto errout_with_acceptsd;
-    }
+      if (setsockopt(acceptsd, SOL_SOCKET, SO_LINGER, &ling,
+                     sizeof(ling)) < 0)
+        {
+          printf("server: setsockopt SO_LINGER failure: %d\n", errno);
+          close(acceptsd);
+          goto errout_with_threads;
+        }
 #endif
 
-  /* Then receive data forever */
+      stream->index  = nstarted;
+      stream->sockfd = acceptsd;
 
-  recvcount = 0;
-  recvtotal = 0;
-  groupcount = 0;
+      if (pthread_create(&stream->thread, NULL, tcpblaster_receiver,
+                         stream) != 0)
+        {
+          printf("server: failed to start stream %d\n", nstarted);
+          close(acceptsd);
+          goto errout_with_threads;
+        }
 
-  clock_gettime(CLOCK_REALTIME, &start);
+      printf("server: Connection %d accepted -- receiving\n", nstarted);
+    }
 
-  for (; ; )
-    {
-#ifdef CONFIG_EXAMPLES_TCPBLASTER_POLLIN
-      struct pollfd fds[1];
-      int ret;
+  /* Then report until every client connection is gone */
 
-      memset(fds, 0, 1 * sizeof(struct pollfd));
-      fds[0].fd     = acceptsd;
-      fds[0].events = POLLIN;
+  memset(&rpt, 0, sizeof(rpt));
+  rpt.streams  = streams;
+  rpt.nstreams = opts->nstreams;
+  tcpblaster_report_reset(&rpt);
 
-      /* Wait until we can receive data or until the connection is lost */
+  do
+    {
+      sleep(opts->interval);
+      tcpblaster_report_interval(&rpt, "server");
 
-      ret = poll(fds, 1, -1);
-      if (ret < 0)
+      for (active = 0, i = 0; i < nstarted; i++)
         {
-          printf("server: ERROR poll failed: %d\n", errno);
-          goto errout_with_acceptsd;
+          active += !streams[i].done;
         }
+    }
+  while (active > 0);
 
-      if ((fds[0].revents & POLLHUP) != 0)
-        {
-          printf("server: WARNING poll returned POLLHUP\n");
-          goto errout_with_acceptsd;
-        }
-#endif
+  tcpblaster_report_summary(&rpt, "server", 0);
 
-      nbytesread = recv(acceptsd, buffer, SENDSIZE, 0);
-      if (nbytesread < 0)
-        {
-          printf("server: recv failed: %d\n", errno);
-          goto errout_with_acceptsd;
-        }
-      else if (nbytesread == 0)
-        {
-          printf("server: The client broke the connection\n");
-          goto errout_with_acceptsd;
-        }
+  for (i = 0; i < nstarted; i++)
+    {
+      pthread_join(streams[i].thread, NULL);
+      close(streams[i].sockfd);
+    }
 
-      recvtotal += nbytesread;
+  close(listensd);
+  return;
 
-      if (++recvcount >= GROUPSIZE)
-        {
-          struct timespec elapsed;
-          struct timespec curr;
-          float fkbsent;
-          float felapsed;
-
-          clock_gettime(CLOCK_REALTIME, &curr);
-
-          elapsed.tv_sec  = curr.tv_sec - start.tv_sec;
-          if (curr.tv_nsec >= start.tv_nsec)
-            {
-              elapsed.tv_nsec = curr.tv_nsec - start.tv_nsec;
-            }
-          else
-            {
-              unsigned long borrow = 1000000000 - start.tv_nsec;
-              elapsed.tv_sec--;
-              elapsed.tv_nsec = curr.tv_nsec + borrow;
-            }
-
-          strftime(timebuff, 100,
-                   "%Y-%m-%d %H:%M:%S.000", localtime(&curr.tv_sec));
-
-          fkbsent  = recvtotal / 1024.0f;
-          felapsed = elapsed.tv_sec + elapsed.tv_nsec / 1000000000.0f;
-          printf("[%s] %d: Received %d buffers: %7.1f KB (buffer average"
-                 "size: %5.1f KB) in %6.2f seconds (%7.1f KB/second)\n",
-                 timebuff, groupcount, recvcount, fkbsent,
-                 fkbsent / recvcount, felapsed, fkbsent / felapsed);
-
-          recvcount       = 0;
-          recvtotal       = 0;
-          groupcount++;
-
-          clock_gettime(CLOCK_REALTIME, &start);
-        }
-    }
+errout_with_threads:
+
+  /* Unblock the running receivers and wait for them */
 
-errout_with_acceptsd:
-  close(acceptsd);
+  for (i = 0; i < nstarted; i++)
+    {
+      shutdown(streams[i].sockfd, SHUT_RDWR);
+      pthread_join(streams[i].thread, NULL);
+      close(streams[i].sockfd);
+    }
 
 errout_with_listensd:
   close(listensd);
 
-errout_with_buffer:
-  free(buffer);
+errout:
   exit(1);
 }
@@ -30,6 +30,10 @@
 #include "config.h"
 
 #include <sys/param.h>
+#include <sys/socket.h>
+
+#include <stdbool.h>
+#include <stdint.h>
 
 #include <arpa/inet.h>
 
@@ -45,8 +49,14 @@
 #  define HTONS(a)       htons(a)
 #  define HTONL(a)       htonl(a)
 
+#  undef NTOHS
+#  undef NTOHL
+#  define NTOHS(a)       ntohs(a)
+#  define NTOHL(a)       ntohl(a)
+
 /* Have SO_LINGER */
 
+#  define FAR
 #  define UDPBLASTER_HAVE_SOLINGER 1
 
 #else
@@ -108,8 +118,43 @@
 
 #define UDPBLASTER_SENDSIZE MIN(UDPBLASTER_MSS, g_udpblaster_strlen)
 
+/* Every packet starts with a struct udpblaster_hdr_s tagged with this */
+
+#define UDPBLASTER_MAGIC    0x55424c53
+
+#define UDPBLASTER_MAXBATCH 64   /* Packets handed to the stack at once */
+#define UDPBLASTER_INTERVAL 1    /* Default report interval, seconds */
+
 /****************************************************************************
- * Public Function Prototypes
+ * Public Types
+ ****************************************************************************/
+
+/* Packet header, all fields in network byte order.  The timestamp is the
+ * sender's CLOCK_MONOTONIC time; only differences between packets are used
+ * by the receiver, so the two clocks need not be synchronized.
+ */
+
+struct udpblaster_hdr_s
+{
+  uint32_t magic;
+  uint32_t seq;
+  uint32_t sec;
+  uint32_t nsec;
+};
+
+struct udpblaster_opts_s
+{
+  bool receive;                /* Receive and measure instead of sending */
+  unsigned long rate;          /* Target rate in bits/second, 0 = no limit */
+  int batch;                   /* Packets sent per pacing period */
+  int size;                    /* UDP payload size in bytes */
+  unsigned long count;         /* Packets to send, 0 = no limit */
+  int interval;                /* Report interval in seconds */
+  int duration;                /* Seconds to run, 0 = no limit */
+};
+
+/****************************************************************************
+ * Public Data
  ****************************************************************************/
 
 extern const char g_udpblaster_text[];
@@ -119,4 +164,12 @@ extern const int g_udpblaster_strlen;
  * Public Function Prototypes
  ****************************************************************************/
 
+void udpblaster_cmdline(FAR struct udpblaster_opts_s *opts,
+                        unsigned long rate, int argc, FAR char *argv[]);
+int udpblaster_sender(int sockfd, FAR const struct sockaddr *peer,
+                      socklen_t addrlen,
+                      FAR const struct udpblaster_opts_s *opts);
+int udpblaster_receiver(int sockfd,
+                        FAR const struct udpblaster_opts_s *opts);
+
 #endif /* __APPS_EXAMPLES_UDPBLASTER_UDPBLASTER_H */
@@ -0,0 +1,132 @@
+/****************************************************************************
+ * apps/examples/udpblaster/udpblaster_cmdline.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "udpblaster.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname)
+{
+  fprintf(stderr, "USAGE: %s [-r] [-b bits/sec] [-B batch] [-s size] "
+          "[-c count] [-i interval] [-t seconds]\n", progname);
+  fprintf(stderr, "  -r          receive and report loss, reordering and "
+          "jitter\n");
+  fprintf(stderr, "  -b rate     sender target rate in bits/second, "
+          "0 for no pacing\n");
+  fprintf(stderr, "  -B batch    packets sent back to back per pacing "
+          "period, 1..%d\n", UDPBLASTER_MAXBATCH);
+  fprintf(stderr, "  -s size     UDP payload size, %zu..%d\n",
+          sizeof(struct udpblaster_hdr_s), UDPBLASTER_MSS);
+  fprintf(stderr, "  -c count    stop after sending count packets\n");
+  fprintf(stderr, "  -i seconds  report interval (default %d)\n",
+          UDPBLASTER_INTERVAL);
+  fprintf(stderr, "  -t seconds  stop after this time\n");
+  exit(1);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * udpblaster_cmdline
+ *
+ * Description:
+ *   Parse the options shared by the target and the host program.  'rate'
+ *   is the default send rate of the caller.
+ *
+ ****************************************************************************/
+
+void udpblaster_cmdline(FAR struct udpblaster_opts_s *opts,
+                        unsigned long rate, int argc, FAR char *argv[])
+{
+  int opt;
+
+  memset(opts, 0, sizeof(*opts));
+  opts->rate     = rate;
+  opts->batch    = 1;
+  opts->size     = UDPBLASTER_SENDSIZE;
+  opts->interval = UDPBLASTER_INTERVAL;
+
+  while ((opt = getopt(argc, argv, "rb:B:s:c:i:t:h")) != -1)
+    {
+      switch (opt)
+        {
+          case 'r':
+            opts->receive = true;
+            break;
+
+          case 'b':
+            opts->rate = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'B':
+            opts->batch = atoi(optarg);
+            break;
+
+          case 's':
+            opts->size = atoi(optarg);
+            break;
+
+          case 'c':
+            opts->count = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'i':
+            opts->interval = atoi(optarg);
+            break;
+
+          case 't':
+            opts->duration = atoi(optarg);
+            break;
+
+          default:
+            show_usage(argv[0]);
+        }
+    }
+
+  if (optind != argc || opts->batch < 1 ||
+      opts->batch > UDPBLASTER_MAXBATCH ||
+      opts->size < (int)sizeof(struct udpblaster_hdr_s) ||
+      opts->size > UDPBLASTER_MSS || opts->interval < 1 ||
+      opts->duration < 0)
+    {
+      show_usage(argv[0]);
+    }
+}
@@ -28,6 +28,7 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <errno.h>
 
@@ -48,22 +49,32 @@ int main(int argc, char **argv, char **envp)
 {
 #ifdef CONFIG_EXAMPLES_UDPBLASTER_IPv4
   struct sockaddr_in target;
+  struct sockaddr_in host;
 #else
   struct sockaddr_in6 target;
+  struct sockaddr_in6 host;
 #endif
+  struct udpblaster_opts_s opts;
   socklen_t addrlen;
-  size_t sendsize;
-  unsigned long delay;
-  int npackets;
-  int ndots;
   int sockfd;
   int ret;
 
+  /* Parse any command line options.  The host sends at
+   * CONFIG_EXAMPLES_UDPBLASTER_HOSTRATE unless told otherwise.
+   */
+
+  udpblaster_cmdline(&opts, CONFIG_EXAMPLES_UDPBLASTER_HOSTRATE,
+                     argc, argv);
+
 #ifdef CONFIG_EXAMPLES_UDPBLASTER_IPv4
   target.sin_family             = AF_INET;
   target.sin_port               = HTONS(UDPBLASTER_TARGET_PORTNO);
   target.sin_addr.s_addr        = HTONL(CONFIG_EXAMPLES_UDPBLASTER_TARGETIP);
 
+  host.sin_family               = AF_INET;
+  host.sin_port                 = HTONS(UDPBLASTER_HOST_PORTNO);
+  host.sin_addr.s_addr          = HTONL(INADDR_ANY);
+
   addrlen                       = sizeof(struct sockaddr_in);
   sockfd                        = socket(PF_INET, SOCK_DGRAM, 0);
   if (sockfd < 0)
@@ -93,6 +104,11 @@ int main(int argc, char **argv, char **envp)
   *(uint16_t *)&target.sin6_addr.s6_addr[14] =
       HTONS(CONFIG_EXAMPLES_UDPBLASTER_TARGETIPv6_8);
 
+  memset(&host, 0, sizeof(host));
+  host.sin6_family              = AF_INET6;
+  host.sin6_port                = HTONS(UDPBLASTER_HOST_PORTNO);
+  host.sin6_addr                = in6addr_any;
+
   addrlen                       = sizeof(struct sockaddr_in6);
   sockfd                        = socket(PF_INET6, SOCK_DGRAM, 0);
   if (sockfd < 0)
@@ -102,49 +118,25 @@ int main(int argc, char **argv, char **envp)
     }
 #endif
 
-  /* bytes/packet = UDPBLASTER_SENDSIZE
-   * bits/sec     = CONFIG_EXAMPLES_UDPBLASTER_HOSTRATE
-   * bytes/sec    = CONFIG_EXAMPLES_UDPBLASTER_HOSTRATE / 8
-   * packets/sec  = (bytes/sec) / (bytes/packet)
-   *              = CONFIG_EXAMPLES_UDPBLASTER_HOSTRATE /
-   *                UDPBLASTER_SENDSIZE / 8
-   * delay        = microseconds/packet
-   *              = (1000000 * UDPBLASTER_SENDSIZE) /
-   *                CONFIG_EXAMPLES_UDPBLASTER_HOSTRATE / 8
-   *              = (125000 * UDPBLASTER_SENDSIZE) /
-   *                CONFIG_EXAMPLES_UDPBLASTER_HOSTRATE
-   */
-
-  sendsize = UDPBLASTER_SENDSIZE;
-  delay    = (125000 * sendsize) / CONFIG_EXAMPLES_UDPBLASTER_HOSTRATE;
-
-  npackets = 0;
-  ndots    = 0;
-
-  for (; ; )
+  if (opts.receive)
     {
-      ret = sendto(sockfd, g_udpblaster_text, sendsize, 0,
-                   (struct sockaddr *)&target, addrlen);
-      if (ret < 0)
-        {
-          fprintf(stderr, "ERROR: sendto() failed: %d\n", errno);
-          return 1;
-        }
+      /* The target sends to the host port */
 
-      if (++npackets >= 10)
+      if (bind(sockfd, (struct sockaddr *)&host, addrlen) < 0)
         {
-          putchar('.');
-          npackets = 0;
-
-          if (++ndots >= 50)
-            {
-              putchar('\n');
-              ndots = 0;
-            }
+          fprintf(stderr, "ERROR: bind() failed: %d\n", errno);
+          close(sockfd);
+          return 1;
         }
 
-      usleep(delay);
+      ret = udpblaster_receiver(sockfd, &opts);
+    }
+  else
+    {
+      ret = udpblaster_sender(sockfd, (struct sockaddr *)&target, addrlen,
+                              &opts);
     }
 
-  return 0; /* Won't get here */
+  close(sockfd);
+  return ret;
 }
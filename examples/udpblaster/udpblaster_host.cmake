@@ -35,7 +35,9 @@ include_directories(${CMAKE_BINARY_DIR}/include/nuttx)
 
 add_compile_definitions(UDPBLASTER_HOST=1)
 add_library(udpblaster)
-target_sources(udpblaster PRIVATE udpblaster_text.c)
+target_sources(
+  udpblaster PRIVATE udpblaster_text.c udpblaster_cmdline.c udpblaster_sender.c
+                     udpblaster_receiver.c)
 add_executable(host udpblaster_host.c)
 target_link_libraries(host PRIVATE udpblaster)
 install(TARGETS host DESTINATION bin)
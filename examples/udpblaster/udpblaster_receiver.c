@@ -0,0 +1,345 @@
+/****************************************************************************
+ * apps/examples/udpblaster/udpblaster_receiver.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include "config.h"
+
+#include <sys/socket.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "udpblaster.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define NSEC_PER_SEC 1000000000ll
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct udpblaster_rxstats_s
+{
+  unsigned long packets;
+  unsigned long long bytes;
+  unsigned long lost;
+  unsigned long reordered;
+  unsigned long invalid;
+};
+
+struct udpblaster_rx_s
+{
+  struct udpblaster_rxstats_s interval;  /* Since the last report */
+  struct udpblaster_rxstats_s total;     /* Since the first packet */
+  bool started;
+  uint32_t next;             /* Next expected sequence number */
+  int64_t transit;           /* Transit time of the previous packet */
+  double jitter;             /* RFC 3550 interarrival jitter, ns */
+  double maxjitter;
+  float maxrate;             /* Best loss free interval, kbit/s */
+  int64_t first;             /* Arrival of the first packet */
+  int64_t last;              /* Arrival of the latest packet */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * udpblaster_now
+ ****************************************************************************/
+
+static int64_t udpblaster_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * udpblaster_account
+ *
+ * Description:
+ *   Account one received packet.  A sequence number ahead of the expected
+ *   one counts the gap as lost; one behind it is a reordered packet that
+ *   was counted as lost before.  Jitter follows RFC 3550: the smoothed
+ *   difference in transit time between consecutive packets, which is
+ *   independent of the offset between the sender and receiver clocks.
+ *
+ ****************************************************************************/
+
+static void udpblaster_account(FAR struct udpblaster_rx_s *rx,
+                               FAR const struct udpblaster_hdr_s *hdr,
+                               int len, int64_t now)
+{
+  uint32_t seq = NTOHL(hdr->seq);
+  int64_t sent;
+  int64_t transit;
+  int64_t d;
+
+  sent    = (int64_t)NTOHL(hdr->sec) * NSEC_PER_SEC + NTOHL(hdr->nsec);
+  transit = now - sent;
+
+  if (!rx->started)
+    {
+      rx->started = true;
+      rx->next    = seq;
+      rx->transit = transit;
+      rx->first   = now;
+    }
+
+  if (seq == rx->next)
+    {
+      rx->next++;
+    }
+  else if ((int32_t)(seq - rx->next) > 0)
+    {
+      rx->interval.lost += seq - rx->next;
+      rx->next = seq + 1;
+    }
+  else
+    {
+      rx->interval.reordered++;
+      if (rx->interval.lost > 0)
+        {
+          rx->interval.lost--;
+        }
+      else if (rx->total.lost > 0)
+        {
+          rx->total.lost--;
+        }
+    }
+
+  d = transit - rx->transit;
+  if (d < 0)
+    {
+      d = -d;
+    }
+
+  rx->jitter  += (d - rx->jitter) / 16.0;
+  rx->transit  = transit;
+  if (rx->jitter > rx->maxjitter)
+    {
+      rx->maxjitter = rx->jitter;
+    }
+
+  rx->interval.packets++;
+  rx->interval.bytes += len;
+  rx->last = now;
+}
+
+/****************************************************************************
+ * udpblaster_report
+ ****************************************************************************/
+
+static void udpblaster_report(FAR struct udpblaster_rx_s *rx, float elapsed)
+{
+  FAR struct udpblaster_rxstats_s *iv = &rx->interval;
+  unsigned long expected = iv->packets + iv->lost;
+  float kbps = iv->bytes * 8 / 1000.0f / elapsed;
+
+  printf("rx: %lu pkts %8.1f pkt/s %9.1f kbit/s lost %lu (%.2f%%) "
+         "reordered %lu jitter %.1f us",
+         iv->packets, iv->packets / elapsed, kbps, iv->lost,
+         expected > 0 ? 100.0f * iv->lost / expected : 0.0f,
+         iv->reordered, rx->jitter / 1000.0);
+
+  if (iv->invalid > 0)
+    {
+      printf(" invalid %lu", iv->invalid);
+    }
+
+  printf("\n");
+
+  if (iv->lost == 0 && kbps > rx->maxrate)
+    {
+      rx->maxrate = kbps;
+    }
+
+  rx->total.packets   += iv->packets;
+  rx->total.bytes     += iv->bytes;
+  rx->total.lost      += iv->lost;
+  rx->total.reordered += iv->reordered;
+  rx->total.invalid   += iv->invalid;
+  memset(iv, 0, sizeof(*iv));
+}
+
+/****************************************************************************
+ * udpblaster_summary
+ ****************************************************************************/
+
+static void udpblaster_summary(FAR struct udpblaster_rx_s *rx)
+{
+  FAR struct udpblaster_rxstats_s *t = &rx->total;
+  unsigned long expected = t->packets + t->lost;
+  float elapsed = (rx->last - rx->first) / 1e9f;
+
+  printf("rx summary: %lu pkts in %.2f s, %.1f kbit/s avg, lost %lu "
+         "(%.3f%%), reordered %lu, jitter max %.1f us, "
+         "max loss free rate %.1f kbit/s\n",
+         t->packets, elapsed,
+         elapsed > 0.0f ? t->bytes * 8 / 1000.0f / elapsed : 0.0f,
+         t->lost, expected > 0 ? 100.0f * t->lost / expected : 0.0f,
+         t->reordered, rx->maxjitter / 1000.0, rx->maxrate);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * udpblaster_receiver
+ *
+ * Description:
+ *   Receive packets from udpblaster_sender() and report once per interval.
+ *   When the sender goes quiet for a whole interval, or restarts its
+ *   sequence at zero, the run is summarized and the statistics are reset
+ *   for the next one.
+ *
+ ****************************************************************************/
+
+int udpblaster_receiver(int sockfd, FAR const struct udpblaster_opts_s *opts)
+{
+  FAR struct udpblaster_hdr_s *hdr;
+  struct udpblaster_rx_s rx;
+  struct pollfd fds[1];
+  FAR char *buf;
+  int64_t interval = (int64_t)opts->interval * NSEC_PER_SEC;
+  int64_t start;
+  int64_t last;
+  int64_t now;
+  int timeout;
+  int ret;
+
+  buf = malloc(UDPBLASTER_MSS);
+  if (buf == NULL)
+    {
+      fprintf(stderr, "ERROR: failed to allocate receive buffer\n");
+      return EXIT_FAILURE;
+    }
+
+  hdr = (FAR struct udpblaster_hdr_s *)buf;
+  memset(&rx, 0, sizeof(rx));
+
+  printf("Receiving, report every %d s\n", opts->interval);
+
+  start = udpblaster_now();
+  last  = start;
+
+  for (; ; )
+    {
+      now     = udpblaster_now();
+      timeout = last + interval > now ? (last + interval - now) / 1000000 : 0;
+
+      memset(fds, 0, sizeof(fds));
+      fds[0].fd     = sockfd;
+      fds[0].events = POLLIN;
+
+      ret = poll(fds, 1, timeout);
+      if (ret < 0 && errno != EINTR)
+        {
+          fprintf(stderr, "ERROR: poll() failed: %d\n", errno);
+          break;
+        }
+
+      /* Drain everything that is queued before looking at the clock */
+
+      while (ret > 0)
+        {
+          ret = recv(sockfd, buf, UDPBLASTER_MSS, MSG_DONTWAIT);
+          if (ret < 0)
+            {
+              break;
+            }
+
+          now = udpblaster_now();
+
+          if (ret < (int)sizeof(struct udpblaster_hdr_s) ||
+              NTOHL(hdr->magic) != UDPBLASTER_MAGIC)
+            {
+              rx.interval.invalid++;
+              continue;
+            }
+
+          /* A sender restarting at sequence zero starts a new run */
+
+          if (rx.started && hdr->seq == 0 && rx.next > 1)
+            {
+              if (rx.interval.packets > 0)
+                {
+                  udpblaster_report(&rx, (now - last) / 1e9f);
+                }
+
+              udpblaster_summary(&rx);
+              memset(&rx, 0, sizeof(rx));
+              last = now;
+            }
+
+          udpblaster_account(&rx, hdr, ret, now);
+        }
+
+      now = udpblaster_now();
+      if (now - last < interval)
+        {
+          continue;
+        }
+
+      if (rx.interval.packets > 0 || rx.interval.invalid > 0)
+        {
+          udpblaster_report(&rx, (now - last) / 1e9f);
+        }
+      else if (rx.started)
+        {
+          /* The sender has stopped */
+
+          udpblaster_summary(&rx);
+          memset(&rx, 0, sizeof(rx));
+        }
+
+      last = now;
+
+      if (opts->duration > 0 &&
+          now - start >= (int64_t)opts->duration * NSEC_PER_SEC)
+        {
+          if (rx.started)
+            {
+              udpblaster_summary(&rx);
+            }
+
+          break;
+        }
+    }
+
+  free(buf);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,314 @@
+/****************************************************************************
+ * apps/examples/udpblaster/udpblaster_sender.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#if defined(UDPBLASTER_HOST) && defined(__linux__)
+#  define _GNU_SOURCE 1    /* For sendmmsg() */
+#endif
+
+#include "config.h"
+
+#include <sys/socket.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "udpblaster.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#if defined(UDPBLASTER_HOST) && defined(__linux__)
+#  define UDPBLASTER_HAVE_SENDMMSG 1
+#endif
+
+#define NSEC_PER_SEC 1000000000ull
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * udpblaster_now
+ ****************************************************************************/
+
+static uint64_t udpblaster_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * udpblaster_sleep_until
+ ****************************************************************************/
+
+static void udpblaster_sleep_until(uint64_t deadline)
+{
+  struct timespec ts;
+
+  ts.tv_sec  = deadline / NSEC_PER_SEC;
+  ts.tv_nsec = deadline % NSEC_PER_SEC;
+
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+         EINTR);
+}
+
+/****************************************************************************
+ * udpblaster_stamp
+ ****************************************************************************/
+
+static void udpblaster_stamp(FAR char *pkt, uint32_t seq, uint64_t now)
+{
+  FAR struct udpblaster_hdr_s *hdr = (FAR struct udpblaster_hdr_s *)pkt;
+
+  hdr->magic = HTONL(UDPBLASTER_MAGIC);
+  hdr->seq   = HTONL(seq);
+  hdr->sec   = HTONL((uint32_t)(now / NSEC_PER_SEC));
+  hdr->nsec  = HTONL((uint32_t)(now % NSEC_PER_SEC));
+}
+
+/****************************************************************************
+ * udpblaster_send_batch
+ *
+ * Description:
+ *   Hand 'n' consecutive packets of 'size' bytes from 'buf' to the stack.
+ *   Returns the number of packets accepted or a negative errno.
+ *
+ ****************************************************************************/
+
+static int udpblaster_send_batch(int sockfd, FAR const struct sockaddr *peer,
+                                 socklen_t addrlen, FAR char *buf,
+                                 int size, int n)
+{
+#ifdef UDPBLASTER_HAVE_SENDMMSG
+  struct mmsghdr msgs[UDPBLASTER_MAXBATCH];
+  struct iovec iov[UDPBLASTER_MAXBATCH];
+  int ret;
+  int i;
+
+  memset(msgs, 0, n * sizeof(struct mmsghdr));
+  for (i = 0; i < n; i++)
+    {
+      iov[i].iov_base             = buf + i * size;
+      iov[i].iov_len              = size;
+      msgs[i].msg_hdr.msg_name    = (FAR void *)peer;
+      msgs[i].msg_hdr.msg_namelen = addrlen;
+      msgs[i].msg_hdr.msg_iov     = &iov[i];
+      msgs[i].msg_hdr.msg_iovlen  = 1;
+    }
+
+  ret = sendmmsg(sockfd, msgs, n, 0);
+  return ret < 0 ? -errno : ret;
+#else
+  int i;
+
+  for (i = 0; i < n; i++)
+    {
+#ifdef CONFIG_EXAMPLES_UDPBLASTER_POLLOUT
+      struct pollfd fds[1];
+
+      memset(fds, 0, 1 * sizeof(struct pollfd));
+      fds[0].fd     = sockfd;
+      fds[0].events = POLLOUT;
+
+      /* Wait until we can send data */
+
+      if (poll(fds, 1, -1) < 0)
+        {
+          return -errno;
+        }
+#endif
+
+      if (sendto(sockfd, buf + i * size, size, 0, peer, addrlen) < 0)
+        {
+          return i > 0 ? i : -errno;
+        }
+    }
+
+  return n;
+#endif
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * udpblaster_sender
+ *
+ * Description:
+ *   Send sequence numbered, timestamped packets to 'peer'.  With a rate
+ *   set, each batch is released at an absolute deadline so that sleep
+ *   overshoot does not accumulate; if the sender falls more than one period
+ *   behind it resynchronizes instead of bursting, and counts the slip.
+ *
+ ****************************************************************************/
+
+int udpblaster_sender(int sockfd, FAR const struct sockaddr *peer,
+                      socklen_t addrlen,
+                      FAR const struct udpblaster_opts_s *opts)
+{
+  FAR char *buf;
+  uint64_t period = 0;
+  uint64_t deadline;
+  uint64_t start;
+  uint64_t last;
+  uint64_t now;
+  unsigned long total = 0;
+  unsigned long npackets = 0;
+  unsigned long nlate = 0;
+  unsigned long nerrors = 0;
+  uint32_t seq = 0;
+  int size = opts->size;
+  int batch;
+  int ret;
+  int i;
+
+  buf = malloc(opts->batch * size);
+  if (buf == NULL)
+    {
+      fprintf(stderr, "ERROR: failed to allocate send buffer\n");
+      return EXIT_FAILURE;
+    }
+
+  /* Fill every slot with text once, only the header changes per packet */
+
+  for (i = 0; i < opts->batch; i++)
+    {
+      int off;
+
+      for (off = 0; off < size; off += g_udpblaster_strlen)
+        {
+          memcpy(buf + i * size + off, g_udpblaster_text,
+                 MIN(g_udpblaster_strlen, size - off));
+        }
+    }
+
+  /* bytes/batch = batch * size
+   * period      = nanoseconds/batch = bytes/batch * 8 * 1e9 / rate
+   */
+
+  if (opts->rate > 0)
+    {
+      period = (uint64_t)opts->batch * size * 8 * NSEC_PER_SEC / opts->rate;
+    }
+
+  printf("Sending %d byte packets, batch %d, rate %lu bit/s%s\n",
+         size, opts->batch, opts->rate,
+         opts->rate > 0 ? "" : " (unpaced)");
+
+  start    = udpblaster_now();
+  last     = start;
+  deadline = start;
+
+  for (; ; )
+    {
+      batch = opts->batch;
+      if (opts->count > 0 && opts->count - total < (unsigned long)batch)
+        {
+          batch = opts->count - total;
+        }
+
+      if (period > 0)
+        {
+          deadline += period;
+          now = udpblaster_now();
+          if (now > deadline + period)
+            {
+              nlate++;
+              deadline = now;
+            }
+          else
+            {
+              udpblaster_sleep_until(deadline);
+            }
+        }
+
+      now = udpblaster_now();
+      for (i = 0; i < batch; i++)
+        {
+          udpblaster_stamp(buf + i * size, seq + i, now);
+        }
+
+      ret = udpblaster_send_batch(sockfd, peer, addrlen, buf, size, batch);
+      if (ret == -ENOBUFS || ret == -EAGAIN)
+        {
+          /* The stack dropped the packets, the receiver will see a gap */
+
+          nerrors += batch;
+          ret       = batch;
+        }
+      else if (ret < 0)
+        {
+          fprintf(stderr, "ERROR: sendto() failed: %d\n", -ret);
+          free(buf);
+          return EXIT_FAILURE;
+        }
+
+      seq      += ret;
+      total    += ret;
+      npackets += ret;
+
+      now = udpblaster_now();
+      if (now - last >= (uint64_t)opts->interval * NSEC_PER_SEC ||
+          (opts->count > 0 && total >= opts->count) ||
+          (opts->duration > 0 &&
+           now - start >= (uint64_t)opts->duration * NSEC_PER_SEC))
+        {
+          float felapsed = (now - last) / 1e9f;
+
+          printf("tx: %lu pkts %8.1f pkt/s %9.1f kbit/s late %lu "
+                 "dropped %lu\n",
+                 npackets, npackets / felapsed,
+                 npackets * size * 8 / 1000.0f / felapsed, nlate, nerrors);
+
+          npackets = 0;
+          nlate    = 0;
+          nerrors  = 0;
+          last     = now;
+
+          if ((opts->count > 0 && total >= opts->count) ||
+              (opts->duration > 0 &&
+               now - start >= (uint64_t)opts->duration * NSEC_PER_SEC))
+            {
+              break;
+            }
+        }
+    }
+
+  printf("tx: sent %lu packets in %.2f s\n", total,
+         (udpblaster_now() - start) / 1e9f);
+
+  free(buf);
+  return EXIT_SUCCESS;
+}
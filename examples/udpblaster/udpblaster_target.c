@@ -29,7 +29,6 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
-#include <poll.h>
 #include <errno.h>
 #include <debug.h>
 #include <unistd.h>
@@ -190,12 +189,15 @@ int main(int argc, FAR char *argv[])
   struct sockaddr_in6 host;
   struct sockaddr_in6 target;
 #endif
+  struct udpblaster_opts_s opts;
   socklen_t addrlen;
-  int npackets;
-  int ndots;
   int sockfd;
   int ret;
 
+  /* Parse any command line options.  The target sends unpaced by default */
+
+  udpblaster_cmdline(&opts, 0, argc, argv);
+
 #ifdef CONFIG_EXAMPLES_UDPBLASTER_INIT
   /* Initialize the network */
 
@@ -283,55 +285,14 @@ int main(int argc, FAR char *argv[])
     }
 #endif
 
-  npackets = 0;
-  ndots    = 0;
-
-  for (; ; )
+  if (opts.receive)
     {
-#ifdef CONFIG_EXAMPLES_UDPBLASTER_POLLOUT
-      struct pollfd fds[1];
-
-      memset(fds, 0, 1 * sizeof(struct pollfd));
-      fds[0].fd     = sockfd;
-      fds[0].events = POLLOUT;
-
-      /* Wait until we can send data or until the connection is lost */
-
-      ret = poll(fds, 1, -1);
-      if (ret < 0)
-        {
-          printf("client: ERROR poll failed: %d\n", errno);
-          goto errout_with_socket;
-        }
-
-      if ((fds[0].revents & POLLHUP) != 0)
-        {
-          printf("client: WARNING poll returned POLLHUP\n");
-          ret = EXIT_SUCCESS;
-          goto errout_with_socket;
-        }
-#endif
-
-      ret = sendto(sockfd, g_udpblaster_text, UDPBLASTER_SENDSIZE, 0,
-                   (struct sockaddr *)&host, addrlen);
-      if (ret < 0)
-        {
-          fprintf(stderr, "ERROR: sendto() failed: %d\n", errno);
-          ret = EXIT_FAILURE;
-          goto errout_with_socket;
-        }
-
-      if (++npackets >= 10000)
-        {
-          putchar('.');
-          npackets = 0;
-
-          if (++ndots >= 50)
-            {
-              putchar('\n');
-              ndots = 0;
-            }
-        }
+      ret = udpblaster_receiver(sockfd, &opts);
+    }
+  else
+    {
+      ret = udpblaster_sender(sockfd, (FAR struct sockaddr *)&host, addrlen,
+                              &opts);
     }
 
 errout_with_socket:
@@ -27,12 +27,15 @@
 #include <nuttx/config.h>
 
 #include <sys/boardctl.h>
+#include <sys/stat.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <string.h>
 #include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
 #include <errno.h>
 
 #include "graphics/tiff.h"
@@ -55,10 +58,31 @@
 #  define CONFIG_SCREENSHOT_FORMAT FB_FMT_RGB16_565
 #endif
 
+#ifndef CONFIG_SCREENSHOT_ROWS
+#  define CONFIG_SCREENSHOT_ROWS 16
+#endif
+
+#ifndef CONFIG_SCREENSHOT_IOBUFSIZE
+#  define CONFIG_SCREENSHOT_IOBUFSIZE 4096
+#endif
+
+/* The original capture path: one row per grab and per strip, staged in two
+ * temporary files with a small I/O buffer.  Kept for comparison (-l).
+ */
+
+#define SCREENSHOT_LEGACY_IOBUFSIZE 300
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
 
+struct screenshot_opts_s
+{
+  int  rows;     /* Rows per grab (and RowsPerStrip) */
+  bool packbits; /* Use PackBits compression */
+  bool legacy;   /* Use the temporary file path with one row per grab */
+};
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -93,18 +117,81 @@ static void replace_extension(FAR const char *filename,
 }
 
 /****************************************************************************
- * Public Functions
+ * Name: screenshot_stride
+ *
+ * Description:
+ *   Return the number of bytes in one row of pixels as returned by
+ *   nx_getrectangle() for the configured color format.
+ *
  ****************************************************************************/
 
+static size_t screenshot_stride(nxgl_coord_t width)
+{
+  switch (CONFIG_SCREENSHOT_FORMAT)
+    {
+      case FB_FMT_Y1:
+        return (width + 7) >> 3;
+
+      case FB_FMT_Y4:
+        return (width + 1) >> 1;
+
+      case FB_FMT_Y8:
+        return width;
+
+      case FB_FMT_RGB16_565:
+        return 2 * width;
+
+      default:
+        return 3 * width;
+    }
+}
+
+/****************************************************************************
+ * Name: screenshot_msec
+ *
+ * Description:
+ *   Return the milliseconds elapsed since start.
+ *
+ ****************************************************************************/
+
+static unsigned long screenshot_msec(FAR const struct timespec *start)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (now.tv_sec - start->tv_sec) * 1000 +
+         (now.tv_nsec - start->tv_nsec) / 1000000;
+}
+
+static void show_usage(FAR const char *progname)
+{
+  fprintf(stderr, "USAGE: %s [OPTIONS] <file>\n", progname);
+  fprintf(stderr, "\nWhere:\n");
+  fprintf(stderr, "\t<file> is the TIFF file to create\n");
+  fprintf(stderr, "\nand OPTIONS include the following:\n");
+  fprintf(stderr,
+          "\t-r <rows>: Rows per grab and per TIFF strip.  Default: %d\n",
+          CONFIG_SCREENSHOT_ROWS);
+  fprintf(stderr, "\t-c: Use PackBits compression\n");
+  fprintf(stderr,
+          "\t-l: Legacy path: temporary files, one row per grab\n");
+}
+
 /****************************************************************************
  * Name: save_screenshot
  *
  * Description:
  *   Takes a screenshot and saves it to a tif file.
  *
+ *   By default, the screen is grabbed several rows at a time and the TIFF
+ *   file is written directly in a single pass.  The legacy path grabs one
+ *   row at a time and lets the TIFF library stage the image in temporary
+ *   files that are copied into the final file.
+ *
  ****************************************************************************/
 
-int save_screenshot(FAR const char *filename)
+static int save_screenshot(FAR const char *filename,
+                           FAR const struct screenshot_opts_s *opts)
 {
   struct tiff_info_s info;
   struct nx_callback_s cb =
@@ -119,17 +206,20 @@ int save_screenshot(FAR const char *filename)
 #ifdef CONFIG_VNCSERVER
   struct boardioc_vncstart_s vnc;
 #endif
+  struct timespec start;
+  unsigned long grabms = 0;
+  unsigned long totalms;
   FAR uint8_t *strip;
   NXHANDLE server;
   NXWINDOW window;
   char tempf1[64];
   char tempf2[64];
+  struct stat st;
+  size_t stride;
+  int rows;
   int row;
   int ret;
 
-  replace_extension(filename, ".tm1", tempf1, sizeof(tempf1));
-  replace_extension(filename, ".tm2", tempf2, sizeof(tempf2));
-
   /* Connect to NX server */
 
   server = nx_connect();
@@ -177,16 +267,46 @@ int save_screenshot(FAR const char *filename)
 
   /* Configure the TIFF structure */
 
+  rows = opts->legacy ? 1 : opts->rows;
+  if (rows > size.h)
+    {
+      rows = size.h;
+    }
+
   memset(&info, 0, sizeof(struct tiff_info_s));
   info.outfile   = filename;
-  info.tmpfile1  = tempf1;
-  info.tmpfile2  = tempf2;
   info.colorfmt  = CONFIG_SCREENSHOT_FORMAT;
-  info.rps       = 1;
+  info.rps       = rows;
   info.imgwidth  = size.w;
   info.imgheight = size.h;
-  info.iobuffer  = (uint8_t *)malloc(300);
-  info.iosize    = 300;
+  info.compress  = opts->packbits ? TAG_COMP_PACKBITS : TAG_COMP_NONE;
+
+  if (opts->legacy)
+    {
+      replace_extension(filename, ".tm1", tempf1, sizeof(tempf1));
+      replace_extension(filename, ".tm2", tempf2, sizeof(tempf2));
+
+      info.tmpfile1 = tempf1;
+      info.tmpfile2 = tempf2;
+      info.iosize   = SCREENSHOT_LEGACY_IOBUFSIZE;
+    }
+  else
+    {
+      info.iosize   = CONFIG_SCREENSHOT_IOBUFSIZE;
+    }
+
+  stride        = screenshot_stride(size.w);
+  info.iobuffer = malloc(info.iosize);
+  strip         = malloc(rows * stride);
+
+  if (info.iobuffer == NULL || strip == NULL)
+    {
+      printf("Failed to allocate %d rows\n", rows);
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
 
   /* Initialize the TIFF library */
 
@@ -194,52 +314,78 @@ int save_screenshot(FAR const char *filename)
   if (ret < 0)
     {
       printf("tiff_initialize() failed: %d\n", ret);
-      return 1;
+      goto errout;
     }
 
-  /* Add each strip to the TIFF file */
-
-  strip = malloc(size.w * 3);
+  /* Grab the screen several rows at a time and add each group as one
+   * strip.  The last group may be short.
+   */
 
-  for (row = 0; row < size.h; row++)
+  for (row = 0; row < size.h; row += rows)
     {
+      struct timespec grab;
       struct nxgl_rect_s rect =
       {
         {
           0, row
         },
         {
-          size.w - 1, row
+          size.w - 1, row + rows - 1
         }
       };
 
-      nx_getrectangle(window, &rect, 0, strip, 0);
+      if (rect.pt2.y >= size.h)
+        {
+          rect.pt2.y = size.h - 1;
+        }
+
+      clock_gettime(CLOCK_MONOTONIC, &grab);
+      nx_getrectangle(window, &rect, 0, strip, stride);
+      grabms += screenshot_msec(&grab);
 
       ret = tiff_addstrip(&info, strip);
       if (ret < 0)
         {
           printf("tiff_addstrip() #%d failed: %d\n", row, ret);
-          break;
+          goto errout;
         }
     }
 
-  free(strip);
-
   /* Then finalize the TIFF file */
 
   ret = tiff_finalize(&info);
   if (ret < 0)
     {
       printf("tiff_finalize() failed: %d\n", ret);
+      goto errout;
+    }
+
+  totalms = screenshot_msec(&start);
+
+  if (stat(filename, &st) < 0)
+    {
+      st.st_size = 0;
     }
 
+  printf("%s: %dx%d, %d rows/strip%s%s, %lu bytes\n",
+         filename, size.w, size.h, rows,
+         opts->packbits ? ", PackBits" : "",
+         opts->legacy ? ", legacy" : "", (unsigned long)st.st_size);
+  printf("  grab %lu ms, total %lu ms\n", grabms, totalms);
+
+errout:
+  free(strip);
   free(info.iobuffer);
   nx_closewindow(window);
   nx_disconnect(server);
 
-  return 0;
+  return ret < 0 ? 1 : 0;
 }
 
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
 /****************************************************************************
  * Name: screenshot_main
  *
@@ -250,11 +396,50 @@ int save_screenshot(FAR const char *filename)
 
 int main(int argc, FAR char *argv[])
 {
-  if (argc != 2)
+  struct screenshot_opts_s opts;
+  int option;
+
+  opts.rows     = CONFIG_SCREENSHOT_ROWS;
+#ifdef CONFIG_SCREENSHOT_PACKBITS
+  opts.packbits = true;
+#else
+  opts.packbits = false;
+#endif
+  opts.legacy   = false;
+
+  while ((option = getopt(argc, argv, "r:clh")) != ERROR)
+    {
+      switch (option)
+        {
+          case 'r':
+            opts.rows = atoi(optarg);
+            if (opts.rows < 1)
+              {
+                fprintf(stderr, "Invalid row count: %s\n", optarg);
+                return 1;
+              }
+            break;
+
+          case 'c':
+            opts.packbits = true;
+            break;
+
+          case 'l':
+            opts.legacy = true;
+            break;
+
+          case 'h':
+          default:
+            show_usage(argv[0]);
+            return 1;
+        }
+    }
+
+  if (optind != argc - 1)
     {
-      fprintf(stderr, "Usage: screenshot file.tif\n");
+      show_usage(argv[0]);
       return 1;
     }
 
-  return save_screenshot(argv[1]);
+  return save_screenshot(argv[optind], &opts);
 }
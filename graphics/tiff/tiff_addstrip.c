@@ -38,6 +38,10 @@
  * Pre-Processor Definitions
  ****************************************************************************/
 
+/* Number of RGB565 pixels converted at a time before PackBits encoding */
+
+#define TIFF_CONV_NPIXELS 32
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -55,86 +59,151 @@
  ****************************************************************************/
 
 /****************************************************************************
- * Name: tiff_addstrip
+ * Name: tiff_rgb565
  *
  * Description:
- *   Convert an RGB565 strip to an RGB888 strip and write it to tmpfile2.
+ *   Convert npixels RGB565 pixels to RGB888.
  *
- *   Add an image data strip.  The size of the strip in pixels must be equal
- *   to the RowsPerStrip x ImageWidth values that were provided to
- *   tiff_initialize().
+ ****************************************************************************/
+
+static inline FAR uint8_t *tiff_rgb565(FAR uint8_t *dest,
+                                       FAR const uint16_t *src,
+                                       size_t npixels)
+{
+  uint16_t rgb565;
+
+  while (npixels-- > 0)
+    {
+      rgb565  = *src++;
+      *dest++ = (rgb565 >> (11-3)) & 0xf8; /* Move bits 11-15 to 3-7 */
+      *dest++ = (rgb565 >> ( 5-2)) & 0xfc; /* Move bits  5-10 to 2-7 */
+      *dest++ = (rgb565 << (   3)) & 0xf8; /* Move bits  0- 4 to 3-7 */
+    }
+
+  return dest;
+}
+
+/****************************************************************************
+ * Name: tiff_convstrip
+ *
+ * Description:
+ *   Convert an RGB565 strip to an RGB888 strip and write it to fd.
  *
  * Input Parameters:
  *   info    - A pointer to the caller allocated parameter passing/TIFF state instance.
- *   buffer  - A buffer containing a single row of data.
+ *   fd      - The file descriptor to write to.
+ *   strip   - A buffer containing the RGB565 strip data.
+ *   npixels - The number of pixels in the strip.
  *
  * Returned Value:
  *   Zero (OK) on success.  A negated errno value on failure.
  *
  ****************************************************************************/
-int tiff_convstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
+
+static int tiff_convstrip(FAR struct tiff_info_s *info, int fd,
+                          FAR const uint8_t *strip, size_t npixels)
 {
-#ifdef CONFIG_DEBUG_GRAPHICS
-  size_t ntotal;
-#endif
-  size_t nbytes;
-  FAR uint16_t *src;
-  FAR uint8_t *dest;
-  uint16_t rgb565;
+  FAR const uint16_t *src;
+  size_t maxpixels;
+  size_t nconv;
   int ret;
-  int i;
 
-  DEBUGASSERT(info->iobuffer != NULL);
+  DEBUGASSERT(info->iobuffer != NULL && info->iosize >= 3);
 
-  /* Convert each RGB565 pixel to RGB888 */
+  /* Convert as many RGB565 pixels to RGB888 as fit in the I/O buffer,
+   * then flush the converted pixels to the file.
+   */
 
-  src    = (FAR uint16_t *)strip;
-  dest   = info->iobuffer;
-  nbytes = 0;
-#ifdef CONFIG_DEBUG_GRAPHICS
-  ntotal = 0;
-#endif
+  src       = (FAR const uint16_t *)strip;
+  maxpixels = info->iosize / 3;
 
-  for (i = 0; i < info->pps; i++)
+  while (npixels > 0)
     {
-      /* Convert RGB565 to RGB888 */
+      nconv = npixels < maxpixels ? npixels : maxpixels;
+      tiff_rgb565(info->iobuffer, src, nconv);
 
-      rgb565  = *src++;
-      *dest++ = (rgb565 >> (11-3)) & 0xf8; /* Move bits 11-15 to 3-7 */
-      *dest++ = (rgb565 >> ( 5-2)) & 0xfc; /* Move bits  5-10 to 2-7 */
-      *dest++ = (rgb565 << (   3)) & 0xf8; /* Move bits  0- 4 to 3-7 */
+      ret = tiff_write(fd, info->iobuffer, 3 * nconv);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      src     += nconv;
+      npixels -= nconv;
+    }
+
+  return OK;
+}
 
-      /* Update the byte count */
+/****************************************************************************
+ * Name: tiff_packstrip
+ *
+ * Description:
+ *   PackBits-encode a strip and write it to fd.  Each row is packed
+ *   separately as required by the TIFF specification.  RGB565 data is
+ *   converted to RGB888 in small chunks on the way into the encoder.
+ *
+ * Input Parameters:
+ *   info  - A pointer to the caller allocated parameter passing/TIFF state
+ *           instance.
+ *   fd    - The file descriptor to write to.
+ *   strip - A buffer containing the strip data.
+ *   nrows - The number of rows in the strip.
+ *
+ * Returned Value:
+ *   The encoded size of the strip on success.  A negated errno value on
+ *   failure.
+ *
+ ****************************************************************************/
 
-      nbytes += 3;
-#ifdef CONFIG_DEBUG_GRAPHICS
-      ntotal += 3;
-#endif
+static ssize_t tiff_packstrip(FAR struct tiff_info_s *info, int fd,
+                              FAR const uint8_t *strip, int nrows)
+{
+  struct tiff_packbits_s pb;
+  uint8_t rgb888[3 * TIFF_CONV_NPIXELS];
+  FAR const uint16_t *src;
+  size_t npixels;
+  size_t nconv;
+  int ret = OK;
+  int row;
 
-      /* Flush the conversion buffer to tmpfile2 when it becomes full */
+  tiff_pbinit(&pb, info, fd);
 
-      if (nbytes > (info->iosize-3))
+  for (row = 0; row < nrows && ret == OK; row++)
+    {
+      if (info->colorfmt == FB_FMT_RGB16_565)
         {
-          ret = tiff_write(info->tmp2fd, info->iobuffer, nbytes);
-          if (ret < 0)
+          src = (FAR const uint16_t *)strip + row * info->imgwidth;
+
+          for (npixels = info->imgwidth; npixels > 0 && ret == OK; )
             {
-              return ret;
-            }
+              nconv = npixels < TIFF_CONV_NPIXELS ?
+                      npixels : TIFF_CONV_NPIXELS;
 
-          /* Reset to refill the conversion buffer */
+              tiff_rgb565(rgb888, src, nconv);
+              ret = tiff_pbwrite(&pb, rgb888, 3 * nconv);
+
+              src     += nconv;
+              npixels -= nconv;
+            }
+        }
+      else
+        {
+          ret = tiff_pbwrite(&pb, strip + row * info->bpr, info->bpr);
+        }
 
-          dest   = info->iobuffer;
-          nbytes = 0;
+      if (ret == OK)
+        {
+          ret = tiff_pbendrow(&pb);
         }
     }
 
-  /* Flush any buffer data to tmpfile2 */
+  if (ret < 0)
+    {
+      return ret;
+    }
 
-  ret = tiff_write(info->tmp2fd, info->iobuffer, nbytes);
-#ifdef CONFIG_DEBUG_GRAPHICS
-  DEBUGASSERT(ntotal == info->bps);
-#endif
-  return ret;
+  return tiff_pbfinish(&pb);
 }
 
 /****************************************************************************
@@ -147,7 +216,8 @@ int tiff_convstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
  * Description:
  *   Add an image data strip.  The size of the strip in pixels must be equal
  *   to the RowsPerStrip x ImageWidth values that were provided to
- *   tiff_initialize().
+ *   tiff_initialize().  In direct mode, the last strip may hold fewer rows;
+ *   only the rows that remain in the image are used.
  *
  * Input Parameters:
  *   info    - A pointer to the caller allocated parameter passing/TIFF state instance.
@@ -161,22 +231,59 @@ int tiff_convstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
 int tiff_addstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
 {
   ssize_t newsize;
+  ssize_t nbytes;
+  int nrows;
+  int fd;
   int ret;
 
-  /* Add the new strip based on the color format.  For FB_FMT_RGB16_565,
-   * will have to perform a conversion to RGB888.
+  /* In direct mode, the strip data goes straight to the outfile.
+   * Otherwise, it is collected in tmpfile2.
+   */
+
+  if (IMGFLAGS_ISDIRECT(info->imgflags))
+    {
+      if (info->nstrips >= info->maxstrips)
+        {
+          gerr("ERROR: Too many strips: %d\n", info->nstrips + 1);
+          ret = -E2BIG;
+          goto errout;
+        }
+
+      fd     = info->outfd;
+      nrows  = info->imgheight - info->nstrips * info->rps;
+      if (nrows > info->rps)
+        {
+          nrows = info->rps;
+        }
+
+      nbytes = tiff_stripsize(info, info->nstrips);
+    }
+  else
+    {
+      fd     = info->tmp2fd;
+      nrows  = info->rps;
+      nbytes = info->bps;
+    }
+
+  /* Add the new strip based on the color format and compression.  For
+   * FB_FMT_RGB16_565, will have to perform a conversion to RGB888.
    */
 
-  if (info->colorfmt == FB_FMT_RGB16_565)
+  if (IMGFLAGS_ISPACKBITS(info->imgflags))
     {
-      ret = tiff_convstrip(info, strip);
+      nbytes = tiff_packstrip(info, fd, strip, nrows);
+      ret    = nbytes < 0 ? (int)nbytes : OK;
+    }
+  else if (info->colorfmt == FB_FMT_RGB16_565)
+    {
+      ret = tiff_convstrip(info, fd, strip, nbytes / 3);
     }
 
   /* For other formats, it is a simple write using the number of bytes per strip */
 
   else
     {
-      ret = tiff_write(info->tmp2fd, strip, info->bps);
+      ret = tiff_write(fd, strip, nbytes);
     }
 
   if (ret < 0)
@@ -184,9 +291,36 @@ int tiff_addstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
       goto errout;
     }
 
+  if (IMGFLAGS_ISDIRECT(info->imgflags))
+    {
+      /* The offsets were precomputed; only compressed sizes need to be
+       * remembered for tiff_finalize().
+       */
+
+      if (info->counts != NULL)
+        {
+          info->counts[info->nstrips] = nbytes;
+        }
+
+      info->outsize += nbytes;
+
+      /* Pad the outfile as necessary achieve word alignment */
+
+      newsize = tiff_wordalign(info->outfd, info->outsize);
+      if (newsize < 0)
+        {
+          ret = (int)newsize;
+          goto errout;
+        }
+
+      info->outsize = (size_t)newsize;
+      info->nstrips++;
+      return OK;
+    }
+
   /* Write the byte count to the outfile and the offset to tmpfile1 */
 
-  ret = tiff_putint32(info->outfd, info->bps);
+  ret = tiff_putint32(info->outfd, nbytes);
   if (ret < 0)
     {
       goto errout;
@@ -202,7 +336,7 @@ int tiff_addstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
 
   /* Increment the size of tmp2file. */
 
-  info->tmp2size += info->bps;
+  info->tmp2size += nbytes;
 
   /* Pad tmpfile2 as necessary achieve word alignment */
 
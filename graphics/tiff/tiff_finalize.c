@@ -26,6 +26,7 @@
 
 #include <nuttx/config.h>
 
+#include <stdlib.h>
 #include <unistd.h>
 #include <assert.h>
 #include <errno.h>
@@ -167,10 +168,100 @@ static void tiff_cleanup(FAR struct tiff_info_s *info)
 
   info->tmp2fd = -1;
 
+  /* Free the compressed strip sizes */
+
+  free(info->counts);
+  info->counts = NULL;
+
   /* And remove the temporary files */
 
-  unlink(info->tmpfile1);
-  unlink(info->tmpfile2);
+  if (info->tmpfile1 != NULL)
+    {
+      unlink(info->tmpfile1);
+      unlink(info->tmpfile2);
+    }
+}
+
+/****************************************************************************
+ * Name: tiff_putstripcounts
+ *
+ * Description:
+ *   In direct mode with compression, replace the placeholder
+ *   StripByteCounts and StripOffsets values written by tiff_initialize()
+ *   with the actual compressed strip sizes and resulting offsets.
+ *
+ * Input Parameters:
+ *   info - A pointer to the caller allocated parameter passing/TIFF
+ *          state instance.
+ *
+ * Returned Value:
+ *   Zero (OK) on success.  A negated errno value on failure.
+ *
+ ****************************************************************************/
+
+static int tiff_putstripcounts(FAR struct tiff_info_s *info)
+{
+  struct tiff_ifdentry_s ifdentry;
+  FAR uint8_t *ptr;
+  size_t maxvalues;
+  size_t nvalues;
+  off_t offset;
+  int pass;
+  int ret;
+  int i;
+
+  /* A single count is held in the IFD entry itself */
+
+  if (info->maxstrips == 1)
+    {
+      ret = tiff_readifdentry(info->outfd, info->filefmt->sbcifdoffset,
+                              &ifdentry);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      tiff_put32(ifdentry.offset, info->counts[0]);
+      return tiff_writeifdentry(info->outfd, info->filefmt->sbcifdoffset,
+                                &ifdentry);
+    }
+
+  /* Otherwise rewrite both arrays, which are contiguous starting at the
+   * StripByteCounts values.
+   */
+
+  offset = lseek(info->outfd, info->filefmt->sbcoffset, SEEK_SET);
+  if (offset == (off_t)-1)
+    {
+      return -errno;
+    }
+
+  maxvalues = info->iosize >> 2;
+
+  for (pass = 0; pass < 2; pass++)
+    {
+      offset = info->dataoffs;
+      for (i = 0; i < info->maxstrips; )
+        {
+          ptr = info->iobuffer;
+          for (nvalues = 0;
+               nvalues < maxvalues && i < info->maxstrips;
+               nvalues++, i++, ptr += 4)
+            {
+              tiff_put32(ptr, pass == 0 ? info->counts[i] : (uint32_t)offset);
+              offset += (info->counts[i] + 3) & ~3;
+            }
+
+          ret = tiff_write(info->outfd, info->iobuffer, nvalues << 2);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+    }
+
+  DEBUGASSERT(offset == info->outsize);
+  return OK;
 }
 
 /****************************************************************************
@@ -218,6 +309,35 @@ int tiff_finalize(FAR struct tiff_info_s *info)
    *    no fixups are required.
    */
 
+  /* In direct mode, the outfile is already complete except for the sizes
+   * of compressed strips.
+   */
+
+  if (IMGFLAGS_ISDIRECT(info->imgflags))
+    {
+      DEBUGASSERT(info->outfd >= 0);
+
+      if (info->nstrips != info->maxstrips)
+        {
+          gerr("ERROR: Expected %d strips, got %d\n",
+               info->maxstrips, info->nstrips);
+          ret = -EINVAL;
+          goto errout;
+        }
+
+      if (info->counts != NULL)
+        {
+          ret = tiff_putstripcounts(info);
+          if (ret < 0)
+            {
+              goto errout;
+            }
+        }
+
+      tiff_cleanup(info);
+      return OK;
+    }
+
   DEBUGASSERT(info && info->outfd >= 0 &&
               info->tmp1fd >= 0 && info->tmp2fd >= 0);
   DEBUGASSERT((info->outsize & 3) == 0 && (info->tmp1size & 3) == 0);
@@ -26,6 +26,7 @@
 
 #include <nuttx/config.h>
 
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
@@ -74,6 +75,11 @@
  *          xxx    StripOffsets                Beginning of strip offsets
  *          xxx    [Probably padding]
  *          xxx    Data for strips             Beginning of strip data
+ *
+ * In direct mode (no temporary files) the layout is the same, but the
+ * number of strips is known up front so that the StripOffsets values
+ * immediately follow the StripByteCounts values and the strip data begins
+ * at StripByteCounts + 8 * nstrips.
  */
 
 #define TIFF_IFD_OFFSET           (SIZEOF_TIFF_HEADER+2)
@@ -416,6 +422,76 @@ static int tiff_datetime(FAR char *timbuf, unsigned int buflen)
   return OK;
 }
 
+/****************************************************************************
+ * Name: tiff_putstripinfo
+ *
+ * Description:
+ *   In direct mode, write the StripByteCounts and StripOffsets values.
+ *   Without compression the strip sizes are known so the final values are
+ *   written now.  With compression, both arrays are placeholders that will
+ *   be patched by tiff_finalize().
+ *
+ * Input Parameters:
+ *   info - A pointer to the caller allocated parameter passing/TIFF state
+ *          instance.
+ *
+ * Returned Value:
+ *   Zero (OK) on success.  A negated errno value on failure.
+ *
+ ****************************************************************************/
+
+static int tiff_putstripinfo(FAR struct tiff_info_s *info)
+{
+  FAR uint8_t *ptr;
+  size_t maxvalues;
+  size_t nvalues;
+  uint32_t value;
+  off_t offset;
+  int pass;
+  int ret;
+  int i;
+
+  /* Pass 0 writes the counts, pass 1 writes the offsets, each batched
+   * through the I/O buffer.
+   */
+
+  maxvalues = info->iosize >> 2;
+  DEBUGASSERT(maxvalues > 0);
+
+  for (pass = 0; pass < 2; pass++)
+    {
+      offset = info->dataoffs;
+      for (i = 0; i < info->maxstrips; )
+        {
+          ptr = info->iobuffer;
+          for (nvalues = 0;
+               nvalues < maxvalues && i < info->maxstrips;
+               nvalues++, i++, ptr += 4)
+            {
+              if (IMGFLAGS_ISPACKBITS(info->imgflags))
+                {
+                  value = 0;
+                }
+              else
+                {
+                  value = tiff_stripsize(info, i);
+                }
+
+              tiff_put32(ptr, pass == 0 ? value : (uint32_t)offset);
+              offset += (value + 3) & ~3;
+            }
+
+          ret = tiff_write(info->outfd, info->iobuffer, nvalues << 2);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+    }
+
+  return OK;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -443,10 +519,14 @@ int tiff_initialize(FAR struct tiff_info_s *info)
   char timbuf[TIFF_DATETIME_STRLEN + 8];
   int ret = -EINVAL;
 
-  DEBUGASSERT(info && info->outfile && info->tmpfile1 && info->tmpfile2);
+  DEBUGASSERT(info && info->outfile &&
+              (info->tmpfile1 != NULL) == (info->tmpfile2 != NULL));
 
   /* Open all output files */
 
+  info->tmp1fd = -1;
+  info->tmp2fd = -1;
+
   info->outfd = open(info->outfile, O_RDWR|O_CREAT|O_TRUNC, 0666);
   if (info->outfd < 0)
     {
@@ -455,20 +535,25 @@ int tiff_initialize(FAR struct tiff_info_s *info)
       goto errout;
     }
 
-  info->tmp1fd = open(info->tmpfile1, O_RDWR|O_CREAT|O_TRUNC, 0666);
-  if (info->tmp1fd < 0)
-    {
-      gerr("ERROR: Failed to open %s for reading/writing: %d\n",
-           info->tmpfile1, errno);
-      goto errout;
-    }
+  /* No temporary files are needed in direct mode */
 
-  info->tmp2fd = open(info->tmpfile2, O_RDWR|O_CREAT|O_TRUNC, 0666);
-  if (info->tmp2fd < 0)
+  if (info->tmpfile1 != NULL)
     {
-      gerr("ERROR: Failed to open %s for reading/writing: %d\n",
-           info->tmpfile2, errno);
-      goto errout;
+      info->tmp1fd = open(info->tmpfile1, O_RDWR|O_CREAT|O_TRUNC, 0666);
+      if (info->tmp1fd < 0)
+        {
+          gerr("ERROR: Failed to open %s for reading/writing: %d\n",
+               info->tmpfile1, errno);
+          goto errout;
+        }
+
+      info->tmp2fd = open(info->tmpfile2, O_RDWR|O_CREAT|O_TRUNC, 0666);
+      if (info->tmp2fd < 0)
+        {
+          gerr("ERROR: Failed to open %s for reading/writing: %d\n",
+               info->tmpfile2, errno);
+          goto errout;
+        }
     }
 
   /* Make some decisions using the color format.  Only the following are
@@ -482,30 +567,35 @@ int tiff_initialize(FAR struct tiff_info_s *info)
         info->filefmt  = &g_bilevinfo;              /* Bi-level file image file info */
         info->imgflags = IMGFLAGS_FMT_Y1;           /* Bit encoded image characteristics */
         info->bps      = (info->pps + 7) >> 3;      /* Bytes per strip */
+        info->bpr      = (info->imgwidth + 7) >> 3; /* Bytes per row */
         break;
 
       case FB_FMT_Y4:                               /* BPP=4, 4-bit greyscale, 0=black */
         info->filefmt  = &g_greyinfo;               /* Greyscale file image file info */
         info->imgflags = IMGFLAGS_FMT_Y4;           /* Bit encoded image characteristics */
         info->bps      = (info->pps + 1) >> 1;      /* Bytes per strip */
+        info->bpr      = (info->imgwidth + 1) >> 1; /* Bytes per row */
         break;
 
       case FB_FMT_Y8:                               /* BPP=8, 8-bit greyscale, 0=black */
         info->filefmt  = &g_greyinfo;               /* Greyscale file image file info */
         info->imgflags = IMGFLAGS_FMT_Y8;           /* Bit encoded image characteristics */
         info->bps      = info->pps;                 /* Bytes per strip */
+        info->bpr      = info->imgwidth;            /* Bytes per row */
         break;
 
       case FB_FMT_RGB16_565:                        /* BPP=16 R=6, G=6, B=5 */
         info->filefmt  = &g_rgbinfo;                /* RGB file image file info */
         info->imgflags = IMGFLAGS_FMT_RGB16_565;    /* Bit encoded image characteristics */
         info->bps      = 3 * info->pps;             /* Bytes per strip */
+        info->bpr      = 3 * info->imgwidth;        /* Bytes per row */
         break;
 
       case FB_FMT_RGB24:                            /* BPP=24 R=8, G=8, B=8 */
         info->filefmt  = &g_rgbinfo;                /* RGB file image file info */
         info->imgflags = IMGFLAGS_FMT_RGB24;        /* Bit encoded image characteristics */
         info->bps      = 3 *info->pps;              /* Bytes per strip */
+        info->bpr      = 3 * info->imgwidth;        /* Bytes per row */
         break;
 
       default:
@@ -513,6 +603,63 @@ int tiff_initialize(FAR struct tiff_info_s *info)
         return -EINVAL;
     }
 
+  /* Select the compression */
+
+  switch (info->compress)
+    {
+      case 0:
+      case TAG_COMP_NONE:
+        info->compress = TAG_COMP_NONE;
+        break;
+
+      case TAG_COMP_PACKBITS:
+        if (info->iobuffer == NULL ||
+            info->iosize < TIFF_PACKBITS_MINIOSIZE)
+          {
+            gerr("ERROR: PackBits needs a %d byte I/O buffer\n",
+                 TIFF_PACKBITS_MINIOSIZE);
+            ret = -EINVAL;
+            goto errout;
+          }
+
+        info->imgflags |= IMGFLAGS_PACKBITS_BIT;
+        break;
+
+      default:
+        gerr("ERROR: Unsupported compression: %d\n", info->compress);
+        ret = -EINVAL;
+        goto errout;
+    }
+
+  /* In direct mode, the number of strips follows from the image height and
+   * the position of every value in the file can be determined now.  Each
+   * strip holds whole, byte-aligned rows; the last strip may be short.
+   */
+
+  if (info->tmpfile1 == NULL)
+    {
+      if (info->rps <= 0 || info->imgheight <= 0)
+        {
+          ret = -EINVAL;
+          goto errout;
+        }
+
+      info->imgflags |= IMGFLAGS_DIRECT_BIT;
+      info->bps       = info->rps * info->bpr;
+      info->maxstrips = (info->imgheight + info->rps - 1) / info->rps;
+      info->dataoffs  = info->filefmt->sbcoffset + 8 * info->maxstrips;
+
+      if (IMGFLAGS_ISPACKBITS(info->imgflags))
+        {
+          info->counts = calloc(info->maxstrips, sizeof(uint32_t));
+          if (info->counts == NULL)
+            {
+              ret = -ENOMEM;
+              goto errout;
+            }
+        }
+    }
+
   /* Write the TIFF header data to the outfile:
    *
    * Header:    0    Byte Order                  "II" or "MM"
@@ -608,12 +755,13 @@ int tiff_initialize(FAR struct tiff_info_s *info)
 
   /* Write Compression:
    *
-   * Bi-level Images: Offset 48 Hard-coded no compression (for now)
-   * Greyscale:       Offset 60  "  " "   " "" "          " " " " "
-   * RGB:             Offset 60 "  " "   " "" "          " " " " "
+   * Bi-level Images: Offset 48 None or PackBits
+   * Greyscale:       Offset 60 None or PackBits
+   * RGB:             Offset 60 None or PackBits
    */
 
-  ret = tiff_putifdentry16(info, IFD_TAG_COMPRESSION, IFD_FIELD_SHORT, 1, TAG_COMP_NONE);
+  ret = tiff_putifdentry16(info, IFD_TAG_COMPRESSION, IFD_FIELD_SHORT, 1,
+                           info->compress);
   if (ret < 0)
     {
       goto errout;
@@ -651,7 +799,21 @@ int tiff_initialize(FAR struct tiff_info_s *info)
    */
 
   tiff_checkoffs(offset, info->filefmt->soifdoffset);
-  ret = tiff_putifdentry(info, IFD_TAG_STRIPOFFSETS, IFD_FIELD_LONG, 0, 0);
+  if (IMGFLAGS_ISDIRECT(info->imgflags))
+    {
+      /* A single value is stored in the IFD entry itself */
+
+      ret = tiff_putifdentry(info, IFD_TAG_STRIPOFFSETS, IFD_FIELD_LONG,
+                             info->maxstrips,
+                             info->maxstrips == 1 ? info->dataoffs :
+                             info->filefmt->sbcoffset + 4 * info->maxstrips);
+    }
+  else
+    {
+      ret = tiff_putifdentry(info, IFD_TAG_STRIPOFFSETS, IFD_FIELD_LONG,
+                             0, 0);
+    }
+
   if (ret < 0)
     {
       goto errout;
@@ -697,7 +859,22 @@ int tiff_initialize(FAR struct tiff_info_s *info)
    */
 
   tiff_checkoffs(offset, info->filefmt->sbcifdoffset);
-  ret = tiff_putifdentry(info, IFD_TAG_STRIPCOUNTS, IFD_FIELD_LONG, 0, info->filefmt->sbcoffset);
+  if (IMGFLAGS_ISDIRECT(info->imgflags))
+    {
+      /* With compression, a single count is patched by tiff_finalize() */
+
+      ret = tiff_putifdentry(info, IFD_TAG_STRIPCOUNTS, IFD_FIELD_LONG,
+                             info->maxstrips,
+                             info->maxstrips > 1 ? info->filefmt->sbcoffset :
+                             IMGFLAGS_ISPACKBITS(info->imgflags) ? 0 :
+                             tiff_stripsize(info, 0));
+    }
+  else
+    {
+      ret = tiff_putifdentry(info, IFD_TAG_STRIPCOUNTS, IFD_FIELD_LONG,
+                             0, info->filefmt->sbcoffset);
+    }
+
   if (ret < 0)
     {
       goto errout;
@@ -891,6 +1068,20 @@ int tiff_initialize(FAR struct tiff_info_s *info)
 
   tiff_checkoffs(offset, info->filefmt->sbcoffset);
   info->outsize = info->filefmt->sbcoffset;
+
+  /* In direct mode, the strip data will follow the counts and offsets */
+
+  if (IMGFLAGS_ISDIRECT(info->imgflags))
+    {
+      ret = tiff_putstripinfo(info);
+      if (ret < 0)
+        {
+          goto errout;
+        }
+
+      info->outsize = info->dataoffs;
+    }
+
   return OK;
 
 errout:
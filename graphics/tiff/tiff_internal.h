@@ -46,6 +46,8 @@
 #define IMGFLAGS_GREY8_BIT     (1 << 2)
 #define IMGFLAGS_RGB_BIT       (1 << 3)
 #define IMGFLAGS_RGB565_BIT    (1 << 4)
+#define IMGFLAGS_DIRECT_BIT    (1 << 5)
+#define IMGFLAGS_PACKBITS_BIT  (1 << 6)
 
 #define IMGFLAGS_FMT_Y1        (IMGFLAGS_BILEV_BIT)
 #define IMGFLAGS_FMT_Y4        (IMGFLAGS_GREY_BIT)
@@ -64,10 +66,38 @@
 #define IMGFLAGS_ISRGB(f) \
   (((f) & IMGFLAGS_FMT_RGB24) != 0)
 
+/* Output Mode **************************************************************/
+
+#define IMGFLAGS_ISDIRECT(f) \
+  (((f) & IMGFLAGS_DIRECT_BIT) != 0)
+#define IMGFLAGS_ISPACKBITS(f) \
+  (((f) & IMGFLAGS_PACKBITS_BIT) != 0)
+
+/* PackBits *****************************************************************/
+
+#define TIFF_PACKBITS_MAXLIT   128 /* Longest literal packet */
+#define TIFF_PACKBITS_MAXRUN   128 /* Longest replicate packet */
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
 
+/* State of the PackBits encoder for one strip.  Encoded packets are
+ * collected in the caller's I/O buffer and written to fd when it fills up.
+ */
+
+struct tiff_packbits_s
+{
+  FAR struct tiff_info_s *info; /* Provides the I/O buffer */
+  int      fd;                  /* Destination file descriptor */
+  size_t   nbuffered;           /* Bytes pending in the I/O buffer */
+  size_t   nwritten;            /* Total encoded bytes for the strip */
+  uint8_t  nlit;                /* Bytes pending in lit[] */
+  uint8_t  nrun;                /* Length of the pending run of runbyte */
+  uint8_t  runbyte;             /* The byte value being replicated */
+  uint8_t  lit[TIFF_PACKBITS_MAXLIT];
+};
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -191,6 +221,99 @@ int tiff_putstring(int fd, FAR const char *string, int len);
 
 ssize_t tiff_wordalign(int fd, size_t size);
 
+/****************************************************************************
+ * Name: tiff_stripsize
+ *
+ * Description:
+ *  Return the size of an uncompressed strip in direct mode.  All strips
+ *  hold RowsPerStrip rows except, possibly, the last one.
+ *
+ * Input Parameters:
+ *   info - A pointer to the caller allocated parameter passing/TIFF state
+ *          instance.
+ *   strip - The strip number
+ *
+ * Returned Value:
+ *   The number of bytes in the strip.
+ *
+ ****************************************************************************/
+
+size_t tiff_stripsize(FAR const struct tiff_info_s *info, int strip);
+
+/****************************************************************************
+ * Name: tiff_pbinit
+ *
+ * Description:
+ *   Prepare to PackBits-encode a new strip.
+ *
+ * Input Parameters:
+ *   pb - The encoder state to initialize
+ *   info - A pointer to the caller allocated parameter passing/TIFF state
+ *          instance.  Its iobuffer holds the encoded output.
+ *   fd - File descriptor that will receive the encoded strip.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void tiff_pbinit(FAR struct tiff_packbits_s *pb,
+                 FAR struct tiff_info_s *info, int fd);
+
+/****************************************************************************
+ * Name: tiff_pbwrite
+ *
+ * Description:
+ *   Encode nbytes of raw image data.  Packets may span several calls but
+ *   the caller must call tiff_pbendrow() at the end of each image row:
+ *   TIFF requires that each row is packed separately.
+ *
+ * Input Parameters:
+ *   pb - The encoder state
+ *   src - The raw data to encode
+ *   nbytes - The number of bytes in src
+ *
+ * Returned Value:
+ *   Zero (OK) on success.  A negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int tiff_pbwrite(FAR struct tiff_packbits_s *pb, FAR const uint8_t *src,
+                 size_t nbytes);
+
+/****************************************************************************
+ * Name: tiff_pbendrow
+ *
+ * Description:
+ *   Terminate the current image row by emitting any pending packet.
+ *
+ * Input Parameters:
+ *   pb - The encoder state
+ *
+ * Returned Value:
+ *   Zero (OK) on success.  A negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int tiff_pbendrow(FAR struct tiff_packbits_s *pb);
+
+/****************************************************************************
+ * Name: tiff_pbfinish
+ *
+ * Description:
+ *   Terminate the strip and flush all encoded data to the file.
+ *
+ * Input Parameters:
+ *   pb - The encoder state
+ *
+ * Returned Value:
+ *   The size of the encoded strip in bytes on success.  A negated errno
+ *   value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t tiff_pbfinish(FAR struct tiff_packbits_s *pb);
+
 #undef EXTERN
 #if defined(__cplusplus)
 }
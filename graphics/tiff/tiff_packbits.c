@@ -0,0 +1,320 @@
+/****************************************************************************
+ * apps/graphics/tiff/tiff_packbits.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/* Reference:
+ *   "TIFF, Revision 6.0, Final," June 3, 1992, Adobe Developers Association,
+ *   Section 9: PackBits Compression.
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include "graphics/tiff.h"
+
+#include "tiff_internal.h"
+
+/****************************************************************************
+ * Pre-Processor Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tiff_pbflush
+ *
+ * Description:
+ *   Write the encoded data collected in the I/O buffer to the file.
+ *
+ ****************************************************************************/
+
+static int tiff_pbflush(FAR struct tiff_packbits_s *pb)
+{
+  int ret = OK;
+
+  if (pb->nbuffered > 0)
+    {
+      ret = tiff_write(pb->fd, pb->info->iobuffer, pb->nbuffered);
+      pb->nbuffered = 0;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: tiff_pbpacket
+ *
+ * Description:
+ *   Add one packet (a header byte followed by nbytes of data) to the I/O
+ *   buffer, flushing the buffer first if the packet does not fit.
+ *
+ ****************************************************************************/
+
+static int tiff_pbpacket(FAR struct tiff_packbits_s *pb, uint8_t hdr,
+                         FAR const uint8_t *data, size_t nbytes)
+{
+  FAR uint8_t *dest;
+  int ret;
+
+  if (pb->info->iosize - pb->nbuffered < nbytes + 1)
+    {
+      ret = tiff_pbflush(pb);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  dest    = &pb->info->iobuffer[pb->nbuffered];
+  *dest++ = hdr;
+  memcpy(dest, data, nbytes);
+
+  pb->nbuffered += nbytes + 1;
+  pb->nwritten  += nbytes + 1;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: tiff_pbliteral and tiff_pbrun
+ *
+ * Description:
+ *   Emit a literal packet (header n-1, then n bytes) or a replicate packet
+ *   (header -(n-1), then the byte to repeat).
+ *
+ ****************************************************************************/
+
+static inline int tiff_pbliteral(FAR struct tiff_packbits_s *pb,
+                                 size_t nbytes)
+{
+  DEBUGASSERT(nbytes > 0 && nbytes <= TIFF_PACKBITS_MAXLIT);
+  return tiff_pbpacket(pb, (uint8_t)(nbytes - 1), pb->lit, nbytes);
+}
+
+static inline int tiff_pbrun(FAR struct tiff_packbits_s *pb)
+{
+  DEBUGASSERT(pb->nrun > 1 && pb->nrun <= TIFF_PACKBITS_MAXRUN);
+  return tiff_pbpacket(pb, (uint8_t)(1 - (int)pb->nrun), &pb->runbyte, 1);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tiff_pbinit
+ *
+ * Description:
+ *   Prepare to PackBits-encode a new strip.
+ *
+ * Input Parameters:
+ *   pb - The encoder state to initialize
+ *   info - A pointer to the caller allocated parameter passing/TIFF state
+ *          instance.  Its iobuffer holds the encoded output.
+ *   fd - File descriptor that will receive the encoded strip.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void tiff_pbinit(FAR struct tiff_packbits_s *pb,
+                 FAR struct tiff_info_s *info, int fd)
+{
+  DEBUGASSERT(info->iobuffer != NULL &&
+              info->iosize >= TIFF_PACKBITS_MINIOSIZE);
+
+  pb->info      = info;
+  pb->fd        = fd;
+  pb->nbuffered = 0;
+  pb->nwritten  = 0;
+  pb->nlit      = 0;
+  pb->nrun      = 0;
+  pb->runbyte   = 0;
+}
+
+/****************************************************************************
+ * Name: tiff_pbwrite
+ *
+ * Description:
+ *   Encode nbytes of raw image data.  Packets may span several calls but
+ *   the caller must call tiff_pbendrow() at the end of each image row:
+ *   TIFF requires that each row is packed separately.
+ *
+ *   Runs of three or more identical bytes become replicate packets;
+ *   anything shorter is cheaper to leave in a literal packet.
+ *
+ * Input Parameters:
+ *   pb - The encoder state
+ *   src - The raw data to encode
+ *   nbytes - The number of bytes in src
+ *
+ * Returned Value:
+ *   Zero (OK) on success.  A negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int tiff_pbwrite(FAR struct tiff_packbits_s *pb, FAR const uint8_t *src,
+                 size_t nbytes)
+{
+  uint8_t value;
+  int ret;
+
+  while (nbytes-- > 0)
+    {
+      value = *src++;
+
+      /* Extend the current run if possible, otherwise terminate it */
+
+      if (pb->nrun > 0)
+        {
+          if (value == pb->runbyte && pb->nrun < TIFF_PACKBITS_MAXRUN)
+            {
+              pb->nrun++;
+              continue;
+            }
+
+          ret = tiff_pbrun(pb);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          pb->nrun = 0;
+        }
+
+      /* Accumulate literal bytes */
+
+      pb->lit[pb->nlit++] = value;
+
+      /* Three identical bytes at the end of the literal start a new run */
+
+      if (pb->nlit >= 3 &&
+          pb->lit[pb->nlit - 2] == value && pb->lit[pb->nlit - 3] == value)
+        {
+          if (pb->nlit > 3)
+            {
+              ret = tiff_pbliteral(pb, pb->nlit - 3);
+              if (ret < 0)
+                {
+                  return ret;
+                }
+            }
+
+          pb->nlit    = 0;
+          pb->nrun    = 3;
+          pb->runbyte = value;
+        }
+      else if (pb->nlit >= TIFF_PACKBITS_MAXLIT)
+        {
+          ret = tiff_pbliteral(pb, pb->nlit);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          pb->nlit = 0;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: tiff_pbendrow
+ *
+ * Description:
+ *   Terminate the current image row by emitting any pending packet.
+ *
+ * Input Parameters:
+ *   pb - The encoder state
+ *
+ * Returned Value:
+ *   Zero (OK) on success.  A negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int tiff_pbendrow(FAR struct tiff_packbits_s *pb)
+{
+  int ret = OK;
+
+  if (pb->nrun > 0)
+    {
+      ret = tiff_pbrun(pb);
+      pb->nrun = 0;
+    }
+  else if (pb->nlit > 0)
+    {
+      ret = tiff_pbliteral(pb, pb->nlit);
+      pb->nlit = 0;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: tiff_pbfinish
+ *
+ * Description:
+ *   Terminate the strip and flush all encoded data to the file.
+ *
+ * Input Parameters:
+ *   pb - The encoder state
+ *
+ * Returned Value:
+ *   The size of the encoded strip in bytes on success.  A negated errno
+ *   value on failure.
+ *
+ ****************************************************************************/
+
+ssize_t tiff_pbfinish(FAR struct tiff_packbits_s *pb)
+{
+  int ret;
+
+  ret = tiff_pbendrow(pb);
+  if (ret == OK)
+    {
+      ret = tiff_pbflush(pb);
+    }
+
+  return ret < 0 ? (ssize_t)ret : (ssize_t)pb->nwritten;
+}
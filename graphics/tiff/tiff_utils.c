@@ -366,3 +366,32 @@ ssize_t tiff_wordalign(int fd, size_t size)
     }
   return size;
 }
+
+/****************************************************************************
+ * Name: tiff_stripsize
+ *
+ * Description:
+ *  Return the size of an uncompressed strip in direct mode.  All strips
+ *  hold RowsPerStrip rows except, possibly, the last one.
+ *
+ * Input Parameters:
+ *   info - A pointer to the caller allocated parameter passing/TIFF state
+ *          instance.
+ *   strip - The strip number
+ *
+ * Returned Value:
+ *   The number of bytes in the strip.
+ *
+ ****************************************************************************/
+
+size_t tiff_stripsize(FAR const struct tiff_info_s *info, int strip)
+{
+  int nrows = info->imgheight - strip * info->rps;
+
+  if (nrows > info->rps)
+    {
+      nrows = info->rps;
+    }
+
+  return (size_t)nrows * info->bpr;
+}
@@ -49,6 +49,7 @@
 
 #include <fcntl.h>
 #include <semaphore.h>
+#include <syslog.h>
 
 #include <nuttx/semaphore.h>
 #include <nuttx/nx/nx.h>
@@ -101,6 +102,8 @@ CTwm4Nx::CTwm4Nx(int display)
   m_mainMenu             = (FAR CMainMenu *)0;
   m_resize               = (FAR CResize *)0;
 
+  std::memset(&m_eventStats, 0, sizeof(struct SEventStats));
+
 #if !defined(CONFIG_TWM4NX_NOKEYBOARD) || !defined(CONFIG_TWM4NX_NOMOUSE)
   m_input                = (FAR CInput *)0;
 #endif
@@ -134,7 +137,7 @@ bool CTwm4Nx::initialize(void)
   //  constructors
 
   struct mq_attr attr;
-  attr.mq_maxmsg  = 32;    // REVISIT:  Should be configurable
+  attr.mq_maxmsg  = CONFIG_TWM4NX_EVENTQ_DEPTH;
   attr.mq_msgsize = MAX_EVENT_MSGSIZE;
   attr.mq_flags   = 0;
   attr.mq_curmsgs = 0;
@@ -307,43 +310,93 @@ bool CTwm4Nx::initialize(void)
 
 bool CTwm4Nx::eventLoop(void)
 {
+  // Two message buffers:  While looking for motion events to coalesce, the
+  // next message may have been read ahead and must be processed next.
+
+  union
+  {
+    struct SEventMsg eventmsg;
+    char buffer[MAX_EVENT_MSGSIZE];
+  } u[2];
+
+  int cur = 0;
+  bool readahead = false;
+
   // Enter the event loop
 
   twminfo("Entering event loop\n");
   for (; ; )
     {
-      // Wait for the next NxWidget event
+      // Wait for the next NxWidget event (unless it was already read)
+
+      if (!readahead)
+        {
+          int ret = mq_receive(m_eventq, u[cur].buffer, MAX_EVENT_MSGSIZE,
+                               (FAR unsigned int *)0);
+          if (ret < 0)
+            {
+              twmerr("ERROR: mq_receive failed: %d\n", errno);
+              cleanup();
+              return false;
+            }
 
-      union
-      {
-        struct SEventMsg eventmsg;
-        char buffer[MAX_EVENT_MSGSIZE];
-      } u;
+          m_eventStats.received++;
+#ifdef CONFIG_TWM4NX_EVENT_STATS
+          updateEventStats();
+#endif
+        }
+
+      readahead = false;
 
-      int ret = mq_receive(m_eventq, u.buffer, MAX_EVENT_MSGSIZE,
-                           (FAR unsigned int *)0);
-      if (ret < 0)
+#ifdef CONFIG_TWM4NX_COALESCE
+      // A motion event only carries the latest pointer position.  While
+      // the next queued message is the same motion event for the same
+      // object, skip to it:  Processing each intermediate position would
+      // redraw the window for positions that are already stale.
+
+      while (isMotionEvent(&u[cur].eventmsg) && readAhead(u[1 - cur].buffer))
         {
-          twmerr("ERROR: mq_receive failed: %d\n", errno);
-          cleanup();
-          return false;
+          FAR struct SEventMsg *next = &u[1 - cur].eventmsg;
+
+          if (next->eventID != u[cur].eventmsg.eventID ||
+              next->obj != u[cur].eventmsg.obj)
+            {
+              readahead = true;
+              break;
+            }
+
+          m_eventStats.coalesced++;
+          cur = 1 - cur;
         }
+#endif
 
       // If we are resizing, then drop all non-critical events (of course,
       // all resizing events must be critical)
 
-      if (!m_resize->resizing() || EVENT_ISCRITICAL(u.eventmsg.eventID))
+      if (!m_resize->resizing() || EVENT_ISCRITICAL(u[cur].eventmsg.eventID))
         {
           // Dispatch the new event
 
-          if (!dispatchEvent(&u.eventmsg))
+          m_eventStats.dispatched++;
+          if (!dispatchEvent(&u[cur].eventmsg))
             {
               twmerr("ERROR: dispatchEvent() failed, eventID=%u\n",
-                     u.eventmsg.eventID);
+                     u[cur].eventmsg.eventID);
               cleanup();
               return false;
             }
         }
+      else
+        {
+          m_eventStats.discarded++;
+        }
+
+      // Process the message that was read ahead next
+
+      if (readahead)
+        {
+          cur = 1 - cur;
+        }
     }
 
   return true;  // Not reachable
@@ -390,6 +443,102 @@ void CTwm4Nx::genMqName(void)
     }
 }
 
+#ifdef CONFIG_TWM4NX_COALESCE
+/**
+ * Check if an event only reports a new pointer position for an object
+ * so that it is superseded by a later event with the same ID and object.
+ *
+ * @param eventmsg.  The received NxWidget event message.
+ * @return True if the event may be coalesced.
+ */
+
+bool CTwm4Nx::isMotionEvent(FAR const struct SEventMsg *eventmsg)
+{
+  switch (eventmsg->eventID)
+    {
+      case EVENT_WINDOW_DRAG:      // Window toolbar dragged
+      case EVENT_ICONWIDGET_DRAG:  // Icon dragged
+      case EVENT_RESIZE_MOVE:      // Mouse movement during resize
+        return true;
+
+      default:
+        return false;
+    }
+}
+
+/**
+ * Read the next message if one is already waiting in the event queue.
+ * This is the only reader of the queue so mq_receive() will not block
+ * if the queue is not empty.
+ *
+ * @param buffer.  Receives the message (MAX_EVENT_MSGSIZE bytes)
+ * @return True if a message was read; false if the queue was empty
+ *   or on a failure.
+ */
+
+bool CTwm4Nx::readAhead(FAR char *buffer)
+{
+  struct mq_attr attr;
+
+  if (mq_getattr(m_eventq, &attr) < 0 || attr.mq_curmsgs <= 0)
+    {
+      return false;
+    }
+
+  int ret = mq_receive(m_eventq, buffer, MAX_EVENT_MSGSIZE,
+                       (FAR unsigned int *)0);
+  if (ret < 0)
+    {
+      twmerr("ERROR: mq_receive failed: %d\n", errno);
+      return false;
+    }
+
+  m_eventStats.received++;
+#ifdef CONFIG_TWM4NX_EVENT_STATS
+  updateEventStats();
+#endif
+  return true;
+}
+#endif
+
+#ifdef CONFIG_TWM4NX_EVENT_STATS
+/**
+ * Sample the event queue depth (counting the message just received) and
+ * periodically report the event statistics.
+ */
+
+void CTwm4Nx::updateEventStats(void)
+{
+  struct mq_attr attr;
+
+  if (mq_getattr(m_eventq, &attr) == 0)
+    {
+      uint16_t depth = (uint16_t)(attr.mq_curmsgs + 1);
+      if (depth > m_eventStats.maxDepth)
+        {
+          m_eventStats.maxDepth = depth;
+        }
+
+      if (depth >= attr.mq_maxmsg)
+        {
+          m_eventStats.full++;
+        }
+    }
+
+  if ((m_eventStats.received % CONFIG_TWM4NX_EVENT_STATS_INTERVAL) == 0)
+    {
+      syslog(LOG_INFO,
+             "Twm4Nx events: received %lu dispatched %lu coalesced %lu "
+             "discarded %lu maxdepth %u full %u\n",
+             (unsigned long)m_eventStats.received,
+             (unsigned long)m_eventStats.dispatched,
+             (unsigned long)m_eventStats.coalesced,
+             (unsigned long)m_eventStats.discarded,
+             m_eventStats.maxDepth, m_eventStats.full);
+    }
+}
+#endif
+
 /**
  * Handle SYSTEM events.
  *
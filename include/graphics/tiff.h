@@ -41,6 +41,13 @@
 
 /* Configuration ************************************************************/
 
+/* The smallest I/O buffer that can be used with PackBits compression.  The
+ * encoder must be able to hold the largest PackBits packet (a header byte
+ * plus 128 literal bytes).
+ */
+
+#define TIFF_PACKBITS_MINIOSIZE   132
+
 /* TIFF File Format Definitions *********************************************/
 
 /* Values for the IFD field type */
@@ -290,6 +297,13 @@ struct tiff_info_s
    * (tmpfile1) will be used to hold the strip image data and the other
    * (tmpfile2) will be used to hold strip offset and count information.
    *
+   * If both tmpfile1 and tmpfile2 are NULL, the file is written directly
+   * in a single pass:  Since imgheight and rps are known in advance, the
+   * number of strips is fixed by tiff_initialize() and the strip offsets
+   * are precomputed.  Strip data then goes straight to the outfile and
+   * tiff_finalize() only has to patch the strip byte counts (and only
+   * if compression is used).  This avoids writing the image data twice.
+   *
    * colorfmt  - Specifies the form of the color data that will be provided
    *             in the strip data.  These are the FB_FMT_* definitions
    *             provided in include/nuttx/video/fb.h.  Only the following
@@ -304,6 +318,10 @@ struct tiff_info_s
    * rps       - TIFF RowsPerStrip
    * imgwidth  - TIFF ImageWidth, Number of columns in the image
    * imgheight - TIFF ImageLength, Number of rows in the image
+   * compress  - TIFF Compression.  Zero or TAG_COMP_NONE for uncompressed
+   *             strips; TAG_COMP_PACKBITS to PackBits-encode each strip.
+   *             PackBits requires an iosize of at least
+   *             TIFF_PACKBITS_MINIOSIZE bytes.
    */
 
   FAR const char *outfile;  /* Full path to the final output file name */
@@ -314,6 +332,8 @@ struct tiff_info_s
   nxgl_coord_t rps;         /* TIFF RowsPerStrip */
   nxgl_coord_t imgwidth;    /* TIFF ImageWidth, Number of columns in the image */
   nxgl_coord_t imgheight;   /* TIFF ImageLength, Number of rows in the image */
+  uint16_t     compress;    /* TIFF Compression, TAG_COMP_NONE or
+                             * TAG_COMP_PACKBITS */
 
   /* The caller must provide an I/O buffer as well.  This I/O buffer will
    * used for color conversions and as the intermediate buffer for copying
@@ -335,6 +355,10 @@ struct tiff_info_s
   nxgl_coord_t nstrips;     /* Number of strips in tmpfile3 */
   size_t       pps;         /* Pixels per strip */
   size_t       bps;         /* Bytes per strip */
+  size_t       bpr;         /* Bytes per row */
+  nxgl_coord_t maxstrips;   /* Number of strips in the image (direct mode) */
+  off_t        dataoffs;    /* Offset to the first strip (direct mode) */
+  FAR uint32_t *counts;     /* Strip byte counts (direct mode, compressed) */
   int          outfd;       /* outfile file descriptor */
   int          tmp1fd;      /* tmpfile1 file descriptor */
   int          tmp2fd;      /* tmpfile2 file descriptor */
@@ -388,7 +412,9 @@ int tiff_initialize(FAR struct tiff_info_s *info);
  * Description:
  *   Add an image data strip.  The size of the strip in pixels
  *    must be equal to the RowsPerStrip x ImageWidth values
- *    that were provided to tiff_initialize().
+ *    that were provided to tiff_initialize().  In direct mode, the
+ *    last strip may be short:  only the rows that remain in the image
+ *    are used.
  *
  * Input Parameters:
  *   info    - A pointer to the caller allocated parameter passing/TIFF state
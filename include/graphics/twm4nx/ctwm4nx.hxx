@@ -96,6 +96,7 @@ namespace Twm4Nx
       FAR CFonts                  *m_fonts;       /**< The cached Cfonts instance */
       FAR CMainMenu               *m_mainMenu;    /**< The cached CMainMenu instance */
       FAR CResize                 *m_resize;      /**< The cached CResize instance */
+      struct SEventStats           m_eventStats;  /**< Event loop statistics */
 
 #if !defined(CONFIG_TWM4NX_NOKEYBOARD) || !defined(CONFIG_TWM4NX_NOMOUSE)
       FAR CInput                  *m_input;       /**< Keyboard/mouse input injector */
@@ -131,6 +132,38 @@ namespace Twm4Nx
 
       inline bool systemEvent(FAR struct SEventMsg *eventmsg);
 
+#ifdef CONFIG_TWM4NX_COALESCE
+      /**
+       * Check if an event only reports a new pointer position for an object
+       * so that it is superseded by a later event with the same ID and
+       * object.
+       *
+       * @param eventmsg.  The received NxWidget event message.
+       * @return True if the event may be coalesced.
+       */
+
+      inline bool isMotionEvent(FAR const struct SEventMsg *eventmsg);
+
+      /**
+       * Read the next message if one is already waiting in the event queue.
+       *
+       * @param buffer.  Receives the message (MAX_EVENT_MSGSIZE bytes)
+       * @return True if a message was read; false if the queue was empty
+       *   or on a failure.
+       */
+
+      bool readAhead(FAR char *buffer);
+#endif
+
+#ifdef CONFIG_TWM4NX_EVENT_STATS
+      /**
+       * Sample the event queue depth and periodically report the event
+       * statistics.
+       */
+
+      void updateEventStats(void);
+#endif
+
       /**
        * Cleanup in preparation for termination.
        */
@@ -299,6 +332,18 @@ namespace Twm4Nx
          return m_resize;
        }
 
+      /**
+       * Return the event loop statistics.  The queue depth fields are
+       * only maintained if CONFIG_TWM4NX_EVENT_STATS is selected.
+       *
+       * @return A reference to the session's event statistics.
+       */
+
+       inline FAR const struct SEventStats &getEventStats(void) const
+       {
+         return m_eventStats;
+       }
+
 #if !defined(CONFIG_TWM4NX_NOKEYBOARD) || !defined(CONFIG_TWM4NX_NOMOUSE)
       /**
        * Return the session's CInput instance.
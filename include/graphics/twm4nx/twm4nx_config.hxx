@@ -67,6 +67,26 @@
 #  error "NX support is required (CONFIG_NX)"
 #endif
 
+// Event Queue //////////////////////////////////////////////////////////////
+
+/**
+ * CONFIG_TWM4NX_EVENTQ_DEPTH - The maximum number of messages in the
+ *   NxWidget event queue.  Default: 32
+ * CONFIG_TWM4NX_COALESCE - Coalesce consecutive motion events (window and
+ *   icon drags, resize moves) for the same object so that only the latest
+ *   position is processed.
+ * CONFIG_TWM4NX_EVENT_STATS - Track the event queue depth and report event
+ *   statistics every CONFIG_TWM4NX_EVENT_STATS_INTERVAL received events.
+ */
+
+#ifndef CONFIG_TWM4NX_EVENTQ_DEPTH
+#  define CONFIG_TWM4NX_EVENTQ_DEPTH 32
+#endif
+
+#ifndef CONFIG_TWM4NX_EVENT_STATS_INTERVAL
+#  define CONFIG_TWM4NX_EVENT_STATS_INTERVAL 500
+#endif
+
 // Background ///////////////////////////////////////////////////////////////
 
 /**
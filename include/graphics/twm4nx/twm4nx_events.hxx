@@ -208,6 +208,21 @@ namespace Twm4Nx
     uint8_t context;                    /**< Button press context */
   };
 
+  /**
+   * Event loop statistics.  See CTwm4Nx::getEventStats().
+   */
+
+  struct SEventStats
+  {
+    uint32_t received;                  /**< Messages read from the event queue */
+    uint32_t dispatched;                /**< Messages dispatched to a recipient */
+    uint32_t coalesced;                 /**< Motion events superseded by a newer one */
+    uint32_t discarded;                 /**< Non-critical events dropped while resizing */
+    uint16_t maxDepth;                  /**< Deepest event queue observed */
+    uint16_t full;                      /**< Times the queue was seen full (senders
+                                         *   may have lost events) */
+  };
+
   /**
    * This message form is used with CWindowEvent redraw commands
    */
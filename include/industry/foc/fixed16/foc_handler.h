@@ -31,6 +31,10 @@
 
 #include <dspb16.h>
 
+#ifdef CONFIG_INDUSTRY_FOC_HANDLER_PERF
+#  include "industry/foc/foc_common.h"
+#endif
+
 #ifdef CONFIG_INDUSTRY_FOC_CORDIC
 #  include "industry/foc/fixed16/foc_cordic.h"
 #endif
@@ -178,6 +182,9 @@ struct foc_handler_b16_s
   struct foc_handler_ops_b16_s  ops;           /* Handler operations */
   FAR void                     *modulation;    /* Modulation data */
   FAR void                     *control;       /* Controller data */
+#ifdef CONFIG_INDUSTRY_FOC_HANDLER_PERF
+  struct foc_handler_perf_s     perf;          /* Stage execution time */
+#endif
 };
 
 /* Modulation configuration */
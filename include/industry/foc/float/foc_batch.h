@@ -0,0 +1,133 @@
+/****************************************************************************
+ * apps/include/industry/foc/float/foc_batch.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __INDUSTRY_FOC_FLOAT_FOC_BATCH_H
+#define __INDUSTRY_FOC_FLOAT_FOC_BATCH_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <dsp.h>
+
+#include "industry/foc/float/foc_handler.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define FOC_BATCH_MAX CONFIG_INDUSTRY_FOC_BATCH_MAX
+
+/****************************************************************************
+ * Public Type Definition
+ ****************************************************************************/
+
+/* Batched FOC current controller (float32).
+ *
+ * Every field holds one element per motor so that each stage of
+ * foc_batch_run_f32() is a straight loop over contiguous arrays.  The
+ * caller writes the input arrays, runs the batch and reads the duty
+ * cycles back; there is no per-motor ops table on this path.
+ */
+
+struct foc_batch_f32_s
+{
+  int   n;                                    /* Number of motors */
+
+  /* Inputs */
+
+  float curr[CONFIG_MOTOR_FOC_PHASES][FOC_BATCH_MAX]; /* Phase current */
+  float angle[FOC_BATCH_MAX];                 /* Electrical angle */
+  float vbus[FOC_BATCH_MAX];                  /* Bus voltage */
+  float id_ref[FOC_BATCH_MAX];                /* D current reference */
+  float iq_ref[FOC_BATCH_MAX];                /* Q current reference */
+  float vd_comp[FOC_BATCH_MAX];               /* D voltage compensation */
+  float vq_comp[FOC_BATCH_MAX];               /* Q voltage compensation */
+
+  /* Outputs */
+
+  float duty[CONFIG_MOTOR_FOC_PHASES][FOC_BATCH_MAX]; /* PWM duty cycle */
+
+  /* Configuration */
+
+  float id_kp[FOC_BATCH_MAX];
+  float id_ki[FOC_BATCH_MAX];
+  float iq_kp[FOC_BATCH_MAX];
+  float iq_ki[FOC_BATCH_MAX];
+  float duty_max[FOC_BATCH_MAX];
+
+  /* Controller state */
+
+  float id_int[FOC_BATCH_MAX];                /* D PI integral part */
+  float iq_int[FOC_BATCH_MAX];                /* Q PI integral part */
+  float i_a[FOC_BATCH_MAX];                   /* Alpha current */
+  float i_b[FOC_BATCH_MAX];                   /* Beta current */
+  float i_d[FOC_BATCH_MAX];                   /* D current */
+  float i_q[FOC_BATCH_MAX];                   /* Q current */
+  float v_d[FOC_BATCH_MAX];                   /* D voltage */
+  float v_q[FOC_BATCH_MAX];                   /* Q voltage */
+  float v_a[FOC_BATCH_MAX];                   /* Alpha voltage */
+  float v_b[FOC_BATCH_MAX];                   /* Beta voltage */
+};
+
+typedef struct foc_batch_f32_s foc_batch_f32_t;
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: foc_batch_init_f32
+ ****************************************************************************/
+
+int foc_batch_init_f32(FAR foc_batch_f32_t *b, int n);
+
+/****************************************************************************
+ * Name: foc_batch_cfg_f32
+ ****************************************************************************/
+
+int foc_batch_cfg_f32(FAR foc_batch_f32_t *b, int motor,
+                      FAR struct foc_initdata_f32_s *ctrl_cfg,
+                      FAR struct foc_mod_cfg_f32_s *mod_cfg);
+
+/****************************************************************************
+ * Name: foc_batch_reset_f32
+ ****************************************************************************/
+
+void foc_batch_reset_f32(FAR foc_batch_f32_t *b, int motor);
+
+/****************************************************************************
+ * Name: foc_batch_run_f32
+ ****************************************************************************/
+
+void foc_batch_run_f32(FAR foc_batch_f32_t *b);
+
+/****************************************************************************
+ * Name: foc_batch_state_f32
+ ****************************************************************************/
+
+void foc_batch_state_f32(FAR foc_batch_f32_t *b, int motor,
+                         FAR struct foc_state_f32_s *state);
+
+#endif /* __INDUSTRY_FOC_FLOAT_FOC_BATCH_H */
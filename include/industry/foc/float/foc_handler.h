@@ -31,6 +31,10 @@
 
 #include <dsp.h>
 
+#ifdef CONFIG_INDUSTRY_FOC_HANDLER_PERF
+#  include "industry/foc/foc_common.h"
+#endif
+
 #ifdef CONFIG_INDUSTRY_FOC_CORDIC
 #  include "industry/foc/float/foc_cordic.h"
 #endif
@@ -179,6 +183,9 @@ struct foc_handler_f32_s
   struct foc_handler_ops_f32_s  ops;           /* Handler operations */
   FAR void                     *modulation;    /* Modulation data */
   FAR void                     *control;       /* Controller data */
+#ifdef CONFIG_INDUSTRY_FOC_HANDLER_PERF
+  struct foc_handler_perf_s     perf;          /* Stage execution time */
+#endif
 };
 
 /* Modulation configuration */
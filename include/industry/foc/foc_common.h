@@ -63,6 +63,16 @@ enum foc_number_type_e
 #endif
 };
 
+#ifdef CONFIG_INDUSTRY_FOC_HANDLER_PERF
+/* FOC handler stage execution time in perf_gettime() ticks */
+
+struct foc_handler_perf_s
+{
+  uint32_t ctrl;   /* Current/voltage controller */
+  uint32_t mod;    /* Modulation */
+};
+#endif
+
 /* Speed ramp mode */
 
 enum foc_ramp_mode_e
@@ -0,0 +1,218 @@
+/****************************************************************************
+ * apps/include/logging/el_async.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_LOGGING_EL_ASYNC_H
+#define __APPS_INCLUDE_LOGGING_EL_ASYNC_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <logging/embedlog.h>
+
+#ifdef CONFIG_EMBEDLOG_ENABLE_ASYNC
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Asynchronous sink configuration.  el_async_config_default() fills in
+ * the Kconfig defaults.
+ */
+
+struct el_async_config_s
+{
+  FAR const char *path;   /* Log file, NULL to forward to syslog */
+  size_t ringsize;        /* Per-thread ring size (bytes) */
+  size_t batchsize;       /* Writer batch size (bytes) */
+  size_t rotate_size;     /* Rotate the file past this size, 0: never */
+  int rotate_count;       /* Rotated files kept: path.1 .. path.N */
+  int interval;           /* Writer wake up period (ms) */
+  int priority;           /* Writer thread priority */
+  int syslog_priority;    /* Priority of records forwarded to syslog */
+  bool binary;            /* Frame records with a 2 byte length */
+  bool compress;          /* LZF-compress each batch */
+};
+
+/* Sink statistics */
+
+struct el_async_stats_s
+{
+  uint32_t records;       /* Records taken from the rings */
+  uint32_t dropped;       /* Records lost to full rings */
+  uint32_t writes;        /* Writes to the file or syslog calls */
+  uint32_t rotations;     /* File rotations */
+  uint32_t errors;        /* Batches lost to output errors */
+  uint32_t rings;         /* Producer rings allocated */
+  uint64_t bytes;         /* Record bytes taken from the rings */
+  uint64_t written;       /* Bytes written after framing/compression */
+};
+
+/* One single-producer ring per logging thread */
+
+struct el_async_ring_s
+{
+  FAR struct el_async_ring_s *flink;
+  atomic_size_t head;     /* Advanced by the producer only */
+  atomic_size_t tail;     /* Advanced by the writer only */
+  atomic_uint dropped;    /* Records the producer could not fit */
+  atomic_bool orphan;     /* Owner exited; may be adopted */
+  size_t mask;            /* Size - 1, size is a power of two */
+  FAR uint8_t *data;
+};
+
+/* Asynchronous sink instance */
+
+struct el_async_s
+{
+  struct el_async_config_s cfg;
+  _Atomic(FAR struct el_async_ring_s *) rings;
+  pthread_mutex_t reglock;  /* Serializes ring registration */
+  pthread_mutex_t wlock;    /* Serializes draining and output */
+  pthread_key_t key;
+  pthread_t writer;
+  sem_t wake;
+  atomic_bool kicked;
+  atomic_bool stop;
+
+  /* Writer state, protected by wlock */
+
+  int fd;
+  size_t fsize;
+  FAR uint8_t *batch;
+  size_t blen;
+  FAR void *lzf;            /* Compression buffers */
+  struct el_async_stats_s stats;
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: el_async_config_default
+ *
+ * Description:
+ *   Fill a configuration with the Kconfig defaults and no file (syslog).
+ *
+ ****************************************************************************/
+
+void el_async_config_default(FAR struct el_async_config_s *cfg);
+
+/****************************************************************************
+ * Name: el_async_init
+ *
+ * Description:
+ *   Open the output and start the writer thread.
+ *
+ * Input Parameters:
+ *   as  - a pointer to an asynchronous sink instance
+ *   cfg - a pointer to the sink configuration, copied
+ *
+ * Returned Value:
+ *   Zero on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int el_async_init(FAR struct el_async_s *as,
+                  FAR const struct el_async_config_s *cfg);
+
+/****************************************************************************
+ * Name: el_async_deinit
+ *
+ * Description:
+ *   Stop the writer after it drained every ring, close the output and free
+ *   the rings.  No thread may log through the sink any more.
+ *
+ ****************************************************************************/
+
+void el_async_deinit(FAR struct el_async_s *as);
+
+/****************************************************************************
+ * Name: el_async_attach
+ *
+ * Description:
+ *   Route the output of an embedlog object to the sink.  Its other outputs
+ *   are disabled.  Objects used from different threads may share a sink.
+ *
+ ****************************************************************************/
+
+int el_async_attach(FAR struct el_async_s *as, FAR struct el *el);
+
+/****************************************************************************
+ * Name: el_async_write
+ *
+ * Description:
+ *   Queue one record from the calling thread.  Never blocks: when the
+ *   thread's ring is full the record is dropped and counted.
+ *
+ * Returned Value:
+ *   Zero on success; -ENOBUFS when the record was dropped, -EMSGSIZE when
+ *   it can never fit, -ENOMEM when no ring could be allocated.
+ *
+ ****************************************************************************/
+
+int el_async_write(FAR struct el_async_s *as, FAR const void *data,
+                   size_t len);
+
+/****************************************************************************
+ * Name: el_async_put
+ *
+ * Description:
+ *   embedlog custom output callback, set up by el_async_attach().
+ *
+ ****************************************************************************/
+
+int el_async_put(FAR const char *s, size_t slen, FAR void *user);
+
+/****************************************************************************
+ * Name: el_async_flush
+ *
+ * Description:
+ *   Drain every ring and write out the partial batch now.
+ *
+ ****************************************************************************/
+
+int el_async_flush(FAR struct el_async_s *as);
+
+/****************************************************************************
+ * Name: el_async_stats
+ *
+ * Description:
+ *   Return a snapshot of the sink statistics.
+ *
+ ****************************************************************************/
+
+void el_async_stats(FAR struct el_async_s *as,
+                    FAR struct el_async_stats_s *stats);
+
+#endif /* CONFIG_EMBEDLOG_ENABLE_ASYNC */
+#endif /* __APPS_INCLUDE_LOGGING_EL_ASYNC_H */
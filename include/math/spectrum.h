@@ -0,0 +1,156 @@
+/****************************************************************************
+ * apps/include/math/spectrum.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_MATH_SPECTRUM_H
+#define __APPS_INCLUDE_MATH_SPECTRUM_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Sample and power types follow the kissfft build: Q15 samples with
+ * integer power in the fixed-point build, float otherwise.
+ */
+
+#ifdef CONFIG_MATH_KISSFFT_FIXED16
+typedef int16_t  spectrum_sample_t;
+typedef uint32_t spectrum_power_t;
+#else
+typedef float    spectrum_sample_t;
+typedef float    spectrum_power_t;
+#endif
+
+enum spectrum_window_e
+{
+  SPECTRUM_WINDOW_RECT = 0,
+  SPECTRUM_WINDOW_HANN,
+  SPECTRUM_WINDOW_HAMMING
+};
+
+/* Called with the averaged power spectrum, nfft / 2 + 1 bins from DC to
+ * the Nyquist frequency.  The buffer is only valid during the call.
+ */
+
+typedef CODE void (*spectrum_cb_t)(FAR void *priv,
+                                   FAR const spectrum_power_t *power,
+                                   size_t nbins);
+
+struct spectrum_cfg_s
+{
+  size_t        nfft;    /* FFT size, even */
+  size_t        hop;     /* New samples per frame, 1..nfft */
+  uint8_t       window;  /* enum spectrum_window_e */
+  uint16_t      navg;    /* Frames averaged per published spectrum */
+  spectrum_cb_t cb;      /* Spectrum consumer */
+  FAR void     *priv;    /* Consumer argument */
+};
+
+struct spectrum_s;
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************
+ * Name: spectrum_create
+ *
+ * Description:
+ *   Allocate a streaming spectrum stage.  Returns NULL if the
+ *   configuration is invalid or memory is exhausted.
+ *
+ ****************************************************************************/
+
+FAR struct spectrum_s *spectrum_create(FAR const struct spectrum_cfg_s *cfg);
+
+/****************************************************************************
+ * Name: spectrum_destroy
+ ****************************************************************************/
+
+void spectrum_destroy(FAR struct spectrum_s *s);
+
+/****************************************************************************
+ * Name: spectrum_reset
+ *
+ * Description:
+ *   Drop buffered samples and the partial average.
+ *
+ ****************************************************************************/
+
+void spectrum_reset(FAR struct spectrum_s *s);
+
+/****************************************************************************
+ * Name: spectrum_push
+ *
+ * Description:
+ *   Feed samples to the stage.  A frame is transformed every 'hop'
+ *   samples once 'nfft' samples are buffered, and the callback is invoked
+ *   after every 'navg' frames.
+ *
+ * Returned Value:
+ *   Number of spectra delivered to the callback during this call.
+ *
+ ****************************************************************************/
+
+int spectrum_push(FAR struct spectrum_s *s,
+                  FAR const spectrum_sample_t *samples, size_t n);
+
+/****************************************************************************
+ * Name: spectrum_frame
+ *
+ * Description:
+ *   Window and transform one frame of 'nfft' samples and add its power to
+ *   the running average, bypassing the input buffer.  Used by
+ *   spectrum_push() and by callers that already hold whole frames.
+ *
+ * Returned Value:
+ *   1 if the average was completed and delivered, 0 otherwise.
+ *
+ ****************************************************************************/
+
+int spectrum_frame(FAR struct spectrum_s *s,
+                   FAR const spectrum_sample_t *frame);
+
+/****************************************************************************
+ * Name: spectrum_nbins
+ ****************************************************************************/
+
+size_t spectrum_nbins(FAR struct spectrum_s *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_MATH_SPECTRUM_H */
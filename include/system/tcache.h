@@ -0,0 +1,110 @@
+/****************************************************************************
+ * apps/include/system/tcache.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_SYSTEM_TCACHE_H
+#define __APPS_INCLUDE_SYSTEM_TCACHE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Counters of the calling thread's cache */
+
+struct tcache_stats_s
+{
+  unsigned long hits;          /* Small requests served from the cache */
+  unsigned long misses;        /* Small requests that needed a refill */
+  unsigned long refilled;      /* Blocks taken from the heap by refills */
+  unsigned long flushed;       /* Blocks given back to the heap */
+  unsigned long large;         /* Requests passed straight to the heap */
+  size_t cached;               /* Bytes held in the cache right now */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+#ifdef __cplusplus
+#define EXTERN extern "C"
+extern "C"
+{
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: tcache_malloc, tcache_calloc, tcache_realloc, tcache_memalign,
+ *       tcache_free
+ *
+ * Description:
+ *   Drop-in replacements for the heap functions of the same name.
+ *   Requests up to CONFIG_SYSTEM_TCACHE_MAXSIZE bytes are served from
+ *   per-thread free lists without taking the heap lock; larger ones go to
+ *   the heap.  Memory from these functions must be released with
+ *   tcache_free() or tcache_realloc(), from any thread, and never with
+ *   free().
+ *
+ ****************************************************************************/
+
+FAR void *tcache_malloc(size_t size);
+FAR void *tcache_calloc(size_t nmemb, size_t size);
+FAR void *tcache_realloc(FAR void *ptr, size_t size);
+FAR void *tcache_memalign(size_t alignment, size_t size);
+void tcache_free(FAR void *ptr);
+
+/****************************************************************************
+ * Name: tcache_flush
+ *
+ * Description:
+ *   Give every block cached by the calling thread back to the heap.  This
+ *   happens automatically when a thread exits and, for the main thread,
+ *   when the task exits; a long-running thread may call it once it is
+ *   done allocating.
+ *
+ ****************************************************************************/
+
+void tcache_flush(void);
+
+/****************************************************************************
+ * Name: tcache_stats
+ *
+ * Description:
+ *   Return the counters of the calling thread's cache.
+ *
+ ****************************************************************************/
+
+void tcache_stats(FAR struct tcache_stats_s *stats);
+
+#undef EXTERN
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_SYSTEM_TCACHE_H */
@@ -32,6 +32,10 @@
 #include <string.h>
 #include <unistd.h>
 
+#ifdef CONFIG_INDUSTRY_FOC_HANDLER_PERF
+#  include <nuttx/clock.h>
+#endif
+
 #include "industry/foc/foc_log.h"
 #include "industry/foc/foc_common.h"
 #include "industry/foc/fixed16/foc_handler.h"
@@ -213,6 +217,10 @@ int foc_handler_run_b16(FAR foc_handler_b16_t *h,
   ab_frame_b16_t v_ab_mod;
   b16_t          vbase = 0;
   int            ret   = OK;
+#ifdef CONFIG_INDUSTRY_FOC_HANDLER_PERF
+  uint32_t       start = perf_gettime();
+  uint32_t       now   = 0;
+#endif
 
   DEBUGASSERT(h);
   DEBUGASSERT(in);
@@ -291,14 +299,29 @@ int foc_handler_run_b16(FAR foc_handler_b16_t *h,
         }
     }
 
+#ifdef CONFIG_INDUSTRY_FOC_HANDLER_PERF
+  now          = perf_gettime();
+  h->perf.ctrl = now - start;
+  start        = now;
+#endif
+
   /* Duty cycle modulation */
 
   h->ops.mod->run(h, &v_ab_mod, out->duty);
 
+#ifdef CONFIG_INDUSTRY_FOC_HANDLER_PERF
+  h->perf.mod = perf_gettime() - start;
+#endif
+
   return ret;
 
 errout:
 
+#ifdef CONFIG_INDUSTRY_FOC_HANDLER_PERF
+  h->perf.ctrl = perf_gettime() - start;
+  h->perf.mod  = 0;
+#endif
+
   /* Set duty to zeros */
 
   memset(out->duty, 0, sizeof(b16_t) * CONFIG_MOTOR_FOC_PHASES);
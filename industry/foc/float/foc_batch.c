@@ -0,0 +1,379 @@
+/****************************************************************************
+ * apps/industry/foc/float/foc_batch.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <dsp.h>
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+
+#include "industry/foc/float/foc_batch.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#if CONFIG_MOTOR_FOC_PHASES != 3
+#  error Batched FOC supports only 3-phase motors
+#endif
+
+/* Parabolic sine approximation with one correction step.  Max error is
+ * about 0.001, comparable to fast_sin2() used by the handler, but it has
+ * no calls and no branches so it vectorizes.
+ */
+
+#define BATCH_SIN_B        (4.0f / M_PI_F)
+#define BATCH_SIN_C        (-4.0f / (M_PI_F * M_PI_F))
+#define BATCH_SIN_P        (0.225f)
+
+/* Plain selects instead of fminf()/fmaxf(), which compilers only turn
+ * into vector min/max with relaxed NaN semantics.
+ */
+
+#define BATCH_MIN(a, b)    ((a) < (b) ? (a) : (b))
+#define BATCH_MAX(a, b)    ((a) > (b) ? (a) : (b))
+#define BATCH_SAT(x, lo, hi) BATCH_MIN(BATCH_MAX(x, lo), hi)
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: batch_sin
+ *
+ * Description:
+ *   Sine for x in [-pi, pi)
+ *
+ ****************************************************************************/
+
+static inline float batch_sin(float x)
+{
+  float y = BATCH_SIN_B * x + BATCH_SIN_C * x * fabsf(x);
+
+  return BATCH_SIN_P * (y * fabsf(y) - y) + y;
+}
+
+/****************************************************************************
+ * Name: batch_transform
+ *
+ * Description:
+ *   Clarke and Park transform of the phase currents for all motors
+ *
+ ****************************************************************************/
+
+static void batch_transform(FAR foc_batch_f32_t *b,
+                            FAR float *sin_a, FAR float *cos_a)
+{
+  float x;
+  float xc;
+  int   i;
+
+  for (i = 0; i < b->n; i++)
+    {
+      /* Wrap angle to [-pi, pi) and get sin/cos */
+
+      x  = b->angle[i];
+      x -= 2.0f * M_PI_F * floorf((x + M_PI_F) * (0.5f / M_PI_F));
+      xc = x + M_PI_2_F;
+      xc = (xc >= M_PI_F) ? xc - 2.0f * M_PI_F : xc;
+
+      sin_a[i] = batch_sin(x);
+      cos_a[i] = batch_sin(xc);
+
+      /* Clarke transform */
+
+      b->i_a[i] = b->curr[0][i];
+      b->i_b[i] = ONE_BY_SQRT3_F * b->curr[0][i] +
+                  TWO_BY_SQRT3_F * b->curr[1][i];
+
+      /* Park transform */
+
+      b->i_d[i] = b->i_a[i] * cos_a[i] + b->i_b[i] * sin_a[i];
+      b->i_q[i] = b->i_b[i] * cos_a[i] - b->i_a[i] * sin_a[i];
+    }
+}
+
+/****************************************************************************
+ * Name: batch_control
+ *
+ * Description:
+ *   DQ current PI controllers, DQ voltage saturation and inverse Park
+ *   transform for all motors
+ *
+ ****************************************************************************/
+
+static void batch_control(FAR foc_batch_f32_t *b,
+                          FAR const float *sin_a, FAR const float *cos_a)
+{
+  float vbase;
+  float err;
+  float mag;
+  float scale;
+  int   i;
+
+  for (i = 0; i < b->n; i++)
+    {
+      /* Maximum DQ voltage magnitude in the SVM linear region */
+
+      vbase = b->vbus[i] * ONE_BY_SQRT3_F;
+
+      /* D axis PI, integral part clamped to the available voltage */
+
+      err          = b->id_ref[i] - b->i_d[i];
+      b->id_int[i] = BATCH_SAT(b->id_int[i] + b->id_ki[i] * err,
+                               -vbase, vbase);
+      b->v_d[i]    = b->id_kp[i] * err + b->id_int[i] + b->vd_comp[i];
+
+      /* Q axis PI */
+
+      err          = b->iq_ref[i] - b->i_q[i];
+      b->iq_int[i] = BATCH_SAT(b->iq_int[i] + b->iq_ki[i] * err,
+                               -vbase, vbase);
+      b->v_q[i]    = b->iq_kp[i] * err + b->iq_int[i] + b->vq_comp[i];
+
+      /* Saturate DQ voltage vector */
+
+      mag       = sqrtf(b->v_d[i] * b->v_d[i] + b->v_q[i] * b->v_q[i]);
+      scale     = BATCH_MIN(1.0f, vbase / BATCH_MAX(mag, 1e-6f));
+      b->v_d[i] = b->v_d[i] * scale;
+      b->v_q[i] = b->v_q[i] * scale;
+
+      /* Inverse Park transform */
+
+      b->v_a[i] = b->v_d[i] * cos_a[i] - b->v_q[i] * sin_a[i];
+      b->v_b[i] = b->v_d[i] * sin_a[i] + b->v_q[i] * cos_a[i];
+    }
+}
+
+/****************************************************************************
+ * Name: batch_modulation
+ *
+ * Description:
+ *   Space vector modulation for all motors, implemented as min-max zero
+ *   sequence injection which gives the same duty cycles as the sector
+ *   based SVM3 without per-sector branches.
+ *
+ ****************************************************************************/
+
+static void batch_modulation(FAR foc_batch_f32_t *b)
+{
+  float inv;
+  float va;
+  float vb;
+  float vc;
+  float off;
+  int   i;
+
+  for (i = 0; i < b->n; i++)
+    {
+      inv = (b->vbus[i] > 0.0f) ? 1.0f / b->vbus[i] : 0.0f;
+
+      /* Inverse Clarke transform */
+
+      va = b->v_a[i];
+      vb = -0.5f * b->v_a[i] + SQRT3_BY_TWO_F * b->v_b[i];
+      vc = -0.5f * b->v_a[i] - SQRT3_BY_TWO_F * b->v_b[i];
+
+      /* Center the phase voltages in the PWM period */
+
+      off = -0.5f * (BATCH_MAX(va, BATCH_MAX(vb, vc)) +
+                     BATCH_MIN(va, BATCH_MIN(vb, vc)));
+
+      b->duty[0][i] = BATCH_SAT(0.5f + (va + off) * inv, 0.0f,
+                                b->duty_max[i]);
+      b->duty[1][i] = BATCH_SAT(0.5f + (vb + off) * inv, 0.0f,
+                                b->duty_max[i]);
+      b->duty[2][i] = BATCH_SAT(0.5f + (vc + off) * inv, 0.0f,
+                                b->duty_max[i]);
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: foc_batch_init_f32
+ *
+ * Description:
+ *   Initialize the batched FOC controller (float32)
+ *
+ * Input Parameter:
+ *   b - pointer to FOC batch
+ *   n - number of motors in the batch
+ *
+ ****************************************************************************/
+
+int foc_batch_init_f32(FAR foc_batch_f32_t *b, int n)
+{
+  DEBUGASSERT(b);
+
+  if (n <= 0 || n > FOC_BATCH_MAX)
+    {
+      return -EINVAL;
+    }
+
+  memset(b, 0, sizeof(foc_batch_f32_t));
+  b->n = n;
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: foc_batch_cfg_f32
+ *
+ * Description:
+ *   Configure one motor in the batch (float32)
+ *
+ * Input Parameter:
+ *   b        - pointer to FOC batch
+ *   motor    - motor index
+ *   ctrl_cfg - current controller configuration
+ *   mod_cfg  - modulation configuration
+ *
+ ****************************************************************************/
+
+int foc_batch_cfg_f32(FAR foc_batch_f32_t *b, int motor,
+                      FAR struct foc_initdata_f32_s *ctrl_cfg,
+                      FAR struct foc_mod_cfg_f32_s *mod_cfg)
+{
+  DEBUGASSERT(b);
+  DEBUGASSERT(ctrl_cfg);
+  DEBUGASSERT(mod_cfg);
+
+  if (motor < 0 || motor >= b->n)
+    {
+      return -EINVAL;
+    }
+
+  b->id_kp[motor]    = ctrl_cfg->id_kp;
+  b->id_ki[motor]    = ctrl_cfg->id_ki;
+  b->iq_kp[motor]    = ctrl_cfg->iq_kp;
+  b->iq_ki[motor]    = ctrl_cfg->iq_ki;
+  b->duty_max[motor] = mod_cfg->pwm_duty_max;
+
+  foc_batch_reset_f32(b, motor);
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: foc_batch_reset_f32
+ *
+ * Description:
+ *   Reset controller state of one motor in the batch (float32)
+ *
+ * Input Parameter:
+ *   b     - pointer to FOC batch
+ *   motor - motor index
+ *
+ ****************************************************************************/
+
+void foc_batch_reset_f32(FAR foc_batch_f32_t *b, int motor)
+{
+  DEBUGASSERT(b);
+  DEBUGASSERT(motor >= 0 && motor < b->n);
+
+  b->id_int[motor]  = 0.0f;
+  b->iq_int[motor]  = 0.0f;
+  b->v_d[motor]     = 0.0f;
+  b->v_q[motor]     = 0.0f;
+  b->v_a[motor]     = 0.0f;
+  b->v_b[motor]     = 0.0f;
+  b->duty[0][motor] = 0.0f;
+  b->duty[1][motor] = 0.0f;
+  b->duty[2][motor] = 0.0f;
+}
+
+/****************************************************************************
+ * Name: foc_batch_run_f32
+ *
+ * Description:
+ *   Run the current controller and modulation for all motors in the batch
+ *   (float32).  Equivalent to foc_handler_run_f32() in current mode with
+ *   the PI controller and SVM3 modulation, called once per motor.
+ *
+ * Input Parameter:
+ *   b - pointer to FOC batch
+ *
+ ****************************************************************************/
+
+void foc_batch_run_f32(FAR foc_batch_f32_t *b)
+{
+  float sin_a[FOC_BATCH_MAX];
+  float cos_a[FOC_BATCH_MAX];
+
+  DEBUGASSERT(b);
+
+  batch_transform(b, sin_a, cos_a);
+  batch_control(b, sin_a, cos_a);
+  batch_modulation(b);
+}
+
+/****************************************************************************
+ * Name: foc_batch_state_f32
+ *
+ * Description:
+ *   Get the controller state of one motor in the batch (float32)
+ *
+ * Input Parameter:
+ *   b     - pointer to FOC batch
+ *   motor - motor index
+ *   state - pointer to FOC state
+ *
+ ****************************************************************************/
+
+void foc_batch_state_f32(FAR foc_batch_f32_t *b, int motor,
+                         FAR struct foc_state_f32_s *state)
+{
+  float vbase;
+
+  DEBUGASSERT(b);
+  DEBUGASSERT(state);
+  DEBUGASSERT(motor >= 0 && motor < b->n);
+
+  vbase = b->vbus[motor] * ONE_BY_SQRT3_F;
+
+  state->curr[0]   = b->curr[0][motor];
+  state->curr[1]   = b->curr[1][motor];
+  state->curr[2]   = b->curr[2][motor];
+  state->volt[0]   = b->v_a[motor];
+  state->volt[1]   = -0.5f * b->v_a[motor] +
+                     SQRT3_BY_TWO_F * b->v_b[motor];
+  state->volt[2]   = -0.5f * b->v_a[motor] -
+                     SQRT3_BY_TWO_F * b->v_b[motor];
+  state->iab.a     = b->i_a[motor];
+  state->iab.b     = b->i_b[motor];
+  state->vab.a     = b->v_a[motor];
+  state->vab.b     = b->v_b[motor];
+  state->vdq.d     = b->v_d[motor];
+  state->vdq.q     = b->v_q[motor];
+  state->idq.d     = b->i_d[motor];
+  state->idq.q     = b->i_q[motor];
+  state->mod_scale = (vbase > 0.0f) ? 1.0f / vbase : 0.0f;
+}
@@ -43,10 +43,12 @@
 #include <fcntl.h>
 #include <limits.h>
 #include <math.h>
+#include <string.h>
 #include <strings.h>
 #include <time.h>
 #include <unistd.h>
 
+#include "bas_arena.h"
 #include "bas_auto.h"
 #include "bas.h"
 #include "bas_error.h"
@@ -113,6 +115,7 @@ static struct Pc g_pc;
 static struct Auto g_stack;
 static struct Program g_program;
 static struct Global g_globals;
+static struct Arena g_scratch;
 static int g_run_restricted;
 
 /****************************************************************************
@@ -191,6 +194,7 @@ static struct Value *lvalue(struct Value *value)
 
   if ((g_pc.token + 1)->type == T_OP)
     {
+      struct ArenaMark scratch;
       struct Pc idxpc;
       unsigned int dim;
       unsigned int capacity;
@@ -200,23 +204,26 @@ static struct Value *lvalue(struct Value *value)
       dim = 0;
       capacity = 0;
       idx = (int *)0;
+      scratch = Arena_mark(&g_scratch);
       while (1)
         {
           if (dim == capacity && g_pass == INTERPRET)     /* enlarge idx */
             {
               int *more;
 
-              more =
-                realloc(idx,
-                        sizeof(unsigned int) *
-                        (capacity ? (capacity *= 2) : (capacity = 3)));
+              capacity = capacity ? capacity * 2 : 3;
+              more = Arena_alloc(&g_scratch, sizeof(int) * capacity);
               if (!more)
                 {
-                  if (capacity)
-                    free(idx);
+                  Arena_release(&g_scratch, scratch);
                   return Value_new_ERROR(value, OUTOFMEMORY);
                 }
 
+              if (dim)
+                {
+                  memcpy(more, idx, sizeof(int) * dim);
+                }
+
               idx = more;
             }
 
@@ -224,11 +231,7 @@ static struct Value *lvalue(struct Value *value)
           if (eval(value, _("index"))->type == V_ERROR ||
               VALUE_RETYPE(value, V_INTEGER)->type == V_ERROR)
             {
-              if (capacity)
-                {
-                  free(idx);
-                }
-
+              Arena_release(&g_scratch, scratch);
               g_pc = idxpc;
               return value;
             }
@@ -270,7 +273,7 @@ static struct Value *lvalue(struct Value *value)
                 g_pc = lvpc;
               }
 
-            free(idx);
+            Arena_release(&g_scratch, scratch);
             return value;
           }
 
@@ -699,7 +702,9 @@ static struct Value *eval(struct Value *value, const char *desc)
       char state;
     };
 
-  struct Pdastack *pdastack = malloc(capacity * sizeof(struct Pdastack));
+  struct ArenaMark scratch = Arena_mark(&g_scratch);
+  struct Pdastack *pdastack =
+    Arena_alloc(&g_scratch, capacity * sizeof(struct Pdastack));
   struct Pdastack *sp = pdastack;
   struct Pdastack *stackEnd = pdastack + capacity - 1;
   enum TokenType ip;
@@ -709,8 +714,12 @@ static struct Value *eval(struct Value *value, const char *desc)
     {
       if (sp == stackEnd)
         {
-          pdastack =
-            realloc(pdastack, (capacity + 10) * sizeof(struct Pdastack));
+          struct Pdastack *more;
+
+          more = Arena_alloc(&g_scratch,
+                             (capacity + 10) * sizeof(struct Pdastack));
+          memcpy(more, pdastack, capacity * sizeof(struct Pdastack));
+          pdastack = more;
           sp = pdastack + capacity - 1;
           capacity += 10;
           stackEnd = pdastack + capacity - 1;
@@ -885,7 +894,7 @@ static struct Value *eval(struct Value *value, const char *desc)
               {
                 assert(sp == pdastack + 1);
                 *value = sp->u.value;
-                free(pdastack);
+                Arena_release(&g_scratch, scratch);
                 return value;
               }
 
@@ -1137,7 +1146,7 @@ error:
       --sp;
     }
 
-  free(pdastack);
+  Arena_release(&g_scratch, scratch);
   return value;
 }
 
@@ -1789,6 +1798,7 @@ static struct Value *assign(struct Value *value)
     }
   else
     {
+      struct ArenaMark scratch = Arena_mark(&g_scratch);
       struct Value **l = (struct Value **)0;
       int i, used = 0, capacity = 0;
       struct Value retyped_value;
@@ -1800,7 +1810,18 @@ static struct Value *assign(struct Value *value)
               struct Value **more;
 
               capacity = capacity ? 2 * capacity : 2;
-              more = realloc(l, capacity * sizeof(*l));
+              more = Arena_alloc(&g_scratch, capacity * sizeof(*l));
+              if (!more)
+                {
+                  Arena_release(&g_scratch, scratch);
+                  return Value_new_ERROR(value, OUTOFMEMORY);
+                }
+
+              if (used)
+                {
+                  memcpy(more, l, used * sizeof(*l));
+                }
+
               l = more;
             }
 
@@ -1813,17 +1834,14 @@ static struct Value *assign(struct Value *value)
                                   (g_pc.token + 1)->type ==
                                   T_OP ? GLOBALARRAY : GLOBALVAR, 0) == 0)
                 {
-                  if (capacity)
-                    {
-                      free(l);
-                    }
-
+                  Arena_release(&g_scratch, scratch);
                   return Value_new_ERROR(value, REDECLARATION);
                 }
             }
 
           if ((l[used] = lvalue(value))->type == V_ERROR)
             {
+              Arena_release(&g_scratch, scratch);
               return value;
             }
 
@@ -1840,6 +1858,7 @@ static struct Value *assign(struct Value *value)
 
       if (g_pc.token->type != T_EQ)
         {
+          Arena_release(&g_scratch, scratch);
           return Value_new_ERROR(value, MISSINGEQ);
         }
 
@@ -1847,6 +1866,7 @@ static struct Value *assign(struct Value *value)
       expr = g_pc;
       if (eval(value, _("rhs"))->type == V_ERROR)
         {
+          Arena_release(&g_scratch, scratch);
           return value;
         }
 
@@ -1857,7 +1877,7 @@ static struct Value *assign(struct Value *value)
               VALUE_RETYPE(&retyped_value, (l[i])->type)->type == V_ERROR)
             {
               g_pc = expr;
-              free(l);
+              Arena_release(&g_scratch, scratch);
               Value_destroy(value);
               *value = retyped_value;
               return value;
@@ -1870,7 +1890,7 @@ static struct Value *assign(struct Value *value)
             }
         }
 
-      free(l);
+      Arena_release(&g_scratch, scratch);
       Value_destroy(value);
       *value = retyped_value;   /* for status only */
     }
@@ -2255,7 +2275,15 @@ static struct Value more_statements;
 #include "bas_statement.c"
 static struct Value *statements(struct Value *value)
 {
+  struct ArenaMark scratch = Arena_mark(&g_scratch);
+
 more:
+
+  /* Whatever the previous statement left in the scratch arena is dead.
+   * Statements run from a function body nest above the caller's mark.
+   */
+
+  Arena_release(&g_scratch, scratch);
   if (g_pc.token->statement)
     {
       struct Value *v;
@@ -2268,6 +2296,7 @@ more:
             }
           else
             {
+              Arena_release(&g_scratch, scratch);
               return value;
             }
         }
@@ -2293,6 +2322,7 @@ more:
       return Value_new_ERROR(value, MISSINGCOLON);
     }
 
+  Arena_release(&g_scratch, scratch);
   return Value_new_NIL(value);
 }
 
@@ -2307,6 +2337,7 @@ void bas_init(int backslash_colon, int restricted, int uppercase, int lpfd)
   Global_new(&g_globals);
   Auto_new(&g_stack);
   Program_new(&g_program);
+  Arena_new(&g_scratch);
   FS_opendev(STDCHANNEL, 0, 1);
   FS_opendev(LPCHANNEL, -1, lpfd);
   g_run_restricted = restricted;
@@ -2469,6 +2500,7 @@ void bas_exit(void)
   Auto_destroy(&g_stack);
   Global_destroy(&g_globals);
   Program_destroy(&g_program);
+  Arena_destroy(&g_scratch);
   if (g_labelstack)
     {
       free(g_labelstack);
@@ -0,0 +1,147 @@
+/****************************************************************************
+ * apps/interpreters/bas/bas_arena.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "bas_arena.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_INTERPRETER_BAS_SCRATCHSIZE
+#  define CONFIG_INTERPRETER_BAS_SCRATCHSIZE 256
+#endif
+
+#define ARENA_ALIGN   sizeof(union { double d; long l; void *p; })
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+#define ARENA_HDRSIZE ARENA_ROUND(sizeof(struct ArenaChunk))
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+struct Arena *Arena_new(struct Arena *self)
+{
+  assert(self != (struct Arena *)0);
+  self->head = (struct ArenaChunk *)0;
+  self->cur = (struct ArenaChunk *)0;
+  return self;
+}
+
+void Arena_destroy(struct Arena *self)
+{
+  struct ArenaChunk *chunk;
+
+  assert(self != (struct Arena *)0);
+  while ((chunk = self->head) != (struct ArenaChunk *)0)
+    {
+      self->head = chunk->next;
+      free(chunk);
+    }
+
+  self->cur = (struct ArenaChunk *)0;
+}
+
+void *Arena_alloc(struct Arena *self, size_t size)
+{
+  struct ArenaChunk *chunk;
+  void *p;
+
+  assert(self != (struct Arena *)0);
+  size = ARENA_ROUND(size);
+
+  if (self->cur == (struct ArenaChunk *)0 && self->head)
+    {
+      self->cur = self->head;
+      self->cur->used = 0;
+    }
+
+  /* Move on to the chunks left over from earlier statements, everything
+   * after the current chunk is free.
+   */
+
+  while (self->cur && self->cur->used + size > self->cur->size &&
+         self->cur->next && self->cur->next->size >= size)
+    {
+      self->cur = self->cur->next;
+      self->cur->used = 0;
+    }
+
+  chunk = self->cur;
+  if (chunk == (struct ArenaChunk *)0 || chunk->used + size > chunk->size)
+    {
+      size_t csize = size > CONFIG_INTERPRETER_BAS_SCRATCHSIZE ?
+                     size : CONFIG_INTERPRETER_BAS_SCRATCHSIZE;
+
+      chunk = malloc(ARENA_HDRSIZE + csize);
+      if (chunk == (struct ArenaChunk *)0)
+        {
+          return (void *)0;
+        }
+
+      chunk->size = csize;
+      chunk->used = 0;
+      if (self->cur)
+        {
+          chunk->next = self->cur->next;
+          self->cur->next = chunk;
+        }
+      else
+        {
+          chunk->next = (struct ArenaChunk *)0;
+          self->head = chunk;
+        }
+
+      self->cur = chunk;
+    }
+
+  p = (char *)chunk + ARENA_HDRSIZE + chunk->used;
+  chunk->used += size;
+  return p;
+}
+
+struct ArenaMark Arena_mark(const struct Arena *self)
+{
+  struct ArenaMark mark;
+
+  mark.chunk = self->cur;
+  mark.used = self->cur ? self->cur->used : 0;
+  return mark;
+}
+
+void Arena_release(struct Arena *self, struct ArenaMark mark)
+{
+  self->cur = mark.chunk;
+  if (mark.chunk)
+    {
+      mark.chunk->used = mark.used;
+    }
+}
@@ -0,0 +1,72 @@
+/****************************************************************************
+ * apps/interpreters/bas/bas_arena.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_EXAMPLES_BAS_BAS_ARENA_H
+#define __APPS_EXAMPLES_BAS_BAS_ARENA_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <sys/types.h>
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Scratch memory for data that does not outlive the statement being
+ * executed, like array index vectors and assignment target lists.
+ * Allocation bumps a pointer and memory is given back in bulk by
+ * releasing to a mark, so there is no per object free().  Chunks are
+ * kept after a release and reused by the next statement.
+ */
+
+struct ArenaChunk
+{
+  struct ArenaChunk *next;
+  size_t size;
+  size_t used;
+};
+
+struct ArenaMark
+{
+  struct ArenaChunk *chunk;
+  size_t used;
+};
+
+struct Arena
+{
+  struct ArenaChunk *head;
+  struct ArenaChunk *cur;
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+struct Arena *Arena_new(struct Arena *self);
+void Arena_destroy(struct Arena *self);
+void *Arena_alloc(struct Arena *self, size_t size);
+struct ArenaMark Arena_mark(const struct Arena *self);
+void Arena_release(struct Arena *self, struct ArenaMark mark);
+
+#endif /* __APPS_EXAMPLES_BAS_BAS_ARENA_H */
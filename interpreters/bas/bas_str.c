@@ -40,6 +40,36 @@
 
 #include "bas_str.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Smallest string buffer, buffers grow in powers of two from here */
+
+#define STRING_MINSIZE 16
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/* Buffer size used for a string of the given length, including the
+ * terminating NUL.  It only depends on the length, so growing a string
+ * within its size class needs no realloc() and appending one character at
+ * a time costs O(log n) reallocations instead of n.
+ */
+
+static size_t String_bufsize(size_t length)
+{
+  size_t size = STRING_MINSIZE;
+
+  while (size < length + 1)
+    {
+      size <<= 1;
+    }
+
+  return size;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -164,9 +194,11 @@ int String_size(struct String *self, size_t length)
 
   if (length)
     {
-      if (length > self->length)
+      if (self->length == 0 ||
+          String_bufsize(length) > String_bufsize(self->length))
         {
-          if ((n = realloc(self->character, length + 1)) == (char *)0)
+          if ((n = realloc(self->character, String_bufsize(length))) ==
+              (char *)0)
             {
               return -1;
             }
@@ -0,0 +1,453 @@
+/****************************************************************************
+ * apps/interpreters/ficl/src/ficl_main.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ficl.h"
+#include "nuttx_image.h"
+#include "nuttx_words.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define FICL_LINESIZE 256
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct ficl_stat_s
+{
+  uint64_t min;
+  uint64_t sum;
+  int count;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint64_t ficl_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void ficl_add(FAR struct ficl_stat_s *st, uint64_t ns)
+{
+  if (st->count == 0 || ns < st->min)
+    {
+      st->min = ns;
+    }
+
+  st->sum += ns;
+  st->count++;
+}
+
+static void ficl_report(FAR const char *what,
+                        FAR const struct ficl_stat_s *st)
+{
+  printf("%-12s min %8" PRIu64 " us  avg %8" PRIu64 " us\n", what,
+         st->min / 1000, st->count ? st->sum / st->count / 1000 : 0);
+}
+
+/****************************************************************************
+ * Name: ficl_boot
+ *
+ * Description:
+ *   Build a system from scratch: create it, which compiles the softcore,
+ *   create the console VM and compile the project words.  On failure the
+ *   partly built system is destroyed and *system is NULL.
+ *
+ ****************************************************************************/
+
+static FAR ficlVm *ficl_boot(FAR ficlSystem **system)
+{
+  ficlSystemInformation fsi;
+  FAR ficlVm *vm;
+  FAR char *words;
+  int ret;
+
+  ficlSystemInformationInitialize(&fsi);
+  fsi.dictionarySize = CONFIG_INTERPRETERS_FICL_DICTSIZE;
+
+  *system = ficlSystemCreate(&fsi);
+  if (*system == NULL)
+    {
+      return NULL;
+    }
+
+  vm = ficlSystemCreateVm(*system);
+  if (vm == NULL)
+    {
+      goto errout;
+    }
+
+  words = strndup((FAR const char *)src_nuttx_fr, src_nuttx_fr_len);
+  if (words == NULL)
+    {
+      goto errout;
+    }
+
+  ret = ficlVmEvaluate(vm, words);
+  free(words);
+
+  if (ret != FICL_VM_STATUS_OUT_OF_TEXT)
+    {
+      fprintf(stderr, "ficl: nuttx.fr failed: %d\n", ret);
+      goto errout;
+    }
+
+  return vm;
+
+errout:
+  ficlSystemDestroy(*system);
+  *system = NULL;
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: ficl_start
+ *
+ * Description:
+ *   Get a ready system: from the image when there is a usable one, else
+ *   by building it, optionally saving the result as the new image.
+ *
+ ****************************************************************************/
+
+static FAR ficlVm *ficl_start(FAR ficlSystem **system,
+                              FAR const char *image, bool cold, bool save)
+{
+  FAR ficlVm *vm;
+#ifdef CONFIG_INTERPRETERS_FICL_IMAGE
+  int ret;
+
+  if (!cold && !save && ficl_image_load(image, system, &vm) == 0)
+    {
+      return vm;
+    }
+
+  ficl_image_capture(true);
+  vm = ficl_boot(system);
+  ficl_image_capture(false);
+
+  if (vm != NULL && save)
+    {
+      ret = ficl_image_save(image, *system, vm);
+      if (ret < 0)
+        {
+          fprintf(stderr, "ficl: cannot save %s: %d\n", image, ret);
+        }
+    }
+#else
+  vm = ficl_boot(system);
+#endif
+
+  return vm;
+}
+
+/****************************************************************************
+ * Name: ficl_bench
+ *
+ * Description:
+ *   Time cold boots, image loads and a lookup of every FORTH word.
+ *
+ ****************************************************************************/
+
+static int ficl_bench(FAR const char *image, int rounds)
+{
+  FAR ficlDictionary *dict;
+  FAR ficlSystem *system = NULL;
+  struct ficl_stat_s st;
+  FAR ficlHash *hash;
+  FAR ficlWord *word;
+  FAR char **names;
+  FAR ficlVm *vm;
+  uint64_t start;
+  int nwords = 0;
+  int misses = 0;
+  int ret = EXIT_FAILURE;
+  unsigned i;
+  int r;
+  int n;
+
+  /* Cold boot */
+
+  memset(&st, 0, sizeof(st));
+  for (r = 0; r < rounds; r++)
+    {
+#ifdef CONFIG_INTERPRETERS_FICL_IMAGE
+      ficl_image_capture(true);
+#endif
+      start = ficl_now();
+      vm = ficl_boot(&system);
+      ficl_add(&st, ficl_now() - start);
+#ifdef CONFIG_INTERPRETERS_FICL_IMAGE
+      ficl_image_capture(false);
+#endif
+
+      if (vm == NULL)
+        {
+          fprintf(stderr, "ficl: cannot create the system\n");
+          return EXIT_FAILURE;
+        }
+
+      /* ficlFree() ignores blocks inside the image region, so this only
+       * releases what spilled onto the heap.
+       */
+
+      if (r + 1 < rounds)
+        {
+          ficlSystemDestroy(system);
+          system = NULL;
+        }
+    }
+
+  ficl_report("cold boot", &st);
+
+#ifdef CONFIG_INTERPRETERS_FICL_IMAGE
+  /* Image load of the system built by the last cold boot */
+
+  n = ficl_image_save(image, system, vm);
+  if (n < 0)
+    {
+      fprintf(stderr, "ficl: cannot save %s: %d\n", image, n);
+      goto out;
+    }
+
+  memset(&st, 0, sizeof(st));
+  for (r = 0; r < rounds; r++)
+    {
+      start = ficl_now();
+      n = ficl_image_load(image, &system, &vm);
+      ficl_add(&st, ficl_now() - start);
+
+      if (n < 0)
+        {
+          /* The region no longer holds a usable system */
+
+          fprintf(stderr, "ficl: cannot load %s: %d\n", image, n);
+          return EXIT_FAILURE;
+        }
+    }
+
+  ficl_report("image load", &st);
+#endif
+
+  /* Lookup of every word of the FORTH wordlist by name */
+
+  dict = ficlSystemGetDictionary(system);
+  hash = dict->forthWordlist;
+
+  for (i = 0; i < hash->size; i++)
+    {
+      for (word = hash->table[i]; word != NULL; word = word->link)
+        {
+          nwords++;
+        }
+    }
+
+  names = malloc(nwords * sizeof(*names));
+  if (names == NULL)
+    {
+      goto out;
+    }
+
+  n = 0;
+  for (i = 0; i < hash->size; i++)
+    {
+      for (word = hash->table[i]; word != NULL; word = word->link)
+        {
+          names[n++] = word->name;
+        }
+    }
+
+  start = ficl_now();
+  for (r = 0; r < rounds; r++)
+    {
+      for (n = 0; n < nwords; n++)
+        {
+          if (ficlSystemLookup(system, names[n]) == NULL)
+            {
+              misses++;
+            }
+        }
+    }
+
+  start = ficl_now() - start;
+  free(names);
+
+  printf("lookup       %d words, %u buckets, %" PRIu64 " ns/word\n",
+         nwords, hash->size,
+         nwords ? start / ((uint64_t)nwords * rounds) : 0);
+
+  if (misses > 0)
+    {
+      printf("ERROR: %d lookups failed\n", misses);
+    }
+  else
+    {
+      ret = EXIT_SUCCESS;
+    }
+
+out:
+  ficlSystemDestroy(system);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname, int exitcode)
+{
+  fprintf(stderr, "Usage: %s [-b rounds]", progname);
+#ifdef CONFIG_INTERPRETERS_FICL_IMAGE
+  fprintf(stderr, " [-i image] [-n] [-s]");
+#endif
+  fprintf(stderr, " [file ...]\n");
+  fprintf(stderr, "  -b  Time boots and word lookups, then exit\n");
+#ifdef CONFIG_INTERPRETERS_FICL_IMAGE
+  fprintf(stderr, "  -i  Dictionary image (default %s)\n",
+          CONFIG_INTERPRETERS_FICL_IMAGEPATH);
+  fprintf(stderr, "  -n  Build the system, ignoring the image\n");
+  fprintf(stderr, "  -s  Build the system and save it as the image\n");
+#endif
+  exit(exitcode);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  char line[FICL_LINESIZE];
+  FAR const char *image = NULL;
+  FAR ficlSystem *system;
+  FAR ficlVm *vm;
+  bool cold = false;
+  bool save = false;
+  int rounds = 0;
+  int ret = FICL_VM_STATUS_OUT_OF_TEXT;
+  int status = EXIT_SUCCESS;
+  int opt;
+  int n;
+
+#ifdef CONFIG_INTERPRETERS_FICL_IMAGE
+  image = CONFIG_INTERPRETERS_FICL_IMAGEPATH;
+#endif
+
+  while ((opt = getopt(argc, argv, "b:i:nsh")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'b':
+            rounds = atoi(optarg);
+            if (rounds <= 0)
+              {
+                show_usage(argv[0], EXIT_FAILURE);
+              }
+            break;
+
+#ifdef CONFIG_INTERPRETERS_FICL_IMAGE
+          case 'i':
+            image = optarg;
+            break;
+
+          case 'n':
+            cold = true;
+            break;
+
+          case 's':
+            save = true;
+            break;
+#endif
+
+          case 'h':
+            show_usage(argv[0], EXIT_SUCCESS);
+            break;
+
+          default:
+            show_usage(argv[0], EXIT_FAILURE);
+            break;
+        }
+    }
+
+  if (rounds > 0)
+    {
+      return ficl_bench(image, rounds);
+    }
+
+  vm = ficl_start(&system, image, cold, save);
+  if (vm == NULL)
+    {
+      fprintf(stderr, "ficl: cannot create the system\n");
+      return EXIT_FAILURE;
+    }
+
+  for (; optind < argc && ret != FICL_VM_STATUS_USER_EXIT; optind++)
+    {
+      n = snprintf(line, sizeof(line), "load %s\n", argv[optind]);
+      if (n < 0 || (size_t)n >= sizeof(line))
+        {
+          fprintf(stderr, "ficl: path too long: %s\n", argv[optind]);
+          status = EXIT_FAILURE;
+          goto out;
+        }
+
+      ret = ficlVmEvaluate(vm, line);
+    }
+
+  while (ret != FICL_VM_STATUS_USER_EXIT)
+    {
+      fputs(FICL_PROMPT, stdout);
+      fflush(stdout);
+
+      if (fgets(line, sizeof(line), stdin) == NULL)
+        {
+          break;
+        }
+
+      ret = ficlVmEvaluate(vm, line);
+    }
+
+out:
+  ficlSystemDestroy(system);
+  return status;
+}
@@ -33,6 +33,8 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
 #include <sys/stat.h>
 
 #include <stdio.h>
@@ -40,6 +42,7 @@
 #include <errno.h>
 
 #include "ficl.h"
+#include "nuttx_image.h"
 
 /****************************************************************************
  * Public Functions
@@ -47,16 +50,45 @@
 
 void *ficlMalloc(size_t size)
 {
+#ifdef CONFIG_INTERPRETERS_FICL_IMAGE
+  void *p;
+
+  if (ficl_image_capturing())
+    {
+      p = ficl_image_alloc(size);
+      if (p != NULL)
+        {
+          return p;
+        }
+    }
+#endif
+
   return malloc(size);
 }
 
 void *ficlRealloc(void *p, size_t size)
 {
+#ifdef CONFIG_INTERPRETERS_FICL_IMAGE
+  if (ficl_image_contains(p) || (p == NULL && ficl_image_capturing()))
+    {
+      return ficl_image_realloc(p, size);
+    }
+#endif
+
   return realloc(p, size);
 }
 
 void ficlFree(void *p)
 {
+#ifdef CONFIG_INTERPRETERS_FICL_IMAGE
+  /* Image blocks are only reclaimed when a new capture starts */
+
+  if (ficl_image_contains(p))
+    {
+      return;
+    }
+#endif
+
   free(p);
 }
 
@@ -0,0 +1,306 @@
+/****************************************************************************
+ * apps/interpreters/ficl/src/nuttx_image.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <nuttx/crc32.h>
+
+#include "nuttx_image.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define FICL_IMAGE_MAGIC   0x4c434946  /* "FICL" */
+#define FICL_IMAGE_ALIGN   (2 * sizeof(uintptr_t))
+#define FICL_IMAGE_ROUND(n) (((n) + FICL_IMAGE_ALIGN - 1) & \
+                             ~(FICL_IMAGE_ALIGN - 1))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The image holds raw pointers: to the region itself, which lives at a
+ * fixed address in .bss, and to the primitives and strings of the
+ * firmware.  The header records enough of both to refuse an image that
+ * was written by another build.
+ */
+
+struct ficl_image_hdr_s
+{
+  uint32_t magic;             /* FICL_IMAGE_MAGIC */
+  uint32_t crc;               /* CRC32 of the saved region bytes */
+  uintptr_t region;           /* Address of the image region */
+  uintptr_t create;           /* Address of ficlSystemCreate() */
+  uintptr_t evaluate;         /* Address of ficlVmEvaluate() */
+  size_t size;                /* Size of the image region */
+  size_t used;                /* Bytes of the region saved */
+  FAR ficlSystem *system;     /* System built in the region */
+  FAR ficlVm *vm;             /* Console VM built in the region */
+};
+
+/* Every block keeps its size in front of it for ficlRealloc() */
+
+struct ficl_image_block_s
+{
+  size_t size;
+  uintptr_t pad;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static union
+{
+  uint8_t bytes[CONFIG_INTERPRETERS_FICL_IMAGESIZE];
+  uintptr_t align[2];
+} g_region;
+
+static size_t g_used;
+static bool g_capture;
+static bool g_overflow;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void ficl_image_stamp(FAR struct ficl_image_hdr_s *hdr)
+{
+  hdr->magic    = FICL_IMAGE_MAGIC;
+  hdr->region   = (uintptr_t)g_region.bytes;
+  hdr->create   = (uintptr_t)ficlSystemCreate;
+  hdr->evaluate = (uintptr_t)ficlVmEvaluate;
+  hdr->size     = sizeof(g_region.bytes);
+}
+
+static ssize_t ficl_image_io(int fd, FAR void *buf, size_t len, bool wr)
+{
+  FAR uint8_t *ptr = buf;
+  size_t done = 0;
+  ssize_t n;
+
+  while (done < len)
+    {
+      n = wr ? write(fd, ptr + done, len - done) :
+               read(fd, ptr + done, len - done);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -errno;
+        }
+      else if (n == 0)
+        {
+          return -EIO;
+        }
+
+      done += n;
+    }
+
+  return done;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+bool ficl_image_capturing(void)
+{
+  return g_capture;
+}
+
+bool ficl_image_contains(FAR const void *p)
+{
+  return (FAR const uint8_t *)p >= g_region.bytes &&
+         (FAR const uint8_t *)p < g_region.bytes + sizeof(g_region.bytes);
+}
+
+FAR void *ficl_image_alloc(size_t size)
+{
+  FAR struct ficl_image_block_s *blk;
+  size_t need = sizeof(*blk) + FICL_IMAGE_ROUND(size);
+
+  if (need > sizeof(g_region.bytes) - g_used)
+    {
+      /* The caller falls back to the heap; this capture cannot be saved */
+
+      g_overflow = true;
+      return NULL;
+    }
+
+  blk = (FAR struct ficl_image_block_s *)(g_region.bytes + g_used);
+  blk->size = size;
+  g_used += need;
+  return blk + 1;
+}
+
+FAR void *ficl_image_realloc(FAR void *p, size_t size)
+{
+  FAR struct ficl_image_block_s *blk;
+  FAR void *mem;
+
+  /* Blocks never move inside the region; grow into a new one (or onto the
+   * heap once the capture is over) and leave the old one behind.
+   */
+
+  mem = g_capture ? ficl_image_alloc(size) : NULL;
+  if (mem == NULL)
+    {
+      mem = malloc(size);
+    }
+
+  if (mem != NULL && p != NULL)
+    {
+      blk = (FAR struct ficl_image_block_s *)p - 1;
+      memcpy(mem, p, blk->size < size ? blk->size : size);
+    }
+
+  return mem;
+}
+
+void ficl_image_capture(bool enable)
+{
+  if (enable)
+    {
+      g_used = 0;
+      g_overflow = false;
+    }
+
+  g_capture = enable;
+}
+
+int ficl_image_save(FAR const char *path, FAR ficlSystem *system,
+                    FAR ficlVm *vm)
+{
+  struct ficl_image_hdr_s hdr;
+  ssize_t ret;
+  int fd;
+
+  if (g_overflow)
+    {
+      return -ENOMEM;
+    }
+
+  if (!ficl_image_contains(system) || !ficl_image_contains(vm))
+    {
+      return -EINVAL;
+    }
+
+  memset(&hdr, 0, sizeof(hdr));
+  ficl_image_stamp(&hdr);
+  hdr.used   = g_used;
+  hdr.system = system;
+  hdr.vm     = vm;
+  hdr.crc    = crc32(g_region.bytes, g_used);
+
+  fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  ret = ficl_image_io(fd, &hdr, sizeof(hdr), true);
+  if (ret >= 0)
+    {
+      ret = ficl_image_io(fd, g_region.bytes, g_used, true);
+    }
+
+  close(fd);
+  if (ret < 0)
+    {
+      unlink(path);
+      return ret;
+    }
+
+  return 0;
+}
+
+int ficl_image_load(FAR const char *path, FAR ficlSystem **system,
+                    FAR ficlVm **vm)
+{
+  struct ficl_image_hdr_s want;
+  struct ficl_image_hdr_s hdr;
+  ssize_t ret;
+  int fd;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+    {
+      return -errno;
+    }
+
+  ret = ficl_image_io(fd, &hdr, sizeof(hdr), false);
+  if (ret < 0)
+    {
+      close(fd);
+      return ret;
+    }
+
+  memset(&want, 0, sizeof(want));
+  ficl_image_stamp(&want);
+
+  if (hdr.magic != want.magic || hdr.region != want.region ||
+      hdr.create != want.create || hdr.evaluate != want.evaluate ||
+      hdr.size != want.size || hdr.used > hdr.size ||
+      !ficl_image_contains(hdr.system) || !ficl_image_contains(hdr.vm))
+    {
+      close(fd);
+      return -ENOEXEC;
+    }
+
+  g_capture  = false;
+  g_overflow = false;
+  g_used     = 0;
+
+  ret = ficl_image_io(fd, g_region.bytes, hdr.used, false);
+  close(fd);
+
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (crc32(g_region.bytes, hdr.used) != hdr.crc)
+    {
+      return -EILSEQ;
+    }
+
+  g_used  = hdr.used;
+  *system = hdr.system;
+  *vm     = hdr.vm;
+  return 0;
+}
@@ -0,0 +1,94 @@
+/****************************************************************************
+ * apps/interpreters/ficl/src/nuttx_image.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INTERPRETERS_FICL_SRC_NUTTX_IMAGE_H
+#define __APPS_INTERPRETERS_FICL_SRC_NUTTX_IMAGE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ficl.h"
+
+#ifdef CONFIG_INTERPRETERS_FICL_IMAGE
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/* Allocation hooks used by ficlMalloc(), ficlRealloc() and ficlFree() */
+
+bool ficl_image_capturing(void);
+bool ficl_image_contains(FAR const void *p);
+FAR void *ficl_image_alloc(size_t size);
+FAR void *ficl_image_realloc(FAR void *p, size_t size);
+
+/****************************************************************************
+ * Name: ficl_image_capture
+ *
+ * Description:
+ *   Start (or stop) placing every Ficl allocation in the static image
+ *   region.  Starting a capture discards whatever the region held, so the
+ *   system previously built there must no longer be used.
+ *
+ ****************************************************************************/
+
+void ficl_image_capture(bool enable);
+
+/****************************************************************************
+ * Name: ficl_image_save
+ *
+ * Description:
+ *   Write the image region, holding the system and VM built during the
+ *   last capture, to a file.
+ *
+ * Returned Value:
+ *   Zero on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int ficl_image_save(FAR const char *path, FAR ficlSystem *system,
+                    FAR ficlVm *vm);
+
+/****************************************************************************
+ * Name: ficl_image_load
+ *
+ * Description:
+ *   Copy an image written by ficl_image_save() back into the image region
+ *   and return the system and VM it holds.  Images written by a different
+ *   firmware, or with a different region size, are refused.
+ *
+ * Returned Value:
+ *   Zero on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int ficl_image_load(FAR const char *path, FAR ficlSystem **system,
+                    FAR ficlVm **vm);
+
+#endif /* CONFIG_INTERPRETERS_FICL_IMAGE */
+#endif /* __APPS_INTERPRETERS_FICL_SRC_NUTTX_IMAGE_H */
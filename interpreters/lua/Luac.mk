@@ -0,0 +1,43 @@
+############################################################################
+# apps/interpreters/lua/Luac.mk
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed to the Apache Software Foundation (ASF) under one or more
+# contributor license agreements.  See the NOTICE file distributed with
+# this work for additional information regarding copyright ownership.  The
+# ASF licenses this file to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance with the
+# License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+# License for the specific language governing permissions and limitations
+# under the License.
+#
+############################################################################
+
+# Precompile Lua scripts with the host luac built by interpreters/lua
+# (CONFIG_INTERPRETER_LUA_LUAC).  Usage from an application Makefile:
+#
+#   include $(APPDIR)/interpreters/lua/Luac.mk
+#
+#   romfs/%.lua: scripts/%.lua
+#   	$(call LUAC_COMPILE,$<,$@)
+#
+# The output keeps the .lua name so that dofile(), loadfile() and
+# require() pick up the binary chunk without any change to the scripts.
+
+LUAC ?= $(APPDIR)$(DELIM)interpreters$(DELIM)lua$(DELIM)luac$(HOSTEXEEXT)
+
+ifeq ($(CONFIG_INTERPRETER_LUA_LUAC_STRIP),y)
+LUACFLAGS += -s
+endif
+
+define LUAC_COMPILE
+	$(Q) echo "LUAC: $1"
+	$(Q) $(LUAC) $(LUACFLAGS) -o $2 $1
+endef
@@ -25,6 +25,7 @@
  ****************************************************************************/
 
 #include <stddef.h>
+#include <string.h>
 
 #include <lua.h>
 #include <lualib.h>
@@ -55,6 +56,64 @@ static const luaL_Reg g_loadedlibs[] =
   {NULL, NULL},
 };
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#ifdef CONFIG_INTERPRETER_LUA_LAZYLOAD
+
+/****************************************************************************
+ * Name: lua_iseager
+ *
+ *   The base library provides require() and the package library provides
+ *   package.preload.  The string library also installs the metatable of
+ *   strings, which method calls like s:upper() use without ever naming
+ *   the string global, so it can not wait either.  Everything else can
+ *   wait for its first use.
+ *
+ ****************************************************************************/
+
+static int lua_iseager(const char *name)
+{
+  return strcmp(name, LUA_GNAME) == 0 ||
+         strcmp(name, LUA_LOADLIBNAME) == 0 ||
+         strcmp(name, LUA_STRLIBNAME) == 0;
+}
+
+/****************************************************************************
+ * Name: lua_lazyindex
+ *
+ *   __index metamethod of the global table: open a library the first time
+ *   its global name is read.  luaL_requiref() reuses a module that was
+ *   already loaded by require() and stores the global, so this only runs
+ *   once per library.
+ *
+ ****************************************************************************/
+
+static int lua_lazyindex(lua_State *L)
+{
+  const luaL_Reg *lib;
+  const char *name;
+
+  if (lua_type(L, 2) != LUA_TSTRING)
+    {
+      return 0;
+    }
+
+  name = lua_tostring(L, 2);
+  for (lib = g_loadedlibs; lib->func; lib++)
+    {
+      if (strcmp(lib->name, name) == 0)
+        {
+          luaL_requiref(L, lib->name, lib->func, 1);
+          return 1;
+        }
+    }
+
+  return 0;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -70,9 +129,50 @@ static const luaL_Reg g_loadedlibs[] =
 void luaL_openlibs(lua_State *L)
 {
   const luaL_Reg *lib;
+
+#ifdef CONFIG_INTERPRETER_LUA_LAZYLOAD
+  for (lib = g_loadedlibs; lib->func; lib++)
+    {
+      if (lua_iseager(lib->name))
+        {
+          luaL_requiref(L, lib->name, lib->func, 1);
+          lua_pop(L, 1);
+        }
+    }
+
+  /* Let require() open the remaining libraries */
+
+  lua_getglobal(L, LUA_LOADLIBNAME);
+  if (lua_istable(L, -1))
+    {
+      lua_getfield(L, -1, "preload");
+      for (lib = g_loadedlibs; lib->func; lib++)
+        {
+          if (!lua_iseager(lib->name))
+            {
+              lua_pushcfunction(L, lib->func);
+              lua_setfield(L, -2, lib->name);
+            }
+        }
+
+      lua_pop(L, 1);
+    }
+
+  lua_pop(L, 1);
+
+  /* And plain global access, e.g. string.format() without require() */
+
+  lua_pushglobaltable(L);
+  lua_createtable(L, 0, 1);
+  lua_pushcfunction(L, lua_lazyindex);
+  lua_setfield(L, -2, "__index");
+  lua_setmetatable(L, -2);
+  lua_pop(L, 1);
+#else
   for (lib = g_loadedlibs; lib->func; lib++)
     {
       luaL_requiref(L, lib->name, lib->func, 1);
       lua_pop(L, 1);
     }
+#endif
 }
@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include <stdarg.h>
 #include <inttypes.h>
+#include <stdbool.h>
 #include <string.h>
 #include <assert.h>
 #include <unistd.h>
@@ -35,16 +36,28 @@
 #include <fcntl.h>
 #include <time.h>
 #include <malloc.h>
+#include <limits.h>
+#include <sys/stat.h>
 
 #include <quickjs.h>
 #include <cutils.h>
 
+#ifdef CONFIG_INTERPRETERS_QUICKJS_MINI_BYTECODE
+#  include "qjsmini.h"
+#endif
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
 
 #define MALLOC_OVERHEAD 8
 
+#ifdef CONFIG_INTERPRETERS_QUICKJS_MINI_WARM
+#  define QJS_WARM_CACHE     CONFIG_INTERPRETERS_QUICKJS_MINI_WARM_CACHE
+#  define QJS_WARM_RETSUFFIX ".ret"
+#  define QJS_WARM_LINESIZE  PATH_MAX
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -54,6 +67,39 @@ struct trace_malloc_data
   uint8_t *base;
 };
 
+#if defined(CONFIG_INTERPRETERS_QUICKJS_MINI_WARM) && QJS_WARM_CACHE > 0
+
+/* Compiled script kept by the warm server, the buffer is allocated with
+ * malloc() so that it survives context recycling.
+ */
+
+struct qjs_cache_s
+{
+  char *path;
+  off_t size;
+  time_t mtime;
+  uint8_t *bc;
+  size_t bc_len;
+  unsigned long stamp;
+};
+
+static struct qjs_cache_s g_qjs_cache[QJS_WARM_CACHE];
+static unsigned long g_qjs_stamp;
+#endif
+
+/****************************************************************************
+ * Public Functions Prototypes
+ ****************************************************************************/
+
+int js_ext_init(JSContext *ctx);
+int js_ext_destroy(JSContext *ctx);
+
+#if defined(CONFIG_INTERPRETERS_QUICKJS_MINI_BYTECODE) || \
+    defined(CONFIG_INTERPRETERS_QUICKJS_MINI_WARM)
+static int js_eval_binary(JSContext *ctx, const uint8_t *buf,
+                          size_t buf_len);
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -75,7 +121,17 @@ static void qjs_help(void)
          "    --memory-limit n       limit the memory usage to 'n' bytes\n"
          "    --stack-size n         limit the stack size to 'n' bytes\n"
          "    --unhandled-rejection  dump unhandled promise rejections\n"
-         "-q  --quit         just instantiate the interpreter and quit\n");
+         "-q  --quit         just instantiate the interpreter and quit\n"
+#ifdef CONFIG_INTERPRETERS_QUICKJS_MINI_BYTECODE
+         "-c  --compile OUT  compile file to the bytecode file OUT\n"
+         "-b  --builtin NAME run the precompiled script NAME\n"
+         "-l  --list         list the precompiled scripts\n"
+#endif
+#ifdef CONFIG_INTERPRETERS_QUICKJS_MINI_WARM
+         "    --serve        run the warm context server\n"
+         "    --send         run file in the warm context server\n"
+#endif
+         );
   exit(1);
 }
 
@@ -403,6 +459,16 @@ static int js_eval_file(JSContext *ctx, const char *filename, int module)
       exit(1);
     }
 
+#if defined(CONFIG_INTERPRETERS_QUICKJS_MINI_BYTECODE) || \
+    defined(CONFIG_INTERPRETERS_QUICKJS_MINI_WARM)
+  if (has_suffix(filename, ".qbc"))
+    {
+      ret = js_eval_binary(ctx, buf, buf_len);
+      js_free(ctx, buf);
+      return ret;
+    }
+#endif
+
   if (module < 0)
     {
       module = (has_suffix(filename, ".mjs") ||
@@ -454,11 +520,544 @@ void js_std_add_helpers(JSContext *ctx)
 }
 
 /****************************************************************************
- * Public Functions Prototypes
+ * Name: js_new_context
  ****************************************************************************/
 
-int js_ext_init(JSContext *ctx);
-int js_ext_destroy(JSContext *ctx);
+static JSContext *js_new_context(JSRuntime *rt)
+{
+  JSContext *ctx;
+
+  ctx = JS_NewContext(rt);
+  if (!ctx)
+    {
+      fprintf(stderr, "qjs: cannot allocate JS context\n");
+      return NULL;
+    }
+
+  js_std_add_helpers(ctx);
+
+#ifdef CONFIG_INTERPRETERS_QUICKJS_EXT_HOOK
+  if (OK != js_ext_init(ctx))
+    {
+      fprintf(stderr, "qjs: external context init failed\n");
+      JS_FreeContext(ctx);
+      return NULL;
+    }
+#endif
+
+  return ctx;
+}
+
+/****************************************************************************
+ * Name: js_free_context
+ ****************************************************************************/
+
+static void js_free_context(JSContext *ctx)
+{
+#ifdef CONFIG_INTERPRETERS_QUICKJS_EXT_HOOK
+  js_ext_destroy(ctx);
+#endif
+  JS_FreeContext(ctx);
+}
+
+#if defined(CONFIG_INTERPRETERS_QUICKJS_MINI_BYTECODE) || \
+    defined(CONFIG_INTERPRETERS_QUICKJS_MINI_WARM)
+
+/****************************************************************************
+ * Name: js_eval_binary
+ *
+ * Description:
+ *   Instantiate and run an object written by JS_WriteObject() or qjsc.
+ *
+ ****************************************************************************/
+
+static int js_eval_binary(JSContext *ctx, const uint8_t *buf,
+                          size_t buf_len)
+{
+  JSValue obj;
+  JSValue val;
+
+  obj = JS_ReadObject(ctx, buf, buf_len, JS_READ_OBJ_BYTECODE);
+  if (JS_IsException(obj))
+    {
+      goto exception;
+    }
+
+  if (JS_VALUE_GET_TAG(obj) == JS_TAG_MODULE &&
+      JS_ResolveModule(ctx, obj) < 0)
+    {
+      JS_FreeValue(ctx, obj);
+      goto exception;
+    }
+
+  val = JS_EvalFunction(ctx, obj);
+  if (JS_IsException(val))
+    {
+      goto exception;
+    }
+
+  JS_FreeValue(ctx, val);
+  return 0;
+
+exception:
+  js_std_dump_error(ctx);
+  return -1;
+}
+
+/****************************************************************************
+ * Name: js_compile_file
+ *
+ * Description:
+ *   Compile a source file and return the bytecode in a malloc()ed
+ *   buffer.  Like js_eval_file(), a negative module selects the type from
+ *   the .mjs suffix or the presence of import/export statements.
+ *
+ ****************************************************************************/
+
+static uint8_t *js_compile_file(JSContext *ctx, const char *filename,
+                                int module, size_t *pbc_len)
+{
+  uint8_t *buf;
+  uint8_t *bc;
+  uint8_t *out = NULL;
+  size_t buf_len;
+  int eval_flags;
+  JSValue obj;
+
+  buf = js_load_file(ctx, &buf_len, filename);
+  if (!buf)
+    {
+      perror(filename);
+      return NULL;
+    }
+
+  if (module < 0)
+    {
+      module = (has_suffix(filename, ".mjs") ||
+                JS_DetectModule((const char *)buf, buf_len));
+    }
+
+  eval_flags = module ? JS_EVAL_TYPE_MODULE : JS_EVAL_TYPE_GLOBAL;
+  obj = JS_Eval(ctx, (const char *)buf, buf_len, filename,
+                eval_flags | JS_EVAL_FLAG_COMPILE_ONLY);
+  js_free(ctx, buf);
+  if (JS_IsException(obj))
+    {
+      js_std_dump_error(ctx);
+      return NULL;
+    }
+
+  bc = JS_WriteObject(ctx, pbc_len, obj, JS_WRITE_OBJ_BYTECODE);
+  JS_FreeValue(ctx, obj);
+  if (!bc)
+    {
+      js_std_dump_error(ctx);
+      return NULL;
+    }
+
+  out = malloc(*pbc_len);
+  if (out)
+    {
+      memcpy(out, bc, *pbc_len);
+    }
+
+  js_free(ctx, bc);
+  return out;
+}
+#endif
+
+#ifdef CONFIG_INTERPRETERS_QUICKJS_MINI_BYTECODE
+
+/****************************************************************************
+ * Name: js_write_bytecode
+ ****************************************************************************/
+
+static int js_write_bytecode(JSContext *ctx, const char *filename,
+                             const char *outname)
+{
+  uint8_t *bc;
+  size_t bc_len;
+  FILE *f;
+  int ret = 0;
+
+  bc = js_compile_file(ctx, filename, -1, &bc_len);
+  if (!bc)
+    {
+      return -1;
+    }
+
+  f = fopen(outname, "wb");
+  if (!f || fwrite(bc, 1, bc_len, f) != bc_len)
+    {
+      perror(outname);
+      ret = -1;
+    }
+
+  if (f)
+    {
+      fclose(f);
+    }
+
+  free(bc);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: js_eval_builtin
+ ****************************************************************************/
+
+static int js_eval_builtin(JSContext *ctx, const char *name)
+{
+  const struct qjsmini_builtin_s *b;
+
+  for (b = g_qjsmini_builtins; b->name; b++)
+    {
+      if (!strcmp(b->name, name))
+        {
+          return js_eval_binary(ctx, b->buf, b->size);
+        }
+    }
+
+  fprintf(stderr, "qjs: no precompiled script '%s'\n", name);
+  return -1;
+}
+
+/****************************************************************************
+ * Name: js_list_builtins
+ ****************************************************************************/
+
+static void js_list_builtins(void)
+{
+  const struct qjsmini_builtin_s *b;
+
+  for (b = g_qjsmini_builtins; b->name; b++)
+    {
+      printf("%-16s %8" PRIu32 " bytes\n", b->name, b->size);
+    }
+}
+#endif
+
+#ifdef CONFIG_INTERPRETERS_QUICKJS_MINI_WARM
+
+/****************************************************************************
+ * Name: js_warm_run
+ *
+ * Description:
+ *   Run one request of the warm server.  Source files are compiled once
+ *   and then run from the cached bytecode while they are unchanged.
+ *
+ ****************************************************************************/
+
+static int js_warm_run(JSContext *ctx, const char *filename)
+{
+#if QJS_WARM_CACHE > 0
+  struct qjs_cache_s *victim = &g_qjs_cache[0];
+  struct qjs_cache_s *c;
+  uint8_t *bc;
+  size_t bc_len;
+  int i;
+#endif
+  struct stat st;
+
+  /* js_eval_file() exits on a missing file, the server must not */
+
+  if (stat(filename, &st) < 0)
+    {
+      perror(filename);
+      return -1;
+    }
+
+#if QJS_WARM_CACHE > 0
+  if (has_suffix(filename, ".qbc"))
+    {
+      return js_eval_file(ctx, filename, 1);
+    }
+
+  for (i = 0; i < QJS_WARM_CACHE; i++)
+    {
+      c = &g_qjs_cache[i];
+      if (c->path && !strcmp(c->path, filename))
+        {
+          if (c->size == st.st_size && c->mtime == st.st_mtime)
+            {
+              c->stamp = ++g_qjs_stamp;
+              return js_eval_binary(ctx, c->bc, c->bc_len);
+            }
+
+          victim = c;
+          break;
+        }
+
+      if (!c->path || c->stamp < victim->stamp)
+        {
+          victim = c;
+        }
+    }
+
+  bc = js_compile_file(ctx, filename, -1, &bc_len);
+  if (!bc)
+    {
+      return -1;
+    }
+
+  free(victim->path);
+  free(victim->bc);
+  victim->path   = strdup(filename);
+  victim->size   = st.st_size;
+  victim->mtime  = st.st_mtime;
+  victim->bc     = bc;
+  victim->bc_len = bc_len;
+  victim->stamp  = ++g_qjs_stamp;
+
+  return js_eval_binary(ctx, bc, bc_len);
+#else
+  return js_eval_file(ctx, filename, -1);
+#endif
+}
+
+/****************************************************************************
+ * Name: js_write_all
+ *
+ * Description:
+ *   Write the whole buffer to a FIFO, retrying on signals and short
+ *   writes.
+ *
+ ****************************************************************************/
+
+static int js_write_all(int fd, const void *buf, size_t len)
+{
+  const uint8_t *ptr = buf;
+  ssize_t n;
+
+  while (len > 0)
+    {
+      n = write(fd, ptr, len);
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -1;
+        }
+
+      ptr += n;
+      len -= n;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: js_warm_reply
+ ****************************************************************************/
+
+static void js_warm_reply(const char *retpath, int status)
+{
+  uint8_t code = status ? 1 : 0;
+  int fd;
+
+  fd = open(retpath, O_WRONLY);
+  if (fd < 0 || js_write_all(fd, &code, 1) < 0)
+    {
+      perror(retpath);
+    }
+
+  if (fd >= 0)
+    {
+      close(fd);
+    }
+}
+
+/****************************************************************************
+ * Name: js_serve
+ *
+ * Description:
+ *   Keep one runtime and context alive and run the scripts named on the
+ *   request FIFO, one path per line, until "quit" is received.
+ *
+ ****************************************************************************/
+
+static int js_serve(JSRuntime *rt)
+{
+  const char *fifo = CONFIG_INTERPRETERS_QUICKJS_MINI_WARM_FIFO;
+  char retpath[PATH_MAX];
+  char *line;
+  JSContext *ctx;
+  bool quit = false;
+  int requests = 0;
+  int status;
+  FILE *req;
+  int i;
+
+  snprintf(retpath, sizeof(retpath), "%s" QJS_WARM_RETSUFFIX, fifo);
+  if ((mkfifo(fifo, 0666) < 0 && errno != EEXIST) ||
+      (mkfifo(retpath, 0666) < 0 && errno != EEXIST))
+    {
+      perror(fifo);
+      return -1;
+    }
+
+  line = malloc(QJS_WARM_LINESIZE);
+  ctx = js_new_context(rt);
+  if (!line || !ctx)
+    {
+      goto out;
+    }
+
+  printf("qjs: serving requests on %s\n", fifo);
+
+  while (!quit)
+    {
+      req = fopen(fifo, "r");
+      if (!req)
+        {
+          perror(fifo);
+          break;
+        }
+
+      while (!quit && fgets(line, QJS_WARM_LINESIZE, req))
+        {
+          line[strcspn(line, "\r\n")] = '\0';
+          if (!strcmp(line, "quit"))
+            {
+              quit = true;
+              js_warm_reply(retpath, 0);
+              break;
+            }
+
+          /* Bound the memory held by the evaluated modules */
+
+          if (++requests > CONFIG_INTERPRETERS_QUICKJS_MINI_WARM_RECYCLE)
+            {
+              js_free_context(ctx);
+              ctx = js_new_context(rt);
+              requests = 1;
+              if (!ctx)
+                {
+                  js_warm_reply(retpath, -1);
+                  quit = true;
+                  break;
+                }
+            }
+
+          status = js_warm_run(ctx, line);
+          fflush(stdout);
+          js_warm_reply(retpath, status);
+        }
+
+      fclose(req);
+    }
+
+out:
+  if (ctx)
+    {
+      js_free_context(ctx);
+    }
+
+#if QJS_WARM_CACHE > 0
+  for (i = 0; i < QJS_WARM_CACHE; i++)
+    {
+      free(g_qjs_cache[i].path);
+      free(g_qjs_cache[i].bc);
+      memset(&g_qjs_cache[i], 0, sizeof(g_qjs_cache[i]));
+    }
+#else
+  UNUSED(i);
+#endif
+
+  free(line);
+  unlink(fifo);
+  unlink(retpath);
+  return 0;
+}
+
+/****************************************************************************
+ * Name: js_send
+ *
+ * Description:
+ *   Client side of the warm server: post the absolute path of the script
+ *   and wait for its status.
+ *
+ ****************************************************************************/
+
+static int js_send(const char *filename)
+{
+  const char *fifo = CONFIG_INTERPRETERS_QUICKJS_MINI_WARM_FIFO;
+  char retpath[PATH_MAX];
+  char path[PATH_MAX];
+  struct stat st;
+  uint8_t code = 1;
+  int len;
+  int fd;
+
+  if (stat(fifo, &st) < 0)
+    {
+      fprintf(stderr, "qjs: no server on %s, start 'qjs --serve &'\n",
+              fifo);
+      return 1;
+    }
+
+  if (filename[0] == '/' || !strcmp(filename, "quit"))
+    {
+      len = snprintf(path, sizeof(path), "%s\n", filename);
+    }
+  else
+    {
+      if (!getcwd(retpath, sizeof(retpath)))
+        {
+          return 1;
+        }
+
+      len = snprintf(path, sizeof(path), "%s/%s\n", retpath, filename);
+    }
+
+  if (len < 0 || (size_t)len >= sizeof(path))
+    {
+      fprintf(stderr, "qjs: path too long\n");
+      return 1;
+    }
+
+  snprintf(retpath, sizeof(retpath), "%s" QJS_WARM_RETSUFFIX, fifo);
+
+  fd = open(fifo, O_WRONLY);
+  if (fd < 0 || js_write_all(fd, path, len) < 0)
+    {
+      perror(fifo);
+      if (fd >= 0)
+        {
+          close(fd);
+        }
+
+      return 1;
+    }
+
+  close(fd);
+
+  fd = open(retpath, O_RDONLY);
+  if (fd < 0)
+    {
+      perror(retpath);
+      return 1;
+    }
+
+  do
+    {
+      len = read(fd, &code, 1);
+    }
+  while (len < 0 && errno == EINTR);
+
+  close(fd);
+  if (len != 1)
+    {
+      fprintf(stderr, "qjs: no status from server\n");
+      return 1;
+    }
+
+  return code;
+}
+#endif
 
 /****************************************************************************
  * Public Functions
@@ -492,6 +1091,15 @@ int main(int argc, char *argv[])
   int empty_run = 0;
   size_t memory_limit = 0;
   size_t stack_size = 0;
+  int status = EXIT_SUCCESS;
+#ifdef CONFIG_INTERPRETERS_QUICKJS_MINI_BYTECODE
+  const char *compile_out = NULL;
+  const char *builtin = NULL;
+#endif
+#ifdef CONFIG_INTERPRETERS_QUICKJS_MINI_WARM
+  int serve = 0;
+  int send = 0;
+#endif
 
   argi = 1;
   while (argi < argc && *argv[argi] == '-')
@@ -560,6 +1168,52 @@ int main(int argc, char *argv[])
               continue;
             }
 
+#ifdef CONFIG_INTERPRETERS_QUICKJS_MINI_BYTECODE
+          if (opt == 'c' || !strcmp(longopt, "compile"))
+            {
+              if (argi >= argc)
+                {
+                  fprintf(stderr, "qjs: missing output for -c\n");
+                  exit(2);
+                }
+
+              compile_out = argv[argi++];
+              continue;
+            }
+
+          if (opt == 'b' || !strcmp(longopt, "builtin"))
+            {
+              if (argi >= argc)
+                {
+                  fprintf(stderr, "qjs: missing name for -b\n");
+                  exit(2);
+                }
+
+              builtin = argv[argi++];
+              continue;
+            }
+
+          if (opt == 'l' || !strcmp(longopt, "list"))
+            {
+              js_list_builtins();
+              exit(0);
+            }
+#endif
+
+#ifdef CONFIG_INTERPRETERS_QUICKJS_MINI_WARM
+          if (!strcmp(longopt, "serve"))
+            {
+              serve++;
+              continue;
+            }
+
+          if (!strcmp(longopt, "send"))
+            {
+              send++;
+              continue;
+            }
+#endif
+
           if (!strcmp(longopt, "memory-limit"))
             {
               if (argi >= argc)
@@ -597,6 +1251,18 @@ int main(int argc, char *argv[])
         }
     }
 
+#ifdef CONFIG_INTERPRETERS_QUICKJS_MINI_WARM
+  if (send)
+    {
+      if (argi >= argc)
+        {
+          qjs_help();
+        }
+
+      return js_send(argv[argi]);
+    }
+#endif
+
   if (trace_memory)
     {
       js_trace_malloc_init(&trace_data);
@@ -618,26 +1284,48 @@ int main(int argc, char *argv[])
   if (stack_size != 0)
     JS_SetMaxStackSize(rt, stack_size);
 
-  ctx = JS_NewContext(rt);
-
-  if (!ctx)
+#ifdef CONFIG_INTERPRETERS_QUICKJS_MINI_WARM
+  if (serve)
     {
-      fprintf(stderr, "qjs: cannot allocate JS context\n");
+      js_serve(rt);
       goto fail;
     }
+#endif
 
-  js_std_add_helpers(ctx);
-
-#ifdef CONFIG_INTERPRETERS_QUICKJS_EXT_HOOK
-  if (OK != js_ext_init(ctx))
+  ctx = js_new_context(rt);
+  if (!ctx)
     {
-      fprintf(stderr, "qjs: external context init failed\n");
       goto fail;
     }
-#endif
 
   if (!empty_run)
     {
+#ifdef CONFIG_INTERPRETERS_QUICKJS_MINI_BYTECODE
+      if (compile_out)
+        {
+          if (argi >= argc)
+            {
+              qjs_help();
+            }
+
+          if (js_write_bytecode(ctx, argv[argi], compile_out) < 0)
+            {
+              status = EXIT_FAILURE;
+            }
+
+          goto fail;
+        }
+
+      if (builtin)
+        {
+          if (js_eval_builtin(ctx, builtin))
+            {
+              status = EXIT_FAILURE;
+              goto fail;
+            }
+        }
+      else
+#endif
       if (expr)
         {
           if (js_eval_buf(ctx, expr, strlen(expr), "<cmdline>", 0))
@@ -666,14 +1354,11 @@ int main(int argc, char *argv[])
 fail:
   if (ctx)
     {
-#ifdef CONFIG_INTERPRETERS_QUICKJS_EXT_HOOK
-      js_ext_destroy(ctx);
-#endif
-      JS_FreeContext(ctx);
+      js_free_context(ctx);
     }
 
   if (rt)
     JS_FreeRuntime(rt);
 
-  return 0;
+  return status;
 }
@@ -0,0 +1,55 @@
+/****************************************************************************
+ * apps/interpreters/quickjs/qjsmini.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INTERPRETERS_QUICKJS_QJSMINI_H
+#define __APPS_INTERPRETERS_QUICKJS_QJSMINI_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdint.h>
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Script compiled by qjsc at build time, see
+ * CONFIG_INTERPRETERS_QUICKJS_MINI_SCRIPTS.
+ */
+
+struct qjsmini_builtin_s
+{
+  FAR const char    *name;
+  FAR const uint8_t *buf;
+  uint32_t           size;
+};
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+/* Generated table, terminated by an entry with a NULL name */
+
+extern const struct qjsmini_builtin_s g_qjsmini_builtins[];
+
+#endif /* __APPS_INTERPRETERS_QUICKJS_QJSMINI_H */
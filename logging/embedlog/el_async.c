@@ -0,0 +1,773 @@
+/****************************************************************************
+ * apps/logging/embedlog/el_async.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef CONFIG_EMBEDLOG_ASYNC_LZF
+#  include <lzf.h>
+#endif
+
+#include <logging/el_async.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define EL_ASYNC_HDRSIZE  2       /* Record length in front of each record */
+#define EL_ASYNC_MAXREC   UINT16_MAX
+
+#ifdef CONFIG_EMBEDLOG_ASYNC_LZF
+#  define EL_ASYNC_HEADROOM LZF_MAX_HDR_SIZE
+#else
+#  define EL_ASYNC_HEADROOM 0
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_EMBEDLOG_ASYNC_LZF
+struct el_async_lzf_s
+{
+  lzf_state_t htab;
+  uint8_t out[1];           /* LZF_MAX_HDR_SIZE + batchsize */
+};
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: el_async_ring_get
+ *
+ * Description:
+ *   Return the ring of the calling thread, adopting the ring of an exited
+ *   thread or allocating a new one on the first record.
+ *
+ ****************************************************************************/
+
+static FAR struct el_async_ring_s *
+el_async_ring_get(FAR struct el_async_s *as)
+{
+  FAR struct el_async_ring_s *ring;
+  bool orphan;
+  size_t size;
+
+  ring = pthread_getspecific(as->key);
+  if (ring != NULL)
+    {
+      return ring;
+    }
+
+  pthread_mutex_lock(&as->reglock);
+
+  for (ring = atomic_load(&as->rings); ring != NULL; ring = ring->flink)
+    {
+      orphan = true;
+      if (atomic_compare_exchange_strong(&ring->orphan, &orphan, false))
+        {
+          break;
+        }
+    }
+
+  if (ring == NULL)
+    {
+      size = 16;
+      while (size < as->cfg.ringsize)
+        {
+          size <<= 1;
+        }
+
+      ring = zalloc(sizeof(*ring) + size);
+      if (ring != NULL)
+        {
+          ring->mask  = size - 1;
+          ring->data  = (FAR uint8_t *)(ring + 1);
+          ring->flink = atomic_load(&as->rings);
+          atomic_store(&as->rings, ring);
+        }
+    }
+
+  pthread_mutex_unlock(&as->reglock);
+
+  if (ring != NULL)
+    {
+      pthread_setspecific(as->key, ring);
+    }
+
+  return ring;
+}
+
+/****************************************************************************
+ * Name: el_async_ring_release
+ *
+ * Description:
+ *   Thread exit destructor: leave the ring, and the records still in it,
+ *   for the writer and the next new thread.
+ *
+ ****************************************************************************/
+
+static void el_async_ring_release(FAR void *arg)
+{
+  FAR struct el_async_ring_s *ring = arg;
+
+  atomic_store(&ring->orphan, true);
+}
+
+/****************************************************************************
+ * Name: el_async_copyin / el_async_copyout
+ *
+ * Description:
+ *   Copy to and from a ring position, wrapping around its end.
+ *
+ ****************************************************************************/
+
+static void el_async_copyin(FAR struct el_async_ring_s *ring, size_t pos,
+                            FAR const void *src, size_t len)
+{
+  size_t off = pos & ring->mask;
+  size_t n = ring->mask + 1 - off;
+
+  if (n > len)
+    {
+      n = len;
+    }
+
+  memcpy(ring->data + off, src, n);
+  memcpy(ring->data, (FAR const uint8_t *)src + n, len - n);
+}
+
+static void el_async_copyout(FAR struct el_async_ring_s *ring, size_t pos,
+                             FAR void *dst, size_t len)
+{
+  size_t off = pos & ring->mask;
+  size_t n = ring->mask + 1 - off;
+
+  if (n > len)
+    {
+      n = len;
+    }
+
+  memcpy(dst, ring->data + off, n);
+  memcpy((FAR uint8_t *)dst + n, ring->data, len - n);
+}
+
+/****************************************************************************
+ * Name: el_async_open
+ ****************************************************************************/
+
+static int el_async_open(FAR struct el_async_s *as, int flags)
+{
+  struct stat st;
+
+  as->fd = open(as->cfg.path, O_WRONLY | O_CREAT | O_APPEND | flags, 0644);
+  if (as->fd < 0)
+    {
+      return -errno;
+    }
+
+  as->fsize = fstat(as->fd, &st) == 0 ? st.st_size : 0;
+  return 0;
+}
+
+/****************************************************************************
+ * Name: el_async_rotate
+ *
+ * Description:
+ *   Shift path.N-1 .. path.1 up by one, the oldest being overwritten, move
+ *   the current file to path.1 and start a new one.
+ *
+ ****************************************************************************/
+
+static void el_async_rotate(FAR struct el_async_s *as)
+{
+  char from[PATH_MAX];
+  char to[PATH_MAX];
+  int i;
+
+  close(as->fd);
+  as->fd = -1;
+
+  if (as->cfg.rotate_count <= 0)
+    {
+      el_async_open(as, O_TRUNC);
+      as->stats.rotations++;
+      return;
+    }
+
+  for (i = as->cfg.rotate_count - 1; i > 0; i--)
+    {
+      snprintf(from, sizeof(from), "%s.%d", as->cfg.path, i);
+      snprintf(to, sizeof(to), "%s.%d", as->cfg.path, i + 1);
+      rename(from, to);
+    }
+
+  snprintf(to, sizeof(to), "%s.1", as->cfg.path);
+  rename(as->cfg.path, to);
+
+  el_async_open(as, O_TRUNC);
+  as->stats.rotations++;
+}
+
+/****************************************************************************
+ * Name: el_async_output
+ *
+ * Description:
+ *   Write one buffer to the log file, rotating first if it would not fit.
+ *   A missing file (removed media, say) is opened again on the next batch.
+ *
+ ****************************************************************************/
+
+static void el_async_output(FAR struct el_async_s *as,
+                            FAR const uint8_t *buf, size_t len)
+{
+  ssize_t ret;
+  size_t done = 0;
+
+  if (as->fd < 0 && el_async_open(as, 0) < 0)
+    {
+      as->stats.errors++;
+      return;
+    }
+
+  if (as->cfg.rotate_size > 0 && as->fsize > 0 &&
+      as->fsize + len > as->cfg.rotate_size)
+    {
+      el_async_rotate(as);
+      if (as->fd < 0)
+        {
+          as->stats.errors++;
+          return;
+        }
+    }
+
+  while (done < len)
+    {
+      ret = write(as->fd, buf + done, len - done);
+      if (ret < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          close(as->fd);
+          as->fd = -1;
+          as->stats.errors++;
+          return;
+        }
+
+      done += ret;
+    }
+
+  as->fsize += len;
+  as->stats.written += len;
+  as->stats.writes++;
+}
+
+/****************************************************************************
+ * Name: el_async_commit
+ *
+ * Description:
+ *   Hand the batch to the output: one write, compressed into one LZF block
+ *   when enabled.
+ *
+ ****************************************************************************/
+
+static void el_async_commit(FAR struct el_async_s *as)
+{
+#ifdef CONFIG_EMBEDLOG_ASYNC_LZF
+  FAR struct el_async_lzf_s *lzf = as->lzf;
+  FAR struct lzf_header_s *hdr;
+  size_t len;
+#endif
+
+  if (as->blen == 0)
+    {
+      return;
+    }
+
+#ifdef CONFIG_EMBEDLOG_ASYNC_LZF
+  if (lzf != NULL)
+    {
+      /* lzf_compress() stores incompressible data with a header placed in
+       * the headroom in front of the batch.
+       */
+
+      len = lzf_compress(as->batch, as->blen, &lzf->out[LZF_MAX_HDR_SIZE],
+                         as->blen > 4 ? as->blen - 4 : as->blen,
+                         lzf->htab, &hdr);
+      el_async_output(as, (FAR const uint8_t *)hdr, len);
+    }
+  else
+#endif
+    {
+      el_async_output(as, as->batch, as->blen);
+    }
+
+  as->blen = 0;
+}
+
+/****************************************************************************
+ * Name: el_async_emit
+ *
+ * Description:
+ *   Append bytes to the batch, committing every time it fills up.
+ *
+ ****************************************************************************/
+
+static void el_async_emit(FAR struct el_async_s *as,
+                          FAR const uint8_t *buf, size_t len)
+{
+  size_t n;
+
+  while (len > 0)
+    {
+      n = as->cfg.batchsize - as->blen;
+      if (n > len)
+        {
+          n = len;
+        }
+
+      memcpy(as->batch + as->blen, buf, n);
+      as->blen += n;
+      buf      += n;
+      len      -= n;
+
+      if (as->blen == as->cfg.batchsize)
+        {
+          el_async_commit(as);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: el_async_drain
+ *
+ * Description:
+ *   Move every queued record to the output.  Called with wlock held.
+ *
+ * Returned Value:
+ *   The number of records drained.
+ *
+ ****************************************************************************/
+
+static int el_async_drain(FAR struct el_async_s *as)
+{
+  FAR struct el_async_ring_s *ring;
+  uint8_t frame[EL_ASYNC_HDRSIZE];
+  uint16_t len;
+  size_t head;
+  size_t tail;
+  size_t n;
+  int count = 0;
+
+  for (ring = atomic_load(&as->rings); ring != NULL; ring = ring->flink)
+    {
+      tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+      head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+      while (tail != head)
+        {
+          el_async_copyout(ring, tail, &len, sizeof(len));
+          tail += EL_ASYNC_HDRSIZE;
+
+          if (as->cfg.path == NULL)
+            {
+              /* syslog bridge: one call per record, without the line
+               * feed embedlog ends its messages with.
+               */
+
+              n = len < as->cfg.batchsize ? len : as->cfg.batchsize;
+              el_async_copyout(ring, tail, as->batch, n);
+              while (n > 0 && as->batch[n - 1] == '\n')
+                {
+                  n--;
+                }
+
+              syslog(as->cfg.syslog_priority, "%.*s", (int)n, as->batch);
+              as->stats.writes++;
+              as->stats.written += n;
+            }
+          else
+            {
+              if (as->cfg.binary)
+                {
+                  frame[0] = len & 0xff;
+                  frame[1] = len >> 8;
+                  el_async_emit(as, frame, sizeof(frame));
+                }
+
+              /* The record may wrap around the end of the ring */
+
+              n = ring->mask + 1 - (tail & ring->mask);
+              if (n > len)
+                {
+                  n = len;
+                }
+
+              el_async_emit(as, ring->data + (tail & ring->mask), n);
+              el_async_emit(as, ring->data, len - n);
+            }
+
+          tail += len;
+          as->stats.records++;
+          as->stats.bytes += len;
+          count++;
+        }
+
+      atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+
+  return count;
+}
+
+/****************************************************************************
+ * Name: el_async_writer
+ ****************************************************************************/
+
+static FAR void *el_async_writer(FAR void *arg)
+{
+  FAR struct el_async_s *as = arg;
+  struct timespec ts;
+  int count;
+
+  while (!atomic_load(&as->stop))
+    {
+      clock_gettime(CLOCK_REALTIME, &ts);
+      ts.tv_sec  += as->cfg.interval / 1000;
+      ts.tv_nsec += (as->cfg.interval % 1000) * 1000000;
+      if (ts.tv_nsec >= 1000000000)
+        {
+          ts.tv_sec++;
+          ts.tv_nsec -= 1000000000;
+        }
+
+      sem_timedwait(&as->wake, &ts);
+      atomic_store(&as->kicked, false);
+
+      pthread_mutex_lock(&as->wlock);
+      count = el_async_drain(as);
+
+      /* Only full batches go out while records keep coming; the rest is
+       * written once the producers have been quiet for an interval.
+       */
+
+      if (count == 0)
+        {
+          el_async_commit(as);
+        }
+
+      pthread_mutex_unlock(&as->wlock);
+    }
+
+  el_async_flush(as);
+  return NULL;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: el_async_config_default
+ ****************************************************************************/
+
+void el_async_config_default(FAR struct el_async_config_s *cfg)
+{
+  memset(cfg, 0, sizeof(*cfg));
+  cfg->ringsize        = CONFIG_EMBEDLOG_ASYNC_RINGSIZE;
+  cfg->batchsize       = CONFIG_EMBEDLOG_ASYNC_BATCHSIZE;
+  cfg->interval        = CONFIG_EMBEDLOG_ASYNC_INTERVAL;
+  cfg->priority        = CONFIG_EMBEDLOG_ASYNC_PRIORITY;
+  cfg->syslog_priority = LOG_INFO;
+}
+
+/****************************************************************************
+ * Name: el_async_init
+ ****************************************************************************/
+
+int el_async_init(FAR struct el_async_s *as,
+                  FAR const struct el_async_config_s *cfg)
+{
+  struct sched_param param;
+  pthread_attr_t attr;
+  size_t size;
+  int ret;
+
+  memset(as, 0, sizeof(*as));
+  as->cfg = *cfg;
+  as->fd  = -1;
+
+  if (as->cfg.batchsize == 0 || as->cfg.batchsize > EL_ASYNC_MAXREC ||
+      as->cfg.ringsize <= EL_ASYNC_HDRSIZE || as->cfg.interval <= 0)
+    {
+      return -EINVAL;
+    }
+
+#ifdef CONFIG_EMBEDLOG_ASYNC_LZF
+  if (as->cfg.compress && as->cfg.path != NULL)
+    {
+      size = sizeof(struct el_async_lzf_s) + LZF_MAX_HDR_SIZE +
+             as->cfg.batchsize;
+      as->lzf = malloc(size);
+      if (as->lzf == NULL)
+        {
+          return -ENOMEM;
+        }
+    }
+#else
+  if (as->cfg.compress)
+    {
+      return -ENOSYS;
+    }
+#endif
+
+  size = EL_ASYNC_HEADROOM + as->cfg.batchsize;
+  as->batch = malloc(size);
+  if (as->batch == NULL)
+    {
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  as->batch += EL_ASYNC_HEADROOM;
+
+  if (as->cfg.path != NULL)
+    {
+      ret = el_async_open(as, 0);
+      if (ret < 0)
+        {
+          goto errout_with_batch;
+        }
+    }
+
+  ret = -pthread_key_create(&as->key, el_async_ring_release);
+  if (ret < 0)
+    {
+      goto errout_with_fd;
+    }
+
+  pthread_mutex_init(&as->reglock, NULL);
+  pthread_mutex_init(&as->wlock, NULL);
+  sem_init(&as->wake, 0, 0);
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, CONFIG_EMBEDLOG_ASYNC_STACKSIZE);
+  param.sched_priority = as->cfg.priority;
+  pthread_attr_setschedparam(&attr, &param);
+
+  ret = -pthread_create(&as->writer, &attr, el_async_writer, as);
+  pthread_attr_destroy(&attr);
+  if (ret < 0)
+    {
+      goto errout_with_key;
+    }
+
+  pthread_setname_np(as->writer, "el_async");
+  return 0;
+
+errout_with_key:
+  sem_destroy(&as->wake);
+  pthread_mutex_destroy(&as->wlock);
+  pthread_mutex_destroy(&as->reglock);
+  pthread_key_delete(as->key);
+errout_with_fd:
+  if (as->fd >= 0)
+    {
+      close(as->fd);
+    }
+
+errout_with_batch:
+  free(as->batch - EL_ASYNC_HEADROOM);
+errout:
+  free(as->lzf);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: el_async_deinit
+ ****************************************************************************/
+
+void el_async_deinit(FAR struct el_async_s *as)
+{
+  FAR struct el_async_ring_s *ring;
+  FAR struct el_async_ring_s *next;
+
+  atomic_store(&as->stop, true);
+  sem_post(&as->wake);
+  pthread_join(as->writer, NULL);
+
+  for (ring = atomic_load(&as->rings); ring != NULL; ring = next)
+    {
+      next = ring->flink;
+      free(ring);
+    }
+
+  pthread_key_delete(as->key);
+  sem_destroy(&as->wake);
+  pthread_mutex_destroy(&as->wlock);
+  pthread_mutex_destroy(&as->reglock);
+
+  if (as->fd >= 0)
+    {
+      close(as->fd);
+    }
+
+  free(as->batch - EL_ASYNC_HEADROOM);
+  free(as->lzf);
+}
+
+/****************************************************************************
+ * Name: el_async_attach
+ ****************************************************************************/
+
+int el_async_attach(FAR struct el_async_s *as, FAR struct el *el)
+{
+  if (el_ooption(el, EL_CUSTOM_PUT, el_async_put, as) != 0 ||
+      el_ooption(el, EL_OUT, EL_OUT_CUSTOM) != 0)
+    {
+      return -errno;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: el_async_write
+ ****************************************************************************/
+
+int el_async_write(FAR struct el_async_s *as, FAR const void *data,
+                   size_t len)
+{
+  FAR struct el_async_ring_s *ring;
+  uint16_t reclen = len;
+  size_t head;
+  size_t tail;
+  size_t need;
+
+  ring = el_async_ring_get(as);
+  if (ring == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  need = EL_ASYNC_HDRSIZE + len;
+  if (len > EL_ASYNC_MAXREC || need > ring->mask + 1)
+    {
+      atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+      return -EMSGSIZE;
+    }
+
+  head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+  if (ring->mask + 1 - (head - tail) < need)
+    {
+      atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+      return -ENOBUFS;
+    }
+
+  el_async_copyin(ring, head, &reclen, sizeof(reclen));
+  el_async_copyin(ring, head + EL_ASYNC_HDRSIZE, data, len);
+  atomic_store_explicit(&ring->head, head + need, memory_order_release);
+
+  /* Wake the writer early once the ring is half full */
+
+  if (head + need - tail > (ring->mask + 1) / 2 &&
+      !atomic_exchange(&as->kicked, true))
+    {
+      sem_post(&as->wake);
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: el_async_put
+ ****************************************************************************/
+
+int el_async_put(FAR const char *s, size_t slen, FAR void *user)
+{
+  return el_async_write(user, s, slen) < 0 ? -1 : 0;
+}
+
+/****************************************************************************
+ * Name: el_async_flush
+ ****************************************************************************/
+
+int el_async_flush(FAR struct el_async_s *as)
+{
+  pthread_mutex_lock(&as->wlock);
+  el_async_drain(as);
+  el_async_commit(as);
+
+  if (as->fd >= 0)
+    {
+      fsync(as->fd);
+    }
+
+  pthread_mutex_unlock(&as->wlock);
+  return as->fd >= 0 || as->cfg.path == NULL ? 0 : -EIO;
+}
+
+/****************************************************************************
+ * Name: el_async_stats
+ ****************************************************************************/
+
+void el_async_stats(FAR struct el_async_s *as,
+                    FAR struct el_async_stats_s *stats)
+{
+  FAR struct el_async_ring_s *ring;
+
+  pthread_mutex_lock(&as->wlock);
+  *stats = as->stats;
+  pthread_mutex_unlock(&as->wlock);
+
+  stats->dropped = 0;
+  stats->rings   = 0;
+  for (ring = atomic_load(&as->rings); ring != NULL; ring = ring->flink)
+    {
+      stats->rings++;
+      stats->dropped += atomic_load_explicit(&ring->dropped,
+                                             memory_order_relaxed);
+    }
+}
@@ -0,0 +1,337 @@
+/****************************************************************************
+ * apps/math/spectrum/spectrum.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "math/spectrum.h"
+
+/* kissfft has no config header, its scalar type is selected here */
+
+#ifdef CONFIG_MATH_KISSFFT_FIXED16
+#  define FIXED_POINT 16
+#endif
+
+#include "kiss_fftr.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_MATH_KISSFFT_FIXED16
+#  define SPECTRUM_WIN_ONE        32767.0f
+#  define SPECTRUM_WINDOW(x, w)   ((int16_t)(((int32_t)(x) * (w)) >> 15))
+#  define SPECTRUM_POWER(c)       ((uint32_t)((int32_t)(c).r * (c).r) + \
+                                   (uint32_t)((int32_t)(c).i * (c).i))
+#else
+#  define SPECTRUM_WIN_ONE        1.0f
+#  define SPECTRUM_WINDOW(x, w)   ((x) * (w))
+#  define SPECTRUM_POWER(c)       ((c).r * (c).r + (c).i * (c).i)
+#endif
+
+#ifndef M_PI
+#  define M_PI 3.14159265358979323846
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_MATH_KISSFFT_FIXED16
+typedef uint64_t spectrum_acc_t;
+#else
+typedef float    spectrum_acc_t;
+#endif
+
+struct spectrum_s
+{
+  struct spectrum_cfg_s      cfg;
+  kiss_fftr_cfg              fft;     /* Points into fftmem */
+  FAR void                  *fftmem;
+  FAR spectrum_sample_t     *buf;     /* Input samples, nfft */
+  FAR spectrum_sample_t     *win;     /* Window coefficients, nfft */
+  FAR kiss_fft_scalar       *in;      /* Windowed frame, nfft */
+  FAR kiss_fft_cpx          *out;     /* FFT output, nbins */
+  FAR spectrum_acc_t        *acc;     /* Power sum, nbins */
+  FAR spectrum_power_t      *power;   /* Averaged power, nbins */
+  size_t                     nbins;
+  size_t                     fill;    /* Samples in buf */
+  uint16_t                   frames;  /* Frames in acc */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: spectrum_window_init
+ ****************************************************************************/
+
+static void spectrum_window_init(FAR struct spectrum_s *s)
+{
+  float  a0;
+  float  w;
+  size_t i;
+
+  switch (s->cfg.window)
+    {
+      case SPECTRUM_WINDOW_HANN:
+        a0 = 0.5f;
+        break;
+
+      case SPECTRUM_WINDOW_HAMMING:
+        a0 = 0.54f;
+        break;
+
+      default:
+        a0 = 1.0f;
+        break;
+    }
+
+  /* Periodic window, which is what overlapped spectral averaging wants */
+
+  for (i = 0; i < s->cfg.nfft; i++)
+    {
+      w = a0 - (1.0f - a0) * cosf(2.0f * M_PI * i / s->cfg.nfft);
+      s->win[i] = (spectrum_sample_t)(w * SPECTRUM_WIN_ONE);
+    }
+}
+
+/****************************************************************************
+ * Name: spectrum_publish
+ ****************************************************************************/
+
+static void spectrum_publish(FAR struct spectrum_s *s)
+{
+  size_t k;
+
+  for (k = 0; k < s->nbins; k++)
+    {
+      s->power[k] = (spectrum_power_t)(s->acc[k] / s->frames);
+      s->acc[k]   = 0;
+    }
+
+  s->frames = 0;
+
+  if (s->cfg.cb != NULL)
+    {
+      s->cfg.cb(s->cfg.priv, s->power, s->nbins);
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: spectrum_create
+ ****************************************************************************/
+
+FAR struct spectrum_s *spectrum_create(FAR const struct spectrum_cfg_s *cfg)
+{
+  FAR struct spectrum_s *s;
+  size_t                 lenmem = 0;
+  size_t                 nfft;
+
+  DEBUGASSERT(cfg);
+
+  nfft = cfg->nfft;
+  if (nfft < 4 || (nfft & 1) != 0 || cfg->hop == 0 || cfg->hop > nfft ||
+      cfg->navg == 0)
+    {
+      return NULL;
+    }
+
+  s = zalloc(sizeof(struct spectrum_s));
+  if (s == NULL)
+    {
+      return NULL;
+    }
+
+  memcpy(&s->cfg, cfg, sizeof(struct spectrum_cfg_s));
+  s->nbins = nfft / 2 + 1;
+
+  /* The kissfft port does not allocate, query the size and pass memory */
+
+  kiss_fftr_alloc(nfft, 0, NULL, &lenmem);
+
+  s->fftmem = malloc(lenmem);
+  s->buf    = malloc(nfft * sizeof(spectrum_sample_t));
+  s->win    = malloc(nfft * sizeof(spectrum_sample_t));
+  s->in     = malloc(nfft * sizeof(kiss_fft_scalar));
+  s->out    = malloc(s->nbins * sizeof(kiss_fft_cpx));
+  s->acc    = zalloc(s->nbins * sizeof(spectrum_acc_t));
+  s->power  = malloc(s->nbins * sizeof(spectrum_power_t));
+
+  if (s->fftmem == NULL || s->buf == NULL || s->win == NULL ||
+      s->in == NULL || s->out == NULL || s->acc == NULL ||
+      s->power == NULL)
+    {
+      goto errout;
+    }
+
+  s->fft = kiss_fftr_alloc(nfft, 0, s->fftmem, &lenmem);
+  if (s->fft == NULL)
+    {
+      goto errout;
+    }
+
+  spectrum_window_init(s);
+  return s;
+
+errout:
+  spectrum_destroy(s);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: spectrum_destroy
+ ****************************************************************************/
+
+void spectrum_destroy(FAR struct spectrum_s *s)
+{
+  if (s == NULL)
+    {
+      return;
+    }
+
+  free(s->fftmem);
+  free(s->buf);
+  free(s->win);
+  free(s->in);
+  free(s->out);
+  free(s->acc);
+  free(s->power);
+  free(s);
+}
+
+/****************************************************************************
+ * Name: spectrum_reset
+ ****************************************************************************/
+
+void spectrum_reset(FAR struct spectrum_s *s)
+{
+  DEBUGASSERT(s);
+
+  memset(s->acc, 0, s->nbins * sizeof(spectrum_acc_t));
+  s->fill   = 0;
+  s->frames = 0;
+}
+
+/****************************************************************************
+ * Name: spectrum_frame
+ ****************************************************************************/
+
+int spectrum_frame(FAR struct spectrum_s *s,
+                   FAR const spectrum_sample_t *frame)
+{
+  size_t i;
+
+  DEBUGASSERT(s);
+  DEBUGASSERT(frame);
+
+  for (i = 0; i < s->cfg.nfft; i++)
+    {
+      s->in[i] = SPECTRUM_WINDOW(frame[i], s->win[i]);
+    }
+
+  kiss_fftr(s->fft, s->in, s->out);
+
+  for (i = 0; i < s->nbins; i++)
+    {
+      s->acc[i] += SPECTRUM_POWER(s->out[i]);
+    }
+
+  if (++s->frames < s->cfg.navg)
+    {
+      return 0;
+    }
+
+  spectrum_publish(s);
+  return 1;
+}
+
+/****************************************************************************
+ * Name: spectrum_push
+ ****************************************************************************/
+
+int spectrum_push(FAR struct spectrum_s *s,
+                  FAR const spectrum_sample_t *samples, size_t n)
+{
+  size_t nfft;
+  size_t keep;
+  size_t chunk;
+  int    ret = 0;
+
+  DEBUGASSERT(s);
+  DEBUGASSERT(samples || n == 0);
+
+  nfft = s->cfg.nfft;
+  keep = nfft - s->cfg.hop;
+
+  while (n > 0)
+    {
+      chunk = nfft - s->fill;
+      if (chunk > n)
+        {
+          chunk = n;
+        }
+
+      memcpy(&s->buf[s->fill], samples, chunk * sizeof(spectrum_sample_t));
+      s->fill += chunk;
+      samples += chunk;
+      n       -= chunk;
+
+      if (s->fill < nfft)
+        {
+          break;
+        }
+
+      ret += spectrum_frame(s, s->buf);
+
+      /* Keep the overlapping tail for the next frame */
+
+      memmove(s->buf, &s->buf[s->cfg.hop], keep * sizeof(spectrum_sample_t));
+      s->fill = keep;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: spectrum_nbins
+ ****************************************************************************/
+
+size_t spectrum_nbins(FAR struct spectrum_s *s)
+{
+  DEBUGASSERT(s);
+
+  return s->nbins;
+}
@@ -0,0 +1,426 @@
+/****************************************************************************
+ * apps/math/spectrum/spectrum_main.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef CONFIG_UORB
+#  include <sensor/accel.h>
+#endif
+
+#include "math/spectrum.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define SPECTRUM_BLOCK       256   /* Samples read per block */
+#define SPECTRUM_NFFT_DEF    1024
+#define SPECTRUM_NAVG_DEF    4
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct spectrum_tool_s
+{
+  FAR FILE *out;          /* Binary output, NULL to print peaks */
+  uint32_t  count;        /* Spectra delivered */
+  uint32_t  limit;        /* Stop after this many spectra, 0 = never */
+  float     rate;         /* Sample rate for bin frequencies, 0 = none */
+  size_t    nfft;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_UORB
+static spectrum_sample_t g_block[SPECTRUM_BLOCK];
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: spectrum_usage
+ ****************************************************************************/
+
+static void spectrum_usage(FAR const char *progname)
+{
+  printf("Usage: %s [options] <-i file | -u axis>\n", progname);
+  printf("  -i file  raw input samples, see -t\n");
+  printf("  -t type  input sample type: f32 or s16 (default: s16)\n");
+#ifdef CONFIG_UORB
+  printf("  -u axis  read sensor_accel topic axis x, y or z\n");
+#endif
+  printf("  -n nfft  FFT size (default: %d)\n", SPECTRUM_NFFT_DEF);
+  printf("  -p pct   frame overlap in percent (default: 50)\n");
+  printf("  -w win   window: rect, hann or hamming (default: hann)\n");
+  printf("  -a navg  frames averaged per spectrum (default: %d)\n",
+         SPECTRUM_NAVG_DEF);
+  printf("  -r rate  sample rate in Hz, used to print frequencies\n");
+  printf("  -c num   stop after num spectra\n");
+  printf("  -o file  write spectra as raw power arrays instead of "
+         "printing the peak bin\n");
+}
+
+/****************************************************************************
+ * Name: spectrum_print
+ ****************************************************************************/
+
+static void spectrum_print(FAR void *priv, FAR const spectrum_power_t *power,
+                           size_t nbins)
+{
+  FAR struct spectrum_tool_s *tool = priv;
+  size_t                      peak = 1;
+  size_t                      k;
+
+  tool->count++;
+
+  if (tool->out != NULL)
+    {
+      fwrite(power, sizeof(spectrum_power_t), nbins, tool->out);
+      return;
+    }
+
+  /* Skip DC when looking for the peak */
+
+  for (k = 2; k < nbins; k++)
+    {
+      if (power[k] > power[peak])
+        {
+          peak = k;
+        }
+    }
+
+  printf("%" PRIu32 ": peak bin %zu", tool->count, peak);
+  if (tool->rate > 0.0f)
+    {
+      printf(" (%.1f Hz)", tool->rate * peak / tool->nfft);
+    }
+
+#ifdef CONFIG_MATH_KISSFFT_FIXED16
+  printf(" power %" PRIu32 "\n", power[peak]);
+#else
+  printf(" power %g\n", power[peak]);
+#endif
+}
+
+/****************************************************************************
+ * Name: spectrum_convert
+ *
+ * Description:
+ *   Convert 'n' raw samples in place to spectrum_sample_t.  float input
+ *   is at least as wide as the result and is converted front to back.
+ *   int16_t input converted to float grows: sample i is written over the
+ *   bytes of samples 2i and 2i + 1, so that loop must run back to front,
+ *   where every source sample is read before it is overwritten.
+ *
+ ****************************************************************************/
+
+static void spectrum_convert(FAR void *raw, size_t n, bool f32)
+{
+  FAR spectrum_sample_t *dst = (FAR spectrum_sample_t *)raw;
+  size_t                 i;
+
+  if (f32)
+    {
+      FAR float *src = raw;
+
+      for (i = 0; i < n; i++)
+        {
+#ifdef CONFIG_MATH_KISSFFT_FIXED16
+          float v = src[i] * 32767.0f;
+
+          dst[i] = v > 32767.0f ? 32767 : v < -32768.0f ? -32768 : v;
+#else
+          dst[i] = src[i];
+#endif
+        }
+    }
+  else
+    {
+      FAR int16_t *src = raw;
+
+#ifdef CONFIG_MATH_KISSFFT_FIXED16
+      UNUSED(src);
+      UNUSED(dst);
+#else
+      /* Back to front, see above */
+
+      for (i = n; i-- > 0; )
+        {
+          dst[i] = src[i] / 32768.0f;
+        }
+#endif
+    }
+}
+
+/****************************************************************************
+ * Name: spectrum_file
+ ****************************************************************************/
+
+static int spectrum_file(FAR struct spectrum_s *s,
+                         FAR struct spectrum_tool_s *tool,
+                         FAR const char *path, bool f32)
+{
+  static float raw[SPECTRUM_BLOCK];
+  size_t       size = f32 ? sizeof(float) : sizeof(int16_t);
+  ssize_t      nread = 0;
+  int          fd;
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+    {
+      printf("ERROR: failed to open %s: %d\n", path, errno);
+      return -errno;
+    }
+
+  while (tool->limit == 0 || tool->count < tool->limit)
+    {
+      nread = read(fd, raw, SPECTRUM_BLOCK * size);
+      if (nread <= 0)
+        {
+          break;
+        }
+
+      spectrum_convert(raw, nread / size, f32);
+      spectrum_push(s, (FAR const spectrum_sample_t *)raw, nread / size);
+    }
+
+  close(fd);
+  return nread < 0 ? -errno : OK;
+}
+
+#ifdef CONFIG_UORB
+/****************************************************************************
+ * Name: spectrum_uorb
+ ****************************************************************************/
+
+static int spectrum_uorb(FAR struct spectrum_s *s,
+                         FAR struct spectrum_tool_s *tool, char axis)
+{
+  static struct sensor_accel data[SPECTRUM_BLOCK / 8];
+  struct pollfd              fds;
+  ssize_t                    nread;
+  size_t                     n;
+  size_t                     i;
+  int                        fd;
+
+  fd = orb_subscribe(ORB_ID(sensor_accel));
+  if (fd < 0)
+    {
+      printf("ERROR: failed to subscribe sensor_accel: %d\n", errno);
+      return -errno;
+    }
+
+  fds.fd     = fd;
+  fds.events = POLLIN;
+
+  while (tool->limit == 0 || tool->count < tool->limit)
+    {
+      if (poll(&fds, 1, -1) <= 0)
+        {
+          continue;
+        }
+
+      /* Drain everything queued since the last wakeup in one copy */
+
+      nread = orb_copy_multi(fd, data, sizeof(data));
+      if (nread <= 0)
+        {
+          continue;
+        }
+
+      n = nread / sizeof(struct sensor_accel);
+      for (i = 0; i < n; i++)
+        {
+          float v = axis == 'x' ? data[i].x :
+                    axis == 'y' ? data[i].y : data[i].z;
+
+#ifdef CONFIG_MATH_KISSFFT_FIXED16
+          /* Scale +-1 in the sensor unit to full range */
+
+          v *= 32767.0f;
+          g_block[i] = v > 32767.0f ? 32767 : v < -32768.0f ? -32768 : v;
+#else
+          g_block[i] = v;
+#endif
+        }
+
+      spectrum_push(s, g_block, n);
+    }
+
+  orb_unsubscribe(fd);
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct spectrum_tool_s tool;
+  struct spectrum_cfg_s  cfg;
+  FAR struct spectrum_s *s;
+  FAR const char        *input   = NULL;
+  FAR const char        *output  = NULL;
+  bool                   f32     = false;
+  char                   axis    = 0;
+  int                    overlap = 50;
+  int                    ret;
+  int                    opt;
+
+  memset(&tool, 0, sizeof(tool));
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.nfft   = SPECTRUM_NFFT_DEF;
+  cfg.window = SPECTRUM_WINDOW_HANN;
+  cfg.navg   = SPECTRUM_NAVG_DEF;
+
+  while ((opt = getopt(argc, argv, "i:t:u:n:p:w:a:r:c:o:h")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'i':
+            input = optarg;
+            break;
+
+          case 't':
+            f32 = strcmp(optarg, "f32") == 0;
+            break;
+
+          case 'u':
+            axis = optarg[0];
+            break;
+
+          case 'n':
+            cfg.nfft = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'p':
+            overlap = atoi(optarg);
+            break;
+
+          case 'w':
+            cfg.window = strcmp(optarg, "rect") == 0 ?
+                         SPECTRUM_WINDOW_RECT :
+                         strcmp(optarg, "hamming") == 0 ?
+                         SPECTRUM_WINDOW_HAMMING : SPECTRUM_WINDOW_HANN;
+            break;
+
+          case 'a':
+            cfg.navg = atoi(optarg);
+            break;
+
+          case 'r':
+            tool.rate = strtof(optarg, NULL);
+            break;
+
+          case 'c':
+            tool.limit = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'o':
+            output = optarg;
+            break;
+
+          case 'h':
+          default:
+            spectrum_usage(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+  if ((input == NULL && axis == 0) || overlap < 0 || overlap > 99)
+    {
+      spectrum_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  cfg.hop  = cfg.nfft - cfg.nfft * overlap / 100;
+  cfg.cb   = spectrum_print;
+  cfg.priv = &tool;
+  tool.nfft = cfg.nfft;
+
+  s = spectrum_create(&cfg);
+  if (s == NULL)
+    {
+      printf("ERROR: invalid configuration or out of memory\n");
+      return EXIT_FAILURE;
+    }
+
+  if (output != NULL)
+    {
+      tool.out = fopen(output, "wb");
+      if (tool.out == NULL)
+        {
+          printf("ERROR: failed to open %s: %d\n", output, errno);
+          spectrum_destroy(s);
+          return EXIT_FAILURE;
+        }
+    }
+
+  if (input != NULL)
+    {
+      ret = spectrum_file(s, &tool, input, f32);
+    }
+  else
+    {
+#ifdef CONFIG_UORB
+      ret = spectrum_uorb(s, &tool, axis);
+#else
+      ret = -ENOSYS;
+#endif
+    }
+
+  if (tool.out != NULL)
+    {
+      fclose(tool.out);
+    }
+
+  spectrum_destroy(s);
+
+  printf("%" PRIu32 " spectra, %zu bins each\n", tool.count,
+         cfg.nfft / 2 + 1);
+  return ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,559 @@
+/****************************************************************************
+ * apps/mlearning/tflite-micro/tflm_bench.cc
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_OPS_MAX     32     /* Operators in the resolver */
+#define BENCH_TAGS_MAX    48     /* Distinct profiled tags */
+#define BENCH_DEPTH_MAX   8      /* Nested profiler events */
+#define BENCH_ARENA_MAX   (16 * 1024 * 1024)
+#define BENCH_ARENA_SLACK 16     /* Arena start alignment */
+
+#ifdef CMSIS_NN
+#  define BENCH_KERNELS   "cmsis-nn"
+#else
+#  define BENCH_KERNELS   "reference"
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+namespace
+{
+
+/* Accumulated time of one profiler tag (operator name) */
+
+struct bench_tag_s
+{
+  const char *name;
+  uint32_t    count;
+  uint64_t    total;
+  uint64_t    max;
+};
+
+/* MicroProfiler replacement that aggregates operator time over many
+ * inferences instead of logging every event.
+ */
+
+class BenchProfiler : public tflite::MicroProfilerInterface
+{
+public:
+  uint32_t BeginEvent(const char *tag) override
+  {
+    if (!enabled_ || depth_ >= BENCH_DEPTH_MAX)
+      {
+        return BENCH_DEPTH_MAX;
+      }
+
+    stack_[depth_].tag   = Lookup(tag);
+    stack_[depth_].start = Now();
+    return depth_++;
+  }
+
+  void EndEvent(uint32_t handle) override
+  {
+    uint64_t elapsed;
+
+    if (handle >= BENCH_DEPTH_MAX || handle + 1 != depth_)
+      {
+        return;
+      }
+
+    depth_--;
+    elapsed = Now() - stack_[handle].start;
+
+    if (stack_[handle].tag != nullptr)
+      {
+        stack_[handle].tag->count += 1;
+        stack_[handle].tag->total += elapsed;
+        stack_[handle].tag->max    = std::max(stack_[handle].tag->max,
+                                              elapsed);
+      }
+  }
+
+  void Enable(bool enable)
+  {
+    enabled_ = enable;
+  }
+
+  int Tags(void) const
+  {
+    return ntags_;
+  }
+
+  struct bench_tag_s *Tag(int i)
+  {
+    return &tags_[i];
+  }
+
+  static uint64_t Now(void)
+  {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+  }
+
+private:
+  struct bench_tag_s *Lookup(const char *tag)
+  {
+    int i;
+
+    /* Tags are operator names owned by the registrations, so the
+     * pointer comparison hits on every call after the first one.
+     */
+
+    for (i = 0; i < ntags_; i++)
+      {
+        if (tags_[i].name == tag || strcmp(tags_[i].name, tag) == 0)
+          {
+            return &tags_[i];
+          }
+      }
+
+    if (ntags_ >= BENCH_TAGS_MAX)
+      {
+        return nullptr;
+      }
+
+    tags_[ntags_].name = tag;
+    return &tags_[ntags_++];
+  }
+
+  struct
+  {
+    struct bench_tag_s *tag;
+    uint64_t            start;
+  } stack_[BENCH_DEPTH_MAX];
+
+  struct bench_tag_s tags_[BENCH_TAGS_MAX] = {};
+  uint32_t           depth_                = 0;
+  int                ntags_                = 0;
+  bool               enabled_              = false;
+};
+
+typedef tflite::MicroMutableOpResolver<BENCH_OPS_MAX> BenchResolver;
+
+}  // namespace
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void usage(void)
+{
+  printf("\nRun a tflite model and report inference time.\n"
+    "[ -i <str> ] Model file path.\n"
+    "[ -n <int> ] Number of timed inferences (default 100).\n"
+    "[ -w <int> ] Number of warm-up inferences (default 1).\n"
+    "[ -a <int> ] Fixed arena size, disables arena sizing.\n"
+    "[ -o       ] Skip the per-operator profiling pass.\n"
+    "[ -c       ] Print the results as CSV.\n"
+    "[ -h       ] Print this message.\n");
+}
+
+static void resolver_init(BenchResolver &resolver)
+{
+  resolver.AddAdd();
+  resolver.AddAveragePool2D();
+  resolver.AddConcatenation();
+  resolver.AddConv2D();
+  resolver.AddDepthwiseConv2D();
+  resolver.AddDequantize();
+  resolver.AddFullyConnected();
+  resolver.AddHardSwish();
+  resolver.AddLogistic();
+  resolver.AddMaxPool2D();
+  resolver.AddMean();
+  resolver.AddMul();
+  resolver.AddPack();
+  resolver.AddPad();
+  resolver.AddQuantize();
+  resolver.AddRelu();
+  resolver.AddRelu6();
+  resolver.AddReshape();
+  resolver.AddShape();
+  resolver.AddSoftmax();
+  resolver.AddSplit();
+  resolver.AddSqueeze();
+  resolver.AddStridedSlice();
+  resolver.AddSub();
+  resolver.AddTanh();
+  resolver.AddTranspose();
+  resolver.AddUnpack();
+}
+
+static uint8_t *model_load(const char *path, size_t *size)
+{
+  uint8_t *buf;
+  FILE    *fp;
+  long     len;
+
+  fp = fopen(path, "rb");
+  if (fp == nullptr)
+    {
+      printf("ERROR: failed to open %s\n", path);
+      return nullptr;
+    }
+
+  fseek(fp, 0, SEEK_END);
+  len = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+
+  buf = len > 0 ? new (std::nothrow) uint8_t[len] : nullptr;
+  if (buf == nullptr || fread(buf, 1, len, fp) != (size_t)len)
+    {
+      printf("ERROR: failed to read %s\n", path);
+      delete[] buf;
+      fclose(fp);
+      return nullptr;
+    }
+
+  fclose(fp);
+  *size = len;
+  return buf;
+}
+
+/* Create an interpreter and allocate its tensors.  With 'grow' set the
+ * arena is doubled until the model fits.
+ */
+
+static tflite::MicroInterpreter *
+interpreter_create(const tflite::Model *model, BenchResolver &resolver,
+                   BenchProfiler &profiler, std::unique_ptr<uint8_t[]> &arena,
+                   size_t *size, bool grow)
+{
+  tflite::MicroInterpreter *interp;
+
+  for (; ; )
+    {
+      arena.reset(new (std::nothrow) uint8_t[*size]);
+      if (!arena)
+        {
+          printf("ERROR: failed to allocate %zu byte arena\n", *size);
+          return nullptr;
+        }
+
+      interp = new (std::nothrow) tflite::MicroInterpreter(model, resolver,
+                                    arena.get(), *size, nullptr, &profiler);
+      if (interp == nullptr)
+        {
+          return nullptr;
+        }
+
+      if (interp->AllocateTensors() == kTfLiteOk)
+        {
+          return interp;
+        }
+
+      delete interp;
+
+      if (!grow || *size * 2 > BENCH_ARENA_MAX)
+        {
+          printf("ERROR: model does not fit in %zu byte arena\n", *size);
+          return nullptr;
+        }
+
+      *size *= 2;
+    }
+}
+
+/* Fill the inputs with a fixed pseudo-random pattern so that runs are
+ * repeatable and data-dependent kernels do not see all zeros.
+ */
+
+static void inputs_fill(tflite::MicroInterpreter *interp)
+{
+  uint32_t seed = 1;
+  size_t   i;
+  size_t   j;
+
+  for (i = 0; i < interp->inputs_size(); i++)
+    {
+      TfLiteTensor *t = interp->input(i);
+
+      for (j = 0; j < t->bytes; j++)
+        {
+          seed = seed * 1103515245 + 12345;
+          t->data.uint8[j] = seed >> 24;
+        }
+    }
+}
+
+static uint64_t percentile(const std::vector<uint64_t> &v, int pct)
+{
+  size_t idx = v.size() * pct / 100;
+
+  return v[std::min(idx, v.size() - 1)];
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+extern "C" int main(int argc, FAR char *argv[])
+{
+  const char *modelFileName = nullptr;
+  bool        fixedArena    = false;
+  bool        profileOps    = true;
+  bool        csv           = false;
+  size_t      arenaSize     = CONFIG_TFLITEMICRO_BENCH_ARENA;
+  size_t      arenaUsed;
+  size_t      modelSize     = 0;
+  uint64_t    total         = 0;
+  uint64_t    start;
+  int         iterations    = 100;
+  int         warmup        = 1;
+  int         ch;
+  int         i;
+
+  while ((ch = getopt(argc, argv, "i:n:w:a:och")) != EOF)
+    {
+      switch (ch)
+        {
+          case 'i':
+            modelFileName = optarg;
+            break;
+          case 'n':
+            iterations = atoi(optarg);
+            break;
+          case 'w':
+            warmup = atoi(optarg);
+            break;
+          case 'a':
+            arenaSize  = strtoul(optarg, NULL, 0);
+            fixedArena = true;
+            break;
+          case 'o':
+            profileOps = false;
+            break;
+          case 'c':
+            csv = true;
+            break;
+          case 'h':
+          default:
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+  if (modelFileName == nullptr || iterations <= 0 || arenaSize == 0)
+    {
+      usage();
+      return EXIT_FAILURE;
+    }
+
+  std::unique_ptr<uint8_t[]> pModel(model_load(modelFileName, &modelSize));
+  if (!pModel)
+    {
+      return EXIT_FAILURE;
+    }
+
+  const tflite::Model *model = tflite::GetModel(pModel.get());
+
+  BenchResolver resolver;
+  resolver_init(resolver);
+
+  BenchProfiler              profiler;
+  std::unique_ptr<uint8_t[]> pArena;
+  std::unique_ptr<tflite::MicroInterpreter> interp(
+    interpreter_create(model, resolver, profiler, pArena, &arenaSize,
+                       !fixedArena));
+  if (!interp)
+    {
+      return EXIT_FAILURE;
+    }
+
+  arenaUsed = interp->arena_used_bytes();
+
+  /* Trim the arena to what the model needs so that the run uses the
+   * same memory footprint a deployment would.
+   */
+
+  if (!fixedArena && arenaUsed + BENCH_ARENA_SLACK < arenaSize)
+    {
+      size_t                     trimSize = arenaUsed + BENCH_ARENA_SLACK;
+      std::unique_ptr<uint8_t[]> pTrimmed;
+
+      interp.reset();
+      interp.reset(interpreter_create(model, resolver, profiler, pTrimmed,
+                                      &trimSize, false));
+      if (interp)
+        {
+          pArena     = std::move(pTrimmed);
+          arenaSize  = trimSize;
+          arenaUsed  = interp->arena_used_bytes();
+        }
+      else
+        {
+          interp.reset(interpreter_create(model, resolver, profiler,
+                                          pArena, &arenaSize, false));
+          if (!interp)
+            {
+              return EXIT_FAILURE;
+            }
+        }
+    }
+
+  inputs_fill(interp.get());
+
+  for (i = 0; i < warmup; i++)
+    {
+      if (interp->Invoke() != kTfLiteOk)
+        {
+          printf("ERROR: Invoke failed\n");
+          return EXIT_FAILURE;
+        }
+    }
+
+  /* Latency pass, without profiler overhead */
+
+  std::vector<uint64_t> lat;
+  lat.reserve(iterations);
+
+  for (i = 0; i < iterations; i++)
+    {
+      start = BenchProfiler::Now();
+      if (interp->Invoke() != kTfLiteOk)
+        {
+          printf("ERROR: Invoke failed\n");
+          return EXIT_FAILURE;
+        }
+
+      lat.push_back(BenchProfiler::Now() - start);
+      total += lat.back();
+    }
+
+  /* Per-operator pass */
+
+  if (profileOps)
+    {
+      profiler.Enable(true);
+      for (i = 0; i < iterations; i++)
+        {
+          interp->Invoke();
+        }
+
+      profiler.Enable(false);
+    }
+
+  std::sort(lat.begin(), lat.end());
+
+  if (csv)
+    {
+      printf("kernels,model,model_bytes,arena_bytes,arena_used,"
+             "runs,min_us,p50_us,p90_us,p99_us,max_us,mean_us\n");
+      printf("%s,%s,%zu,%zu,%zu,%d,%llu,%llu,%llu,%llu,%llu,%llu\n",
+             BENCH_KERNELS, modelFileName, modelSize, arenaSize, arenaUsed,
+             iterations,
+             (unsigned long long)lat.front() / 1000,
+             (unsigned long long)percentile(lat, 50) / 1000,
+             (unsigned long long)percentile(lat, 90) / 1000,
+             (unsigned long long)percentile(lat, 99) / 1000,
+             (unsigned long long)lat.back() / 1000,
+             (unsigned long long)(total / iterations) / 1000);
+    }
+  else
+    {
+      printf("kernels:   %s\n", BENCH_KERNELS);
+      printf("model:     %s (%zu bytes)\n", modelFileName, modelSize);
+      printf("arena:     %zu bytes used of %zu\n", arenaUsed, arenaSize);
+      printf("latency:   %d runs [us]\n", iterations);
+      printf("  min %llu p50 %llu p90 %llu p99 %llu max %llu mean %llu\n",
+             (unsigned long long)lat.front() / 1000,
+             (unsigned long long)percentile(lat, 50) / 1000,
+             (unsigned long long)percentile(lat, 90) / 1000,
+             (unsigned long long)percentile(lat, 99) / 1000,
+             (unsigned long long)lat.back() / 1000,
+             (unsigned long long)(total / iterations) / 1000);
+    }
+
+  if (profileOps)
+    {
+      uint64_t opsTotal = 0;
+
+      for (i = 0; i < profiler.Tags(); i++)
+        {
+          opsTotal += profiler.Tag(i)->total;
+        }
+
+      if (csv)
+        {
+          printf("op,calls,total_us,avg_us,max_us,percent\n");
+        }
+      else
+        {
+          printf("%-24s %8s %10s %8s %8s %6s\n", "operator", "calls",
+                 "total_us", "avg_us", "max_us", "%");
+        }
+
+      for (i = 0; i < profiler.Tags(); i++)
+        {
+          struct bench_tag_s *tag = profiler.Tag(i);
+          unsigned long long  avg = 0;
+          double              pct = 0.0;
+
+          if (tag->count > 0)
+            {
+              avg = tag->total / tag->count / 1000;
+            }
+
+          if (opsTotal > 0)
+            {
+              pct = 100.0 * tag->total / opsTotal;
+            }
+
+          printf(csv ? "%s,%lu,%llu,%llu,%llu,%.1f\n" :
+                 "%-24s %8lu %10llu %8llu %8llu %6.1f\n",
+                 tag->name, (unsigned long)tag->count,
+                 (unsigned long long)tag->total / 1000, avg,
+                 (unsigned long long)tag->max / 1000, pct);
+        }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -42,6 +42,9 @@
  * Included Files
  ****************************************************************************/
 
+#include <stdbool.h>
+#include <string.h>
+
 #include "ppp_conf.h"
 #include "ppp.h"
 
@@ -57,33 +60,168 @@
 #  define PACKET_TX_DEBUG 0
 #endif
 
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* HDLC address and control fields */
+
+static const uint8_t g_acfc[2] =
+{
+  0xff, 0x03
+};
+
+/* FCS-16 lookup table (RFC 1662, appendix C.2) */
+
+static const uint16_t g_fcstab[256] =
+{
+  0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
+  0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
+  0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
+  0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
+  0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
+  0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
+  0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
+  0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
+  0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
+  0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
+  0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
+  0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
+  0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
+  0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
+  0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
+  0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
+  0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
+  0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
+  0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
+  0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
+  0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
+  0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
+  0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
+  0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
+  0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
+  0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
+  0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
+  0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
+  0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
+  0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
+  0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
+  0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78
+};
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
 /****************************************************************************
- * Simple and fast CRC16 routine for embedded processors.
+ * crcadd(crcvalue, c) - add one byte to the running FCS-16.
  *
- *    Just slightly slower than the table lookup method but consumes
- *    almost no space.  Much faster and smaller than the loop and
- *    shift method that is widely used in the embedded space.
- *    Can be optimized even more in .ASM
+ ****************************************************************************/
+
+static inline uint16_t crcadd(uint16_t crcvalue, uint8_t c)
+{
+  return (crcvalue >> 8) ^ g_fcstab[(crcvalue ^ c) & 0xff];
+}
+
+/****************************************************************************
+ * ahdlc_fcs(crcvalue, buffer, len) - add a run of bytes to the running
+ *    FCS-16.
  *
- *    data = (crcvalue ^ inputchar) & 0xff;
- *    data = (data ^ (data << 4)) & 0xff;
- *    crc = (crc >> 8) ^ ((data << 8) ^ (data <<3) ^ (data >> 4))
+ ****************************************************************************/
+
+static uint16_t ahdlc_fcs(uint16_t crcvalue, FAR const uint8_t *buffer,
+                          uint16_t len)
+{
+  while (len-- > 0)
+    {
+      crcvalue = crcadd(crcvalue, *buffer++);
+    }
+
+  return crcvalue;
+}
+
+/****************************************************************************
+ * ahdlc_tx_flush(ctx) - write the framed bytes collected in the tx buffer
+ *    to the serial device.
+ *
+ ****************************************************************************/
+
+static void ahdlc_tx_flush(FAR struct ppp_context_s *ctx)
+{
+  if (ctx->tty_txlen > 0)
+    {
+      ppp_arch_write(ctx, ctx->tty_txbuf, ctx->tty_txlen);
+      ctx->tty_txlen = 0;
+    }
+}
+
+/****************************************************************************
+ * ahdlc_tx_flag(ctx) - queue a frame delimiter.
  *
  ****************************************************************************/
 
-static uint16_t crcadd(uint16_t crcvalue, uint8_t c)
+static void ahdlc_tx_flag(FAR struct ppp_context_s *ctx)
 {
-  uint16_t b;
+  if (ctx->tty_txlen >= PPP_TTY_BUFFER_SIZE)
+    {
+      ahdlc_tx_flush(ctx);
+    }
+
+  ctx->tty_txbuf[ctx->tty_txlen++] = 0x7e;
+}
+
+/****************************************************************************
+ * ahdlc_tx_bytes(ctx, protocol, buffer, len) - queue a run of frame bytes,
+ *    escape if necessary.
+ *
+ * Relies on local global vars   :    ahdlc_tx_crc, ahdlc_flags.
+ * Modifies local global vars    :    ahdlc_tx_crc, tty_txbuf, tty_txlen.
+ *
+ ****************************************************************************/
+
+static void ahdlc_tx_bytes(FAR struct ppp_context_s *ctx, uint16_t protocol,
+                           FAR const uint8_t *buffer, uint16_t len)
+{
+  FAR uint8_t *txbuf = ctx->tty_txbuf;
+  uint16_t crc = ctx->ahdlc_tx_crc;
+  uint16_t txlen = ctx->tty_txlen;
+  bool escctl;
+  uint8_t c;
 
-  b = (crcvalue ^ c) & 0xff;
-  b = (b ^ (b << 4)) & 0xff;
-  b = (b << 8) ^ (b << 3) ^ (b >> 4);
+  /* We always escape 0x7d and 0x7e, in the case of char < 0x20 we only
+   * support async map of default or none, so escape if ASYNC map is not
+   * set.  We may want to modify this to support ASYNC map.
+   */
+
+  escctl = protocol == LCP || (ctx->ahdlc_flags & PPP_TX_ASYNC_MAP) == 0;
+
+  while (len-- > 0)
+    {
+      c   = *buffer++;
+      crc = crcadd(crc, c);
+
+      /* Leave room for an escaped byte */
+
+      if (txlen > PPP_TTY_BUFFER_SIZE - 2)
+        {
+          ctx->tty_txlen = txlen;
+          ahdlc_tx_flush(ctx);
+          txlen = 0;
+        }
+
+      if (c == 0x7d || c == 0x7e || (c < 0x20 && escctl))
+        {
+          /* Send escape char and xor byte by 0x20 */
+
+          txbuf[txlen++] = 0x7d;
+          c ^= 0x20;
+        }
 
-  return ((crcvalue >> 8) ^ b);
+      txbuf[txlen++] = c;
+    }
+
+  ctx->ahdlc_tx_crc = crc;
+  ctx->tty_txlen    = txlen;
 }
 
 /****************************************************************************
@@ -102,6 +240,12 @@ void ahdlc_init(struct ppp_context_s *ctx)
   ctx->ahdlc_rx_count = 0;
   ctx->ahdlc_tx_offline = 0;
 
+  /* Drop anything left over in the serial buffers */
+
+  ctx->tty_rxpos = 0;
+  ctx->tty_rxlen = 0;
+  ctx->tty_txlen = 0;
+
 #ifdef PPP_STATISTICS
   ctx->ahdlc_crc_error = 0;
   ctx->ahdlc_rx_tobig_error = 0;
@@ -298,36 +442,61 @@ uint8_t ahdlc_rx(FAR struct ppp_context_s *ctx, uint8_t c)
 }
 
 /****************************************************************************
- * ahdlc_tx_char(char) - write a character to the serial device,
- * escape if necessary.
+ * ahdlc_rx_block(buffer, len) - process a block of received bytes.
  *
- * Relies on local global vars   :    ahdlc_tx_crc, ahdlc_flags.
- * Modifies local global vars    :    ahdlc_tx_crc.
+ *    Runs of plain bytes inside a frame are checked and copied in one go;
+ *    flags, escapes and the start of a frame go through ahdlc_rx().
+ *    Processing stops after a frame carrying an IP packet was delivered,
+ *    so that the caller can forward it before the buffer is reused.
+ *
+ *    Returns the number of bytes consumed.
  *
  ****************************************************************************/
 
-void ahdlc_tx_char(struct ppp_context_s *ctx, uint16_t protocol, uint8_t c)
+uint16_t ahdlc_rx_block(FAR struct ppp_context_s *ctx,
+                        FAR const uint8_t *buffer, uint16_t len)
 {
-  /* Add in crc */
+  FAR const uint8_t *ptr = buffer;
+  FAR const uint8_t *end = buffer + len;
+  FAR const uint8_t *run;
+  FAR const uint8_t *limit;
+  uint16_t count;
 
-  ctx->ahdlc_tx_crc = crcadd(ctx->ahdlc_tx_crc, c);
+  while (ptr < end && ctx->ip_len == 0)
+    {
+      count = ctx->ahdlc_rx_count;
 
-  /* See if we need to escape char, we always escape 0x7d and 0x7e, in the
-   * case of char < 0x20 we only support async map of default or none, so
-   * escape if ASYNC map is not set.  We may want to modify this to support
-   * ASYNC map.
-   */
+      if ((ctx->ahdlc_flags & (PPP_RX_READY | PPP_ESCAPED |
+                               PPP_RX_ASYNC_MAP)) ==
+          (PPP_RX_READY | PPP_RX_ASYNC_MAP) &&
+          count > 0 && count < PPP_RX_BUFFER_SIZE)
+        {
+          limit = end;
+          if (limit - ptr > PPP_RX_BUFFER_SIZE - count)
+            {
+              limit = ptr + (PPP_RX_BUFFER_SIZE - count);
+            }
 
-  if ((c == 0x7d) || (c == 0x7e) || ((c < 0x20) &&
-      ((protocol == LCP) || (ctx->ahdlc_flags & PPP_TX_ASYNC_MAP) == 0)))
-    {
-      /* Send escape char and xor byte by 0x20 */
+          for (run = ptr; run < limit && *run != 0x7e && *run != 0x7d;
+               run++)
+            {
+            }
+
+          if (run > ptr)
+            {
+              ctx->ahdlc_rx_crc = ahdlc_fcs(ctx->ahdlc_rx_crc, ptr,
+                                            run - ptr);
+              memcpy(&ctx->ahdlc_rx_buffer[count], ptr, run - ptr);
+              ctx->ahdlc_rx_count = count + (run - ptr);
+              ptr = run;
+              continue;
+            }
+        }
 
-      ppp_arch_putchar(ctx, 0x7d);
-      c ^= 0x20;
+      ahdlc_rx(ctx, *ptr++);
     }
 
-  ppp_arch_putchar(ctx, c);
+  return ptr - buffer;
 }
 
 /****************************************************************************
@@ -345,8 +514,8 @@ uint8_t ahdlc_tx(struct ppp_context_s *ctx, uint16_t protocol,
                  FAR uint8_t * header, FAR uint8_t * buffer,
                  uint16_t headerlen, uint16_t datalen)
 {
+  uint8_t proto[2];
   uint16_t i;
-  uint8_t c;
 
   DEBUG1(("\nAHDLC_TX - transmit frame, protocol 0x%04x, length %d "
           "offline %d\n",
@@ -380,7 +549,7 @@ uint8_t ahdlc_tx(struct ppp_context_s *ctx, uint16_t protocol,
 
   /* Write leading 0x7e */
 
-  ppp_arch_putchar(ctx, 0x7e);
+  ahdlc_tx_flag(ctx);
 
   /* Set initial CRC value */
 
@@ -394,50 +563,33 @@ uint8_t ahdlc_tx(struct ppp_context_s *ctx, uint16_t protocol,
 
   if ((0 == (ctx->ahdlc_flags & PPP_ACFC)) || (protocol == LCP))
     {
-      ahdlc_tx_char(ctx, protocol, 0xff);
-      ahdlc_tx_char(ctx, protocol, 0x03);
+      ahdlc_tx_bytes(ctx, protocol, g_acfc, sizeof(g_acfc));
     }
 
   /* Write Protocol */
 
-  ahdlc_tx_char(ctx, protocol, (uint8_t)(protocol >> 8));
-  ahdlc_tx_char(ctx, protocol, (uint8_t)(protocol & 0xff));
-
-  /* Write header if it exists */
-
-  for (i = 0; i < headerlen; ++i)
-    {
-      /* Get next byte from buffer */
+  proto[0] = (uint8_t)(protocol >> 8);
+  proto[1] = (uint8_t)(protocol & 0xff);
+  ahdlc_tx_bytes(ctx, protocol, proto, 2);
 
-      c = header[i];
+  /* Write header if it exists, then the frame bytes */
 
-      /* Write it... */
-
-      ahdlc_tx_char(ctx, protocol, c);
-    }
-
-  /* Write frame bytes */
-
-  for (i = 0; i < datalen; ++i)
-    {
-      /* Get next byte from buffer */
-
-      c = buffer[i];
-
-      /* Write it... */
-
-      ahdlc_tx_char(ctx, protocol, c);
-    }
+  ahdlc_tx_bytes(ctx, protocol, header, headerlen);
+  ahdlc_tx_bytes(ctx, protocol, buffer, datalen);
 
   /* Send crc, lsb then msb */
 
   i = ctx->ahdlc_tx_crc ^ 0xffff;
-  ahdlc_tx_char(ctx, protocol, (uint8_t)(i & 0xff));
-  ahdlc_tx_char(ctx, protocol, (uint8_t)((i >> 8) & 0xff));
+  proto[0] = (uint8_t)(i & 0xff);
+  proto[1] = (uint8_t)((i >> 8) & 0xff);
+  ahdlc_tx_bytes(ctx, protocol, proto, 2);
 
-  /* Write trailing 0x7e, probably not needed but it doesn't hurt */
+  /* Write trailing 0x7e, probably not needed but it doesn't hurt, and
+   * hand the whole frame to the serial device at once.
+   */
 
-  ppp_arch_putchar(ctx, 0x7e);
+  ahdlc_tx_flag(ctx);
+  ahdlc_tx_flush(ctx);
 
 #if PPP_STATISTICS
   /* Update statistics */
@@ -214,7 +214,7 @@ void ppp_send(FAR struct ppp_context_s *ctx)
 
 void ppp_poll(FAR struct ppp_context_s *ctx)
 {
-  uint8_t c;
+  ssize_t ret;
 
   ctx->ip_len = 0;
 
@@ -230,9 +230,27 @@ void ppp_poll(FAR struct ppp_context_s *ctx)
       return;
     }
 
-  while (ctx->ip_len == 0 && ppp_arch_getchar(ctx, &c))
+  /* Deframe what the serial device has, up to the next IP packet.  Bytes
+   * after that packet stay in tty_rxbuf for the next call.
+   */
+
+  while (ctx->ip_len == 0)
     {
-      ahdlc_rx(ctx, c);
+      if (ctx->tty_rxpos >= ctx->tty_rxlen)
+        {
+          ret = ppp_arch_read(ctx, ctx->tty_rxbuf, PPP_TTY_BUFFER_SIZE);
+          if (ret <= 0)
+            {
+              break;
+            }
+
+          ctx->tty_rxpos = 0;
+          ctx->tty_rxlen = ret;
+        }
+
+      ctx->tty_rxpos += ahdlc_rx_block(ctx,
+                                       &ctx->tty_rxbuf[ctx->tty_rxpos],
+                                       ctx->tty_rxlen - ctx->tty_rxpos);
     }
 
   /* If IPCP came up then our link should be up. */
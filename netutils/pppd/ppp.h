@@ -170,6 +170,14 @@ struct ppp_context_s
   uint8_t  ahdlc_flags;      /* ahdlc state flags, see above */
   uint8_t  ahdlc_tx_offline;
 
+  /* Serial I/O buffers */
+
+  uint8_t  tty_rxbuf[PPP_TTY_BUFFER_SIZE];
+  uint16_t tty_rxpos;        /* Next byte of tty_rxbuf to deframe */
+  uint16_t tty_rxlen;        /* Number of bytes in tty_rxbuf */
+  uint8_t  tty_txbuf[PPP_TTY_BUFFER_SIZE];
+  uint16_t tty_txlen;        /* Framed bytes waiting in tty_txbuf */
+
   /* Statistics counters */
 
 #ifdef PPP_STATISTICS
@@ -42,6 +42,7 @@
 
 #include <nuttx/config.h>
 
+#include <sys/types.h>
 #include <stdint.h>
 #include <string.h>
 #include <time.h>
@@ -77,8 +78,10 @@ extern "C"
 
 time_t ppp_arch_clock_seconds(void);
 
-int ppp_arch_getchar(FAR struct ppp_context_s *ctx, FAR uint8_t *p);
-int ppp_arch_putchar(FAR struct ppp_context_s *ctx, uint8_t c);
+ssize_t ppp_arch_read(FAR struct ppp_context_s *ctx, FAR uint8_t *buffer,
+                      size_t len);
+ssize_t ppp_arch_write(FAR struct ppp_context_s *ctx,
+                       FAR const uint8_t *buffer, size_t len);
 
 #undef EXTERN
 #ifdef __cplusplus
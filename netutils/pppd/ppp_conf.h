@@ -58,6 +58,8 @@
 
 #define PPP_RX_BUFFER_SIZE      1024 //1024  //GD 2048 for 1280 IPv6 MTU
 
+#define PPP_TTY_BUFFER_SIZE     CONFIG_NETUTILS_PPPD_TTY_BUFSIZE
+
 #define AHDLC_TX_OFFLINE        5
 
 #define IPCP_GET_PEER_IP        1
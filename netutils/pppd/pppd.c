@@ -274,41 +274,65 @@ time_t ppp_arch_clock_seconds(void)
 }
 
 /****************************************************************************
- * Name: ppp_arch_getchar
+ * Name: ppp_arch_read
+ *
+ * Description:
+ *   Read whatever the serial device has buffered, up to len bytes, without
+ *   blocking.  Returns the number of bytes read, or 0 if there are none.
+ *
  ****************************************************************************/
 
-int ppp_arch_getchar(FAR struct ppp_context_s *ctx, FAR uint8_t * c)
+ssize_t ppp_arch_read(FAR struct ppp_context_s *ctx, FAR uint8_t *buffer,
+                      size_t len)
 {
-  int ret;
+  ssize_t ret;
 
-  ret = read(ctx->ctl.fd, c, 1);
-  return ret == 1 ? ret : 0;
+  ret = read(ctx->ctl.fd, buffer, len);
+  return ret > 0 ? ret : 0;
 }
 
 /****************************************************************************
- * Name: ppp_arch_putchar
+ * Name: ppp_arch_write
+ *
+ * Description:
+ *   Write a block of framed bytes to the serial device.  When the device
+ *   is full, wait up to one second for room before giving up on the rest.
+ *   Returns the number of bytes written.
+ *
  ****************************************************************************/
 
-int ppp_arch_putchar(FAR struct ppp_context_s *ctx, uint8_t c)
+ssize_t ppp_arch_write(FAR struct ppp_context_s *ctx,
+                       FAR const uint8_t *buffer, size_t len)
 {
-  int ret;
   struct pollfd fds;
+  size_t nwritten = 0;
+  ssize_t ret;
 
-  ret = write(ctx->ctl.fd, &c, 1);
-  if (ret < 0 && errno == EAGAIN)
+  while (nwritten < len)
     {
+      ret = write(ctx->ctl.fd, buffer + nwritten, len - nwritten);
+      if (ret > 0)
+        {
+          nwritten += ret;
+          continue;
+        }
+
+      if (ret < 0 && errno != EAGAIN)
+        {
+          break;
+        }
+
       fds.fd = ctx->ctl.fd;
       fds.events = POLLOUT;
       fds.revents = 0;
 
-      ret = poll(&fds, 1, 1000);
-      if (ret > 0)
+      if (poll(&fds, 1, 1000) <= 0)
         {
-          ret = write(ctx->ctl.fd, &c, 1);
+          break;
         }
     }
 
-  return ret == 1 ? ret : 0;
+  return nwritten;
 }
 
 /****************************************************************************
@@ -358,7 +382,9 @@ int pppd(const struct pppd_settings_s *pppd_settings)
     {
       fds[0].revents = fds[1].revents = 0;
 
-      ret = poll(fds, 2, 1000);
+      /* Do not sleep while deframed data is still waiting in tty_rxbuf */
+
+      ret = poll(fds, 2, ctx->tty_rxpos < ctx->tty_rxlen ? 0 : 1000);
 
       if (ret > 0 && fds[0].revents & POLLIN)
         {
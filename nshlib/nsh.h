@@ -984,6 +984,12 @@ int cmd_irqinfo(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
 #ifndef CONFIG_NSH_DISABLE_DD
   int cmd_dd(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
 #endif
+#ifndef CONFIG_NSH_DISABLE_GREP
+  int cmd_grep(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
+#endif
+#ifndef CONFIG_NSH_DISABLE_HEAD
+  int cmd_head(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
+#endif
 #ifndef CONFIG_NSH_DISABLE_HEXDUMP
   int cmd_hexdump(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
 #endif
@@ -993,6 +999,15 @@ int cmd_irqinfo(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
 #ifndef CONFIG_NSH_DISABLE_LS
   int cmd_ls(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
 #endif
+#ifndef CONFIG_NSH_DISABLE_TAIL
+  int cmd_tail(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
+#endif
+#ifndef CONFIG_NSH_DISABLE_UNIQ
+  int cmd_uniq(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
+#endif
+#ifndef CONFIG_NSH_DISABLE_WC
+  int cmd_wc(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
+#endif
 #if defined(CONFIG_SYSLOG_DEVPATH) && !defined(CONFIG_NSH_DISABLE_DMESG)
   int cmd_dmesg(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
 #endif
@@ -169,7 +169,8 @@ static const struct cmdmap_s g_cmdmap[] =
 #endif
 
 #ifndef CONFIG_NSH_DISABLE_CP
-  CMD_MAP("cp",       cmd_cp,       3, 4, "[-r] <source-path> <dest-path>"),
+  CMD_MAP("cp",       cmd_cp,       3, 5,
+    "[-r] [-p] <source-path> <dest-path>"),
 #endif
 
 #ifndef CONFIG_NSH_DISABLE_CMP
@@ -268,6 +269,16 @@ static const struct cmdmap_s g_cmdmap[] =
 #  endif
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_GREP
+  CMD_MAP("grep",     cmd_grep,     2, CONFIG_NSH_MAXARGUMENTS,
+    "[-EFcinqv] <pattern> [<path> [<path> ...]]"),
+#endif
+
+#ifndef CONFIG_NSH_DISABLE_HEAD
+  CMD_MAP("head",     cmd_head,     1, CONFIG_NSH_MAXARGUMENTS,
+    "[-n <lines>] [<path> [<path> ...]]"),
+#endif
+
 #ifndef CONFIG_NSH_DISABLE_HELP
 #  ifdef CONFIG_NSH_HELP_TERSE
   CMD_MAP("help",     cmd_help,     1, 2, "[<cmd>]"),
@@ -588,6 +599,11 @@ static const struct cmdmap_s g_cmdmap[] =
   CMD_MAP("swtichboot", cmd_switchboot, 2, 2, "<image path>"),
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_TAIL
+  CMD_MAP("tail",     cmd_tail,     1, CONFIG_NSH_MAXARGUMENTS,
+    "[-n <lines>] [<path> [<path> ...]]"),
+#endif
+
 #if !defined(CONFIG_NSH_DISABLESCRIPT) && !defined(CONFIG_NSH_DISABLE_TEST)
   CMD_MAP("test",     cmd_test,
           3, CONFIG_NSH_MAXARGUMENTS, "<expression>"),
@@ -630,6 +646,10 @@ static const struct cmdmap_s g_cmdmap[] =
 #  endif
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_UNIQ
+  CMD_MAP("uniq",     cmd_uniq,     1, 5, "[-cdu] [<path>]"),
+#endif
+
 #ifndef CONFIG_NSH_DISABLE_UNSET
   CMD_MAP("unset",    cmd_unset,    2, 2, "<name>"),
 #endif
@@ -667,6 +687,11 @@ static const struct cmdmap_s g_cmdmap[] =
           2, 6, "[-n] interval [-c] count <command>"),
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_WC
+  CMD_MAP("wc",       cmd_wc,       1, CONFIG_NSH_MAXARGUMENTS,
+    "[-lwc] [<path> [<path> ...]]"),
+#endif
+
 #ifdef CONFIG_NET_TCP
 #  ifndef CONFIG_NSH_DISABLE_WGET
   CMD_MAP("wget",     cmd_wget,     2, 4, "[-o <local-path>] <url>"),
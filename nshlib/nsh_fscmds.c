@@ -25,6 +25,7 @@
  ****************************************************************************/
 
 #include <nuttx/config.h>
+#include <nuttx/clock.h>
 
 #include <sys/types.h>
 #include <sys/ioctl.h>
@@ -43,8 +44,14 @@
 #include <limits.h>
 #include <libgen.h>
 #include <errno.h>
+#include <time.h>
 #include <debug.h>
 
+#ifdef CONFIG_NSH_CP_DOUBLEBUF
+#  include <pthread.h>
+#  include <semaphore.h>
+#endif
+
 #include "nsh.h"
 
 #if !defined(CONFIG_DISABLE_MOUNTPOINT)
@@ -94,18 +101,342 @@
 #define MB                   (1UL << 20)
 #define GB                   (1UL << 30)
 
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_CP
+/* State of one file copy */
+
+struct cp_state_s
+{
+  FAR struct nsh_vtbl_s *vtbl;
+  int rdfd;
+  int wrfd;
+  bool progress;            /* -p: report progress and throughput */
+  off_t total;              /* Size of the source, 0 if unknown */
+  off_t done;               /* Bytes written so far */
+  uint64_t start;           /* Start time (usec) */
+  uint64_t report;          /* Time of the last progress report (usec) */
+#ifdef CONFIG_NSH_CP_DOUBLEBUF
+  FAR char *buf[2];         /* Filled by the reader, drained by the writer */
+  ssize_t len[2];           /* Valid data in each buffer, 0 at the end */
+  sem_t empty;              /* Buffers free for the reader */
+  sem_t full;               /* Buffers ready for the writer */
+  volatile int errcode;     /* Write failure seen by the writer thread */
+#endif
+};
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: cp_now
+ *
+ * Description:
+ *   Return the monotonic time in microseconds.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_CP
+static uint64_t cp_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * USEC_PER_SEC + ts.tv_nsec / NSEC_PER_USEC;
+}
+
+/****************************************************************************
+ * Name: cp_progress
+ *
+ * Description:
+ *   With -p, print the amount copied and the throughput about once per
+ *   second, and a summary when the copy completes.
+ *
+ ****************************************************************************/
+
+static void cp_progress(FAR struct cp_state_s *cp, bool final)
+{
+  uint64_t now = cp_now();
+  uint64_t elapsed;
+  unsigned int rate;
+
+  if (!cp->progress || (!final && now - cp->report < USEC_PER_SEC))
+    {
+      return;
+    }
+
+  cp->report = now;
+  elapsed    = now - cp->start;
+  rate       = elapsed > 0 ?
+               (unsigned int)((uint64_t)cp->done * USEC_PER_SEC /
+                              1024 / elapsed) : 0;
+
+  if (final)
+    {
+      nsh_output(cp->vtbl, "\r%" PRIu64 " bytes copied, %" PRIu64
+                 " usec, %u KB/s\n", (uint64_t)cp->done, elapsed, rate);
+    }
+  else if (cp->total > 0)
+    {
+      nsh_output(cp->vtbl, "\r%" PRIu64 "/%" PRIu64 " KB (%u%%), %u KB/s",
+                 (uint64_t)cp->done / 1024, (uint64_t)cp->total / 1024,
+                 (unsigned int)((uint64_t)cp->done * 100 / cp->total),
+                 rate);
+    }
+  else
+    {
+      nsh_output(cp->vtbl, "\r%" PRIu64 " KB, %u KB/s",
+                 (uint64_t)cp->done / 1024, rate);
+    }
+}
+
+/****************************************************************************
+ * Name: cp_write
+ *
+ * Description:
+ *   Write a whole buffer.
+ *
+ * Returned Value:
+ *   Zero on success, otherwise the errno value of the failure.
+ *
+ ****************************************************************************/
+
+static int cp_write(int fd, FAR const char *buffer, size_t len)
+{
+  ssize_t nbyteswritten;
+
+  while (len > 0)
+    {
+      nbyteswritten = write(fd, buffer, len);
+      if (nbyteswritten < 0)
+        {
+          return errno;
+        }
+
+      buffer += nbyteswritten;
+      len    -= nbyteswritten;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: cp_error
+ ****************************************************************************/
+
+static void cp_error(FAR struct nsh_vtbl_s *vtbl, FAR const char *op,
+                     int errcode)
+{
+  /* EINTR is not an error (but will still stop the copy) */
+
+  if (errcode == EINTR)
+    {
+      nsh_error(vtbl, g_fmtsignalrecvd, "cp");
+    }
+  else
+    {
+      nsh_error(vtbl, g_fmtcmdfailed, "cp", op, NSH_ERRNO_OF(errcode));
+    }
+}
+
+/****************************************************************************
+ * Name: cp_writer
+ *
+ * Description:
+ *   Writer side of the double buffered copy.  Runs until it takes an empty
+ *   buffer, which marks the end of the input.  After a write failure it
+ *   keeps releasing buffers so that the reader never blocks.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NSH_CP_DOUBLEBUF
+static FAR void *cp_writer(FAR void *arg)
+{
+  FAR struct cp_state_s *cp = arg;
+  int errcode = 0;
+  int index = 0;
+
+  for (; ; )
+    {
+      while (sem_wait(&cp->full) < 0)
+        {
+        }
+
+      if (cp->len[index] == 0)
+        {
+          break;
+        }
+
+      if (errcode == 0)
+        {
+          /* The reader polls errcode only to stop early; the final
+           * status is read after pthread_join().
+           */
+
+          errcode = cp_write(cp->wrfd, cp->buf[index], cp->len[index]);
+          if (errcode != 0)
+            {
+              cp->errcode = errcode;
+            }
+        }
+
+      sem_post(&cp->empty);
+      index ^= 1;
+    }
+
+  return NULL;
+}
+#endif
+
+/****************************************************************************
+ * Name: cp_copy
+ *
+ * Description:
+ *   Copy rdfd to wrfd through CONFIG_NSH_COPYSIZE byte buffers.  With
+ *   CONFIG_NSH_CP_DOUBLEBUF a second thread writes one buffer while the
+ *   next one is read, so that a slow source and a slow destination (two
+ *   different flash devices, say) are kept busy at the same time.  If the
+ *   buffers or the thread cannot be had, fall back to one buffer and then
+ *   to the console I/O buffer.
+ *
+ ****************************************************************************/
+
+static int cp_copy(FAR struct cp_state_s *cp)
+{
+  FAR char *iobuffer;
+  FAR char *allocbuf = NULL;
+  size_t bufsize = CONFIG_NSH_COPYSIZE;
+  ssize_t nbytesread;
+  int errcode;
+#ifdef CONFIG_NSH_CP_DOUBLEBUF
+  pthread_t writer;
+  int index = 0;
+
+  cp->buf[0] = malloc(2 * bufsize);
+  if (cp->buf[0] != NULL)
+    {
+      cp->buf[1]  = cp->buf[0] + bufsize;
+      cp->errcode = 0;
+      sem_init(&cp->empty, 0, 2);
+      sem_init(&cp->full, 0, 0);
+
+      if (pthread_create(&writer, NULL, cp_writer, cp) == 0)
+        {
+          for (; ; )
+            {
+              while (sem_wait(&cp->empty) < 0)
+                {
+                }
+
+              nbytesread = 0;
+              if (cp->errcode == 0)
+                {
+                  nbytesread = read(cp->rdfd, cp->buf[index], bufsize);
+                }
+
+              errcode = nbytesread < 0 ? errno : 0;
+              cp->len[index] = nbytesread > 0 ? nbytesread : 0;
+              sem_post(&cp->full);
+
+              if (nbytesread <= 0)
+                {
+                  break;
+                }
+
+              /* Progress counts data handed to the writer, which is at
+               * most two buffers ahead of the destination.
+               */
+
+              cp->done += nbytesread;
+              cp_progress(cp, false);
+              index ^= 1;
+            }
+
+          pthread_join(writer, NULL);
+          sem_destroy(&cp->empty);
+          sem_destroy(&cp->full);
+          free(cp->buf[0]);
+
+          if (errcode != 0)
+            {
+              cp_error(cp->vtbl, "read", errcode);
+              return ERROR;
+            }
+
+          if (cp->errcode != 0)
+            {
+              cp_error(cp->vtbl, "write", cp->errcode);
+              return ERROR;
+            }
+
+          cp_progress(cp, true);
+          return OK;
+        }
+
+      sem_destroy(&cp->empty);
+      sem_destroy(&cp->full);
+      allocbuf = cp->buf[0];
+    }
+#endif
+
+  if (allocbuf == NULL)
+    {
+      allocbuf = malloc(bufsize);
+    }
+
+  iobuffer = allocbuf;
+  if (iobuffer == NULL)
+    {
+      iobuffer = cp->vtbl->iobuffer;
+      bufsize  = IOBUFFERSIZE;
+    }
+
+  for (; ; )
+    {
+      nbytesread = read(cp->rdfd, iobuffer, bufsize);
+      if (nbytesread == 0)
+        {
+          /* End of file */
+
+          cp_progress(cp, true);
+          free(allocbuf);
+          return OK;
+        }
+      else if (nbytesread < 0)
+        {
+          cp_error(cp->vtbl, "read", errno);
+          break;
+        }
+
+      errcode = cp_write(cp->wrfd, iobuffer, nbytesread);
+      if (errcode != 0)
+        {
+          cp_error(cp->vtbl, "write", errcode);
+          break;
+        }
+
+      cp->done += nbytesread;
+      cp_progress(cp, false);
+    }
+
+  free(allocbuf);
+  return ERROR;
+}
+#endif
+
 /****************************************************************************
  * Name: cp_handler
  ****************************************************************************/
 
 #ifndef CONFIG_NSH_DISABLE_CP
 static int cp_handler(FAR struct nsh_vtbl_s *vtbl, FAR const char *srcpath,
-                      FAR const char *destpath)
+                      FAR const char *destpath, bool progress)
 {
+  struct cp_state_s cp;
   struct stat buf;
   FAR char *allocpath = NULL;
   int oflags = O_WRONLY | O_CREAT | O_TRUNC;
@@ -163,70 +494,20 @@ static int cp_handler(FAR struct nsh_vtbl_s *vtbl, FAR const char *srcpath,
       goto errout_with_allocpath;
     }
 
-  for (; ; )
-    {
-      ssize_t nbyteswritten;
-      ssize_t nbytesread;
-      FAR char *iobuffer = vtbl->iobuffer;
-
-      nbytesread = read(rdfd, iobuffer, IOBUFFERSIZE);
-      if (nbytesread == 0)
-        {
-          /* End of file */
-
-          ret = OK;
-          goto errout_with_wrfd;
-        }
-      else if (nbytesread < 0)
-        {
-          /* EINTR is not an error (but will still stop the copy) */
-
-          if (errno == EINTR)
-            {
-              nsh_error(vtbl, g_fmtsignalrecvd, "cp");
-            }
-          else
-            {
-              /* Read error */
-
-              nsh_error(vtbl, g_fmtcmdfailed, "cp", "read",
-                        NSH_ERRNO);
-            }
-
-          goto errout_with_wrfd;
-        }
-
-      do
-        {
-          nbyteswritten = write(wrfd, iobuffer, nbytesread);
-          if (nbyteswritten >= 0)
-            {
-              nbytesread -= nbyteswritten;
-              iobuffer += nbyteswritten;
-            }
-          else
-            {
-              /* EINTR is not an error (but will still stop the copy) */
-
-              if (errno == EINTR)
-                {
-                  nsh_error(vtbl, g_fmtsignalrecvd, "cp");
-                }
-              else
-                {
-                  /* Read error */
+  memset(&cp, 0, sizeof(cp));
+  cp.vtbl     = vtbl;
+  cp.rdfd     = rdfd;
+  cp.wrfd     = wrfd;
+  cp.progress = progress;
+  cp.start    = cp_now();
+  cp.report   = cp.start;
 
-                  nsh_error(vtbl, g_fmtcmdfailed, "cp", "write",
-                            NSH_ERRNO);
-                }
-
-              goto errout_with_wrfd;
-            }
-        }
-      while (nbytesread > 0);
+  if (fstat(rdfd, &buf) == 0 && S_ISREG(buf.st_mode))
+    {
+      cp.total = buf.st_size;
     }
 
-errout_with_wrfd:
+  ret = cp_copy(&cp);
   close(wrfd);
 
 errout_with_allocpath:
@@ -245,7 +526,7 @@ errout_with_rdfd:
 
 #ifndef CONFIG_NSH_DISABLE_CP
 static int cp_recursive(FAR struct nsh_vtbl_s *vtbl, FAR const char *srcpath,
-                        FAR const char *destpath)
+                        FAR const char *destpath, bool progress)
 {
   FAR struct dirent *entry;
   FAR char *allocdestpath;
@@ -302,7 +583,8 @@ static int cp_recursive(FAR struct nsh_vtbl_s *vtbl, FAR const char *srcpath,
             }
 #endif
 
-          ret = cp_recursive(vtbl, allocsrcpath, allocdestpath);
+          ret = cp_recursive(vtbl, allocsrcpath, allocdestpath,
+                             progress);
           if (ret != OK)
             {
               goto errout_with_allocdestpath;
@@ -310,7 +592,7 @@ static int cp_recursive(FAR struct nsh_vtbl_s *vtbl, FAR const char *srcpath,
         }
       else
         {
-          ret = cp_handler(vtbl, allocsrcpath, allocdestpath);
+          ret = cp_handler(vtbl, allocsrcpath, allocdestpath, progress);
           if (ret != OK)
             {
               goto errout_with_allocdestpath;
@@ -885,21 +1167,32 @@ int cmd_cp(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
   FAR char *srcpath  = NULL;
   FAR char *destpath = NULL;
   bool recursive = false;
+  bool progress = false;
   int ret = ERROR;
   int option;
 
   /* Get the cp flags */
 
-  while ((option = getopt(argc, argv, "r")) != ERROR)
+  while ((option = getopt(argc, argv, "rp")) != ERROR)
     {
       switch (option)
         {
           case 'r':
             recursive = true;
             break;
+
+          case 'p':
+            progress = true;
+            break;
         }
     }
 
+  if (argc - optind != 2)
+    {
+      nsh_error(vtbl, g_fmtargrequired, argv[0]);
+      return ERROR;
+    }
+
   /* Get the full path to the source file */
 
   srcpath = nsh_getfullpath(vtbl, argv[optind]);
@@ -928,11 +1221,11 @@ int cmd_cp(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
 
   if (recursive)
     {
-      ret = cp_recursive(vtbl, srcpath, destpath);
+      ret = cp_recursive(vtbl, srcpath, destpath, progress);
     }
   else
     {
-      ret = cp_handler(vtbl, srcpath, destpath);
+      ret = cp_handler(vtbl, srcpath, destpath, progress);
     }
 
 errout_with_destpath:
@@ -136,6 +136,7 @@ int nsh_catfile(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
                 FAR const char *filepath)
 {
   FAR char *buffer;
+  size_t bufsize;
   int fd;
   int ret = OK;
 
@@ -158,7 +159,16 @@ int nsh_catfile(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
       return ERROR;
     }
 
-  buffer = (FAR char *)malloc(IOBUFFERSIZE);
+  /* Prefer the large copy buffer; small (procfs) files do not need it */
+
+  bufsize = CONFIG_NSH_COPYSIZE;
+  buffer  = (FAR char *)malloc(bufsize);
+  if (buffer == NULL && bufsize > IOBUFFERSIZE)
+    {
+      bufsize = IOBUFFERSIZE;
+      buffer  = (FAR char *)malloc(bufsize);
+    }
+
   if (buffer == NULL)
     {
       close(fd);
@@ -170,7 +180,7 @@ int nsh_catfile(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
 
   for (; ; )
     {
-      int nbytesread = read(fd, buffer, IOBUFFERSIZE);
+      int nbytesread = read(fd, buffer, bufsize);
 
       /* Check for read errors */
 
@@ -0,0 +1,1466 @@
+/****************************************************************************
+ * apps/nshlib/nsh_textcmds.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef CONFIG_NSH_GREP_REGEX
+#  include <regex.h>
+#endif
+
+#include "nsh.h"
+#include "nsh_console.h"
+
+#if !defined(CONFIG_NSH_DISABLE_GREP) || !defined(CONFIG_NSH_DISABLE_WC) || \
+    !defined(CONFIG_NSH_DISABLE_HEAD) || \
+    !defined(CONFIG_NSH_DISABLE_TAIL) || !defined(CONFIG_NSH_DISABLE_UNIQ)
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define TEXT_BUFSIZE CONFIG_NSH_TEXTIOSIZE
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Buffered text input.  Data is consumed in blocks of complete lines so
+ * that the filters can scan many lines with one memchr()/search call.
+ */
+
+struct text_in_s
+{
+  FAR struct nsh_vtbl_s *vtbl;
+  int fd;                   /* Input file, -1 for the console */
+  size_t start;             /* First byte not consumed yet */
+  size_t end;               /* End of the valid data */
+  bool eof;                 /* No more data to read */
+  char buf[TEXT_BUFSIZE + 1];
+};
+
+/* Buffered output to the console */
+
+struct text_out_s
+{
+  FAR struct nsh_vtbl_s *vtbl;
+  size_t len;
+  char buf[TEXT_BUFSIZE];
+};
+
+#ifndef CONFIG_NSH_DISABLE_GREP
+/* Compiled grep pattern */
+
+struct grep_s
+{
+  struct text_in_s in;
+  struct text_out_s out;
+  FAR const char *pat;      /* Pattern, folded to lower case with -i */
+  size_t patlen;
+  bool literal;             /* Plain string search, no regex */
+  bool icase;               /* -i */
+  bool invert;              /* -v */
+  bool count;               /* -c */
+  bool number;              /* -n */
+  bool quiet;               /* -q */
+  bool names;               /* More than one file: prefix file names */
+  size_t shift[256];        /* Boyer-Moore-Horspool bad character shifts */
+#ifdef CONFIG_NSH_GREP_REGEX
+  regex_t re;
+#endif
+};
+#endif
+
+#ifndef CONFIG_NSH_DISABLE_UNIQ
+/* uniq state.  A line longer than the buffer arrives in several blocks;
+ * its pieces are collected in 'part' until its newline is seen.
+ */
+
+struct uniq_s
+{
+  FAR struct text_out_s *out;
+  FAR char *prev;           /* Line of the current group */
+  size_t plen;
+  size_t psize;
+  size_t repeat;            /* Lines in the group, 0 before the first */
+  FAR char *part;           /* Start of a line still missing its end */
+  size_t partlen;
+  size_t partsize;
+  bool counts;              /* -c */
+  bool dups;                /* -d */
+  bool uniq;                /* -u */
+};
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: text_open
+ *
+ * Description:
+ *   Prepare to read a file, or the console when path is NULL.
+ *
+ ****************************************************************************/
+
+static int text_open(FAR struct text_in_s *in, FAR struct nsh_vtbl_s *vtbl,
+                     FAR const char *cmd, FAR const char *path)
+{
+  FAR char *fullpath;
+
+  in->vtbl  = vtbl;
+  in->fd    = -1;
+  in->start = 0;
+  in->end   = 0;
+  in->eof   = false;
+
+  if (path == NULL)
+    {
+      return OK;
+    }
+
+  fullpath = nsh_getfullpath(vtbl, path);
+  if (fullpath == NULL)
+    {
+      nsh_error(vtbl, g_fmtcmdoutofmemory, cmd);
+      return ERROR;
+    }
+
+  in->fd = open(fullpath, O_RDONLY);
+  nsh_freefullpath(fullpath);
+
+  if (in->fd < 0)
+    {
+      nsh_error(vtbl, g_fmtcmdfailed, cmd, "open", NSH_ERRNO);
+      return ERROR;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: text_close
+ ****************************************************************************/
+
+static void text_close(FAR struct text_in_s *in)
+{
+  if (in->fd >= 0)
+    {
+      close(in->fd);
+      in->fd = -1;
+    }
+}
+
+/****************************************************************************
+ * Name: text_fill
+ *
+ * Description:
+ *   Move the unconsumed data to the front of the buffer and read more
+ *   behind it.
+ *
+ ****************************************************************************/
+
+static int text_fill(FAR struct text_in_s *in)
+{
+  ssize_t nread;
+
+  if (in->start > 0)
+    {
+      memmove(in->buf, in->buf + in->start, in->end - in->start);
+      in->end  -= in->start;
+      in->start = 0;
+    }
+
+  do
+    {
+      if (in->fd >= 0)
+        {
+          nread = read(in->fd, in->buf + in->end, TEXT_BUFSIZE - in->end);
+        }
+      else
+        {
+          nread = nsh_read(in->vtbl, in->buf + in->end,
+                           TEXT_BUFSIZE - in->end);
+        }
+    }
+  while (nread < 0 && errno == EINTR);
+
+  if (nread < 0)
+    {
+      return ERROR;
+    }
+
+  if (nread == 0)
+    {
+      in->eof = true;
+    }
+
+  in->end += nread;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: text_block
+ *
+ * Description:
+ *   Return the next run of complete lines.  The final line of the input
+ *   may lack its newline, and a line longer than the buffer is returned
+ *   in buffer sized pieces.  The byte after the block may be overwritten
+ *   by the caller until the next call.
+ *
+ * Returned Value:
+ *   The length of the block, 0 at the end of the input or ERROR.
+ *
+ ****************************************************************************/
+
+static ssize_t text_block(FAR struct text_in_s *in, FAR char **block)
+{
+  FAR char *first;
+  FAR char *last;
+  size_t len;
+
+  for (; ; )
+    {
+      first = in->buf + in->start;
+      last  = in->buf + in->end;
+
+      while (last > first && last[-1] != '\n')
+        {
+          last--;
+        }
+
+      if (last == first &&
+          (in->eof || (in->start == 0 && in->end == TEXT_BUFSIZE)))
+        {
+          last = in->buf + in->end;
+        }
+
+      if (last > first)
+        {
+          len = last - first;
+          in->start += len;
+          *block = first;
+          return len;
+        }
+
+      if (in->eof)
+        {
+          return 0;
+        }
+
+      if (text_fill(in) < 0)
+        {
+          return ERROR;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: text_flush / text_put
+ ****************************************************************************/
+
+#if !defined(CONFIG_NSH_DISABLE_GREP) || \
+    !defined(CONFIG_NSH_DISABLE_HEAD) || !defined(CONFIG_NSH_DISABLE_UNIQ)
+static int text_flush(FAR struct text_out_s *out)
+{
+  ssize_t ret = 0;
+
+  if (out->len > 0)
+    {
+      ret = nsh_write(out->vtbl, out->buf, out->len);
+      out->len = 0;
+    }
+
+  return ret < 0 ? ERROR : OK;
+}
+
+static int text_put(FAR struct text_out_s *out, FAR const char *data,
+                    size_t len)
+{
+  if (len > TEXT_BUFSIZE - out->len && text_flush(out) < 0)
+    {
+      return ERROR;
+    }
+
+  if (len >= TEXT_BUFSIZE)
+    {
+      return nsh_write(out->vtbl, data, len) < 0 ? ERROR : OK;
+    }
+
+  memcpy(out->buf + out->len, data, len);
+  out->len += len;
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: text_count
+ *
+ * Description:
+ *   Count the newlines in a buffer.
+ *
+ ****************************************************************************/
+
+#if !defined(CONFIG_NSH_DISABLE_GREP) || !defined(CONFIG_NSH_DISABLE_WC)
+static size_t text_count(FAR const char *p, size_t len)
+{
+  FAR const char *end = p + len;
+  size_t n = 0;
+
+  while ((p = memchr(p, '\n', end - p)) != NULL)
+    {
+      n++;
+      p++;
+    }
+
+  return n;
+}
+#endif
+
+/****************************************************************************
+ * Name: text_putline
+ *
+ * Description:
+ *   Output one line, adding the newline the last line of a file may lack.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_GREP
+static int text_putline(FAR struct text_out_s *out, FAR const char *line,
+                        size_t len)
+{
+  int ret = text_put(out, line, len);
+
+  if (ret == OK && (len == 0 || line[len - 1] != '\n'))
+    {
+      ret = text_put(out, "\n", 1);
+    }
+
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: text_getcount
+ *
+ * Description:
+ *   Parse the argument of -n.
+ *
+ ****************************************************************************/
+
+#if !defined(CONFIG_NSH_DISABLE_HEAD) || !defined(CONFIG_NSH_DISABLE_TAIL)
+static int text_getcount(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
+                         FAR const char *arg, FAR size_t *count)
+{
+  FAR char *endp;
+  long value;
+
+  value = strtol(arg, &endp, 10);
+  if (*arg == '\0' || *endp != '\0' || value < 0)
+    {
+      nsh_error(vtbl, g_fmtarginvalid, cmd);
+      return ERROR;
+    }
+
+  *count = value;
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: grep_compile
+ *
+ * Description:
+ *   Prepare the pattern: strings without regex special characters (or any
+ *   string with -F) are searched with Boyer-Moore-Horspool, or memchr() for
+ *   one character; anything else is compiled once with regcomp().
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_GREP
+static int grep_compile(FAR struct grep_s *g, FAR char *pat, bool fixed,
+                        bool extended)
+{
+  FAR const char *special = extended ? ".[]*^$\\+?(){}|" : ".[]*^$\\";
+  size_t i;
+
+  g->patlen  = strlen(pat);
+  g->literal = fixed || strpbrk(pat, special) == NULL;
+
+#ifdef CONFIG_NSH_GREP_REGEX
+  if (!g->literal)
+    {
+      int flags = REG_NOSUB;
+
+      if (extended)
+        {
+          flags |= REG_EXTENDED;
+        }
+
+      if (g->icase)
+        {
+          flags |= REG_ICASE;
+        }
+
+      return regcomp(&g->re, pat, flags) == 0 ? OK : ERROR;
+    }
+#else
+  g->literal = true;
+#endif
+
+  if (g->icase)
+    {
+      for (i = 0; i < g->patlen; i++)
+        {
+          pat[i] = tolower((unsigned char)pat[i]);
+        }
+    }
+
+  g->pat = pat;
+
+  for (i = 0; i < 256; i++)
+    {
+      g->shift[i] = g->patlen;
+    }
+
+  for (i = 0; i + 1 < g->patlen; i++)
+    {
+      g->shift[(unsigned char)pat[i]] = g->patlen - 1 - i;
+      if (g->icase)
+        {
+          g->shift[toupper((unsigned char)pat[i])] = g->patlen - 1 - i;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: grep_find
+ *
+ * Description:
+ *   Find the first occurrence of the literal pattern in a buffer.
+ *
+ ****************************************************************************/
+
+static FAR char *grep_find(FAR struct grep_s *g, FAR char *p, size_t len)
+{
+  FAR const char *pat = g->pat;
+  size_t last = g->patlen - 1;
+  size_t pos = 0;
+  size_t j;
+
+  if (g->patlen == 0)
+    {
+      return p;
+    }
+
+  if (g->patlen == 1 && !g->icase)
+    {
+      return memchr(p, pat[0], len);
+    }
+
+  while (pos + last < len)
+    {
+      j = last;
+      if (g->icase)
+        {
+          while (tolower((unsigned char)p[pos + j]) == pat[j])
+            {
+              if (j-- == 0)
+                {
+                  return p + pos;
+                }
+            }
+        }
+      else
+        {
+          while (p[pos + j] == pat[j])
+            {
+              if (j-- == 0)
+                {
+                  return p + pos;
+                }
+            }
+        }
+
+      pos += g->shift[(unsigned char)p[pos + last]];
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: grep_match
+ *
+ * Description:
+ *   Test one line (without its newline, len bytes at line).
+ *
+ ****************************************************************************/
+
+static bool grep_match(FAR struct grep_s *g, FAR char *line, size_t len)
+{
+#ifdef CONFIG_NSH_GREP_REGEX
+  char save;
+  bool match;
+
+  if (!g->literal)
+    {
+      /* regexec() wants a terminated string; the input buffer always has
+       * a spare byte behind the data.
+       */
+
+      save = line[len];
+      line[len] = '\0';
+      match = regexec(&g->re, line, 0, NULL, 0) == 0;
+      line[len] = save;
+      return match;
+    }
+#endif
+
+  return grep_find(g, line, len) != NULL;
+}
+
+/****************************************************************************
+ * Name: grep_emit
+ ****************************************************************************/
+
+static int grep_emit(FAR struct grep_s *g, FAR const char *name,
+                     size_t lineno, FAR const char *line, size_t len)
+{
+  char num[16];
+  int ret = OK;
+
+  if (g->count || g->quiet)
+    {
+      return OK;
+    }
+
+  if (g->names)
+    {
+      ret = text_put(&g->out, name, strlen(name));
+      if (ret == OK)
+        {
+          ret = text_put(&g->out, ":", 1);
+        }
+    }
+
+  if (ret == OK && g->number)
+    {
+      ret = text_put(&g->out, num,
+                     snprintf(num, sizeof(num), "%zu:", lineno));
+    }
+
+  if (ret == OK)
+    {
+      ret = text_putline(&g->out, line, len);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: grep_stream
+ *
+ * Description:
+ *   Filter one input.  Without -v, literal patterns are searched through
+ *   whole blocks and only the lines around the hits are looked at.
+ *
+ * Returned Value:
+ *   The number of selected lines, or ERROR.
+ *
+ ****************************************************************************/
+
+static ssize_t grep_stream(FAR struct grep_s *g, FAR const char *name)
+{
+  FAR char *block;
+  FAR char *end;
+  FAR char *hit;
+  FAR char *ls;
+  FAR char *le;
+  FAR char *p;
+  size_t lineno = 0;
+  size_t count = 0;
+  size_t len;
+  ssize_t n;
+
+  while ((n = text_block(&g->in, &block)) > 0)
+    {
+      p   = block;
+      end = block + n;
+
+      while (p < end)
+        {
+          if (g->literal && !g->invert)
+            {
+              hit = grep_find(g, p, end - p);
+              if (hit == NULL)
+                {
+                  if (g->number)
+                    {
+                      lineno += text_count(p, end - p);
+                    }
+
+                  break;
+                }
+
+              ls = hit;
+              while (ls > p && ls[-1] != '\n')
+                {
+                  ls--;
+                }
+
+              if (g->number)
+                {
+                  lineno += text_count(p, ls - p);
+                }
+            }
+          else
+            {
+              ls = p;
+            }
+
+          le  = memchr(ls, '\n', end - ls);
+          len = le != NULL ? le - ls : end - ls;
+          le  = le != NULL ? le + 1 : end;
+          lineno++;
+
+          if ((g->literal && !g->invert) ||
+              grep_match(g, ls, len) != g->invert)
+            {
+              count++;
+              if (g->quiet)
+                {
+                  return count;
+                }
+
+              if (grep_emit(g, name, lineno, ls, le - ls) < 0)
+                {
+                  return ERROR;
+                }
+            }
+
+          p = le;
+        }
+    }
+
+  if (n < 0)
+    {
+      nsh_error(g->in.vtbl, g_fmtcmdfailed, "grep", "read", NSH_ERRNO);
+      return ERROR;
+    }
+
+  return count;
+}
+#endif /* !CONFIG_NSH_DISABLE_GREP */
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: cmd_grep
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_GREP
+int cmd_grep(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
+{
+  FAR struct grep_s *g;
+  FAR const char *name;
+  bool extended = false;
+  bool fixed = false;
+  size_t total = 0;
+  ssize_t count;
+  char num[16];
+  int option;
+  int ret = OK;
+  int i;
+
+  g = zalloc(sizeof(*g));
+  if (g == NULL)
+    {
+      nsh_error(vtbl, g_fmtcmdoutofmemory, argv[0]);
+      return ERROR;
+    }
+
+  g->out.vtbl = vtbl;
+
+  while ((option = getopt(argc, argv, "EFcinqv")) != ERROR)
+    {
+      switch (option)
+        {
+          case 'E':
+            extended = true;
+            break;
+
+          case 'F':
+            fixed = true;
+            break;
+
+          case 'c':
+            g->count = true;
+            break;
+
+          case 'i':
+            g->icase = true;
+            break;
+
+          case 'n':
+            g->number = true;
+            break;
+
+          case 'q':
+            g->quiet = true;
+            break;
+
+          case 'v':
+            g->invert = true;
+            break;
+
+          default:
+            nsh_error(vtbl, g_fmtarginvalid, argv[0]);
+            free(g);
+            return ERROR;
+        }
+    }
+
+  if (optind >= argc)
+    {
+      nsh_error(vtbl, g_fmtargrequired, argv[0]);
+      free(g);
+      return ERROR;
+    }
+
+  if (grep_compile(g, argv[optind++], fixed, extended) < 0)
+    {
+      nsh_error(vtbl, g_fmtarginvalid, argv[0]);
+      free(g);
+      return ERROR;
+    }
+
+  g->names = argc - optind > 1;
+  i = optind;
+
+  do
+    {
+      name = i < argc ? argv[i] : NULL;
+      if (text_open(&g->in, vtbl, argv[0], name) < 0)
+        {
+          ret = ERROR;
+          continue;
+        }
+
+      count = grep_stream(g, name);
+      text_close(&g->in);
+
+      if (count < 0)
+        {
+          ret = ERROR;
+          break;
+        }
+
+      total += count;
+      if (g->quiet && total > 0)
+        {
+          break;
+        }
+
+      if (g->count)
+        {
+          if (g->names)
+            {
+              text_put(&g->out, name, strlen(name));
+              text_put(&g->out, ":", 1);
+            }
+
+          text_put(&g->out, num, snprintf(num, sizeof(num), "%zd\n",
+                                          count));
+        }
+    }
+  while (++i < argc);
+
+  text_flush(&g->out);
+
+#ifdef CONFIG_NSH_GREP_REGEX
+  if (!g->literal)
+    {
+      regfree(&g->re);
+    }
+#endif
+
+  free(g);
+
+  /* Like grep(1): fail when nothing was selected */
+
+  return ret == OK && total == 0 ? ERROR : ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: cmd_wc
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_WC
+int cmd_wc(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
+{
+  FAR struct text_in_s *in;
+  FAR const char *name;
+  FAR char *block;
+  size_t total[3] =
+    {
+      0, 0, 0
+    };
+
+  size_t count[3];
+  bool show[3] =
+    {
+      false, false, false
+    };
+
+  bool inword;
+  ssize_t n;
+  int option;
+  int ret = OK;
+  int files;
+  int i;
+  int j;
+
+  while ((option = getopt(argc, argv, "lwc")) != ERROR)
+    {
+      switch (option)
+        {
+          case 'l':
+            show[0] = true;
+            break;
+
+          case 'w':
+            show[1] = true;
+            break;
+
+          case 'c':
+            show[2] = true;
+            break;
+
+          default:
+            nsh_error(vtbl, g_fmtarginvalid, argv[0]);
+            return ERROR;
+        }
+    }
+
+  if (!show[0] && !show[1] && !show[2])
+    {
+      show[0] = show[1] = show[2] = true;
+    }
+
+  in = malloc(sizeof(*in));
+  if (in == NULL)
+    {
+      nsh_error(vtbl, g_fmtcmdoutofmemory, argv[0]);
+      return ERROR;
+    }
+
+  files = argc - optind;
+  i = optind;
+
+  do
+    {
+      name = i < argc ? argv[i] : NULL;
+      if (text_open(in, vtbl, argv[0], name) < 0)
+        {
+          ret = ERROR;
+          continue;
+        }
+
+      memset(count, 0, sizeof(count));
+      inword = false;
+
+      while ((n = text_block(in, &block)) > 0)
+        {
+          count[0] += text_count(block, n);
+          count[2] += n;
+
+          if (show[1])
+            {
+              for (j = 0; j < n; j++)
+                {
+                  if (isspace((unsigned char)block[j]))
+                    {
+                      inword = false;
+                    }
+                  else if (!inword)
+                    {
+                      inword = true;
+                      count[1]++;
+                    }
+                }
+            }
+        }
+
+      text_close(in);
+
+      if (n < 0)
+        {
+          nsh_error(vtbl, g_fmtcmdfailed, argv[0], "read", NSH_ERRNO);
+          ret = ERROR;
+          continue;
+        }
+
+      for (j = 0; j < 3; j++)
+        {
+          total[j] += count[j];
+          if (show[j])
+            {
+              nsh_output(vtbl, "%7zu ", count[j]);
+            }
+        }
+
+      nsh_output(vtbl, "%s\n", name != NULL ? name : "");
+    }
+  while (++i < argc);
+
+  if (files > 1)
+    {
+      for (j = 0; j < 3; j++)
+        {
+          if (show[j])
+            {
+              nsh_output(vtbl, "%7zu ", total[j]);
+            }
+        }
+
+      nsh_output(vtbl, "total\n");
+    }
+
+  free(in);
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: cmd_head
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_HEAD
+int cmd_head(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
+{
+  FAR struct text_out_s *out;
+  FAR struct text_in_s *in;
+  FAR const char *name;
+  FAR char *block;
+  FAR char *p;
+  size_t lines = 10;
+  size_t left;
+  ssize_t n;
+  int option;
+  int ret = OK;
+  int i;
+
+  while ((option = getopt(argc, argv, "n:")) != ERROR)
+    {
+      if (option != 'n' ||
+          text_getcount(vtbl, argv[0], optarg, &lines) < 0)
+        {
+          if (option != 'n')
+            {
+              nsh_error(vtbl, g_fmtarginvalid, argv[0]);
+            }
+
+          return ERROR;
+        }
+    }
+
+  in  = malloc(sizeof(*in));
+  out = malloc(sizeof(*out));
+  if (in == NULL || out == NULL)
+    {
+      nsh_error(vtbl, g_fmtcmdoutofmemory, argv[0]);
+      free(in);
+      free(out);
+      return ERROR;
+    }
+
+  out->vtbl = vtbl;
+  out->len  = 0;
+  i = optind;
+
+  do
+    {
+      name = i < argc ? argv[i] : NULL;
+      if (text_open(in, vtbl, argv[0], name) < 0)
+        {
+          ret = ERROR;
+          continue;
+        }
+
+      if (argc - optind > 1)
+        {
+          text_flush(out);
+          nsh_output(vtbl, "%s==> %s <==\n", i > optind ? "\n" : "", name);
+        }
+
+      /* Copy whole blocks until the block holding the last line.  A
+       * line only counts once its newline is seen, as a line longer
+       * than the buffer arrives in several blocks.
+       */
+
+      left = lines;
+      while (left > 0 && (n = text_block(in, &block)) > 0)
+        {
+          for (p = block; left > 0 && p < block + n; left--)
+            {
+              p = memchr(p, '\n', block + n - p);
+              if (p == NULL)
+                {
+                  p = block + n;
+                  break;
+                }
+
+              p++;
+            }
+
+          text_put(out, block, p - block);
+        }
+
+      text_close(in);
+    }
+  while (++i < argc);
+
+  text_flush(out);
+  free(in);
+  free(out);
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: cmd_tail
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_TAIL
+int cmd_tail(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
+{
+  FAR struct text_in_s *in;
+  FAR const char *name;
+  FAR char *keep = NULL;
+  FAR char *block;
+  FAR char *p;
+  size_t klen;
+  size_t lines = 10;
+  size_t found;
+  off_t pos;
+  off_t size;
+  ssize_t n;
+  int option;
+  int ret = OK;
+  int i;
+
+  while ((option = getopt(argc, argv, "n:")) != ERROR)
+    {
+      if (option != 'n' ||
+          text_getcount(vtbl, argv[0], optarg, &lines) < 0)
+        {
+          if (option != 'n')
+            {
+              nsh_error(vtbl, g_fmtarginvalid, argv[0]);
+            }
+
+          return ERROR;
+        }
+    }
+
+  in = malloc(sizeof(*in));
+  if (in == NULL)
+    {
+      nsh_error(vtbl, g_fmtcmdoutofmemory, argv[0]);
+      return ERROR;
+    }
+
+  i = optind;
+
+  do
+    {
+      name = i < argc ? argv[i] : NULL;
+      if (text_open(in, vtbl, argv[0], name) < 0)
+        {
+          ret = ERROR;
+          continue;
+        }
+
+      if (argc - optind > 1)
+        {
+          nsh_output(vtbl, "%s==> %s <==\n", i > optind ? "\n" : "", name);
+        }
+
+      size = in->fd >= 0 ? lseek(in->fd, 0, SEEK_END) : -1;
+      if (size >= 0)
+        {
+          /* Seekable file: scan backwards from the end for the start of
+           * the last lines and copy from there.  A newline ending the file
+           * does not start a line.
+           */
+
+          pos   = size;
+          found = 0;
+
+          while (pos > 0 && found < lines)
+            {
+              n = pos > TEXT_BUFSIZE ? TEXT_BUFSIZE : pos;
+              pos -= n;
+
+              if (lseek(in->fd, pos, SEEK_SET) < 0 ||
+                  read(in->fd, in->buf, n) != n)
+                {
+                  break;
+                }
+
+              for (p = in->buf + n; p > in->buf; p--)
+                {
+                  if (p[-1] == '\n' && pos + (p - in->buf) < size &&
+                      ++found >= lines)
+                    {
+                      pos += p - in->buf;
+                      break;
+                    }
+                }
+            }
+
+          lseek(in->fd, pos, SEEK_SET);
+          in->start = in->end = 0;
+          in->eof   = false;
+
+          while ((n = text_block(in, &block)) > 0)
+            {
+              nsh_write(vtbl, block, n);
+            }
+        }
+      else
+        {
+          /* Stream: keep the data read so far, cut down to the last lines
+           * whenever it grows past twice the buffer size.
+           */
+
+          klen = 0;
+          while ((n = text_block(in, &block)) > 0)
+            {
+              p = realloc(keep, klen + n);
+              if (p == NULL)
+                {
+                  nsh_error(vtbl, g_fmtcmdoutofmemory, argv[0]);
+                  ret = ERROR;
+                  break;
+                }
+
+              keep = p;
+              memcpy(keep + klen, block, n);
+              klen += n;
+
+              if (lines == 0)
+                {
+                  klen = 0;
+                  continue;
+                }
+
+              if (klen < 2 * TEXT_BUFSIZE)
+                {
+                  continue;
+                }
+
+              for (found = 0, p = keep + klen; p > keep; p--)
+                {
+                  if (p[-1] == '\n' && p < keep + klen && ++found >= lines)
+                    {
+                      break;
+                    }
+                }
+
+              klen -= p - keep;
+              memmove(keep, p, klen);
+            }
+
+          if (klen > 0)
+            {
+              for (found = 0, p = keep + klen; p > keep; p--)
+                {
+                  if (p[-1] == '\n' && p < keep + klen && ++found >= lines)
+                    {
+                      break;
+                    }
+                }
+
+              nsh_write(vtbl, p, keep + klen - p);
+            }
+        }
+
+      text_close(in);
+    }
+  while (++i < argc);
+
+  free(keep);
+  free(in);
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: uniq_store
+ *
+ * Description:
+ *   Copy 'len' bytes to offset 'off' of a growing buffer.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_UNIQ
+static int uniq_store(FAR char **buf, FAR size_t *size, size_t off,
+                      FAR const char *data, size_t len)
+{
+  FAR char *tmp;
+
+  if (off + len > *size)
+    {
+      tmp = realloc(*buf, off + len);
+      if (tmp == NULL)
+        {
+          return ERROR;
+        }
+
+      *buf  = tmp;
+      *size = off + len;
+    }
+
+  memcpy(*buf + off, data, len);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: uniq_group
+ *
+ * Description:
+ *   Print the current group, if the options select it.
+ *
+ ****************************************************************************/
+
+static void uniq_group(FAR struct uniq_s *u)
+{
+  char num[16];
+
+  if (u->repeat > 0 && (!u->dups || u->repeat > 1) &&
+      (!u->uniq || u->repeat == 1))
+    {
+      if (u->counts)
+        {
+          text_put(u->out, num,
+                   snprintf(num, sizeof(num), "%7zu ", u->repeat));
+        }
+
+      text_put(u->out, u->prev, u->plen);
+      text_put(u->out, "\n", 1);
+    }
+}
+
+/****************************************************************************
+ * Name: uniq_line
+ *
+ * Description:
+ *   Add one complete line, without its newline.
+ *
+ ****************************************************************************/
+
+static int uniq_line(FAR struct uniq_s *u, FAR const char *line,
+                     size_t len)
+{
+  if (u->repeat > 0 && len == u->plen && memcmp(line, u->prev, len) == 0)
+    {
+      u->repeat++;
+      return OK;
+    }
+
+  uniq_group(u);
+
+  if (uniq_store(&u->prev, &u->psize, 0, line, len) < 0)
+    {
+      return ERROR;
+    }
+
+  u->plen   = len;
+  u->repeat = 1;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: cmd_uniq
+ ****************************************************************************/
+
+int cmd_uniq(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
+{
+  FAR struct text_in_s *in;
+  FAR char *block = NULL;
+  FAR char *le;
+  FAR char *p;
+  struct uniq_s u;
+  ssize_t n;
+  int option;
+  int ret;
+
+  memset(&u, 0, sizeof(u));
+
+  while ((option = getopt(argc, argv, "cdu")) != ERROR)
+    {
+      switch (option)
+        {
+          case 'c':
+            u.counts = true;
+            break;
+
+          case 'd':
+            u.dups = true;
+            break;
+
+          case 'u':
+            u.uniq = true;
+            break;
+
+          default:
+            nsh_error(vtbl, g_fmtarginvalid, argv[0]);
+            return ERROR;
+        }
+    }
+
+  if (argc - optind > 1)
+    {
+      nsh_error(vtbl, g_fmttoomanyargs, argv[0]);
+      return ERROR;
+    }
+
+  in    = malloc(sizeof(*in));
+  u.out = malloc(sizeof(*u.out));
+  if (in == NULL || u.out == NULL)
+    {
+      nsh_error(vtbl, g_fmtcmdoutofmemory, argv[0]);
+      free(in);
+      free(u.out);
+      return ERROR;
+    }
+
+  u.out->vtbl = vtbl;
+  u.out->len  = 0;
+
+  ret = text_open(in, vtbl, argv[0], optind < argc ? argv[optind] : NULL);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  do
+    {
+      n = text_block(in, &block);
+      if (n < 0)
+        {
+          nsh_error(vtbl, g_fmtcmdfailed, argv[0], "read", NSH_ERRNO);
+          ret = ERROR;
+          goto errout_with_in;
+        }
+
+      for (p = block; p < block + n; p = le + 1)
+        {
+          le = memchr(p, '\n', block + n - p);
+          if (le == NULL)
+            {
+              /* The line goes on in the next block */
+
+              ret = uniq_store(&u.part, &u.partsize, u.partlen, p,
+                               block + n - p);
+              u.partlen += block + n - p;
+              break;
+            }
+
+          if (u.partlen > 0)
+            {
+              ret = uniq_store(&u.part, &u.partsize, u.partlen, p,
+                               le - p);
+              if (ret == OK)
+                {
+                  ret = uniq_line(&u, u.part, u.partlen + (le - p));
+                }
+
+              u.partlen = 0;
+            }
+          else
+            {
+              ret = uniq_line(&u, p, le - p);
+            }
+
+          if (ret < 0)
+            {
+              break;
+            }
+        }
+
+      if (ret < 0)
+        {
+          nsh_error(vtbl, g_fmtcmdoutofmemory, argv[0]);
+          goto errout_with_in;
+        }
+    }
+  while (n > 0);
+
+  /* The last line may lack its newline */
+
+  if (u.partlen > 0 && uniq_line(&u, u.part, u.partlen) < 0)
+    {
+      nsh_error(vtbl, g_fmtcmdoutofmemory, argv[0]);
+      ret = ERROR;
+      goto errout_with_in;
+    }
+
+  uniq_group(&u);
+
+errout_with_in:
+  text_close(in);
+  text_flush(u.out);
+
+errout:
+  free(u.prev);
+  free(u.part);
+  free(in);
+  free(u.out);
+  return ret;
+}
+#endif
+
+#endif /* !CONFIG_NSH_DISABLE_GREP || ... */
@@ -0,0 +1,812 @@
+/****************************************************************************
+ * apps/system/tcache/tcache.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "system/tcache.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Size classes are TCACHE_GRANULE bytes apart up to the maximum size */
+
+#define TCACHE_GRANULE     16
+#define TCACHE_NCLASSES    ((CONFIG_SYSTEM_TCACHE_MAXSIZE + \
+                             TCACHE_GRANULE - 1) / TCACHE_GRANULE)
+#define TCACHE_CLASS(s)    (((s) - 1) / TCACHE_GRANULE)
+#define TCACHE_CLASSSIZE(c) (((c) + 1) * TCACHE_GRANULE)
+
+#define TCACHE_HDRSIZE     sizeof(struct tcache_hdr_s)
+
+/* Environment variable holding the generation of the group's entry */
+
+#define TCACHE_GENVAR      "TCACHE_GROUP"
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Every block starts with this header.  Cached blocks have base == NULL
+ * and size set to their class size; the others remember what to hand
+ * back to free().  The header keeps the user pointer aligned like the
+ * heap aligns it.
+ */
+
+struct tcache_hdr_s
+{
+  size_t size;
+  FAR void *base;
+};
+
+/* A cached block links through its user area */
+
+struct tcache_block_s
+{
+  FAR struct tcache_block_s *next;
+};
+
+struct tcache_bin_s
+{
+  FAR struct tcache_block_s *head;
+  unsigned int count;
+};
+
+struct tcache_s
+{
+  struct tcache_bin_s bins[TCACHE_NCLASSES];
+  struct tcache_stats_s stats;
+};
+
+/* pthread keys belong to a task group, but in flat and protected builds
+ * this file's data is shared by every task linking it.  So each group
+ * gets its own key, created on first use and deleted when the group
+ * exits.
+ *
+ * A group that is killed never runs its atexit() handler, and its PID
+ * may later be given to an unrelated group.  So every entry also carries
+ * a generation, which the owning group keeps in its own environment; an
+ * entry only belongs to the caller when both match.  key and gen are
+ * written before pid is published, and pid is read with acquire, so a
+ * lock-free lookup never sees a half-written entry.
+ */
+
+struct tcache_group_s
+{
+  atomic_int pid;              /* Task group owning the key, 0 if free */
+  uint32_t gen;                /* Generation of the owner */
+  pthread_key_t key;
+};
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct tcache_group_s g_tcache_groups[CONFIG_SYSTEM_TCACHE_NGROUPS];
+static pthread_mutex_t g_tcache_lock = PTHREAD_MUTEX_INITIALIZER;
+#ifndef CONFIG_DISABLE_ENVIRON
+static uint32_t g_tcache_gen;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcache_hdr / tcache_user
+ ****************************************************************************/
+
+static inline FAR struct tcache_hdr_s *tcache_hdr(FAR void *ptr)
+{
+  return (FAR struct tcache_hdr_s *)((FAR uint8_t *)ptr - TCACHE_HDRSIZE);
+}
+
+static inline FAR void *tcache_user(FAR struct tcache_hdr_s *hdr)
+{
+  return (FAR uint8_t *)hdr + TCACHE_HDRSIZE;
+}
+
+/****************************************************************************
+ * Name: tcache_flush_bin
+ *
+ * Description:
+ *   Give 'count' blocks of a bin back to the heap.  Freed blocks are
+ *   pushed at the head, so these are taken from the tail: the blocks that
+ *   have been idle longest, while the recently freed ones that are still
+ *   in the CPU cache stay for the next allocations.
+ *
+ ****************************************************************************/
+
+static void tcache_flush_bin(FAR struct tcache_s *tc, int cls,
+                             unsigned int count)
+{
+  FAR struct tcache_bin_s *bin = &tc->bins[cls];
+  FAR struct tcache_block_s *block;
+  FAR struct tcache_block_s *next;
+  unsigned int keep;
+
+  if (count >= bin->count)
+    {
+      keep  = 0;
+      block = bin->head;
+      bin->head = NULL;
+    }
+  else
+    {
+      /* Cut the list after its first 'keep' blocks */
+
+      keep  = bin->count - count;
+      block = bin->head;
+      while (--keep > 0)
+        {
+          block = block->next;
+        }
+
+      next = block->next;
+      block->next = NULL;
+      block = next;
+      keep = bin->count - count;
+    }
+
+  bin->count = keep;
+
+  while (block != NULL)
+    {
+      next = block->next;
+      free(tcache_hdr(block));
+      tc->stats.flushed++;
+      tc->stats.cached -= TCACHE_CLASSSIZE(cls);
+      block = next;
+    }
+}
+
+/****************************************************************************
+ * Name: tcache_destroy
+ *
+ * Description:
+ *   Thread exit destructor of the per-thread cache.
+ *
+ ****************************************************************************/
+
+static void tcache_destroy(FAR void *arg)
+{
+  FAR struct tcache_s *tc = arg;
+  int cls;
+
+  for (cls = 0; cls < TCACHE_NCLASSES; cls++)
+    {
+      tcache_flush_bin(tc, cls, UINT_MAX);
+    }
+
+  free(tc);
+}
+
+/****************************************************************************
+ * Name: tcache_find
+ *
+ * Description:
+ *   Return the entry published for 'pid', or NULL if there is none.
+ *
+ ****************************************************************************/
+
+static FAR struct tcache_group_s *tcache_find(pid_t pid)
+{
+  int i;
+
+  for (i = 0; i < CONFIG_SYSTEM_TCACHE_NGROUPS; i++)
+    {
+      if (atomic_load_explicit(&g_tcache_groups[i].pid,
+                               memory_order_acquire) == pid)
+        {
+          return &g_tcache_groups[i];
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: tcache_mygen
+ *
+ * Description:
+ *   Return the generation recorded in the calling group's environment, 0
+ *   if it has none.  Child tasks inherit the variable, but never the PID
+ *   it was recorded with, so an inherited value matches no entry of
+ *   theirs.
+ *
+ ****************************************************************************/
+
+static uint32_t tcache_mygen(void)
+{
+#ifndef CONFIG_DISABLE_ENVIRON
+  FAR const char *value = getenv(TCACHE_GENVAR);
+
+  if (value != NULL)
+    {
+      return strtoul(value, NULL, 10);
+    }
+
+  return 0;
+#else
+  /* Without an environment PID reuse cannot be told apart; only dead
+   * owners are detected, when the table is full.
+   */
+
+  return 1;
+#endif
+}
+
+/****************************************************************************
+ * Name: tcache_release
+ *
+ * Description:
+ *   Free an entry.  The caller holds g_tcache_lock.
+ *
+ ****************************************************************************/
+
+static void tcache_release(FAR struct tcache_group_s *group)
+{
+  atomic_store_explicit(&group->pid, 0, memory_order_release);
+}
+
+/****************************************************************************
+ * Name: tcache_reclaim
+ *
+ * Description:
+ *   Free the entries of groups that no longer exist and return one free
+ *   entry, or NULL if every owner is still alive.  Their keys went away
+ *   with the groups.  The caller holds g_tcache_lock.
+ *
+ ****************************************************************************/
+
+static FAR struct tcache_group_s *tcache_reclaim(void)
+{
+  FAR struct tcache_group_s *group;
+  pid_t pid;
+  int i;
+
+  for (i = 0; i < CONFIG_SYSTEM_TCACHE_NGROUPS; i++)
+    {
+      group = &g_tcache_groups[i];
+      pid   = atomic_load_explicit(&group->pid, memory_order_relaxed);
+      if (pid != 0 && kill(pid, 0) < 0 && errno == ESRCH)
+        {
+          tcache_release(group);
+        }
+    }
+
+  return tcache_find(0);
+}
+
+/****************************************************************************
+ * Name: tcache_group_exit
+ *
+ * Description:
+ *   atexit() handler of a task group that used the cache.  Key destructors
+ *   do not run for the exiting thread, so flush its cache here, then give
+ *   the key back so that no later group inherits it.
+ *
+ ****************************************************************************/
+
+static void tcache_group_exit(void)
+{
+  FAR struct tcache_group_s *group;
+  FAR struct tcache_s *tc;
+
+  pthread_mutex_lock(&g_tcache_lock);
+
+  group = tcache_find(getpid());
+  if (group != NULL && group->gen == tcache_mygen())
+    {
+      tc = pthread_getspecific(group->key);
+      if (tc != NULL)
+        {
+          pthread_setspecific(group->key, NULL);
+          tcache_destroy(tc);
+        }
+
+      pthread_key_delete(group->key);
+      tcache_release(group);
+    }
+
+  pthread_mutex_unlock(&g_tcache_lock);
+}
+
+/****************************************************************************
+ * Name: tcache_claim
+ *
+ * Description:
+ *   Set up a free entry for the calling group.  The caller holds
+ *   g_tcache_lock.
+ *
+ ****************************************************************************/
+
+static int tcache_claim(FAR struct tcache_group_s *group, pid_t pid)
+{
+#ifndef CONFIG_DISABLE_ENVIRON
+  char value[12];
+#endif
+  uint32_t gen;
+
+#ifndef CONFIG_DISABLE_ENVIRON
+  /* 0 means "no entry" to tcache_mygen() */
+
+  gen = ++g_tcache_gen;
+  if (gen == 0)
+    {
+      gen = ++g_tcache_gen;
+    }
+
+  snprintf(value, sizeof(value), "%" PRIu32, gen);
+  if (setenv(TCACHE_GENVAR, value, 1) < 0)
+    {
+      return -errno;
+    }
+#else
+  gen = 1;
+#endif
+
+  if (pthread_key_create(&group->key, tcache_destroy) != 0)
+    {
+      return -ENOMEM;
+    }
+
+  if (atexit(tcache_group_exit) != 0)
+    {
+      pthread_key_delete(group->key);
+      return -ENOMEM;
+    }
+
+  group->gen = gen;
+  atomic_store_explicit(&group->pid, pid, memory_order_release);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: tcache_group
+ *
+ * Description:
+ *   Return the calling task group's entry, creating its key on first use.
+ *   NULL means that the group has no key and cannot get one.
+ *
+ ****************************************************************************/
+
+static FAR struct tcache_group_s *tcache_group(bool create)
+{
+  FAR struct tcache_group_s *group;
+  pid_t pid = getpid();
+  uint32_t gen = tcache_mygen();
+
+  group = tcache_find(pid);
+  if (group != NULL && group->gen == gen)
+    {
+      return group;
+    }
+
+  if (group == NULL && !create)
+    {
+      return NULL;
+    }
+
+  pthread_mutex_lock(&g_tcache_lock);
+
+  /* An entry with our PID but another generation was left behind by a
+   * dead group; its key means nothing here.
+   */
+
+  group = tcache_find(pid);
+  if (group != NULL && group->gen != gen)
+    {
+      tcache_release(group);
+      group = NULL;
+    }
+
+  if (group == NULL && create)
+    {
+      group = tcache_find(0);
+      if (group == NULL)
+        {
+          group = tcache_reclaim();
+        }
+
+      if (group != NULL && tcache_claim(group, pid) < 0)
+        {
+          group = NULL;
+        }
+    }
+
+  pthread_mutex_unlock(&g_tcache_lock);
+  return group;
+}
+
+/****************************************************************************
+ * Name: tcache_get
+ *
+ * Description:
+ *   Return the calling thread's cache, creating it on first use.  Without
+ *   a key for the task group or memory for the cache, NULL is returned
+ *   and every request goes to the heap.
+ *
+ ****************************************************************************/
+
+static FAR struct tcache_s *tcache_get(bool create)
+{
+  FAR struct tcache_group_s *group;
+  FAR struct tcache_s *tc;
+
+  group = tcache_group(create);
+  if (group == NULL)
+    {
+      return NULL;
+    }
+
+  tc = pthread_getspecific(group->key);
+  if (tc == NULL && create)
+    {
+      tc = zalloc(sizeof(struct tcache_s));
+      if (tc != NULL && pthread_setspecific(group->key, tc) != 0)
+        {
+          free(tc);
+          tc = NULL;
+        }
+    }
+
+  return tc;
+}
+
+/****************************************************************************
+ * Name: tcache_refill
+ *
+ * Description:
+ *   Take a batch of blocks of one class from the heap, in one go.  Returns
+ *   one of them, the rest are left in the bin.
+ *
+ ****************************************************************************/
+
+static FAR void *tcache_refill(FAR struct tcache_s *tc, int cls)
+{
+  FAR struct tcache_bin_s *bin = &tc->bins[cls];
+  FAR struct tcache_block_s *block = NULL;
+  FAR struct tcache_block_s *next;
+  FAR struct tcache_hdr_s *hdr;
+  size_t size = TCACHE_CLASSSIZE(cls);
+  int i;
+
+  for (i = 0; i < CONFIG_SYSTEM_TCACHE_BATCH; i++)
+    {
+      hdr = malloc(TCACHE_HDRSIZE + size);
+      if (hdr == NULL)
+        {
+          break;
+        }
+
+      hdr->size = size;
+      hdr->base = NULL;
+      tc->stats.refilled++;
+
+      if (i == 0)
+        {
+          block = tcache_user(hdr);
+          continue;
+        }
+
+      next = tcache_user(hdr);
+      next->next = bin->head;
+      bin->head = next;
+      bin->count++;
+      tc->stats.cached += size;
+    }
+
+  return block;
+}
+
+/****************************************************************************
+ * Name: tcache_large
+ *
+ * Description:
+ *   Allocate a block outside the cache, 'alignment' must be a power of
+ *   two.
+ *
+ ****************************************************************************/
+
+static FAR void *tcache_large(size_t alignment, size_t size)
+{
+  FAR struct tcache_hdr_s *hdr;
+  FAR uint8_t *base;
+
+  if (alignment <= TCACHE_HDRSIZE)
+    {
+      if (size > SIZE_MAX - TCACHE_HDRSIZE)
+        {
+          return NULL;
+        }
+
+      base = malloc(TCACHE_HDRSIZE + size);
+      hdr  = (FAR struct tcache_hdr_s *)base;
+    }
+  else
+    {
+      /* The first 'alignment' bytes only carry the header */
+
+      if (size > SIZE_MAX - alignment)
+        {
+          return NULL;
+        }
+
+      base = memalign(alignment, alignment + size);
+      hdr  = (FAR struct tcache_hdr_s *)(base + alignment -
+                                         TCACHE_HDRSIZE);
+    }
+
+  if (base == NULL)
+    {
+      return NULL;
+    }
+
+  hdr->size = size;
+  hdr->base = base;
+  return tcache_user(hdr);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcache_malloc
+ ****************************************************************************/
+
+FAR void *tcache_malloc(size_t size)
+{
+  FAR struct tcache_block_s *block;
+  FAR struct tcache_bin_s *bin;
+  FAR struct tcache_s *tc;
+  int cls;
+
+  if (size > CONFIG_SYSTEM_TCACHE_MAXSIZE)
+    {
+      tc = tcache_get(false);
+      if (tc != NULL)
+        {
+          tc->stats.large++;
+        }
+
+      return tcache_large(0, size);
+    }
+
+  cls = TCACHE_CLASS(size > 0 ? size : 1);
+  tc  = tcache_get(true);
+  if (tc == NULL)
+    {
+      FAR struct tcache_hdr_s *hdr;
+
+      /* No cache for this thread, hand out an uncached class block */
+
+      hdr = malloc(TCACHE_HDRSIZE + TCACHE_CLASSSIZE(cls));
+      if (hdr == NULL)
+        {
+          return NULL;
+        }
+
+      hdr->size = TCACHE_CLASSSIZE(cls);
+      hdr->base = NULL;
+      return tcache_user(hdr);
+    }
+
+  bin = &tc->bins[cls];
+  block = bin->head;
+  if (block == NULL)
+    {
+      tc->stats.misses++;
+      return tcache_refill(tc, cls);
+    }
+
+  bin->head = block->next;
+  bin->count--;
+  tc->stats.hits++;
+  tc->stats.cached -= TCACHE_CLASSSIZE(cls);
+  return block;
+}
+
+/****************************************************************************
+ * Name: tcache_free
+ ****************************************************************************/
+
+void tcache_free(FAR void *ptr)
+{
+  FAR struct tcache_block_s *block = ptr;
+  FAR struct tcache_hdr_s *hdr;
+  FAR struct tcache_bin_s *bin;
+  FAR struct tcache_s *tc;
+  int cls;
+
+  if (ptr == NULL)
+    {
+      return;
+    }
+
+  hdr = tcache_hdr(ptr);
+  if (hdr->base != NULL)
+    {
+      free(hdr->base);
+      return;
+    }
+
+  cls = TCACHE_CLASS(hdr->size);
+  tc  = tcache_get(true);
+  if (tc == NULL)
+    {
+      free(hdr);
+      return;
+    }
+
+  /* A full bin gives its older half back before taking this one, so
+   * that alternating bursts do not bounce single blocks.
+   */
+
+  bin = &tc->bins[cls];
+  if (bin->count >= CONFIG_SYSTEM_TCACHE_COUNT)
+    {
+      tcache_flush_bin(tc, cls, CONFIG_SYSTEM_TCACHE_COUNT / 2 + 1);
+    }
+
+  block->next = bin->head;
+  bin->head = block;
+  bin->count++;
+  tc->stats.cached += hdr->size;
+}
+
+/****************************************************************************
+ * Name: tcache_calloc
+ ****************************************************************************/
+
+FAR void *tcache_calloc(size_t nmemb, size_t size)
+{
+  FAR void *ptr;
+
+  if (size != 0 && nmemb > SIZE_MAX / size)
+    {
+      return NULL;
+    }
+
+  ptr = tcache_malloc(nmemb * size);
+  if (ptr != NULL)
+    {
+      memset(ptr, 0, nmemb * size);
+    }
+
+  return ptr;
+}
+
+/****************************************************************************
+ * Name: tcache_realloc
+ ****************************************************************************/
+
+FAR void *tcache_realloc(FAR void *ptr, size_t size)
+{
+  FAR void *newptr;
+  size_t oldsize;
+
+  if (ptr == NULL)
+    {
+      return tcache_malloc(size);
+    }
+
+  if (size == 0)
+    {
+      tcache_free(ptr);
+      return NULL;
+    }
+
+  /* Class blocks can grow up to their class size in place.  Anything else
+   * moves, which also lets a large block that shrank become a cached one.
+   */
+
+  oldsize = tcache_hdr(ptr)->size;
+  if (size <= oldsize && tcache_hdr(ptr)->base == NULL)
+    {
+      return ptr;
+    }
+
+  newptr = tcache_malloc(size);
+  if (newptr != NULL)
+    {
+      memcpy(newptr, ptr, size < oldsize ? size : oldsize);
+      tcache_free(ptr);
+    }
+
+  return newptr;
+}
+
+/****************************************************************************
+ * Name: tcache_memalign
+ ****************************************************************************/
+
+FAR void *tcache_memalign(size_t alignment, size_t size)
+{
+  if ((alignment & (alignment - 1)) != 0)
+    {
+      return NULL;
+    }
+
+  /* Class blocks are aligned like the header */
+
+  if (alignment <= TCACHE_HDRSIZE)
+    {
+      return tcache_malloc(size);
+    }
+
+  return tcache_large(alignment, size);
+}
+
+/****************************************************************************
+ * Name: tcache_flush
+ ****************************************************************************/
+
+void tcache_flush(void)
+{
+  FAR struct tcache_s *tc = tcache_get(false);
+  int cls;
+
+  if (tc != NULL)
+    {
+      for (cls = 0; cls < TCACHE_NCLASSES; cls++)
+        {
+          tcache_flush_bin(tc, cls, UINT_MAX);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: tcache_stats
+ ****************************************************************************/
+
+void tcache_stats(FAR struct tcache_stats_s *stats)
+{
+  FAR struct tcache_s *tc = tcache_get(false);
+
+  if (tc != NULL)
+    {
+      *stats = tc->stats;
+    }
+  else
+    {
+      memset(stats, 0, sizeof(*stats));
+    }
+}
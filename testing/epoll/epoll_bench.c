@@ -0,0 +1,614 @@
+/****************************************************************************
+ * apps/testing/epoll/epoll_bench.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef CONFIG_EVENT_FD
+#  include <sys/eventfd.h>
+#endif
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_DEFAULT_MAXFDS  1000
+#define BENCH_DEFAULT_ACTIVE  1
+#define BENCH_DEFAULT_ROUNDS  1000
+#define BENCH_MINFDS          10
+
+#define NSEC_PER_SEC          1000000000ull
+
+#if CONFIG_DEV_PIPE_SIZE > 0
+#  define BENCH_HAVE_PIPE 1
+#endif
+
+#ifdef CONFIG_EVENT_FD
+#  define BENCH_HAVE_EVENTFD 1
+#endif
+
+#ifdef CONFIG_NET_LOCAL_STREAM
+#  define BENCH_HAVE_LOCAL 1
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+enum bench_type_e
+{
+  BENCH_PIPE = 0,
+  BENCH_EVENTFD,
+  BENCH_LOCAL,
+  BENCH_NTYPES
+};
+
+/* One event source: written through wfd, watched and drained on rfd */
+
+struct bench_src_s
+{
+  int rfd;
+  int wfd;
+  unsigned int stamp;          /* Last round that fired this source */
+};
+
+struct bench_result_s
+{
+  uint64_t ctl_add;            /* Total ns spent in EPOLL_CTL_ADD */
+  uint64_t ctl_del;            /* Total ns spent in EPOLL_CTL_DEL */
+  uint64_t wait;               /* Total ns spent waiting for the events */
+  uint64_t wait_max;           /* Slowest single round */
+  uint64_t events;             /* Events reported */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static FAR const char *g_type_name[BENCH_NTYPES] =
+{
+  "pipe",
+  "eventfd",
+  "local"
+};
+
+static uint32_t g_seed = 0x2545f491;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bench_now
+ ****************************************************************************/
+
+static uint64_t bench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: bench_random
+ ****************************************************************************/
+
+static uint32_t bench_random(void)
+{
+  g_seed ^= g_seed << 13;
+  g_seed ^= g_seed >> 17;
+  g_seed ^= g_seed << 5;
+  return g_seed;
+}
+
+/****************************************************************************
+ * Name: bench_rate
+ ****************************************************************************/
+
+static uint64_t bench_rate(FAR const struct bench_result_s *res)
+{
+  if (res->wait == 0)
+    {
+      return 0;
+    }
+
+  return res->events * NSEC_PER_SEC / res->wait;
+}
+
+/****************************************************************************
+ * Name: bench_src_open
+ ****************************************************************************/
+
+static int bench_src_open(FAR struct bench_src_s *src, int type)
+{
+  int fd[2];
+
+  src->stamp = 0;
+
+  switch (type)
+    {
+#ifdef BENCH_HAVE_PIPE
+      case BENCH_PIPE:
+        if (pipe(fd) < 0)
+          {
+            return -errno;
+          }
+        break;
+#endif
+
+#ifdef BENCH_HAVE_EVENTFD
+      case BENCH_EVENTFD:
+        fd[0] = eventfd(0, 0);
+        if (fd[0] < 0)
+          {
+            return -errno;
+          }
+
+        fd[1] = fd[0];
+        break;
+#endif
+
+#ifdef BENCH_HAVE_LOCAL
+      case BENCH_LOCAL:
+        if (socketpair(AF_LOCAL, SOCK_STREAM, 0, fd) < 0)
+          {
+            return -errno;
+          }
+        break;
+#endif
+
+      default:
+        return -ENOSYS;
+    }
+
+  src->rfd = fd[0];
+  src->wfd = fd[1];
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bench_src_close
+ ****************************************************************************/
+
+static void bench_src_close(FAR struct bench_src_s *src)
+{
+  close(src->rfd);
+  if (src->wfd != src->rfd)
+    {
+      close(src->wfd);
+    }
+}
+
+/****************************************************************************
+ * Name: bench_src_fire
+ ****************************************************************************/
+
+static void bench_src_fire(FAR struct bench_src_s *src)
+{
+  uint64_t one = 1;
+
+  /* An eventfd takes an 8-byte counter, the others a single byte */
+
+  write(src->wfd, &one, src->wfd == src->rfd ? sizeof(one) : 1);
+}
+
+/****************************************************************************
+ * Name: bench_src_drain
+ ****************************************************************************/
+
+static void bench_src_drain(FAR struct bench_src_s *src)
+{
+  uint64_t buf;
+
+  read(src->rfd, &buf, sizeof(buf));
+}
+
+/****************************************************************************
+ * Name: bench_fire
+ *
+ * Description:
+ *   Make 'active' distinct, randomly chosen sources readable and return
+ *   how many were fired.
+ *
+ ****************************************************************************/
+
+static int bench_fire(FAR struct bench_src_s *srcs, int nfds, int active,
+                      unsigned int round)
+{
+  int fired = 0;
+  int i;
+
+  while (fired < active)
+    {
+      i = bench_random() % nfds;
+      if (srcs[i].stamp != round)
+        {
+          srcs[i].stamp = round;
+          bench_src_fire(&srcs[i]);
+          fired++;
+        }
+    }
+
+  return fired;
+}
+
+/****************************************************************************
+ * Name: bench_epoll
+ ****************************************************************************/
+
+static int bench_epoll(FAR struct bench_src_s *srcs, int nfds, int active,
+                       int rounds, FAR struct epoll_event *evs,
+                       FAR struct bench_result_s *res)
+{
+  struct epoll_event ev;
+  uint64_t start;
+  uint64_t delta;
+  int expect;
+  int round;
+  int efd;
+  int ret;
+  int got;
+  int i;
+
+  efd = epoll_create1(EPOLL_CLOEXEC);
+  if (efd < 0)
+    {
+      return -errno;
+    }
+
+  start = bench_now();
+  for (i = 0; i < nfds; i++)
+    {
+      ev.events   = EPOLLIN;
+      ev.data.ptr = &srcs[i];
+      if (epoll_ctl(efd, EPOLL_CTL_ADD, srcs[i].rfd, &ev) < 0)
+        {
+          ret = -errno;
+          goto errout;
+        }
+    }
+
+  res->ctl_add = bench_now() - start;
+
+  for (round = 1; round <= rounds; round++)
+    {
+      expect = bench_fire(srcs, nfds, active, round);
+
+      /* Only the epoll_wait() calls are timed.  The sources were all
+       * ready before the first call, so it normally returns all of them.
+       */
+
+      for (delta = 0, got = 0; got < expect; got += ret)
+        {
+          start = bench_now();
+          ret = epoll_wait(efd, evs, active, -1);
+          delta += bench_now() - start;
+          if (ret < 0)
+            {
+              ret = -errno;
+              goto errout;
+            }
+
+          for (i = 0; i < ret; i++)
+            {
+              bench_src_drain(evs[i].data.ptr);
+            }
+        }
+
+      res->wait += delta;
+      res->events += got;
+      if (delta > res->wait_max)
+        {
+          res->wait_max = delta;
+        }
+    }
+
+  start = bench_now();
+  for (i = 0; i < nfds; i++)
+    {
+      epoll_ctl(efd, EPOLL_CTL_DEL, srcs[i].rfd, NULL);
+    }
+
+  res->ctl_del = bench_now() - start;
+  ret = OK;
+
+errout:
+  close(efd);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: bench_poll
+ *
+ * Description:
+ *   The same rounds with poll() over the whole set, including the scan for
+ *   the ready entries that a poll() based server has to do.
+ *
+ ****************************************************************************/
+
+static int bench_poll(FAR struct bench_src_s *srcs, int nfds, int active,
+                      int rounds, FAR struct pollfd *pfds,
+                      FAR struct bench_result_s *res)
+{
+  uint64_t start;
+  uint64_t delta;
+  unsigned int round;
+  int expect;
+  int got;
+  int ret;
+  int i;
+
+  for (i = 0; i < nfds; i++)
+    {
+      pfds[i].fd     = srcs[i].rfd;
+      pfds[i].events = POLLIN;
+    }
+
+  /* Continue the round numbering after the epoll pass */
+
+  for (round = rounds + 1; round <= 2 * (unsigned int)rounds; round++)
+    {
+      expect = bench_fire(srcs, nfds, active, round);
+
+      start = bench_now();
+      ret = poll(pfds, nfds, -1);
+      if (ret < 0)
+        {
+          return -errno;
+        }
+
+      for (got = 0, i = 0; i < nfds; i++)
+        {
+          if (pfds[i].revents & POLLIN)
+            {
+              got++;
+            }
+        }
+
+      delta = bench_now() - start;
+
+      for (i = 0; i < nfds; i++)
+        {
+          if (pfds[i].revents & POLLIN)
+            {
+              bench_src_drain(&srcs[i]);
+            }
+        }
+
+      if (got != expect)
+        {
+          return -EIO;
+        }
+
+      res->wait += delta;
+      res->events += got;
+      if (delta > res->wait_max)
+        {
+          res->wait_max = delta;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bench_run
+ ****************************************************************************/
+
+static int bench_run(int type, int nfds, int active, int rounds)
+{
+  FAR struct bench_src_s *srcs;
+  FAR struct epoll_event *evs;
+  FAR struct pollfd *pfds;
+  struct bench_result_s epres;
+  struct bench_result_s pres;
+  int opened;
+  int ret;
+
+  if (active > nfds)
+    {
+      active = nfds;
+    }
+
+  srcs = calloc(nfds, sizeof(*srcs));
+  evs  = calloc(active, sizeof(*evs));
+  pfds = calloc(nfds, sizeof(*pfds));
+  if (srcs == NULL || evs == NULL || pfds == NULL)
+    {
+      ret = -ENOMEM;
+      opened = 0;
+      goto errout;
+    }
+
+  for (opened = 0; opened < nfds; opened++)
+    {
+      ret = bench_src_open(&srcs[opened], type);
+      if (ret < 0)
+        {
+          printf("%7d  cannot open %s %d: %d\n",
+                 nfds, g_type_name[type], opened, ret);
+          goto errout;
+        }
+    }
+
+  memset(&epres, 0, sizeof(epres));
+  memset(&pres, 0, sizeof(pres));
+
+  ret = bench_epoll(srcs, nfds, active, rounds, evs, &epres);
+  if (ret < 0)
+    {
+      printf("%7d  epoll failed: %d\n", nfds, ret);
+      goto errout;
+    }
+
+  ret = bench_poll(srcs, nfds, active, rounds, pfds, &pres);
+  if (ret < 0)
+    {
+      printf("%7d  poll failed: %d\n", nfds, ret);
+      goto errout;
+    }
+
+  printf("%7d %8" PRIu64 " %8" PRIu64 " %9" PRIu64 " %9" PRIu64
+         " %10" PRIu64 " %9" PRIu64 " %9" PRIu64 " %10" PRIu64 "\n",
+         nfds, epres.ctl_add / nfds, epres.ctl_del / nfds,
+         epres.wait / rounds, epres.wait_max,
+         bench_rate(&epres),
+         pres.wait / rounds, pres.wait_max,
+         bench_rate(&pres));
+
+errout:
+  while (opened-- > 0)
+    {
+      bench_src_close(&srcs[opened]);
+    }
+
+  free(pfds);
+  free(evs);
+  free(srcs);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname, int exitcode)
+{
+  printf("Usage: %s [-t type] [-n maxfds] [-a active] [-r rounds]\n",
+         progname);
+  printf("  -t  Event source: pipe, eventfd or local (default pipe)\n");
+  printf("  -n  Largest set, runs %d, %d, ... up to it (default %d)\n",
+         BENCH_MINFDS, BENCH_MINFDS * 10, BENCH_DEFAULT_MAXFDS);
+  printf("  -a  Sources fired per round (default %d)\n",
+         BENCH_DEFAULT_ACTIVE);
+  printf("  -r  Rounds per set size (default %d)\n", BENCH_DEFAULT_ROUNDS);
+  printf("Each row registers the set with epoll, fires a random subset\n"
+         "and times epoll_wait(), then repeats the rounds with poll() on\n"
+         "the same descriptors.  ctl times are ns per call, wait times\n"
+         "are ns per round.\n");
+  exit(exitcode);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  int maxfds = BENCH_DEFAULT_MAXFDS;
+  int active = BENCH_DEFAULT_ACTIVE;
+  int rounds = BENCH_DEFAULT_ROUNDS;
+  int type = BENCH_PIPE;
+  int nfds;
+  int ret = OK;
+  int opt;
+  int i;
+
+  while ((opt = getopt(argc, argv, "t:n:a:r:h")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 't':
+            for (i = 0; i < BENCH_NTYPES; i++)
+              {
+                if (strcmp(optarg, g_type_name[i]) == 0)
+                  {
+                    break;
+                  }
+              }
+
+            if (i == BENCH_NTYPES)
+              {
+                show_usage(argv[0], EXIT_FAILURE);
+              }
+
+            type = i;
+            break;
+
+          case 'n':
+            maxfds = atoi(optarg);
+            break;
+
+          case 'a':
+            active = atoi(optarg);
+            break;
+
+          case 'r':
+            rounds = atoi(optarg);
+            break;
+
+          case 'h':
+            show_usage(argv[0], EXIT_SUCCESS);
+            break;
+
+          default:
+            show_usage(argv[0], EXIT_FAILURE);
+            break;
+        }
+    }
+
+  if (maxfds < 1 || active < 1 || rounds < 1)
+    {
+      show_usage(argv[0], EXIT_FAILURE);
+    }
+
+  printf("epollbench: %s, %d active per round, %d rounds\n",
+         g_type_name[type], active, rounds);
+  printf("                 epoll_ctl      epoll_wait (ns)         "
+         "       poll (ns)\n");
+  printf("    fds      add      del       avg       max   events/s"
+         "       avg       max   events/s\n");
+
+  for (nfds = BENCH_MINFDS < maxfds ? BENCH_MINFDS : maxfds; ;
+       nfds = nfds * 10 < maxfds ? nfds * 10 : maxfds)
+    {
+      ret = bench_run(type, nfds, active, rounds);
+      if (ret < 0 || nfds == maxfds)
+        {
+          break;
+        }
+    }
+
+  return ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+/****************************************************************************
+ * apps/testing/memstress/memorystress.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_TESTING_MEMSTRESS_MEMORYSTRESS_H
+#define __APPS_TESTING_MEMSTRESS_MEMORYSTRESS_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MEMSTRESS_PREFIX "MemoryStress:"
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+struct memorystress_func_s
+{
+  void *(*malloc)(size_t size);
+  void *(*aligned_alloc)(size_t align, size_t nbytes);
+  void *(*realloc)(FAR void *ptr, size_t new_size);
+  void (*freefunc)(FAR void *ptr);
+};
+
+struct memorystress_global_s
+{
+  FAR struct memorystress_func_s func;
+  FAR pthread_t *threads;
+  size_t max_allocsize;
+  size_t nthreads;
+  size_t nodelen;
+  uint32_t sleep_us;
+  bool debug;
+  bool tcache;                 /* Allocate through system/tcache */
+
+  /* Benchmark mode */
+
+  bool bench;
+  FAR const char *pattern;     /* fixed, uniform or pow */
+  FAR const char *trace;       /* Recorded request sizes, one per line */
+  size_t nops;                 /* Allocations per thread */
+  uint32_t sample_ms;          /* Heap sampling interval */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: memorystress_bench
+ *
+ * Description:
+ *   Replay an allocation size distribution on global->nthreads threads
+ *   through global->func and report throughput, latency percentiles and
+ *   heap fragmentation over time.
+ *
+ ****************************************************************************/
+
+int memorystress_bench(FAR struct memorystress_global_s *global);
+
+#endif /* __APPS_TESTING_MEMSTRESS_MEMORYSTRESS_H */
@@ -0,0 +1,766 @@
+/****************************************************************************
+ * apps/testing/memstress/memorystress_bench.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <nuttx/clock.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <malloc.h>
+#include <sys/param.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef CONFIG_SYSTEM_TCACHE
+#  include "system/tcache.h"
+#endif
+
+#include "memorystress.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Latency buckets: exact below 4 ticks, then four per power of two */
+
+#define BENCH_NBUCKETS     256
+
+/* Smallest request of the power-law pattern */
+
+#define BENCH_POW_MIN      16
+#define BENCH_POW_MAXSHIFT 20
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+enum bench_pattern_e
+{
+  BENCH_FIXED = 0,
+  BENCH_UNIFORM,
+  BENCH_POW,
+  BENCH_TRACE
+};
+
+struct bench_hist_s
+{
+  uint32_t count[BENCH_NBUCKETS];
+  uint64_t total;              /* Sum of all samples, in perf ticks */
+  clock_t max;
+  size_t samples;
+};
+
+struct bench_thread_s
+{
+  FAR struct bench_run_s *run;
+  pthread_t thread;
+  FAR uint8_t **slots;         /* Live blocks */
+  FAR size_t *sizes;           /* Their request sizes */
+  size_t trace_pos;
+  uint32_t seed;
+  volatile size_t live;        /* Requested bytes currently held */
+  volatile bool done;
+  uint64_t end;                /* When the last operation completed */
+  size_t failed;
+#ifdef CONFIG_SYSTEM_TCACHE
+  struct tcache_stats_s tcache;
+#endif
+  struct bench_hist_s alloc;
+  struct bench_hist_s free;
+};
+
+struct bench_run_s
+{
+  FAR struct memorystress_global_s *global;
+  FAR struct bench_thread_s *threads;
+  size_t nthreads;
+  sem_t start;                 /* Posted once per worker to start it */
+  volatile bool abort;         /* Not every worker could be created */
+  int pattern;
+  FAR size_t *trace;
+  size_t ntrace;
+};
+
+struct bench_result_s
+{
+  uint64_t ops;
+  uint64_t wall_ns;
+  uint64_t alloc_avg_ns;
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bench_now
+ ****************************************************************************/
+
+static uint64_t bench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: bench_ticks2ns
+ ****************************************************************************/
+
+static uint64_t bench_ticks2ns(clock_t ticks)
+{
+  struct timespec ts;
+
+  perf_convert(ticks, &ts);
+  return (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: bench_random
+ ****************************************************************************/
+
+static uint32_t bench_random(FAR uint32_t *seed)
+{
+  uint32_t x = *seed;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *seed = x;
+  return x;
+}
+
+/****************************************************************************
+ * Name: bench_bucket / bench_bucket_value
+ *
+ * Description:
+ *   Map a latency to its histogram bucket and a bucket back to the
+ *   largest latency it holds.
+ *
+ ****************************************************************************/
+
+static int bench_bucket(uint64_t value)
+{
+  int msb = 0;
+  int index;
+
+  if (value < 4)
+    {
+      return value;
+    }
+
+  while ((value >> msb) > 1)
+    {
+      msb++;
+    }
+
+  index = 4 * (msb - 1) + ((value >> (msb - 2)) & 3);
+  return index < BENCH_NBUCKETS ? index : BENCH_NBUCKETS - 1;
+}
+
+static uint64_t bench_bucket_value(int index)
+{
+  if (index < 4)
+    {
+      return index;
+    }
+
+  index++;
+  return ((uint64_t)(4 + index % 4) << (index / 4 - 1)) - 1;
+}
+
+/****************************************************************************
+ * Name: bench_hist_add
+ ****************************************************************************/
+
+static void bench_hist_add(FAR struct bench_hist_s *hist, clock_t ticks)
+{
+  hist->count[bench_bucket(ticks)]++;
+  hist->total += ticks;
+  hist->samples++;
+  if (ticks > hist->max)
+    {
+      hist->max = ticks;
+    }
+}
+
+/****************************************************************************
+ * Name: bench_hist_merge
+ ****************************************************************************/
+
+static void bench_hist_merge(FAR struct bench_hist_s *dst,
+                             FAR const struct bench_hist_s *src)
+{
+  int i;
+
+  for (i = 0; i < BENCH_NBUCKETS; i++)
+    {
+      dst->count[i] += src->count[i];
+    }
+
+  dst->total   += src->total;
+  dst->samples += src->samples;
+  if (src->max > dst->max)
+    {
+      dst->max = src->max;
+    }
+}
+
+/****************************************************************************
+ * Name: bench_hist_print
+ ****************************************************************************/
+
+static void bench_hist_print(FAR const char *name,
+                             FAR const struct bench_hist_s *hist)
+{
+  static const uint32_t permille[] =
+  {
+    500, 900, 990, 999
+  };
+
+  uint64_t seen = 0;
+  int p = 0;
+  int i;
+
+  printf("  %-12s %8" PRIu64, name, hist->samples ?
+         bench_ticks2ns(hist->total / hist->samples) : 0);
+
+  for (i = 0; i < BENCH_NBUCKETS && p < 4; i++)
+    {
+      seen += hist->count[i];
+      while (p < 4 && seen * 1000 >= (uint64_t)hist->samples * permille[p]
+             && hist->samples > 0)
+        {
+          printf(" %8" PRIu64, bench_ticks2ns(MIN(bench_bucket_value(i),
+                                                  hist->max)));
+          p++;
+        }
+    }
+
+  printf(" %8" PRIu64 "\n", bench_ticks2ns(hist->max));
+}
+
+/****************************************************************************
+ * Name: bench_size
+ ****************************************************************************/
+
+static size_t bench_size(FAR struct bench_run_s *run,
+                         FAR struct bench_thread_s *ctx)
+{
+  size_t max = run->global->max_allocsize;
+  uint32_t r = bench_random(&ctx->seed);
+  size_t size;
+  int shift;
+
+  switch (run->pattern)
+    {
+      case BENCH_FIXED:
+        return max;
+
+      case BENCH_UNIFORM:
+        return 1 + r % max;
+
+      case BENCH_TRACE:
+        size = run->trace[ctx->trace_pos++];
+        if (ctx->trace_pos == run->ntrace)
+          {
+            ctx->trace_pos = 0;
+          }
+
+        return size;
+
+      default:
+
+        /* Each doubling of the size class halves its probability, then
+         * pick a size within the class.
+         */
+
+        for (shift = 0; (r & 1) && shift < BENCH_POW_MAXSHIFT; shift++)
+          {
+            r >>= 1;
+          }
+
+        size = (size_t)BENCH_POW_MIN << shift;
+        size = size / 2 + 1 + bench_random(&ctx->seed) % (size / 2);
+        return size < max ? size : max;
+    }
+}
+
+/****************************************************************************
+ * Name: bench_thread
+ ****************************************************************************/
+
+static FAR void *bench_thread(FAR void *arg)
+{
+  FAR struct bench_thread_s *ctx = arg;
+  FAR struct bench_run_s *run = ctx->run;
+  FAR struct memorystress_func_s *func = &run->global->func;
+  size_t nodelen = run->global->nodelen;
+  FAR uint8_t *ptr;
+  clock_t start;
+  size_t index;
+  size_t size;
+  size_t i;
+  int ret;
+
+  while ((ret = sem_wait(&run->start)) < 0 && errno == EINTR);
+  if (ret < 0)
+    {
+      printf(MEMSTRESS_PREFIX "sem_wait failed: %d\n", errno);
+    }
+
+  if (run->abort)
+    {
+      return NULL;
+    }
+
+  for (i = 0; i < run->global->nops; i++)
+    {
+      index = bench_random(&ctx->seed) % nodelen;
+      if (ctx->slots[index] != NULL)
+        {
+          start = perf_gettime();
+          func->freefunc(ctx->slots[index]);
+          bench_hist_add(&ctx->free, perf_gettime() - start);
+
+          ctx->live -= ctx->sizes[index];
+          ctx->slots[index] = NULL;
+        }
+
+      size = bench_size(run, ctx);
+
+      start = perf_gettime();
+      ptr = func->malloc(size);
+      bench_hist_add(&ctx->alloc, perf_gettime() - start);
+
+      if (ptr == NULL)
+        {
+          ctx->failed++;
+          continue;
+        }
+
+      /* Touch both ends like a real user of the block would */
+
+      ptr[0] = (uint8_t)i;
+      ptr[size - 1] = (uint8_t)i;
+
+      ctx->slots[index] = ptr;
+      ctx->sizes[index] = size;
+      ctx->live += size;
+    }
+
+  for (i = 0; i < nodelen; i++)
+    {
+      if (ctx->slots[i] != NULL)
+        {
+          func->freefunc(ctx->slots[i]);
+          ctx->slots[i] = NULL;
+        }
+    }
+
+  ctx->end = bench_now();
+
+#ifdef CONFIG_SYSTEM_TCACHE
+  /* What is still cached goes back to the heap when the thread exits */
+
+  if (run->global->tcache)
+    {
+      tcache_stats(&ctx->tcache);
+    }
+#endif
+
+  ctx->live = 0;
+  ctx->done = true;
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: bench_sample
+ *
+ * Description:
+ *   Print one line of the heap timeline.  Fragmentation is the share of
+ *   free heap memory that is not part of the largest free chunk.
+ *
+ ****************************************************************************/
+
+static void bench_sample(FAR struct bench_run_s *run, uint64_t start,
+                         FAR size_t *peak)
+{
+  struct mallinfo info = mallinfo();
+  size_t used = info.uordblks;
+  size_t freed = info.fordblks;
+  size_t largest = info.mxordblk;
+  size_t live = 0;
+  size_t i;
+
+  for (i = 0; i < run->nthreads; i++)
+    {
+      live += run->threads[i].live;
+    }
+
+  if (used > *peak)
+    {
+      *peak = used;
+    }
+
+  printf("%8" PRIu64 " %10zu %10zu %10zu %10zu %5zu%% %5zu%%\n",
+         (bench_now() - start) / 1000000, live, used, freed, largest,
+         freed > 0 ? 100 - largest * 100 / freed : 0,
+         used > live ? (used - live) * 100 / used : 0);
+}
+
+/****************************************************************************
+ * Name: bench_run
+ ****************************************************************************/
+
+static int bench_run(FAR struct bench_run_s *run, size_t nthreads,
+                     FAR struct bench_result_s *result)
+{
+  FAR struct memorystress_global_s *global = run->global;
+  struct bench_hist_s alloc;
+  struct bench_hist_s free_hist;
+  uint64_t start;
+  size_t failed = 0;
+  size_t peak = 0;
+  size_t created;
+  size_t i;
+  bool done;
+  int ret = OK;
+
+  run->nthreads = nthreads;
+  run->threads = zalloc(sizeof(struct bench_thread_s) * nthreads);
+  if (run->threads == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  for (i = 0; i < nthreads; i++)
+    {
+      FAR struct bench_thread_s *ctx = &run->threads[i];
+
+      ctx->run = run;
+      ctx->seed = 0x9e3779b9u * (i + 1);
+      ctx->trace_pos = run->ntrace * i / nthreads;
+      ctx->slots = zalloc(sizeof(FAR uint8_t *) * global->nodelen);
+      ctx->sizes = zalloc(sizeof(size_t) * global->nodelen);
+      if (ctx->slots == NULL || ctx->sizes == NULL)
+        {
+          ret = -ENOMEM;
+          nthreads = i + 1;
+          goto errout;
+        }
+    }
+
+  /* The workers wait on the start semaphore until all of them exist, so
+   * they begin together and a failed creation can still release them.
+   */
+
+  if (sem_init(&run->start, 0, 0) < 0)
+    {
+      ret = -errno;
+      goto errout;
+    }
+
+  run->abort = false;
+  for (created = 0; created < nthreads; created++)
+    {
+      ret = pthread_create(&run->threads[created].thread, NULL,
+                           bench_thread, &run->threads[created]);
+      if (ret != 0)
+        {
+          printf(MEMSTRESS_PREFIX "pthread_create failed: %d\n", ret);
+          run->abort = true;
+          ret = -ret;
+          break;
+        }
+    }
+
+  if (run->abort)
+    {
+      for (i = 0; i < created; i++)
+        {
+          sem_post(&run->start);
+        }
+
+      for (i = 0; i < created; i++)
+        {
+          pthread_join(run->threads[i].thread, NULL);
+        }
+
+      sem_destroy(&run->start);
+      goto errout;
+    }
+
+  printf("\n%zu thread(s)\n", nthreads);
+  printf("   ms      live bytes  heap used  heap free   largest "
+         "  frag  ovhd\n");
+
+  start = bench_now();
+  bench_sample(run, start, &peak);
+  start = bench_now();
+
+  for (i = 0; i < nthreads; i++)
+    {
+      sem_post(&run->start);
+    }
+
+  do
+    {
+      usleep(global->sample_ms * 1000);
+      bench_sample(run, start, &peak);
+
+      for (done = true, i = 0; i < nthreads; i++)
+        {
+          done = done && run->threads[i].done;
+        }
+    }
+  while (!done);
+
+  for (i = 0; i < nthreads; i++)
+    {
+      pthread_join(run->threads[i].thread, NULL);
+    }
+
+  /* The threads start together, throughput is up to the last one
+   * finishing rather than up to the next sample.
+   */
+
+  result->wall_ns = 0;
+  for (i = 0; i < nthreads; i++)
+    {
+      if (run->threads[i].end - start > result->wall_ns)
+        {
+          result->wall_ns = run->threads[i].end - start;
+        }
+    }
+
+  sem_destroy(&run->start);
+
+  memset(&alloc, 0, sizeof(alloc));
+  memset(&free_hist, 0, sizeof(free_hist));
+  for (i = 0; i < nthreads; i++)
+    {
+      bench_hist_merge(&alloc, &run->threads[i].alloc);
+      bench_hist_merge(&free_hist, &run->threads[i].free);
+      failed += run->threads[i].failed;
+    }
+
+  result->ops = alloc.samples + free_hist.samples;
+  result->alloc_avg_ns = alloc.samples ?
+                         bench_ticks2ns(alloc.total / alloc.samples) : 0;
+
+  printf("  %" PRIu64 " ops in %" PRIu64 " ms, %" PRIu64 " ops/s, "
+         "%zu failed, peak heap used %zu\n", result->ops,
+         result->wall_ns / 1000000, result->wall_ns ?
+         result->ops * NSEC_PER_SEC / result->wall_ns : 0, failed, peak);
+#ifdef CONFIG_SYSTEM_TCACHE
+  if (global->tcache)
+    {
+      struct tcache_stats_s stats;
+
+      memset(&stats, 0, sizeof(stats));
+      for (i = 0; i < nthreads; i++)
+        {
+          stats.hits     += run->threads[i].tcache.hits;
+          stats.misses   += run->threads[i].tcache.misses;
+          stats.refilled += run->threads[i].tcache.refilled;
+          stats.flushed  += run->threads[i].tcache.flushed;
+          stats.large    += run->threads[i].tcache.large;
+        }
+
+      printf("  tcache: %lu hits, %lu misses, %lu refilled, "
+             "%lu flushed, %lu large\n", stats.hits, stats.misses,
+             stats.refilled, stats.flushed, stats.large);
+    }
+#endif
+
+  printf("  latency (ns)      avg      p50      p90      p99    p99.9"
+         "      max\n");
+  bench_hist_print("malloc", &alloc);
+  bench_hist_print("free", &free_hist);
+
+errout:
+  for (i = 0; i < nthreads; i++)
+    {
+      free(run->threads[i].slots);
+      free(run->threads[i].sizes);
+    }
+
+  free(run->threads);
+  run->threads = NULL;
+  return ret;
+}
+
+/****************************************************************************
+ * Name: bench_load_trace
+ ****************************************************************************/
+
+static int bench_load_trace(FAR struct bench_run_s *run,
+                            FAR const char *path)
+{
+  FAR size_t *trace;
+  FAR FILE *stream;
+  FAR char *end;
+  char line[32];
+  size_t room = 0;
+  size_t size;
+
+  stream = fopen(path, "r");
+  if (stream == NULL)
+    {
+      return -errno;
+    }
+
+  while (fgets(line, sizeof(line), stream) != NULL)
+    {
+      size = strtoul(line, &end, 0);
+      if (end == line || size == 0)
+        {
+          continue;             /* Comment or blank line */
+        }
+
+      if (run->ntrace == room)
+        {
+          room = room ? room * 2 : 256;
+          trace = realloc(run->trace, room * sizeof(size_t));
+          if (trace == NULL)
+            {
+              fclose(stream);
+              return -ENOMEM;
+            }
+
+          run->trace = trace;
+        }
+
+      run->trace[run->ntrace++] = size;
+    }
+
+  fclose(stream);
+  return run->ntrace > 0 ? OK : -EINVAL;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: memorystress_bench
+ ****************************************************************************/
+
+int memorystress_bench(FAR struct memorystress_global_s *global)
+{
+  struct bench_result_s single;
+  struct bench_result_s multi;
+  struct bench_run_s run;
+  int ret;
+
+  memset(&run, 0, sizeof(run));
+  run.global = global;
+
+  if (global->trace != NULL)
+    {
+      run.pattern = BENCH_TRACE;
+      ret = bench_load_trace(&run, global->trace);
+      if (ret < 0)
+        {
+          printf(MEMSTRESS_PREFIX "Can't load trace %s: %d\n",
+                 global->trace, ret);
+          return EXIT_FAILURE;
+        }
+    }
+  else if (strcmp(global->pattern, "fixed") == 0)
+    {
+      run.pattern = BENCH_FIXED;
+    }
+  else if (strcmp(global->pattern, "uniform") == 0)
+    {
+      run.pattern = BENCH_UNIFORM;
+    }
+  else if (strcmp(global->pattern, "pow") == 0)
+    {
+      run.pattern = BENCH_POW;
+    }
+  else
+    {
+      printf(MEMSTRESS_PREFIX "Unknown pattern %s\n", global->pattern);
+      return EXIT_FAILURE;
+    }
+
+  if (global->nthreads < 1 || global->nodelen < 1 ||
+      global->max_allocsize < 1 || global->sample_ms < 1)
+    {
+      printf(MEMSTRESS_PREFIX "Invalid parameters\n");
+      return EXIT_FAILURE;
+    }
+
+  printf("memstress benchmark: %s sizes", global->trace ? global->trace :
+         global->pattern);
+  if (run.pattern != BENCH_TRACE)
+    {
+      printf(" up to %zu", global->max_allocsize);
+    }
+
+  printf(", %zu live blocks and %zu allocations per thread%s\n",
+         global->nodelen, global->nops,
+         global->tcache ? ", tcache" : "");
+
+  /* The single thread run is the reference for the contention figures */
+
+  ret = bench_run(&run, 1, &single);
+  if (ret == OK && global->nthreads > 1)
+    {
+      ret = bench_run(&run, global->nthreads, &multi);
+      if (ret == OK && single.wall_ns > 0 && multi.wall_ns > 0)
+        {
+          uint64_t base = single.ops * NSEC_PER_SEC / single.wall_ns;
+          uint64_t rate = multi.ops * NSEC_PER_SEC / multi.wall_ns;
+
+          printf("\nscaling: %zu threads reach %" PRIu64 "%% of "
+                 "%zu x single thread throughput\n",
+                 global->nthreads, base ? rate * 100 /
+                 (base * global->nthreads) : 0, global->nthreads);
+          printf("contention: mean malloc latency %" PRIu64 " ns, "
+                 "%" PRIu64 " ns with one thread\n",
+                 multi.alloc_avg_ns, single.alloc_avg_ns);
+        }
+    }
+
+  free(run.trace);
+
+  if (ret < 0)
+    {
+      printf(MEMSTRESS_PREFIX "Benchmark failed: %d\n", ret);
+      return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
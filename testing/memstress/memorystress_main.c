@@ -34,11 +34,16 @@
 #include <stdbool.h>
 #include <assert.h>
 
+#ifdef CONFIG_SYSTEM_TCACHE
+#  include "system/tcache.h"
+#endif
+
+#include "memorystress.h"
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
 
-#define MEMSTRESS_PREFIX "MemoryStress:"
 #define DEBUG_MAGIC 0xaa
 
 #define OPTARG_TO_VALUE(value, type) \
@@ -63,14 +68,6 @@ enum memorystress_rwerror_e
   MEMORY_STRESS_WRITE_ERROR
 };
 
-struct memorystress_func_s
-{
-  void *(*malloc)(size_t size);
-  void *(*aligned_alloc)(size_t align, size_t nbytes);
-  void *(*realloc)(FAR void *ptr, size_t new_size);
-  void (*freefunc)(FAR void *ptr);
-};
-
 struct memorystress_error_s
 {
   FAR uint8_t *buf;
@@ -97,17 +94,6 @@ struct memorystress_thread_context_s
   struct memorystress_error_s error;
 };
 
-struct memorystress_global_s
-{
-  FAR struct memorystress_func_s func;
-  FAR pthread_t *threads;
-  size_t max_allocsize;
-  size_t nthreads;
-  size_t nodelen;
-  uint32_t sleep_us;
-  bool debug;
-};
-
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -129,6 +115,19 @@ static void show_usage(FAR const char *progname)
   printf("  -x [nthreads] Enable multi-thread stress testing. \n");
   printf("  -d [debug mode] Helps to localize the problem situation,"
          "there is a lot of information output in this mode.\n");
+  printf("\nBenchmark mode: %s -b [-p fixed|uniform|pow] [-r trace] "
+         "[-o ops] [-i ms] [-m] [-n] [-x]\n", progname);
+  printf("  -b Measure instead of checking data.\n");
+#ifdef CONFIG_SYSTEM_TCACHE
+  printf("  -c Allocate through the per-thread cache (tcache), also "
+         "without -b.\n");
+#endif
+  printf("  -p [pattern] Request sizes: all -m bytes, uniform up to -m "
+         "or power-law up to -m. Default: pow\n");
+  printf("  -r [trace] Replay request sizes from a file, one per line.\n");
+  printf("  -o [ops] Allocations per thread. Default: 100000\n");
+  printf("  -i [ms] Heap sampling interval. Default: 100\n");
+  printf("  -n gives the live blocks per thread, -x the threads.\n");
   exit(EXIT_FAILURE);
 }
 
@@ -392,14 +391,37 @@ static void global_init(FAR struct memorystress_global_s *global, int argc,
   global->sleep_us = 100;
   global->max_allocsize = 8192;
   global->nodelen = 1024;
+  global->pattern = "pow";
+  global->nops = 100000;
+  global->sample_ms = 100;
 
-  while ((ch = getopt(argc, argv, "dm:n:t:x::")) != ERROR)
+  while ((ch = getopt(argc, argv, "dm:n:t:x:bcp:r:o:i:")) != ERROR)
     {
       switch (ch)
         {
           case 'd':
             global->debug = true;
             break;
+          case 'b':
+            global->bench = true;
+            break;
+#ifdef CONFIG_SYSTEM_TCACHE
+          case 'c':
+            global->tcache = true;
+            break;
+#endif
+          case 'p':
+            global->pattern = optarg;
+            break;
+          case 'r':
+            global->trace = optarg;
+            break;
+          case 'o':
+            OPTARG_TO_VALUE(global->nops, size_t);
+            break;
+          case 'i':
+            OPTARG_TO_VALUE(global->sample_ms, uint32_t);
+            break;
           case 'm':
             OPTARG_TO_VALUE(global->max_allocsize, size_t);
             break;
@@ -418,6 +440,16 @@ static void global_init(FAR struct memorystress_global_s *global, int argc,
         }
     }
 
+#ifdef CONFIG_SYSTEM_TCACHE
+    if (global->tcache)
+      {
+        global->func.malloc = tcache_malloc;
+        global->func.aligned_alloc = tcache_memalign;
+        global->func.realloc = tcache_realloc;
+        global->func.freefunc = tcache_free;
+      }
+    else
+#endif
     if (global->debug)
       {
         global->func.malloc = debug_malloc;
@@ -500,6 +532,11 @@ int main(int argc, FAR char *argv[])
   int i;
 
   global_init(&global, argc, argv);
+  if (global.bench)
+    {
+      return memorystress_bench(&global);
+    }
+
   syslog(LOG_INFO, MEMSTRESS_PREFIX "testing...\n");
   for (i = 0; i < global.nthreads; i++)
     {
@@ -24,11 +24,17 @@
  * Included Files
  ****************************************************************************/
 
+#include <errno.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <signal.h>
 #include <time.h>
+#include <unistd.h>
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -38,6 +44,16 @@
 #define DEFAULT_INTERVAL  1000
 #define DEFAULT_ITERATION 1000
 
+/* Each timer thread waits for its own real-time signal, so the number of
+ * simultaneous timers is bounded by the real-time signal range too.
+ */
+
+#define MAX_THREADS       8
+#define MAX_LOADS         8
+#define LOAD_BUFSIZE      4096
+
+#define TIMER_SIGNO(n)    (SIGRTMIN + (n))
+
 /* Fix compilation error for Non-NuttX OS */
 #ifndef FAR
   #define FAR
@@ -57,17 +73,34 @@
 
 struct timerjitter_param_s
 {
-  clockid_t     clockid;
-  unsigned int  interval;
-  unsigned long max_cnt;
-  unsigned long cur_cnt;
-  double        avg;
-  unsigned long max;
-  unsigned long min;
-  int           print;
-  unsigned int  missed;
+  int             id;
+  clockid_t       clockid;
+  bool            nanosleep;
+  unsigned int    interval;
+  unsigned long   max_cnt;
+  unsigned long   cur_cnt;
+  double          avg;
+  unsigned long   max;
+  unsigned long   min;
+  int             print;
+  unsigned int    missed;
+  int             priority;
+  int             cpu;
+
+  /* Latency histogram, hist_size buckets of hist_width us each */
+
+  FAR unsigned long *hist;
+  unsigned long   hist_size;
+  unsigned long   hist_width;
+  unsigned long   overflow;
 };
 
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static volatile bool g_load_stop;
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -130,6 +163,39 @@ static unsigned long get_num(FAR const char *str)
   return val;
 }
 
+/* Record one latency sample */
+
+static void update_stats(FAR struct timerjitter_param_s *param,
+                         int64_t diff)
+{
+  unsigned long lat = diff > 0 ? (unsigned long)diff : 0;
+
+  if (lat > param->max)
+    {
+      param->max = lat;
+    }
+
+  if (lat < param->min)
+    {
+      param->min = lat;
+    }
+
+  param->avg += lat;
+
+  if (param->hist != NULL)
+    {
+      lat /= param->hist_width;
+      if (lat < param->hist_size)
+        {
+          param->hist[lat]++;
+        }
+      else
+        {
+          param->overflow++;
+        }
+    }
+}
+
 static FAR void *timerjitter(FAR void *arg)
 {
   FAR struct timerjitter_param_s *param = arg;
@@ -145,67 +211,89 @@ static FAR void *timerjitter(FAR void *arg)
   int               ret;
 
   sigemptyset(&sigset);
-  sigaddset(&sigset, SIGALRM);
-  sigprocmask(SIG_BLOCK, &sigset, NULL);
+  sigaddset(&sigset, TIMER_SIGNO(param->id));
 
   intv.tv_sec  = param->interval / USEC_PER_SEC;
   intv.tv_nsec = (param->interval % USEC_PER_SEC) * 1000;
 
-  sigev.sigev_notify = SIGEV_SIGNAL;
-  sigev.sigev_signo  = SIGALRM;
+  if (!param->nanosleep)
+    {
+      memset(&sigev, 0, sizeof(sigev));
+      sigev.sigev_notify = SIGEV_SIGNAL;
+      sigev.sigev_signo  = TIMER_SIGNO(param->id);
+
+      if (timer_create(param->clockid, &sigev, &timer) < 0)
+        {
+          printf("[%d] timer_create failed %d\n", param->id, errno);
+          return NULL;
+        }
+    }
 
-  timer_create(param->clockid, &sigev, &timer);
   clock_gettime(param->clockid, &now);
 
   next = now;
   calc_next(&next, &intv);
 
-  /* Set cyclic timer */
+  if (!param->nanosleep)
+    {
+      /* Set cyclic timer */
 
-  tspec.it_interval = intv;
+      tspec.it_interval = intv;
 
-  /* Using TIMER_ABSTIME */
+      /* Using TIMER_ABSTIME */
 
-  tspec.it_value = next;
-  timer_settime(timer, TIMER_ABSTIME, &tspec, NULL);
+      tspec.it_value = next;
+      timer_settime(timer, TIMER_ABSTIME, &tspec, NULL);
+    }
 
   param->avg = 0;
   param->max = 0;
   param->min = (unsigned long)-1;
 
-  while (param->cur_cnt++ < param->max_cnt)
+  while (param->cur_cnt < param->max_cnt)
     {
-      /* Wait for SIGALRM */
+      if (param->nanosleep)
+        {
+          /* Sleep until the absolute deadline */
 
-      if (sigwait(&sigset, &sigs) < 0)
+          ret = clock_nanosleep(param->clockid, TIMER_ABSTIME, &next,
+                                NULL);
+          if (ret != 0)
+            {
+              if (ret == EINTR)
+                {
+                  continue;
+                }
+
+              printf("[%d] clock_nanosleep failed %d\n", param->id, ret);
+              break;
+            }
+        }
+
+      /* Wait for the timer signal */
+
+      else if (sigwait(&sigset, &sigs) != 0)
         {
-          printf("sig wait failed\n");
+          printf("[%d] sig wait failed\n", param->id);
           break;
         }
 
+      param->cur_cnt++;
+
       ret = clock_gettime(param->clockid, &now);
       if (ret)
         {
-          printf("clock_gettime failed %d\n", ret);
+          printf("[%d] clock_gettime failed %d\n", param->id, ret);
         }
 
       diff = calc_diff(&now, &next);
       if (param->print)
         {
-          printf("diff %lu, now %lu.%lu\n", diff, now.tv_sec, now.tv_nsec);
+          printf("[%d] diff %lld, now %lld.%09ld\n", param->id,
+                 (long long)diff, (long long)now.tv_sec, now.tv_nsec);
         }
 
-      if (diff > param->max)
-        {
-          param->max = diff;
-        }
-
-      if (diff < param->min)
-        {
-          param->min = diff;
-        }
-
-      param->avg += diff;
+      update_stats(param, diff);
 
       /* Calculate next = next + intv */
 
@@ -216,14 +304,157 @@ static FAR void *timerjitter(FAR void *arg)
       while (ts_greater(&now, &next))
         {
           calc_next(&next, &intv);
-          printf("time frame missed %u\n", ++param->missed);
+          printf("[%d] time frame missed %u\n", param->id,
+                 ++param->missed);
         }
     }
 
-  param->avg = param->avg / param->cur_cnt;
+  if (!param->nanosleep)
+    {
+      timer_delete(timer);
+    }
+
+  if (param->cur_cnt > 0)
+    {
+      param->avg = param->avg / param->cur_cnt;
+    }
+
   return NULL;
 }
 
+/* Background load: keep the CPU and the memory bus busy below the timer
+ * threads until they are all done.
+ */
+
+static FAR void *timerjitter_load(FAR void *arg)
+{
+  FAR uint8_t *buf;
+  uint32_t     sum = 0;
+  int          i;
+
+  buf = malloc(LOAD_BUFSIZE);
+  if (buf == NULL)
+    {
+      return NULL;
+    }
+
+  while (!g_load_stop)
+    {
+      memset(buf, sum & 0xff, LOAD_BUFSIZE);
+      for (i = 0; i < LOAD_BUFSIZE; i += 64)
+        {
+          sum += buf[i] + i;
+        }
+    }
+
+  free(buf);
+  return (FAR void *)(uintptr_t)sum;
+}
+
+static int setup_attr(FAR pthread_attr_t *attr, int priority, int cpu)
+{
+  struct sched_param sparam;
+  int ret;
+
+  ret = pthread_attr_init(attr);
+  if (ret)
+    {
+      return ret;
+    }
+
+  if (priority > 0)
+    {
+      pthread_attr_setinheritsched(attr, PTHREAD_EXPLICIT_SCHED);
+      pthread_attr_setschedpolicy(attr, SCHED_FIFO);
+      sparam.sched_priority = priority;
+      pthread_attr_setschedparam(attr, &sparam);
+    }
+
+#ifdef CONFIG_SMP
+  if (cpu >= 0)
+    {
+      cpu_set_t cpuset;
+
+      CPU_ZERO(&cpuset);
+      CPU_SET(cpu % CONFIG_SMP_NCPUS, &cpuset);
+      pthread_attr_setaffinity_np(attr, sizeof(cpu_set_t), &cpuset);
+    }
+#endif
+
+  return 0;
+}
+
+static FAR const char *clock_name(clockid_t clockid)
+{
+  return clockid == CLOCK_MONOTONIC ? "CLOCK_MONOTONIC" : "CLOCK_REALTIME";
+}
+
+/* Write the histograms as one row per bucket and one column per thread,
+ * followed by the summary as comment lines, so that the output can be fed
+ * straight to a plotting tool.
+ */
+
+static void print_histogram(FAR FILE *out,
+                            FAR struct timerjitter_param_s *params,
+                            int nthreads)
+{
+  unsigned long last = 0;
+  unsigned long i;
+  int j;
+
+  for (j = 0; j < nthreads; j++)
+    {
+      for (i = last; i < params[j].hist_size; i++)
+        {
+          if (params[j].hist[i] != 0)
+            {
+              last = i + 1;
+            }
+        }
+    }
+
+  fprintf(out, "# Histogram, %lu us per bucket\n", params[0].hist_width);
+  for (i = 0; i < last; i++)
+    {
+      fprintf(out, "%06lu", i * params[0].hist_width);
+      for (j = 0; j < nthreads; j++)
+        {
+          fprintf(out, " %06lu", params[j].hist[i]);
+        }
+
+      fprintf(out, "\n");
+    }
+
+  for (j = 0; j < nthreads; j++)
+    {
+      fprintf(out, "# Thread %d: samples %lu min %lu avg %.0lf max %lu "
+              "overflows %lu missed %u\n", j, params[j].cur_cnt,
+              params[j].min, params[j].avg, params[j].max,
+              params[j].overflow, params[j].missed);
+    }
+}
+
+static void show_usage(FAR const char *progname)
+{
+  printf("usage: %s [-pmrn] [-t threads] [-P prio] [-a cpu] [-d dist]\n"
+         "       [-l loads] [-H buckets] [-B width] [-o file]\n"
+         "       [interval(us)] [iteration]\n"
+         "-p: print time diff between two iteration\n"
+         "-m: use CLOCK_MONOTONIC\n"
+         "-r: use CLOCK_REALTIME\n"
+         "-n: wait with clock_nanosleep() instead of a POSIX timer\n"
+         "-t: number of timer threads, 1..%d (default 1)\n"
+         "-P: SCHED_FIFO priority of thread 0, each next thread gets one "
+         "less\n"
+         "-a: pin thread n to CPU (cpu + n), needs CONFIG_SMP\n"
+         "-d: interval added for each next thread (us)\n"
+         "-l: number of load threads below the timer threads, 0..%d\n"
+         "-H: latency histogram with this many buckets\n"
+         "-B: histogram bucket width (us, default 1)\n"
+         "-o: write the histogram to a file instead of stdout\n",
+         progname, MAX_THREADS, MAX_LOADS);
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -234,107 +465,244 @@ static FAR void *timerjitter(FAR void *arg)
 
 int main(int argc, FAR char *argv[])
 {
+  struct timerjitter_param_s params[MAX_THREADS];
   struct timerjitter_param_s param =
   {
-    .clockid  = DEFAULT_CLOCKID,
-    .interval = DEFAULT_INTERVAL,
-    .max_cnt  = DEFAULT_ITERATION,
-    .cur_cnt  = 0,
-    .print    = 0,
-    .missed   = 0
+    .clockid    = DEFAULT_CLOCKID,
+    .interval   = DEFAULT_INTERVAL,
+    .max_cnt    = DEFAULT_ITERATION,
+    .cur_cnt    = 0,
+    .print      = 0,
+    .missed     = 0,
+    .priority   = 0,
+    .cpu        = -1,
+    .hist_width = 1
   };
 
-  pthread_attr_t  attr;
-  pthread_t       thread;
-  sigset_t        sigset;
-  FAR const char *arg;
-  int             ret;
+  struct sched_param sparam;
+  pthread_attr_t     attr;
+  pthread_t          threads[MAX_THREADS];
+  pthread_t          loads[MAX_LOADS];
+  sigset_t           sigset;
+  FAR const char     *output = NULL;
+  FAR FILE           *out = stdout;
+  unsigned int       distance = 0;
+  int                nthreads = 1;
+  int                nloads = 0;
+  int                created = 0;
+  int                loaded = 0;
+  int                load_prio = 0;
+  int                opt;
+  int                ret;
+  int                i;
+
+  while ((opt = getopt(argc, argv, "pmrnt:P:a:d:l:H:B:o:h")) != -1)
+    {
+      switch (opt)
+        {
+          case 'p':
+            param.print = 1;
+            break;
+          case 'm':
+            param.clockid = CLOCK_MONOTONIC;
+            break;
+          case 'r':
+            param.clockid = CLOCK_REALTIME;
+            break;
+          case 'n':
+            param.nanosleep = true;
+            break;
+          case 't':
+            nthreads = atoi(optarg);
+            break;
+          case 'P':
+            param.priority = atoi(optarg);
+            break;
+          case 'a':
+            param.cpu = atoi(optarg);
+            break;
+          case 'd':
+            distance = strtoul(optarg, NULL, 0);
+            break;
+          case 'l':
+            nloads = atoi(optarg);
+            break;
+          case 'H':
+            param.hist_size = get_num(optarg);
+            break;
+          case 'B':
+            param.hist_width = get_num(optarg);
+            break;
+          case 'o':
+            output = optarg;
+            break;
+          case 'h':
+            show_usage(argv[0]);
+            return 0;
+          default:
+            show_usage(argv[0]);
+            return -1;
+        }
+    }
+
+  if (optind < argc)
+    {
+      param.interval = get_num(argv[optind]);
+    }
+
+  if (optind + 1 < argc)
+    {
+      param.max_cnt = get_num(argv[optind + 1]);
+    }
+
+  if (nthreads < 1 || nthreads > MAX_THREADS ||
+      TIMER_SIGNO(nthreads - 1) > SIGRTMAX ||
+      nloads < 0 || nloads > MAX_LOADS ||
+      param.interval == 0 || param.max_cnt == 0 || param.hist_width == 0 ||
+      (param.priority > 0 && param.priority - nthreads + 1 <
+       sched_get_priority_min(SCHED_FIFO) + (nloads > 0)))
+    {
+      show_usage(argv[0]);
+      return -1;
+    }
 
-  /* Mask SIGALRM at first */
+  /* Mask the timer signals at first, every thread inherits this */
 
   sigemptyset(&sigset);
-  sigaddset(&sigset, SIGALRM);
-  sigprocmask(SIG_BLOCK, &sigset, NULL);
+  for (i = 0; i < nthreads; i++)
+    {
+      sigaddset(&sigset, TIMER_SIGNO(i));
+    }
 
-  if (argc > 1)
+  pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+
+  for (i = 0; i < nthreads; i++)
     {
-      while ((arg = argv[1]) != NULL)
+      params[i]           = param;
+      params[i].id        = i;
+      params[i].interval  = param.interval + i * distance;
+      params[i].priority  = param.priority > 0 ? param.priority - i : 0;
+      params[i].cpu       = param.cpu >= 0 ? param.cpu + i : -1;
+
+      if (param.hist_size > 0)
         {
-          if (*arg != '-')
+          params[i].hist = calloc(param.hist_size, sizeof(unsigned long));
+          if (params[i].hist == NULL)
             {
-              break;
+              printf("no memory for histogram\n");
+              ret = -1;
+              goto errout;
             }
+        }
+    }
 
-          for (; ; )
-            {
-              switch (*++arg)
-                {
-                  case 0:
-                    break;
-                  case 'p':
-                    param.print = 1;
-                    continue;
-                  case 'm':
-                    param.clockid = CLOCK_MONOTONIC;
-                    continue;
-                  case 'r':
-                    param.clockid = CLOCK_REALTIME;
-                    continue;
-                  case 'h':
-                    printf(
-                    "usage: timerjitter [-pmr] [interval(us)] [iteration]\n"
-                    "-p: print time diff between two iteration\n"
-                    "-m: use CLOCK_MONOTONIC\n"
-                    "-r: use CLOCK_REALTIME\n"
-                    "");
-                    return 0;
-                  default:
-                    printf("Unknown flag '%s'", arg);
-                    return -1;
-                }
-              break;
-            }
+  if (output != NULL)
+    {
+      out = fopen(output, "w");
+      if (out == NULL)
+        {
+          printf("failed to open %s: %d\n", output, errno);
+          ret = -1;
+          goto errout;
+        }
+    }
+
+  /* The load runs one priority level below the lowest timer thread */
+
+  if (param.priority > 0)
+    {
+      load_prio = param.priority - nthreads;
+    }
+  else if (sched_getparam(0, &sparam) == 0)
+    {
+      load_prio = sparam.sched_priority - 1;
+    }
 
-          /* Find next parameters */
+  if (load_prio < sched_get_priority_min(SCHED_FIFO))
+    {
+      load_prio = 0;
+    }
 
-          argv++;
-          argc--;
+  g_load_stop = false;
+  for (loaded = 0; loaded < nloads; loaded++)
+    {
+      ret = setup_attr(&attr, load_prio,
+                       param.cpu >= 0 ? param.cpu + loaded : -1);
+      if (ret == 0)
+        {
+          ret = pthread_create(&loads[loaded], &attr, timerjitter_load,
+                               NULL);
+          pthread_attr_destroy(&attr);
         }
 
-      if (argc > 1)
+      if (ret)
         {
-          param.interval = get_num(argv[1]);
+          printf("load thread created failed %d\n", ret);
+          break;
         }
+    }
 
-      if (argc > 2)
+  for (created = 0; created < nthreads; created++)
+    {
+      ret = setup_attr(&attr, params[created].priority,
+                       params[created].cpu);
+      if (ret)
         {
-          param.max_cnt = get_num(argv[2]);
+          printf("pthread_attr_init failed %d\n", ret);
+          break;
+        }
+
+      ret = pthread_create(&threads[created], &attr, timerjitter,
+                           &params[created]);
+      pthread_attr_destroy(&attr);
+      if (ret)
+        {
+          printf("thread created failed %d\n", ret);
+          break;
         }
     }
 
-  ret = pthread_attr_init(&attr);
-  if (ret)
+  for (i = 0; i < created; i++)
     {
-      printf("pthread_attr_init failed %d\n", ret);
+      pthread_join(threads[i], NULL);
     }
 
-  ret = pthread_create(&thread, &attr, timerjitter, &param);
-  if (ret)
+  g_load_stop = true;
+  for (i = 0; i < loaded; i++)
     {
-      printf("thread created failed %d\n", ret);
+      pthread_join(loads[i], NULL);
     }
 
-  pthread_join(thread, NULL);
+  printf("timer jitter in %lu run, %s, %s, %d load thread(s):\n",
+         param.max_cnt, clock_name(param.clockid),
+         param.nanosleep ? "clock_nanosleep" : "timer", loaded);
 
-  ret = pthread_attr_destroy(&attr);
-  if (ret)
+  for (i = 0; i < created; i++)
     {
-      printf("pthread_attr_destroy failed %d\n", ret);
+      printf("[%d] interval %u us prio %d: "
+             "(latency/us) min: %lu, avg: %.0lf, max %lu, missed %u\n",
+             i, params[i].interval, params[i].priority, params[i].min,
+             params[i].avg, params[i].max, params[i].missed);
     }
 
-  printf("timer jitter in %lu run:\n", param.max_cnt);
-  printf("(latency/us) min: %lu, avg: %.0lf, max %lu\n",
-         param.min, param.avg, param.max);
+  if (param.hist_size > 0 && created > 0)
+    {
+      print_histogram(out, params, created);
+    }
 
-  return 0;
+  if (out != stdout)
+    {
+      fclose(out);
+    }
+
+  ret = 0;
+  i = nthreads;
+
+errout:
+  while (i-- > 0)
+    {
+      free(params[i].hist);
+    }
+
+  return ret;
 }
@@ -0,0 +1,130 @@
+# ##############################################################################
+# apps/tools/Wasm/WAMR.cmake
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed to the Apache Software Foundation (ASF) under one or more contributor
+# license agreements.  See the NOTICE file distributed with this work for
+# additional information regarding copyright ownership.  The ASF licenses this
+# file to you under the Apache License, Version 2.0 (the "License"); you may not
+# use this file except in compliance with the License.  You may obtain a copy of
+# the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+# License for the specific language governing permissions and limitations under
+# the License.
+#
+# ##############################################################################
+
+# This file provides the wamrc (WAMR AOT compiler) support for the Wasm build.
+# It mirrors interpreters/wamr/Toolchain.defs of the Makefile based build and
+# must be included after the NuttX configuration has been exported, since the
+# wamrc target is derived from the CONFIG_ARCH_* options.
+#
+# The target can be overridden from the command line with -DWAMRC_TARGET=...,
+# -DWAMRC_TARGET_ABI=... and -DWAMRC_CPU=..., which is required for the
+# architectures that are not detected below.
+
+set(WAMRC
+    wamrc
+    CACHE STRING "Path to the WAMR AOT compiler")
+
+set(WAMRC_TARGET
+    ""
+    CACHE STRING "wamrc --target, detected from the configuration if empty")
+
+set(WAMRC_TARGET_ABI
+    ""
+    CACHE STRING "wamrc --target-abi")
+
+set(WAMRC_CPU
+    ""
+    CACHE STRING "wamrc --cpu")
+
+set(WAMRC_FLAGS "")
+
+if(NOT WAMRC_TARGET)
+  if(CONFIG_ARCH_XTENSA)
+    set(WAMRC_TARGET xtensa)
+  elseif(CONFIG_ARCH_X86_64)
+    set(WAMRC_TARGET x86_64)
+  elseif(CONFIG_ARCH_X86)
+    set(WAMRC_TARGET i386)
+  elseif(CONFIG_ARCH_MIPS)
+    set(WAMRC_TARGET mips)
+  elseif(CONFIG_ARCH_SIM)
+    list(APPEND WAMRC_FLAGS --disable-simd)
+    if(CONFIG_SIM_M32)
+      set(WAMRC_TARGET i386)
+    else()
+      set(WAMRC_TARGET x86_64)
+    endif()
+  endif()
+endif()
+
+if(WAMRC_TARGET)
+  list(APPEND WAMRC_FLAGS --target=${WAMRC_TARGET})
+endif()
+
+if(WAMRC_TARGET_ABI)
+  list(APPEND WAMRC_FLAGS --target-abi=${WAMRC_TARGET_ABI})
+endif()
+
+if(WAMRC_CPU)
+  list(APPEND WAMRC_FLAGS --cpu=${WAMRC_CPU})
+endif()
+
+# ~~~
+# Function "wasm_aot_compile" to generate the AOT image of a Wasm application.
+#
+# This function adds a post build step to the given Wasm application target
+# that runs wamrc and writes NAME.aot (or NAME.xip) next to NAME.wasm.
+# Nothing is done unless CONFIG_INTERPRETERS_WAMR_AOT is enabled, and INT
+# modules are only compiled when CONFIG_INTERPRETERS_WAMR_AOT_ALL is set.
+#
+# Usage:
+#   wasm_aot_compile(NAME <name> MODE <INT|AOT|XIP>)
+#
+# Parameters:
+#   NAME: The name of the application target (NAME.wasm).
+#   MODE: The WAMR mode requested by the application.
+# ~~~
+
+function(wasm_aot_compile)
+
+  cmake_parse_arguments(AOT "" "NAME;MODE" "" ${ARGN})
+
+  if(NOT CONFIG_INTERPRETERS_WAMR_AOT)
+    return()
+  endif()
+
+  if(AOT_MODE STREQUAL "XIP")
+    set(AOT_SUFFIX xip)
+    set(AOT_FLAGS --enable-indirect-mode --disable-llvm-intrinsics)
+  elseif(AOT_MODE STREQUAL "AOT" OR CONFIG_INTERPRETERS_WAMR_AOT_ALL)
+    set(AOT_SUFFIX aot)
+    set(AOT_FLAGS "")
+  else()
+    return()
+  endif()
+
+  if(NOT WAMRC_TARGET)
+    message(WARNING "wamrc target unknown, set WAMRC_TARGET to generate "
+                    "${AOT_NAME}.${AOT_SUFFIX}")
+    return()
+  endif()
+
+  add_custom_command(
+    TARGET ${AOT_NAME}
+    POST_BUILD
+    COMMAND ${WAMRC} ${WAMRC_FLAGS} ${AOT_FLAGS} -o
+            $<TARGET_FILE_DIR:${AOT_NAME}>/${AOT_NAME}.${AOT_SUFFIX}
+            $<TARGET_FILE:${AOT_NAME}>
+    COMMENT "Wamrc Generate: ${AOT_NAME}.${AOT_SUFFIX}"
+    VERBATIM)
+
+endfunction()
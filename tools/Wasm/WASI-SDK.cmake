@@ -56,7 +56,8 @@ set(CMAKE_CXX_COMPILER ${WASI_SDK_PATH}/bin/clang++)
 #
 # Usage:
 #   wasm_add_application(NAME <name> SRCS <source files>
-#     [STACK_SIZE <stack size>] [INITIAL_MEMORY_SIZE <initial memory size>])
+#     [STACK_SIZE <stack size>] [INITIAL_MEMORY_SIZE <initial memory size>]
+#     [WAMR_MODE <INT|AOT|XIP>] [EXPORTS <symbols>])
 #
 # Parameters:
 #   NAME: The name of the application (NAME.wasm).
@@ -64,6 +65,11 @@ set(CMAKE_CXX_COMPILER ${WASI_SDK_PATH}/bin/clang++)
 #   STACK_SIZE: The stack size of the application. Default is 2048.
 #   INITIAL_MEMORY_SIZE: The initial memory size of the application.
 #     Default is 65536 (One page), and must be a multiple of 65536.
+#   WAMR_MODE: How the module is meant to run, same as WAMR_MODE of the
+#     Makefile build. AOT and XIP generate NAME.aot / NAME.xip with wamrc
+#     next to NAME.wasm. Default is INT.
+#   EXPORTS: Additional functions to export from the module, so that a host
+#     program can look them up and call them.
 # ~~~
 
 function(wasm_add_application)
@@ -73,9 +79,11 @@ function(wasm_add_application)
   set(APP_SRCS "")
   set(APP_STACK_SIZE 2048)
   set(APP_INITIAL_MEMORY_SIZE 65536)
+  set(APP_WAMR_MODE INT)
+  set(APP_EXPORTS "")
 
-  cmake_parse_arguments(APP "" "NAME;STACK_SIZE;INITIAL_MEMORY_SIZE" "SRCS"
-                        ${ARGN})
+  cmake_parse_arguments(APP "" "NAME;STACK_SIZE;INITIAL_MEMORY_SIZE;WAMR_MODE"
+                        "SRCS;EXPORTS" ${ARGN})
 
   # Check if the APP_NAME (NAME) is provided
   if(NOT APP_NAME)
@@ -93,6 +101,15 @@ function(wasm_add_application)
   # Set the target properties
   set_target_properties(${APP_NAME} PROPERTIES OUTPUT_NAME ${APP_NAME}.wasm)
 
+  foreach(APP_EXPORT ${APP_EXPORTS})
+    target_link_libraries(${APP_NAME} -Wl,--export=${APP_EXPORT})
+  endforeach()
+
+  # Generate the AOT image if requested, see WAMR.cmake
+  if(COMMAND wasm_aot_compile)
+    wasm_aot_compile(NAME ${APP_NAME} MODE ${APP_WAMR_MODE})
+  endif()
+
 endfunction()
 
 # ~~~